@@ -2,19 +2,212 @@
 #include <vector>
 #include <string>
 #include <limits> // Required for numeric_limits
-#include <cstdlib> // Required for system("cls") or system("clear")
+#include <cstdlib> // atoi, strtoul
 #include <ios>     // Required for streamsize
-#include <map>     // For storing attendance temporarily
+#include <map>     // Subject name lookups
+#include <cstdint> // Fixed width integers for hashing and indexes
+#include <cctype>  // tolower/toupper for normalizing keys
+#include <algorithm> // min, fill, copy, sort, merge, binary_search
+#include <iterator>  // back_inserter
+#include <chrono>  // Timing for the benchmark mode
+#include <cstring> // strcmp for command line flags
+#include <iomanip> // setw for benchmark tables
+#include <cstdio>  // FILE* writes for snapshot files
+#include <thread>  // Background flusher for the write-ahead log
+#include <mutex>
+#include <condition_variable>
+#include <shared_mutex> // Reader/writer locks for stores shared by server sessions
+#include <deque>   // Stable element addresses while other sessions append
+#include <memory>  // unique_ptr for server sessions
+#include <csignal> // Ctrl+C ends server mode cleanly
+#include <atomic>  // Lock-free submission queue
+#include <functional>
+#include <ctime>   // Submission timestamps
+#include <cmath>   // log for search ranking
+#include <fstream> // Batch command files
+#include <sstream> // Menus are composed before they are drawn
+#include <random>  // Password salts
+#include <stdexcept> // length_error when the string arena runs out of offsets
 
-// --- Clear Screen Function ---
-// Platform specific clear screen
-void clearScreen() {
+#if defined(__AVX2__)
+#include <immintrin.h> // Vectorized popcount for attendance bitsets
+#endif
+
+#ifdef _WIN32
+#define NOMINMAX // Keep windows.h from breaking numeric_limits<...>::max()
+#include <windows.h>
+#include <io.h>       // _commit, _chsize_s for FILE* based files
+#else
+#include <fcntl.h>    // open() for memory mapped files
+#include <sys/mman.h> // mmap
+#include <sys/stat.h> // fstat for file size
+#include <sys/ioctl.h> // Console window size for the menu renderer
+#include <unistd.h>   // close, fsync
+#include <sys/socket.h> // Server mode sockets
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <cerrno>
+#if defined(__linux__)
+#include <sys/epoll.h> // Server event loop; other systems fall back to poll()
+#else
+#include <poll.h>
+#endif
+#endif
+
+// --- Session Streams ---
+// The menus read and write through sessionIn()/sessionOut() rather than
+// std::cin/std::cout. On the console they read std::cin and write std::cout
+// through a TerminalScreen; in server mode each session thread points them
+// at its own connection.
+thread_local std::istream* sessionInput = &std::cin;
+thread_local std::ostream* sessionOutput = &std::cout;
+
+inline std::istream& sessionIn() { return *sessionInput; }
+inline std::ostream& sessionOut() { return *sessionOutput; }
+
+// Puts a stream's number format and precision back when the scope ends, so a
+// table printed with std::fixed does not change how the next screen (or the
+// next client on this thread) sees numbers.
+class FormatGuard {
+public:
+    explicit FormatGuard(std::ostream& out) : out(out), flags(out.flags()), precision(out.precision()) {}
+    ~FormatGuard() {
+        out.flags(flags);
+        out.precision(precision);
+    }
+    FormatGuard(const FormatGuard&) = delete;
+    FormatGuard& operator=(const FormatGuard&) = delete;
+
+private:
+    std::ostream& out;
+    std::ios::fmtflags flags;
+    std::streamsize precision;
+};
+
+// --- Terminal Rendering ---
+// The menus write through a TerminalScreen, which holds everything written
+// between two reads and hands it to the terminal in one write. It also
+// remembers the last menu it drew and how much was printed under it, so
+// drawing the menu again only repaints the rows that changed. Screens are
+// cleared with ANSI sequences; no clear command is run.
+const int DEFAULT_TERMINAL_ROWS = 24; // Assumed when the height cannot be asked, e.g. for server clients
+
+// Height of the console window, or the default when output is not a console
+int consoleRows() {
 #ifdef _WIN32
-    system("cls");
+    CONSOLE_SCREEN_BUFFER_INFO info;
+    if (GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &info)) {
+        return info.srWindow.Bottom - info.srWindow.Top + 1;
+    }
 #else
-    // Assume POSIX (Linux, macOS)
-    system("clear");
+    struct winsize size;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_row > 0) return size.ws_row;
+#endif
+    return DEFAULT_TERMINAL_ROWS;
+}
+
+#ifdef _WIN32
+#ifndef ENABLE_VIRTUAL_TERMINAL_PROCESSING
+#define ENABLE_VIRTUAL_TERMINAL_PROCESSING 0x0004 // Older SDKs lack it; Windows 10 consoles understand it
+#endif
+// Windows consoles only act on ANSI sequences once asked to
+void enableConsoleEscapes() {
+    HANDLE console = GetStdHandle(STD_OUTPUT_HANDLE);
+    DWORD mode = 0;
+    if (GetConsoleMode(console, &mode)) SetConsoleMode(console, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+}
 #endif
+
+class TerminalScreen : public std::streambuf {
+public:
+    // rows is the terminal height; 0 asks the console before each menu (it may have been resized)
+    TerminalScreen(std::streambuf* target, int rows) : target(target), rows(rows), rowsBelow(0) {}
+    ~TerminalScreen() { flush(); }
+    TerminalScreen(const TerminalScreen&) = delete;
+    TerminalScreen& operator=(const TerminalScreen&) = delete;
+
+    void clear() {
+        pending += "\033[H\033[2J";
+        shown.clear();
+    }
+
+    // Draws a menu; its last line is the prompt, left without a newline
+    void present(const std::string& screen) {
+        std::vector<std::string> next;
+        for (size_t start = 0;;) {
+            size_t end = screen.find('\n', start);
+            next.push_back(screen.substr(start, end == std::string::npos ? end : end - start));
+            if (end == std::string::npos) break;
+            start = end + 1;
+        }
+        // The old menu is still where we drew it unless something cleared it or
+        // pushed it off the top; the choice and "Press Enter" each echo a row too
+        size_t height = static_cast<size_t>(rows > 0 ? rows : consoleRows());
+        if (shown.empty() || shown.size() + rowsBelow + 2 > height || next.size() > height) {
+            pending += "\033[H\033[2J";
+            pending += screen;
+        } else {
+            size_t last = next.size() - 1;
+            for (size_t row = 0; row < last; row++) {
+                // The old prompt row also holds the answer typed after it
+                if (row + 1 < shown.size() && shown[row] == next[row]) continue;
+                pending += "\033[" + std::to_string(row + 1) + ";1H" + next[row] + "\033[K";
+            }
+            // Wipe from the prompt down, taking whatever the last choice printed with it
+            pending += "\033[" + std::to_string(last + 1) + ";1H\033[J" + next[last];
+        }
+        shown.swap(next);
+        rowsBelow = 0;
+    }
+
+protected:
+    int_type overflow(int_type c) override {
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            pending.push_back(traits_type::to_char_type(c));
+            if (traits_type::to_char_type(c) == '\n') rowsBelow++;
+        }
+        return traits_type::not_eof(c);
+    }
+
+    std::streamsize xsputn(const char* text, std::streamsize count) override {
+        pending.append(text, static_cast<size_t>(count));
+        rowsBelow += static_cast<size_t>(std::count(text, text + count, '\n'));
+        return count;
+    }
+
+    int sync() override { return flush(); }
+
+private:
+    int flush() {
+        std::streamsize size = static_cast<std::streamsize>(pending.size());
+        bool sent = pending.empty() || target->sputn(pending.data(), size) == size;
+        pending.clear();
+        return sent && target->pubsync() == 0 ? 0 : -1;
+    }
+
+    std::streambuf* target;
+    int rows;
+    size_t rowsBelow;               // Lines printed since the menu was drawn
+    std::string pending;            // Written but not yet handed to the terminal
+    std::vector<std::string> shown; // The menu on screen by row; empty when there is none
+};
+
+thread_local TerminalScreen* sessionScreen = nullptr; // Null outside the menus, e.g. in batch mode
+
+void clearScreen() {
+    if (sessionScreen) sessionScreen->clear();
+    else sessionOut() << "\033[H\033[2J";
+}
+
+// Shows a menu composed off to the side; see TerminalScreen::present
+void presentScreen(const std::string& screen) {
+    if (sessionScreen) {
+        sessionScreen->present(screen);
+    } else {
+        clearScreen();
+        sessionOut() << screen;
+    }
 }
 
 // --- Role Enumeration ---
@@ -36,567 +229,11553 @@ struct User {
 
 // --- Data Structures for Shared Info ---
 struct Complaint {
+    uint64_t sequence = 0;    // Submission number, assigned when it is stored
+    int64_t submittedAt = 0;  // Unix time (seconds) it was stored
     std::string studentEmail; // Identify who submitted
     std::string studentName;
     std::string message;
-    // Could add timestamp later
 };
 
 struct LeaveNotice {
+    uint64_t sequence = 0;   // Shares the numbering with complaints
+    int64_t submittedAt = 0; // Unix time (seconds) it was stored
     std::string studentEmail;
     std::string studentName;
-    std::string dates;
+    std::string dates;       // As typed, e.g. "25-27 Feb 2024"
     std::string reason;
-    // Could add submission timestamp later
+    int64_t firstDay = 0;    // Days since 1970-01-01 covered by `dates`, inclusive;
+    int64_t lastDay = -1;    // lastDay < firstDay when they could not be read
 };
 
-// --- Global User & Shared Data Storage (In-memory "database") ---
-std::vector<User> users;
-std::vector<Complaint> studentComplaints;
-std::vector<LeaveNotice> studentLeaveNotices;
-
-// --- Function Declarations ---
-void displayMainMenu();
-void handleRegistration();
-bool handleLogin(User& loggedInUser); // Pass by reference to store logged-in user info
-
-// Student Dashboard & Functions
-void showStudentDashboard(const User& user);
-void displayCollegeEvents();
-void displayAttendance();
-void handleComplaintBox(const User& student); // Pass student info
-void handleLeaveNotice(const User& student); // Pass student info
-void displayResults();
-
-// Teacher Dashboard & Functions
-void showTeacherDashboard(const User& user);
-void displayTeacherMeetings();
-void handleResultUpload();
-void handleAttendanceTaking();
-void viewStudentComplaints();
-void viewStudentLeaveNotices();
-
-// Non-Teaching Staff Dashboard
-void showNonTeachingStaffDashboard(const User& user);
-
-// Helper Function
-void ignoreLine();
-
-// --- Main Function ---
-int main() {
-    // Optional: Add default users for easy testing
-    users.push_back({"Alice Smith", "student@test.com", "pass123", "1234567890", Role::STUDENT, "S1001"});
-    users.push_back({"Bob Johnson", "student2@test.com", "pass123", "1122334455", Role::STUDENT, "S1002"});
-    users.push_back({"Prof. Davis", "teacher@test.com", "pass456", "0987654321", Role::TEACHER, "Professor"});
-    users.push_back({"Mr. Lee", "staff@test.com", "pass789", "5556667777", Role::NON_TEACHING_STAFF, "Librarian"});
+// A string that points into another buffer (e.g. a memory mapped file)
+// instead of owning a copy
+struct StrView {
+    const char* data;
+    size_t size;
+    std::string str() const { return std::string(data, size); }
+};
 
-    int choice;
-    bool loggedIn = false;
-    User currentUser; // To store details of the logged-in user
+// Locale-free character helpers for the hot parsing loops
+inline bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
 
-    while (true) {
-        clearScreen();
-        displayMainMenu();
-        std::cout << "Enter your choice: ";
-        std::cin >> choice;
+inline char asciiUpper(char c) {
+    return c >= 'a' && c <= 'z' ? static_cast<char>(c - 'a' + 'A') : c;
+}
 
-        if (std::cin.fail()) {
-            std::cout << "Invalid input. Please enter a number.\n";
-            std::cin.clear();
-            ignoreLine();
-            std::cout << "Press Enter to continue...";
-            ignoreLine(); // Consume the Enter press
-            continue;
-        }
-        ignoreLine(); // Consume the newline character left by cin
+// Narrows a pointer/length slice to exclude surrounding whitespace
+inline void trimSlice(const char*& text, size_t& length) {
+    while (length > 0 && isBlank(*text)) { text++; length--; }
+    while (length > 0 && isBlank(text[length - 1])) length--;
+}
 
-        switch (choice) {
-            case 1: // Login
-                clearScreen();
-                loggedIn = handleLogin(currentUser);
-                if (loggedIn) {
-                    switch (currentUser.role) {
-                        case Role::STUDENT:
-                            showStudentDashboard(currentUser);
-                            break;
-                        case Role::TEACHER:
-                            showTeacherDashboard(currentUser);
-                            break;
-                        case Role::NON_TEACHING_STAFF:
-                            showNonTeachingStaffDashboard(currentUser);
-                            break;
-                    }
-                    loggedIn = false; // Reset login status after logout/dashboard exit
-                    currentUser = {}; // Clear current user data
-                }
-                break;
-            case 2: // Register
-                clearScreen();
-                handleRegistration();
-                break;
-            case 3: // Exit
-                std::cout << "Exiting College Alerter. Goodbye!\n";
-                return 0;
-            default:
-                std::cout << "Invalid choice. Please try again.\n";
-                std::cout << "Press Enter to continue...";
-                std::cin.get(); // Wait for user press Enter
-                break;
-        }
+// --- Hashing Helpers ---
+// FNV-1a, good enough for short keys like emails and IDs
+uint64_t hashBytes(const char* text, size_t length) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= static_cast<unsigned char>(text[i]);
+        hash *= 1099511628211ULL;
     }
+    return hash;
+}
 
-    return 0;
+uint64_t hashString(const std::string& text) {
+    return hashBytes(text.data(), text.size());
 }
 
-// --- Function Implementations ---
+// Lowercased, trimmed form used to match names typed in different ways
+std::string normalizeKey(const std::string& text) {
+    size_t first = text.find_first_not_of(" \t\r\n");
+    if (first == std::string::npos) return "";
+    size_t last = text.find_last_not_of(" \t\r\n");
+    std::string result = text.substr(first, last - first + 1);
+    for (auto& c : result) c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    return result;
+}
 
-void ignoreLine() {
-    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+// Emails are matched case-insensitively and without surrounding spaces
+std::string normalizeEmail(const std::string& email) {
+    return normalizeKey(email);
 }
 
-void displayMainMenu() {
-    std::cout << "=====================================\n";
-    std::cout << "        Welcome to College Alerter\n";
-    std::cout << "=====================================\n";
-    std::cout << "1. Login\n";
-    std::cout << "2. Register\n";
-    std::cout << "3. Exit\n";
-    std::cout << "=====================================\n";
+// Student IDs like "s1001 " and "S1001" refer to the same student
+std::string normalizeStudentId(const std::string& id) {
+    size_t first = id.find_first_not_of(" \t\r\n");
+    if (first == std::string::npos) return "";
+    size_t last = id.find_last_not_of(" \t\r\n");
+    std::string result = id.substr(first, last - first + 1);
+    for (auto& c : result) c = static_cast<char>(toupper(static_cast<unsigned char>(c)));
+    return result;
 }
 
-void handleRegistration() {
-    User newUser;
-    int roleChoice;
-    int staffChoice;
+// Cache hint for lookups whose address is known a little ahead of use
+#if defined(__GNUC__)
+#define PREFETCH(address) __builtin_prefetch(address)
+#else
+#define PREFETCH(address) ((void)(address))
+#endif
 
-    std::cout << "--- Registration ---\n";
-    std::cout << "Enter Name: ";
-    std::getline(std::cin, newUser.name);
+// --- Open Addressing Hash Index ---
+// Maps a key hash to a record index. Slots are 8 bytes in one flat array
+// (linear probing), so a lookup usually touches a single cache line.
+// The index never stores keys; callers confirm a candidate with a match
+// callback against their own records.
+class OpenHashIndex {
+public:
+    static const uint32_t npos = 0xFFFFFFFFu;
 
-    std::cout << "Enter Email: ";
-    std::getline(std::cin, newUser.email);
+    OpenHashIndex() : count(0), mask(0) {}
 
-    // Basic check if email already exists
-    for(const auto& user : users) {
-        if (user.email == newUser.email) {
-            std::cout << "\nError: Email already registered.\n";
-            std::cout << "Press Enter to return to the main menu...";
-            std::cin.get();
-            return;
+    void reserve(size_t records) {
+        size_t needed = 16;
+        while (needed * 7 / 10 < records) needed *= 2; // Keep load factor under 0.7
+        if (needed > slots.size()) rehash(needed);
+    }
+
+    void insert(uint64_t hash, uint32_t value) {
+        if (slots.empty() || (count + 1) * 10 > slots.size() * 7) {
+            rehash(slots.empty() ? 16 : slots.size() * 2);
         }
+        place(fold(hash), value);
+        count++;
     }
 
-    std::cout << "Enter Phone Number: ";
-    std::getline(std::cin, newUser.phone);
+    // Returns the stored value whose record satisfies matches(value), or npos
+    template <typename Match>
+    uint32_t find(uint64_t hash, Match matches) const {
+        if (slots.empty()) return npos;
+        uint32_t tag = fold(hash);
+        for (uint32_t pos = tag & mask; ; pos = (pos + 1) & mask) {
+            const Slot& slot = slots[pos];
+            if (slot.value == npos) return npos;
+            if (slot.tag == tag && matches(slot.value)) return slot.value;
+        }
+    }
 
-    std::cout << "Enter Password: ";
-    std::getline(std::cin, newUser.password);
+    size_t size() const { return count; }
+    size_t memoryUsage() const { return slots.capacity() * sizeof(Slot); }
 
-    std::cout << "\nSelect Role:\n";
-    std::cout << "1. Student\n";
-    std::cout << "2. Teacher\n";
-    std::cout << "3. Non-Teaching Staff\n";
-    std::cout << "Enter role choice: ";
-    std::cin >> roleChoice;
+    // For batched lookups: start loading a key's home slot into cache now,
+    // and later peek at the first likely match so its record can be loaded
+    // too, before find() needs either
+    void prefetch(uint64_t hash) const {
+        if (!slots.empty()) PREFETCH(&slots[fold(hash) & mask]);
+    }
 
-    while (std::cin.fail() || (roleChoice < 1 || roleChoice > 3)) {
-         std::cout << "Invalid input. Please enter 1, 2, or 3: ";
-         std::cin.clear();
-         ignoreLine();
-         std::cin >> roleChoice;
+    uint32_t firstCandidate(uint64_t hash) const {
+        if (slots.empty()) return npos;
+        uint32_t tag = fold(hash);
+        for (uint32_t pos = tag & mask; ; pos = (pos + 1) & mask) {
+            if (slots[pos].value == npos || slots[pos].tag == tag) return slots[pos].value;
+        }
     }
-    ignoreLine(); // Consume newline
 
-    switch (roleChoice) {
-        case 1:
-            newUser.role = Role::STUDENT;
-            std::cout << "Enter Student ID Number: ";
-            std::getline(std::cin, newUser.roleSpecificData);
-            break;
-        case 2:
-            newUser.role = Role::TEACHER;
-            std::cout << "Enter Teacher Position (e.g., Professor, Asst. Professor): ";
-            std::getline(std::cin, newUser.roleSpecificData);
-            break;
-        case 3:
-            newUser.role = Role::NON_TEACHING_STAFF;
-            std::cout << "\nSelect Non-Teaching Staff Role:\n";
-            std::cout << "1. Librarian\n";
-            std::cout << "2. Watchman\n";
-            std::cout << "3. Other Clerical/Support Staff\n";
-            std::cout << "Enter staff role choice: ";
-            std::cin >> staffChoice;
-
-             while (std::cin.fail() || (staffChoice < 1 || staffChoice > 3)) {
-                std::cout << "Invalid input. Please enter 1, 2, or 3: ";
-                std::cin.clear();
-                ignoreLine();
-                std::cin >> staffChoice;
-            }
-             ignoreLine(); // Consume newline
+private:
+    struct Slot {
+        uint32_t tag;   // Folded hash, also used to re-place the slot on growth
+        uint32_t value; // Record index, npos for an empty slot
+    };
 
-            switch (staffChoice) {
-                case 1: newUser.roleSpecificData = "Librarian"; break;
-                case 2: newUser.roleSpecificData = "Watchman"; break;
-                case 3: newUser.roleSpecificData = "Clerical/Support Staff"; break;
-            }
-            break;
+    std::vector<Slot> slots;
+    size_t count;
+    uint32_t mask;
+
+    static uint32_t fold(uint64_t hash) {
+        return static_cast<uint32_t>(hash ^ (hash >> 32));
     }
 
-    users.push_back(newUser);
-    std::cout << "\nRegistration Successful!\n";
-    std::cout << "Press Enter to return to the main menu...";
-    std::cin.get();
-}
+    void place(uint32_t tag, uint32_t value) {
+        uint32_t pos = tag & mask;
+        while (slots[pos].value != npos) pos = (pos + 1) & mask;
+        slots[pos].tag = tag;
+        slots[pos].value = value;
+    }
 
-bool handleLogin(User& loggedInUser) {
-    std::string email, password;
-    std::cout << "--- Login ---\n";
-    std::cout << "Enter Email: ";
-    std::getline(std::cin, email);
-    std::cout << "Enter Password: ";
-    std::getline(std::cin, password);
-
-    for (const auto& user : users) {
-        if (user.email == email && user.password == password) {
-            std::cout << "\nLogin Successful! Welcome, " << user.name << ".\n";
-            loggedInUser = user;
-            std::cout << "Press Enter to continue...";
-            std::cin.get();
-            return true;
+    void rehash(size_t capacity) {
+        std::vector<Slot> old;
+        old.swap(slots);
+        slots.assign(capacity, Slot{0, npos});
+        mask = static_cast<uint32_t>(capacity - 1);
+        for (const auto& slot : old) {
+            if (slot.value != npos) place(slot.tag, slot.value);
         }
     }
+};
 
-    std::cout << "\nLogin Failed: Invalid email or password.\n";
-    std::cout << "Press Enter to return to the main menu...";
-    std::cin.get();
-    return false;
-}
+// --- String Arena ---
+// Append-only storage for many small strings. Bytes go into 1 MB chunks that
+// are never moved or freed, and a string is referred to by a packed 8-byte
+// (offset, length) pair, so it costs its bytes plus 8 - no heap block,
+// capacity slack or 32-byte std::string per field. A StrView into the arena
+// stays valid for the arena's lifetime.
+struct PackedString {
+    uint32_t offset;
+    uint32_t length;
+};
 
-// --- Student Dashboard and Functions ---
+class StringArena {
+public:
+    static const size_t CHUNK_BITS = 20;
+    static const size_t CHUNK_SIZE = size_t(1) << CHUNK_BITS;
+    static const size_t MAX_CHUNKS = size_t(1) << (32 - CHUNK_BITS); // 4 GB of offsets
 
-void showStudentDashboard(const User& user) {
-    int choice;
-    while (true) {
-        clearScreen();
-        std::cout << "=====================================\n";
-        std::cout << "        Student Dashboard - Welcome " << user.name << "\n";
-        std::cout << "=====================================\n";
-        std::cout << "1. View College Events\n";
-        std::cout << "2. View Attendance\n";
-        std::cout << "3. Submit Complaint\n";
-        std::cout << "4. Submit Leave Notice\n";
-        std::cout << "5. View Results\n";
-        std::cout << "6. Logout\n";
-        std::cout << "=====================================\n";
-        std::cout << "Enter your choice: ";
-        std::cin >> choice;
-
-        if (std::cin.fail()) {
-            std::cout << "Invalid input. Please enter a number.\n";
-            std::cin.clear();
-            ignoreLine();
-            std::cout << "Press Enter to continue...";
-            ignoreLine();
-            continue;
-        }
-        ignoreLine();
+    StringArena() : used(CHUNK_SIZE) {}
 
-        switch (choice) {
-            case 1: displayCollegeEvents(); break;
-            case 2: displayAttendance(); break;
-            case 3: handleComplaintBox(user); break; // Pass user info
-            case 4: handleLeaveNotice(user); break; // Pass user info
-            case 5: displayResults(); break;
-            case 6:
-                std::cout << "Logging out...\n";
-                std::cout << "Press Enter to return to main menu...";
-                std::cin.get();
-                return;
-            default:
-                std::cout << "Invalid choice. Please try again.\n";
-                break;
-        }
-        if (choice != 6) {
-             std::cout << "\nPress Enter to return to the Student Dashboard...";
-             std::cin.get();
+    // Strings longer than a chunk are cut to CHUNK_SIZE (user fields never are).
+    // An empty string takes no space; throws length_error past MAX_CHUNKS.
+    PackedString store(const char* text, size_t length) {
+        if (length == 0) return PackedString{0, 0};
+        if (length > CHUNK_SIZE) length = CHUNK_SIZE;
+        if (length > CHUNK_SIZE - used) {
+            if (chunks.size() == MAX_CHUNKS) throw std::length_error("string arena is full");
+            chunks.emplace_back(new char[CHUNK_SIZE]);
+            used = 0;
         }
+        memcpy(chunks.back().get() + used, text, length);
+        PackedString packed{static_cast<uint32_t>(((chunks.size() - 1) << CHUNK_BITS) + used),
+                            static_cast<uint32_t>(length)};
+        used += length;
+        return packed;
     }
-}
 
-void displayCollegeEvents() {
-    clearScreen();
-    std::cout << "--- Upcoming College Events ---\n";
-    std::cout << "1. Tech Fest 'Innovate 2024'\n";
-    std::cout << "   Date: 20 March, 2024\n";
-    std::cout << "   Venue: College Auditorium\n\n";
-    std::cout << "2. Annual Sports Day\n";
-    std::cout << "   Date: 05 April, 2024\n";
-    std::cout << "   Venue: College Sports Ground\n\n";
-    std::cout << "3. Guest Lecture on AI Ethics\n";
-    std::cout << "   Date: 15 April, 2024\n";
-    std::cout << "   Venue: Seminar Hall B\n";
-    std::cout << "--------------------------------\n";
-}
-
-void displayAttendance() {
-    clearScreen();
-    std::cout << "--- Your Attendance (Dummy Data) ---\n";
-    std::cout << "Overall Attendance: 85%\n\n";
-    std::cout << "Subject Wise:\n";
-    std::cout << "- Data Structures: 90%\n";
-    std::cout << "- Operating Systems: 82%\n";
-    std::cout << "- Database Management: 78%\n";
-    std::cout << "- Computer Networks: 91%\n";
-     std::cout << "------------------------------------\n";
-     // In a real system, this data would be fetched based on teacher uploads
-}
-
-void handleComplaintBox(const User& student) {
-    clearScreen();
-    Complaint newComplaint;
-    newComplaint.studentEmail = student.email; // Store student email
-    newComplaint.studentName = student.name;   // Store student name
-    std::cout << "--- Submit Complaint ---\n";
-    std::cout << "Please type your complaint below and press Enter:\n";
-    std::cout << "----------------------------------------------\n";
-    std::getline(std::cin, newComplaint.message);
-    std::cout << "\n----------------------------------------------\n";
+    StrView view(PackedString packed) const {
+        if (packed.length == 0) return {"", 0};
+        return {chunks[packed.offset >> CHUNK_BITS].get() + (packed.offset & (CHUNK_SIZE - 1)), packed.length};
+    }
 
-    studentComplaints.push_back(newComplaint); // Add to global list
+    size_t memoryUsage() const { return chunks.size() * CHUNK_SIZE + chunks.capacity() * sizeof(chunks[0]); }
+
+private:
+    std::vector<std::unique_ptr<char[]>> chunks;
+    size_t used; // Bytes used in the last chunk
+};
 
-    std::cout << "Thank you. Your complaint has been recorded.\n";
-    std::cout << "----------------------------------------------\n";
+inline bool operator==(StrView view, const std::string& text) {
+    return view.size == text.size() && memcmp(view.data, text.data(), view.size) == 0;
 }
 
-void handleLeaveNotice(const User& student) {
-    clearScreen();
-    LeaveNotice newNotice;
-    newNotice.studentEmail = student.email;
-    newNotice.studentName = student.name;
+inline std::ostream& operator<<(std::ostream& out, StrView view) {
+    return out.write(view.data, static_cast<std::streamsize>(view.size));
+}
 
-    std::cout << "--- Submit Leave Notice ---\n";
-    std::cout << "Enter Date(s) of Leave (e.g., 25 Feb 2024 or 25-27 Feb 2024): ";
-    std::getline(std::cin, newNotice.dates);
-    std::cout << "Enter Reason for Leave:\n";
-    std::cout << "---------------------------\n";
-    std::getline(std::cin, newNotice.reason);
-    std::cout << "\n---------------------------\n";
+// --- User Directory ---
+// Owns every user. Records are stored column by column (structure of
+// arrays): roles and student slots are dense arrays that scans walk without
+// touching any text, and the text fields are packed references into one
+// string arena. Non-student role data ("Professor", "Librarian", ...) is
+// interned, so thousands of staff share one copy of each value.
+//
+// Users are referred to by a UserHandle (their position) rather than by
+// copies; accessors return StrViews into the arena. Lookups by email (login,
+// duplicate checks) and student ID go through hash indexes.
+//
+// Safe to share between server sessions: reads take a shared lock, adds an
+// exclusive one, and arena bytes never move, so a returned StrView stays
+// valid while other sessions register.
+typedef uint32_t UserHandle;
 
-    studentLeaveNotices.push_back(newNotice); // Add to global list
+class UserDirectory {
+public:
+    static const UserHandle npos = 0xFFFFFFFFu;
+    static const uint32_t NO_STUDENT_SLOT = 0xFFFFFFFFu;
 
-    std::cout << "Leave notice submitted for "<< newNotice.dates << ".\n";
-    std::cout << "---------------------------\n";
-}
+    UserDirectory() = default;
+    UserDirectory(const UserDirectory&) = delete;
+    UserDirectory& operator=(const UserDirectory&) = delete;
 
-void displayResults() {
-    clearScreen();
-    std::cout << "--- Your Results (Dummy Data - Last Semester) ---\n";
-    std::cout << "Subject             | Grade\n";
-    std::cout << "--------------------|-------\n";
-    std::cout << "Data Structures     | A\n";
-    std::cout << "Mathematics III     | B+\n";
-    std::cout << "Digital Logic       | A-\n";
-    std::cout << "Economics           | B\n";
-    std::cout << "--------------------|-------\n";
-    std::cout << "SGPA: 8.8\n";
-    std::cout << "---------------------------\n";
-    // In a real system, this data would be fetched based on teacher uploads
-}
+    // Swaps in a directory built elsewhere (e.g. loaded from a snapshot)
+    UserDirectory& operator=(UserDirectory&& other) {
+        std::unique_lock<std::shared_timed_mutex> lock(mutex);
+        arena = std::move(other.arena);
+        names = std::move(other.names);
+        emails = std::move(other.emails);
+        phones = std::move(other.phones);
+        passwords = std::move(other.passwords);
+        roleData = std::move(other.roleData);
+        roles = std::move(other.roles);
+        studentSlots = std::move(other.studentSlots);
+        studentUsers = std::move(other.studentUsers);
+        emailIndex = std::move(other.emailIndex);
+        studentIdIndex = std::move(other.studentIdIndex);
+        internIndex = std::move(other.internIndex);
+        interned = std::move(other.interned);
+        return *this;
+    }
 
+    size_t size() const {
+        std::shared_lock<std::shared_timed_mutex> lock(mutex);
+        return roles.size();
+    }
+    bool empty() const { return size() == 0; }
 
-// --- Teacher Dashboard and Functions ---
+    void reserve(size_t count) {
+        std::unique_lock<std::shared_timed_mutex> lock(mutex);
+        reserveLocked(count);
+    }
 
-void showTeacherDashboard(const User& user) {
-    int choice;
-    while (true) {
-        clearScreen();
-        std::cout << "=====================================\n";
-        std::cout << "        Teacher Dashboard - Welcome " << user.name << "\n";
-        std::cout << "        Position: " << user.roleSpecificData << "\n";
-        std::cout << "=====================================\n";
-        std::cout << "1. View/Announce Meetings\n";
-        std::cout << "2. Upload Student Results\n";
-        std::cout << "3. Take/Upload Attendance\n";
-        std::cout << "4. View Student Complaints (" << studentComplaints.size() << ")\n"; // Show count
-        std::cout << "5. View Student Leave Notices (" << studentLeaveNotices.size() << ")\n"; // Show count
-        std::cout << "6. Logout\n";
-        std::cout << "=====================================\n";
-        std::cout << "Enter your choice: ";
-        std::cin >> choice;
-
-        if (std::cin.fail()) {
-            std::cout << "Invalid input. Please enter a number.\n";
-            std::cin.clear();
-            ignoreLine();
-            std::cout << "Press Enter to continue...";
-            ignoreLine();
-            continue;
-        }
-        ignoreLine();
+    // Field accessors. For students roleData is the student ID.
+    StrView name(UserHandle user) const { return field(names, user); }
+    StrView email(UserHandle user) const { return field(emails, user); }
+    StrView phone(UserHandle user) const { return field(phones, user); }
+    StrView roleSpecificData(UserHandle user) const { return field(roleData, user); }
+    Role role(UserHandle user) const {
+        std::shared_lock<std::shared_timed_mutex> lock(mutex);
+        return static_cast<Role>(roles[user]);
+    }
 
-        switch (choice) {
-            case 1: displayTeacherMeetings(); break;
-            case 2: handleResultUpload(); break;
-            case 3: handleAttendanceTaking(); break;
-            case 4: viewStudentComplaints(); break;
-            case 5: viewStudentLeaveNotices(); break;
-            case 6:
-                std::cout << "Logging out...\n";
-                 std::cout << "Press Enter to return to main menu...";
-                std::cin.get();
-                return; // Exit the teacher dashboard loop
-            default:
-                std::cout << "Invalid choice. Please try again.\n";
-                break;
-        }
-         if (choice != 6) {
-             std::cout << "\nPress Enter to return to the Teacher Dashboard...";
-             std::cin.get();
-        }
+    // A hash in the form verifyPassword reads, or a plaintext password
+    // saved by an older build
+    StrView storedPassword(UserHandle user) const { return field(passwords, user); }
+
+    // The old bytes stay in the arena (StrViews of them may be in use)
+    void setStoredPassword(UserHandle user, const std::string& stored) {
+        std::unique_lock<std::shared_timed_mutex> lock(mutex);
+        passwords[user] = arena.store(stored.data(), stored.size());
     }
-}
 
-void displayTeacherMeetings() {
-    clearScreen();
-    std::cout << "--- Scheduled/Announced Meetings ---\n";
-    std::cout << "1. Department Faculty Meeting\n";
-    std::cout << "   Date: 18 February, 2024\n";
-    std::cout << "   Time: 03:00 PM\n";
-    std::cout << "   Venue: Staff Room\n\n";
-    std::cout << "2. Curriculum Review Committee\n";
-    std::cout << "   Date: 25 February, 2024\n";
-    std::cout << "   Time: 11:00 AM\n";
-    std::cout << "   Venue: Conference Hall\n\n";
-    std::cout << "3. [Placeholder for adding new meetings]\n";
-    std::cout << "-------------------------------------\n";
-    // Could add functionality here for teachers to add new meetings
-}
-
-void handleResultUpload() {
-    clearScreen();
-    std::string subjectName;
-    std::string filePath;
-    std::cout << "--- Upload Student Results ---\n";
-    std::cout << "Enter Subject Name: ";
-    std::getline(std::cin, subjectName);
-    std::cout << "Enter path to results file (e.g., C:\\results\\DS_results.csv): ";
-    std::getline(std::cin, filePath);
-    std::cout << "\n--- Simulation ---\n";
-    std::cout << "Simulating upload of results for subject '" << subjectName << "' from file '" << filePath << "'.\n";
-    std::cout << "In a real application, the file would be processed and data stored.\n";
-    std::cout << "Results are now considered 'uploaded' for students to view (in this simulation).\n";
-     std::cout << "-----------------------------\n";
-}
+    // A full copy of one record, for saving it
+    User get(UserHandle user) const {
+        std::shared_lock<std::shared_timed_mutex> lock(mutex);
+        return {arena.view(names[user]).str(), arena.view(emails[user]).str(), arena.view(passwords[user]).str(),
+                arena.view(phones[user]).str(), static_cast<Role>(roles[user]), arena.view(roleData[user]).str()};
+    }
 
-void handleAttendanceTaking() {
-    clearScreen();
-    std::string subjectName;
-    std::string date;
-    char presentChoice;
-    std::map<std::string, bool> attendanceRecord; // Map email to present status
-
-    std::cout << "--- Take Attendance ---\n";
-    std::cout << "Enter Subject Name: ";
-    std::getline(std::cin, subjectName);
-    std::cout << "Enter Date (e.g., 15 Feb 2024): ";
-    std::getline(std::cin, date);
-    std::cout << "----------------------\n";
-    std::cout << "Mark Attendance (P=Present, A=Absent):\n";
-
-    int studentCount = 0;
-    for (const auto& user : users) {
-        if (user.role == Role::STUDENT) {
-            studentCount++;
-            std::cout << "- " << user.name << " (" << user.roleSpecificData << "): ";
-            while (true) {
-                std::cin >> presentChoice;
-                presentChoice = tolower(presentChoice);
-                if (presentChoice == 'p' || presentChoice == 'a') {
-                    attendanceRecord[user.email] = (presentChoice == 'p'); // Store true if present, false if absent
-                    ignoreLine(); // Consume newline after single char input
-                    break;
-                } else {
-                    std::cout << "Invalid input. Enter 'p' or 'a': ";
-                    std::cin.clear();
-                    ignoreLine();
-                }
-            }
+    // Students are also numbered 0..studentCount()-1 in registration order,
+    // so per-student data (attendance bits, grades) can live in dense arrays
+    size_t studentCount() const {
+        std::shared_lock<std::shared_timed_mutex> lock(mutex);
+        return studentUsers.size();
+    }
+    uint32_t studentSlot(UserHandle user) const {
+        std::shared_lock<std::shared_timed_mutex> lock(mutex);
+        return studentSlots[user];
+    }
+    UserHandle userOfStudent(uint32_t slot) const {
+        std::shared_lock<std::shared_timed_mutex> lock(mutex);
+        return studentUsers[slot];
+    }
+
+    // Calls visit(slot, user, studentId) for every student under one read
+    // lock; keep the visitor short since registrations wait for it
+    template <typename Visit>
+    void forEachStudent(Visit visit) const {
+        std::shared_lock<std::shared_timed_mutex> lock(mutex);
+        for (uint32_t slot = 0; slot < studentUsers.size(); slot++) {
+            UserHandle user = studentUsers[slot];
+            visit(slot, user, arena.view(roleData[user]));
         }
     }
 
-    if (studentCount == 0) {
-        std::cout << "No students found to take attendance for.\n";
-    } else {
-        std::cout << "\n--- Attendance Summary (" << subjectName << " - " << date << ") ---\n";
-        for(const auto& pair : attendanceRecord) {
-            std::string studentName = "Unknown";
-            // Find student name again (could optimize this)
-            for(const auto& user : users) {
-                if(user.email == pair.first) {
-                    studentName = user.name;
-                    break;
-                }
+    // Student ID and name of each slot in `slots` under one read lock, for
+    // writing out many rows without a lock per field. The views stay valid
+    // (the arena never moves); unknown slots read as empty.
+    void studentLabels(const std::vector<uint32_t>& slots, std::vector<StrView>& ids,
+                       std::vector<StrView>& studentNames) const {
+        ids.resize(slots.size());
+        studentNames.resize(slots.size());
+        std::shared_lock<std::shared_timed_mutex> lock(mutex);
+        for (size_t i = 0; i < slots.size(); i++) {
+            if (slots[i] >= studentUsers.size()) {
+                ids[i] = studentNames[i] = StrView{"", 0};
+                continue;
             }
-            std::cout << studentName << ": " << (pair.second ? "Present" : "Absent") << "\n";
+            UserHandle user = studentUsers[slots[i]];
+            ids[i] = arena.view(roleData[user]);
+            studentNames[i] = arena.view(names[user]);
         }
-        std::cout << "--------------------------------------------------------\n";
-        std::cout << "Attendance Recorded (Simulated Save).\n";
-        // In a real system, this map would be saved to a database/file.
     }
-     std::cout << "----------------------\n";
-}
 
-
-void viewStudentComplaints() {
-    clearScreen();
-    std::cout << "--- Received Student Complaints ---\n";
-    if (studentComplaints.empty()) {
-        std::cout << "No complaints have been submitted yet.\n";
-    } else {
-        int count = 1;
-        for (const auto& complaint : studentComplaints) {
-            std::cout << count++ << ". From: " << complaint.studentName << " (" << complaint.studentEmail << ")\n";
-            std::cout << "   Complaint: " << complaint.message << "\n";
-            std::cout << "---------------------------------------\n";
+    // Users registered before `limit` whose role bit (1 << role) is in
+    // roleMask, found by scanning the one-byte role column
+    void usersWithRoles(uint8_t roleMask, UserHandle limit, std::vector<UserHandle>& found) const {
+        std::shared_lock<std::shared_timed_mutex> lock(mutex);
+        size_t count = std::min<size_t>(limit, roles.size());
+        for (UserHandle user = 0; user < count; user++) {
+            if (roleMask & (1u << roles[user])) found.push_back(user);
         }
     }
-     std::cout << "-----------------------------------\n";
-}
 
-void viewStudentLeaveNotices() {
-    clearScreen();
-    std::cout << "--- Received Student Leave Notices ---\n";
-    if (studentLeaveNotices.empty()) {
-        std::cout << "No leave notices have been submitted yet.\n";
-    } else {
-        int count = 1;
-        for (const auto& notice : studentLeaveNotices) {
-            std::cout << count++ << ". From: " << notice.studentName << " (" << notice.studentEmail << ")\n";
-            std::cout << "   Dates: " << notice.dates << "\n";
-            std::cout << "   Reason: " << notice.reason << "\n";
-            std::cout << "----------------------------------------\n";
+    UserHandle findByEmail(const std::string& email) const {
+        std::string key = normalizeEmail(email);
+        std::shared_lock<std::shared_timed_mutex> lock(mutex);
+        return findLocked(emailIndex, emails, key);
+    }
+
+    UserHandle findByStudentId(const std::string& studentId) const {
+        std::string key = normalizeStudentId(studentId);
+        if (key.empty()) return npos;
+        std::shared_lock<std::shared_timed_mutex> lock(mutex);
+        return findLocked(studentIdIndex, roleData, key);
+    }
+
+    // Resolves many IDs at once (count <= MAX_ID_BATCH), given as slices of
+    // a larger buffer; nothing is allocated. The batch is walked
+    // three times - hash, peek at the slot, compare - with prefetches in
+    // between, so the cache misses of all lookups overlap instead of being
+    // paid one after another. Used by bulk loaders such as the results upload.
+    // Reports student slots (NO_STUDENT_SLOT when unknown), read under the
+    // same lock as the lookup.
+    static const size_t MAX_ID_BATCH = 32;
+
+    void findStudentSlots(const StrView* ids, size_t count, uint32_t* found) const {
+        char keys[MAX_ID_BATCH][64];
+        size_t lengths[MAX_ID_BATCH];
+        uint64_t hashes[MAX_ID_BATCH];
+        for (size_t i = 0; i < count; i++) {
+            const char* text = ids[i].data;
+            size_t length = ids[i].size;
+            trimSlice(text, length);
+            if (length > sizeof(keys[i])) length = 0; // Too long to be an ID
+            for (size_t c = 0; c < length; c++) keys[i][c] = asciiUpper(text[c]);
+            lengths[i] = length;
+            hashes[i] = hashBytes(keys[i], length);
+        }
+        // The index's slots may move in a rehash, so even the prefetch is
+        // done under the lock
+        std::shared_lock<std::shared_timed_mutex> lock(mutex);
+        for (size_t i = 0; i < count; i++) studentIdIndex.prefetch(hashes[i]);
+        for (size_t i = 0; i < count; i++) {
+            uint32_t candidate = studentIdIndex.firstCandidate(hashes[i]);
+            if (candidate != OpenHashIndex::npos) PREFETCH(&roleData[candidate]);
+        }
+        for (size_t i = 0; i < count; i++) {
+            StrView key{keys[i], lengths[i]};
+            uint32_t index = key.size == 0 ? OpenHashIndex::npos : studentIdIndex.find(hashes[i], [&](uint32_t candidate) {
+                StrView id = arena.view(roleData[candidate]);
+                return id.size == key.size && memcmp(id.data, key.data, key.size) == 0;
+            });
+            found[i] = index == OpenHashIndex::npos ? NO_STUDENT_SLOT : studentSlots[index];
         }
     }
-     std::cout << "--------------------------------------\n";
-}
 
+    // Adds a user; refuses duplicate emails and duplicate student IDs.
+    // The stored email (and student ID) is kept in normalized form.
+    bool add(User user) {
+        user.email = normalizeEmail(user.email);
+        bool isStudent = user.role == Role::STUDENT;
+        if (isStudent) user.roleSpecificData = normalizeStudentId(user.roleSpecificData);
 
-// --- Non-Teaching Staff Dashboard ---
+        std::unique_lock<std::shared_timed_mutex> lock(mutex);
+        if (findLocked(emailIndex, emails, user.email) != npos) return false;
+        if (isStudent && !user.roleSpecificData.empty() &&
+            findLocked(studentIdIndex, roleData, user.roleSpecificData) != npos) return false;
 
-void showNonTeachingStaffDashboard(const User& user) {
-    clearScreen();
-    std::cout << "=====================================\n";
-    std::cout << "   Non-Teaching Staff Dashboard - Welcome " << user.name << "\n";
-    std::cout << "        Role: " << user.roleSpecificData << "\n";
-    std::cout << "=====================================\n";
-    // Add staff-specific options here based on roleSpecificData if needed
-    if (user.roleSpecificData == "Librarian") {
-         std::cout << "1. Manage Books (Not Implemented)\n";
-         std::cout << "2. View Overdue Books (Not Implemented)\n";
-    } else {
-        std::cout << "General staff features not implemented yet.\n";
+        insertLocked(user);
+        return true;
+    }
+
+    // Appends a record that is already normalized and known to be unique
+    // (e.g. read back from our own snapshot), skipping the duplicate checks
+    void addTrusted(const User& user) {
+        std::unique_lock<std::shared_timed_mutex> lock(mutex);
+        insertLocked(user);
+    }
+
+    // Removes the users whose email or student ID is already taken, keeping
+    // the others in order; returns how many were removed. The records must
+    // be normalized, as a roster import makes them.
+    size_t dropRegistered(std::vector<User>& batch) const {
+        std::shared_lock<std::shared_timed_mutex> lock(mutex);
+        auto taken = [&](const User& user) {
+            return findLocked(emailIndex, emails, user.email) != npos ||
+                   (user.role == Role::STUDENT && !user.roleSpecificData.empty() &&
+                    findLocked(studentIdIndex, roleData, user.roleSpecificData) != npos);
+        };
+        size_t before = batch.size();
+        batch.erase(std::remove_if(batch.begin(), batch.end(), taken), batch.end());
+        return before - batch.size();
+    }
+
+    // Appends normalized, unique users under one lock, so other sessions
+    // see either none of them or all of them
+    void addBatch(const std::vector<User>& batch) {
+        std::unique_lock<std::shared_timed_mutex> lock(mutex);
+        reserveLocked(roles.size() + batch.size());
+        for (const User& user : batch) insertLocked(user);
+    }
+
+    // Bytes held by the columns, arena and indexes
+    size_t memoryUsage() const {
+        std::shared_lock<std::shared_timed_mutex> lock(mutex);
+        size_t columns = (names.capacity() + emails.capacity() + phones.capacity() + passwords.capacity() +
+                          roleData.capacity() + interned.capacity()) * sizeof(PackedString) +
+                         roles.capacity() + (studentSlots.capacity() + studentUsers.capacity()) * sizeof(uint32_t);
+        return columns + arena.memoryUsage() + emailIndex.memoryUsage() + studentIdIndex.memoryUsage() +
+               internIndex.memoryUsage();
+    }
+
+private:
+    mutable std::shared_timed_mutex mutex;
+    StringArena arena;
+    std::vector<PackedString> names;
+    std::vector<PackedString> emails;
+    std::vector<PackedString> phones;
+    std::vector<PackedString> passwords;
+    std::vector<PackedString> roleData;  // Student ID, or an interned staff value
+    std::vector<uint8_t> roles;          // Role, one byte per user
+    std::vector<uint32_t> studentSlots;  // Per user: student slot or NO_STUDENT_SLOT
+    std::vector<uint32_t> studentUsers;  // Per student slot: user
+    OpenHashIndex emailIndex;
+    OpenHashIndex studentIdIndex;
+    OpenHashIndex internIndex;           // Hash of an interned value -> position in `interned`
+    std::vector<PackedString> interned;
+
+    void reserveLocked(size_t count) {
+        names.reserve(count);
+        emails.reserve(count);
+        phones.reserve(count);
+        passwords.reserve(count);
+        roleData.reserve(count);
+        roles.reserve(count);
+        studentSlots.reserve(count);
+        emailIndex.reserve(count);
+        studentIdIndex.reserve(count);
     }
-     std::cout << "\nPress Enter to Logout...";
-    std::cin.get(); // Wait for user
-}
\ No newline at end of file
+
+    StrView field(const std::vector<PackedString>& column, UserHandle user) const {
+        std::shared_lock<std::shared_timed_mutex> lock(mutex);
+        return arena.view(column[user]);
+    }
+
+    UserHandle findLocked(const OpenHashIndex& index, const std::vector<PackedString>& column,
+                          const std::string& key) const {
+        uint32_t found = index.find(hashString(key), [&](uint32_t candidate) {
+            return arena.view(column[candidate]) == key;
+        });
+        return found == OpenHashIndex::npos ? npos : found;
+    }
+
+    PackedString intern(const std::string& value) {
+        uint64_t hash = hashString(value);
+        uint32_t found = internIndex.find(hash, [&](uint32_t candidate) {
+            return arena.view(interned[candidate]) == value;
+        });
+        if (found != OpenHashIndex::npos) return interned[found];
+        internIndex.insert(hash, static_cast<uint32_t>(interned.size()));
+        interned.push_back(arena.store(value.data(), value.size()));
+        return interned.back();
+    }
+
+    void insertLocked(const User& user) {
+        UserHandle handle = static_cast<UserHandle>(roles.size());
+        names.push_back(arena.store(user.name.data(), user.name.size()));
+        emails.push_back(arena.store(user.email.data(), user.email.size()));
+        phones.push_back(arena.store(user.phone.data(), user.phone.size()));
+        passwords.push_back(arena.store(user.password.data(), user.password.size()));
+        roles.push_back(static_cast<uint8_t>(user.role));
+        emailIndex.insert(hashString(user.email), handle);
+        if (user.role == Role::STUDENT) {
+            roleData.push_back(arena.store(user.roleSpecificData.data(), user.roleSpecificData.size()));
+            if (!user.roleSpecificData.empty()) studentIdIndex.insert(hashString(user.roleSpecificData), handle);
+            studentSlots.push_back(static_cast<uint32_t>(studentUsers.size()));
+            studentUsers.push_back(handle);
+        } else {
+            roleData.push_back(intern(user.roleSpecificData));
+            studentSlots.push_back(NO_STUDENT_SLOT);
+        }
+    }
+};
+
+// Out-of-class definitions so the constants can be bound to references (C++14)
+const uint32_t OpenHashIndex::npos;
+const size_t StringArena::CHUNK_BITS;
+const size_t StringArena::CHUNK_SIZE;
+const UserHandle UserDirectory::npos;
+const size_t UserDirectory::MAX_ID_BATCH;
+const uint32_t UserDirectory::NO_STUDENT_SLOT;
+
+// --- Password Hashing ---
+// Passwords are kept as PBKDF2-HMAC-SHA256 with a random salt per user and a
+// deliberately slow iteration count, so a copied snapshot or log does not
+// give them away. The stored form is binary and starts with a zero byte,
+// which no typed password can:
+//   0x00 | u8 version (1) | u32 iterations | salt[16] | hash[32]
+// Anything else is a plaintext password from an older build. It is still
+// accepted, and is replaced by a hash the first time its owner logs in (as
+// is a hash made with fewer iterations than passwordIterations).
+
+class Sha256 {
+public:
+    Sha256() : buffered(0), total(0) { memcpy(state, INITIAL, sizeof(state)); }
+
+    // Carries on from a state that has taken `bytes` bytes (a whole number of blocks)
+    Sha256(const uint32_t (&midstate)[8], uint64_t bytes) : buffered(0), total(bytes) {
+        memcpy(state, midstate, sizeof(state));
+    }
+
+    void update(const uint8_t* data, size_t length) {
+        total += length;
+        while (length > 0) {
+            size_t take = std::min(length, sizeof(buffer) - buffered);
+            memcpy(buffer + buffered, data, take);
+            buffered += take;
+            data += take;
+            length -= take;
+            if (buffered == sizeof(buffer)) {
+                compress(state, buffer);
+                buffered = 0;
+            }
+        }
+    }
+
+    void finish(uint8_t (&digest)[32]) {
+        uint64_t bits = total * 8;
+        uint8_t padding[72] = {0x80};
+        size_t padLength = (buffered < 56 ? 56 : 120) - buffered;
+        for (int i = 0; i < 8; i++) padding[padLength + i] = static_cast<uint8_t>(bits >> (56 - 8 * i));
+        update(padding, padLength + 8);
+        storeState(state, digest);
+    }
+
+    static void storeState(const uint32_t (&words)[8], uint8_t* out) {
+        for (int i = 0; i < 8; i++) {
+            out[4 * i] = static_cast<uint8_t>(words[i] >> 24);
+            out[4 * i + 1] = static_cast<uint8_t>(words[i] >> 16);
+            out[4 * i + 2] = static_cast<uint8_t>(words[i] >> 8);
+            out[4 * i + 3] = static_cast<uint8_t>(words[i]);
+        }
+    }
+
+    static void compress(uint32_t (&hash)[8], const uint8_t* block) {
+        static const uint32_t ROUND[64] = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+        uint32_t w[64];
+        for (int i = 0; i < 16; i++) {
+            w[i] = (uint32_t(block[4 * i]) << 24) | (uint32_t(block[4 * i + 1]) << 16) |
+                   (uint32_t(block[4 * i + 2]) << 8) | block[4 * i + 3];
+        }
+        for (int i = 16; i < 64; i++) {
+            uint32_t s0 = rotate(w[i - 15], 7) ^ rotate(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = rotate(w[i - 2], 17) ^ rotate(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        uint32_t a = hash[0], b = hash[1], c = hash[2], d = hash[3], e = hash[4], f = hash[5], g = hash[6], h = hash[7];
+        for (int i = 0; i < 64; i++) {
+            uint32_t t1 = h + (rotate(e, 6) ^ rotate(e, 11) ^ rotate(e, 25)) + ((e & f) ^ (~e & g)) + ROUND[i] + w[i];
+            uint32_t t2 = (rotate(a, 2) ^ rotate(a, 13) ^ rotate(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
+        }
+        hash[0] += a; hash[1] += b; hash[2] += c; hash[3] += d;
+        hash[4] += e; hash[5] += f; hash[6] += g; hash[7] += h;
+    }
+
+    static const uint32_t INITIAL[8];
+
+private:
+    uint32_t state[8];
+    uint8_t buffer[64];
+    size_t buffered;
+    uint64_t total;
+
+    static uint32_t rotate(uint32_t value, int bits) { return (value >> bits) | (value << (32 - bits)); }
+};
+
+const uint32_t Sha256::INITIAL[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                     0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+// PBKDF2-HMAC-SHA256 for one 32-byte block. The HMAC pads are hashed once;
+// after that every iteration is exactly two compressions of a block whose
+// padding never changes.
+void pbkdf2Sha256(const char* password, size_t passwordLength, const uint8_t* salt, size_t saltLength,
+                  uint32_t iterations, uint8_t (&out)[32]) {
+    uint8_t key[64] = {};
+    if (passwordLength > sizeof(key)) {
+        uint8_t digest[32];
+        Sha256 keyHash;
+        keyHash.update(reinterpret_cast<const uint8_t*>(password), passwordLength);
+        keyHash.finish(digest);
+        memcpy(key, digest, sizeof(digest));
+    } else {
+        memcpy(key, password, passwordLength);
+    }
+    uint8_t pad[64];
+    uint32_t inner[8], outer[8];
+    for (int i = 0; i < 64; i++) pad[i] = key[i] ^ 0x36;
+    memcpy(inner, Sha256::INITIAL, sizeof(inner));
+    Sha256::compress(inner, pad);
+    for (int i = 0; i < 64; i++) pad[i] = key[i] ^ 0x5c;
+    memcpy(outer, Sha256::INITIAL, sizeof(outer));
+    Sha256::compress(outer, pad);
+
+    // U1 = HMAC(password, salt || big-endian 1)
+    uint8_t u[32];
+    const uint8_t blockNumber[4] = {0, 0, 0, 1};
+    Sha256 first(inner, 64);
+    first.update(salt, saltLength);
+    first.update(blockNumber, sizeof(blockNumber));
+    first.finish(u);
+    Sha256 firstOuter(outer, 64);
+    firstOuter.update(u, sizeof(u));
+    firstOuter.finish(u);
+    memcpy(out, u, sizeof(u));
+
+    // Later U are HMACs of a 32-byte value: one block after the 64-byte pad
+    uint8_t block[64] = {};
+    memcpy(block, u, sizeof(u));
+    block[32] = 0x80;
+    block[62] = 0x03; // (64 + 32) * 8 = 768 bits
+    for (uint32_t i = 1; i < iterations; i++) {
+        uint32_t state[8];
+        memcpy(state, inner, sizeof(state));
+        Sha256::compress(state, block);
+        Sha256::storeState(state, block);
+        memcpy(state, outer, sizeof(state));
+        Sha256::compress(state, block);
+        Sha256::storeState(state, block);
+        for (int b = 0; b < 32; b++) out[b] ^= block[b];
+    }
+}
+
+const uint32_t DEFAULT_PASSWORD_ITERATIONS = 30000;
+const size_t PASSWORD_SALT_BYTES = 16;
+const size_t PASSWORD_HASH_BYTES = 32;
+const size_t STORED_PASSWORD_SIZE = 2 + 4 + PASSWORD_SALT_BYTES + PASSWORD_HASH_BYTES;
+
+// Iterations for new hashes (--password-iterations); hashes made with fewer
+// are upgraded at the next login
+uint32_t passwordIterations = DEFAULT_PASSWORD_ITERATIONS;
+
+// Imported rosters and plaintext passwords found at startup are hashed this
+// cheaply instead: a 100,000 row roster is then about 2 CPU-minutes rather
+// than 55. Each is raised to passwordIterations at its owner's first login.
+const uint32_t IMPORT_PASSWORD_ITERATIONS = 1000;
+
+inline uint32_t importPasswordIterations() {
+    return std::min(passwordIterations, IMPORT_PASSWORD_ITERATIONS);
+}
+
+inline bool isHashedPassword(StrView stored) {
+    return stored.size == STORED_PASSWORD_SIZE && stored.data[0] == 0 && stored.data[1] == 1;
+}
+
+uint32_t hashIterations(StrView stored) {
+    uint32_t iterations = 0;
+    if (isHashedPassword(stored)) memcpy(&iterations, stored.data + 2, sizeof(iterations));
+    return iterations;
+}
+
+std::string hashPassword(const std::string& password, uint32_t iterations) {
+    std::string stored(STORED_PASSWORD_SIZE, '\0');
+    stored[1] = 1;
+    memcpy(&stored[2], &iterations, sizeof(iterations));
+    static thread_local std::random_device random; // Opened once per thread
+    uint8_t* salt = reinterpret_cast<uint8_t*>(&stored[6]);
+    for (size_t i = 0; i < PASSWORD_SALT_BYTES; i += 4) {
+        uint32_t word = random();
+        memcpy(salt + i, &word, sizeof(word));
+    }
+    uint8_t hash[PASSWORD_HASH_BYTES];
+    pbkdf2Sha256(password.data(), password.size(), salt, PASSWORD_SALT_BYTES, iterations, hash);
+    memcpy(&stored[6 + PASSWORD_SALT_BYTES], hash, sizeof(hash));
+    return stored;
+}
+
+// Compares every byte whatever the first difference, so timing does not
+// tell a guesser how close they were
+inline bool sameBytes(const char* a, const char* b, size_t length) {
+    unsigned char difference = 0;
+    for (size_t i = 0; i < length; i++) difference |= static_cast<unsigned char>(a[i] ^ b[i]);
+    return difference == 0;
+}
+
+bool verifyPassword(StrView stored, const std::string& password) {
+    if (!isHashedPassword(stored)) {
+        return stored.size == password.size() && sameBytes(stored.data, password.data(), password.size());
+    }
+    uint8_t hash[PASSWORD_HASH_BYTES];
+    pbkdf2Sha256(password.data(), password.size(), reinterpret_cast<const uint8_t*>(stored.data + 6),
+                 PASSWORD_SALT_BYTES, hashIterations(stored), hash);
+    return sameBytes(reinterpret_cast<const char*>(hash), stored.data + 6 + PASSWORD_SALT_BYTES, sizeof(hash));
+}
+
+// Failed logins per email in a fixed table of atomic words, so checking and
+// counting never take a lock. A word packs a 16-bit tag from the email's
+// hash, the failure count and the time of the last failure; an email lives
+// in one of the four words of its bucket. When all four hold other emails
+// the one idle longest is replaced, and two threads adding the same email
+// at once may split its count: both err towards letting a login through.
+class LoginThrottle {
+public:
+    static const uint32_t MAX_FAILURES = 5;     // In a row, each within LOCKOUT_SECONDS of the last
+    static const int64_t LOCKOUT_SECONDS = 300;
+
+    LoginThrottle() {
+        for (auto& word : words) word.store(0, std::memory_order_relaxed);
+    }
+
+    // Seconds until the email may try again; 0 when it is not locked out
+    int64_t lockedFor(uint64_t emailHash, int64_t now) const {
+        const std::atomic<uint64_t>* bucket = bucketOf(emailHash);
+        for (size_t w = 0; w < BUCKET_WORDS; w++) {
+            uint64_t word = bucket[w].load(std::memory_order_relaxed);
+            if (word == 0 || tagOf(word) != tag(emailHash)) continue;
+            int64_t since = secondsSince(word, now);
+            return countOf(word) >= MAX_FAILURES && since < LOCKOUT_SECONDS ? LOCKOUT_SECONDS - since : 0;
+        }
+        return 0;
+    }
+
+    void recordFailure(uint64_t emailHash, int64_t now) {
+        std::atomic<uint64_t>* bucket = bucketOf(emailHash);
+        while (true) {
+            size_t victim = 0;
+            int64_t idlest = -1;
+            uint64_t seen[BUCKET_WORDS];
+            for (size_t w = 0; w < BUCKET_WORDS; w++) {
+                seen[w] = bucket[w].load(std::memory_order_relaxed);
+                if (seen[w] != 0 && tagOf(seen[w]) == tag(emailHash)) {
+                    uint32_t count = secondsSince(seen[w], now) < LOCKOUT_SECONDS ? std::min<uint32_t>(countOf(seen[w]) + 1, 0xFFFF) : 1;
+                    if (bucket[w].compare_exchange_weak(seen[w], pack(emailHash, count, now), std::memory_order_relaxed)) return;
+                    idlest = -2; // Changed under us; look again
+                    break;
+                }
+                int64_t idle = seen[w] == 0 ? std::numeric_limits<int64_t>::max() : secondsSince(seen[w], now);
+                if (idle > idlest) {
+                    idlest = idle;
+                    victim = w;
+                }
+            }
+            if (idlest == -2) continue;
+            if (bucket[victim].compare_exchange_weak(seen[victim], pack(emailHash, 1, now), std::memory_order_relaxed)) return;
+        }
+    }
+
+    void recordSuccess(uint64_t emailHash) {
+        std::atomic<uint64_t>* bucket = bucketOf(emailHash);
+        for (size_t w = 0; w < BUCKET_WORDS; w++) {
+            uint64_t word = bucket[w].load(std::memory_order_relaxed);
+            while (word != 0 && tagOf(word) == tag(emailHash) && !bucket[w].compare_exchange_weak(word, 0, std::memory_order_relaxed)) {}
+        }
+    }
+
+private:
+    static const size_t BUCKET_WORDS = 4;
+    static const size_t BUCKET_COUNT = 1 << 12;
+    std::atomic<uint64_t> words[BUCKET_COUNT * BUCKET_WORDS]; // 128 KB
+
+    std::atomic<uint64_t>* bucketOf(uint64_t hash) { return words + (hash & (BUCKET_COUNT - 1)) * BUCKET_WORDS; }
+    const std::atomic<uint64_t>* bucketOf(uint64_t hash) const { return words + (hash & (BUCKET_COUNT - 1)) * BUCKET_WORDS; }
+    static uint64_t tag(uint64_t hash) { return hash >> 48; }
+    static uint64_t tagOf(uint64_t word) { return word >> 48; }
+    static uint32_t countOf(uint64_t word) { return static_cast<uint32_t>(word >> 32) & 0xFFFF; }
+    static uint64_t pack(uint64_t hash, uint32_t count, int64_t now) {
+        return (tag(hash) << 48) | (uint64_t(count) << 32) | static_cast<uint32_t>(now);
+    }
+    // Times are kept to 32 bits, so differences are taken modulo 2^32
+    static int64_t secondsSince(uint64_t word, int64_t now) {
+        return static_cast<int32_t>(static_cast<uint32_t>(now) - static_cast<uint32_t>(word));
+    }
+};
+
+const uint32_t LoginThrottle::MAX_FAILURES;
+const int64_t LoginThrottle::LOCKOUT_SECONDS;
+const size_t LoginThrottle::BUCKET_WORDS;
+const size_t LoginThrottle::BUCKET_COUNT;
+
+// Hashing and checking passwords on a fixed set of threads, so a rush of
+// logins queues for the cores instead of every session thread hashing at
+// once, and a roster's hashes are spread over all of them. A worker that
+// wakes takes its share of everything queued in one go, so a burst of
+// logins costs one lock round trip per worker, not per login. A single
+// task (a login or registration) goes to the front of the queue, so a
+// roster being hashed never makes people wait to sign in. Without started
+// workers (batch runs, benchmarks) the work runs on the caller.
+class PasswordWorkers {
+public:
+    PasswordWorkers() : stopping(false), workerCount(1) {}
+    ~PasswordWorkers() { stop(); }
+    PasswordWorkers(const PasswordWorkers&) = delete;
+    PasswordWorkers& operator=(const PasswordWorkers&) = delete;
+
+    void start(unsigned count) {
+        stop();
+        stopping = false;
+        workerCount = std::max(1u, count);
+        for (unsigned t = 0; t < workerCount; t++) threads.emplace_back(&PasswordWorkers::work, this);
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        jobAdded.notify_all();
+        for (auto& thread : threads) thread.join();
+        threads.clear();
+    }
+
+    size_t threadCount() const { return threads.size(); }
+
+    // Runs task(0) .. task(count - 1) on the workers and returns when all
+    // are done; `urgent` tasks go ahead of everything already queued
+    void runAll(size_t count, const std::function<void(size_t)>& task, bool urgent = false) {
+        if (threads.empty()) {
+            for (size_t i = 0; i < count; i++) task(i);
+            return;
+        }
+        Completion done;
+        done.remaining = count;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (size_t i = 0; i < count; i++) {
+                if (urgent) jobs.push_front(Job{&task, count - 1 - i, &done});
+                else jobs.push_back(Job{&task, i, &done});
+            }
+        }
+        if (count == 1) jobAdded.notify_one();
+        else jobAdded.notify_all();
+        std::unique_lock<std::mutex> lock(done.mutex);
+        done.finished.wait(lock, [&] { return done.remaining == 0; });
+    }
+
+    void run(const std::function<void()>& task) {
+        runAll(1, [&](size_t) { task(); }, true);
+    }
+
+private:
+    struct Completion {
+        std::mutex mutex;
+        std::condition_variable finished;
+        size_t remaining;
+    };
+    struct Job {
+        const std::function<void(size_t)>* task;
+        size_t index;
+        Completion* done;
+    };
+
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable jobAdded;
+    std::deque<Job> jobs;
+    bool stopping;
+    unsigned workerCount;
+
+    void work() {
+        std::vector<Job> taken;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                jobAdded.wait(lock, [&] { return !jobs.empty() || stopping; });
+                if (jobs.empty()) return;
+                size_t share = std::max<size_t>(1, jobs.size() / workerCount); // Leave some for the others
+                taken.assign(jobs.begin(), jobs.begin() + share);
+                jobs.erase(jobs.begin(), jobs.begin() + share);
+            }
+            for (const Job& job : taken) {
+                (*job.task)(job.index);
+                std::lock_guard<std::mutex> lock(job.done->mutex);
+                if (--job.done->remaining == 0) job.done->finished.notify_one();
+            }
+        }
+    }
+};
+
+// --- Bit Counting ---
+// Counts set bits across a whole array of words. With AVX2 this uses the
+// nibble lookup table method (32 bytes per step), otherwise the compiler's
+// popcount builtin, which becomes a single instruction where available.
+inline uint32_t popcount64(uint64_t word) {
+#if defined(__GNUC__)
+    return static_cast<uint32_t>(__builtin_popcountll(word));
+#else
+    word = word - ((word >> 1) & 0x5555555555555555ULL);
+    word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+    word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast<uint32_t>((word * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+uint64_t popcountWords(const uint64_t* words, size_t count) {
+    uint64_t total = 0;
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i lowMask = _mm256_set1_epi8(0x0F);
+    __m256i sums = _mm256_setzero_si256();
+    for (; i + 4 <= count; i += 4) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words + i));
+        __m256i low = _mm256_shuffle_epi8(lookup, _mm256_and_si256(block, lowMask));
+        __m256i high = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(block, 4), lowMask));
+        sums = _mm256_add_epi64(sums, _mm256_sad_epu8(_mm256_add_epi8(low, high), _mm256_setzero_si256()));
+    }
+    uint64_t lanes[4];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), sums);
+    total = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+    for (; i < count; i++) total += popcount64(words[i]);
+    return total;
+}
+
+// --- Subject Catalog ---
+// Subjects are shared by attendance, results and enrollment and referred to
+// by a small id. Names are matched case-insensitively; the first spelling is kept.
+// Shared by server sessions, so it locks internally; names never move once added.
+class SubjectCatalog {
+public:
+    static const uint32_t npos = 0xFFFFFFFFu;
+
+    SubjectCatalog() = default;
+    SubjectCatalog(const SubjectCatalog&) = delete;
+    SubjectCatalog& operator=(const SubjectCatalog&) = delete;
+
+    SubjectCatalog& operator=(SubjectCatalog&& other) {
+        std::unique_lock<std::shared_timed_mutex> lock(mutex);
+        names = std::move(other.names);
+        ids = std::move(other.ids);
+        return *this;
+    }
+
+    uint32_t find(const std::string& name) const {
+        std::string key = normalizeKey(name);
+        std::shared_lock<std::shared_timed_mutex> lock(mutex);
+        auto found = ids.find(key);
+        return found == ids.end() ? npos : found->second;
+    }
+
+    uint32_t add(const std::string& name) {
+        std::string key = normalizeKey(name);
+        std::unique_lock<std::shared_timed_mutex> lock(mutex);
+        auto found = ids.find(key);
+        if (found != ids.end()) return found->second;
+        uint32_t id = static_cast<uint32_t>(names.size());
+        ids[key] = id;
+        names.push_back(name);
+        return id;
+    }
+
+    size_t size() const {
+        std::shared_lock<std::shared_timed_mutex> lock(mutex);
+        return names.size();
+    }
+    const std::string& name(uint32_t id) const {
+        std::shared_lock<std::shared_timed_mutex> lock(mutex);
+        return names[id];
+    }
+
+private:
+    mutable std::shared_timed_mutex mutex;
+    std::deque<std::string> names;
+    std::map<std::string, uint32_t> ids;
+};
+
+const uint32_t SubjectCatalog::npos;
+
+// --- Attendance Store ---
+// Each attendance session (one subject on one date) is two packed bitsets
+// over the dense student slots: who was on the register ("marked") and who
+// was present. Sessions are grouped per subject, so percentage queries are
+// popcounts over contiguous words rather than lookups per student.
+struct AttendanceSession {
+    uint32_t subject;
+    std::string date;               // As entered, e.g. "15 Feb 2024"
+    std::vector<uint64_t> marked;   // Bit per student slot: attendance was taken
+    std::vector<uint64_t> present;  // Bit per student slot: present (subset of marked)
+};
+
+struct AttendanceTally {
+    uint64_t attended;
+    uint64_t held;
+    double percent() const { return held == 0 ? 0.0 : 100.0 * attended / held; }
+};
+
+inline bool testBit(const std::vector<uint64_t>& bits, uint32_t slot) {
+    size_t word = slot / 64;
+    return word < bits.size() && ((bits[word] >> (slot % 64)) & 1);
+}
+
+inline void setBit(std::vector<uint64_t>& bits, uint32_t slot) {
+    if (bits.size() <= slot / 64) bits.resize(slot / 64 + 1, 0);
+    bits[slot / 64] |= 1ULL << (slot % 64);
+}
+
+class AttendanceStore {
+public:
+    static const uint32_t ALL_SUBJECTS = 0xFFFFFFFFu;
+
+    const std::vector<AttendanceSession>& allSessions() const { return sessions; }
+
+    void addSession(AttendanceSession session) {
+        if (subjectSessions.size() <= session.subject) subjectSessions.resize(session.subject + 1);
+        subjectSessions[session.subject].push_back(static_cast<uint32_t>(sessions.size()));
+        sessions.push_back(std::move(session));
+    }
+
+    // One student in one subject: a bit test per session of that subject
+    AttendanceTally studentTally(uint32_t slot, uint32_t subject) const {
+        AttendanceTally tally{0, 0};
+        if (subject >= subjectSessions.size()) return tally;
+        for (uint32_t id : subjectSessions[subject]) {
+            const AttendanceSession& session = sessions[id];
+            if (testBit(session.marked, slot)) {
+                tally.held++;
+                if (testBit(session.present, slot)) tally.attended++;
+            }
+        }
+        return tally;
+    }
+
+    // Every student together in one subject (or ALL_SUBJECTS)
+    AttendanceTally collegeTally(uint32_t subject) const {
+        AttendanceTally tally{0, 0};
+        auto add = [&](const AttendanceSession& session) {
+            tally.held += popcountWords(session.marked.data(), session.marked.size());
+            tally.attended += popcountWords(session.present.data(), session.present.size());
+        };
+        if (subject == ALL_SUBJECTS) {
+            for (const auto& session : sessions) add(session);
+        } else if (subject < subjectSessions.size()) {
+            for (uint32_t id : subjectSessions[subject]) add(sessions[id]);
+        }
+        return tally;
+    }
+
+    // Per-student attended/held counts over all sessions, for shortage
+    // reports. Counts are kept "vertically": plane k holds bit k of 64
+    // students' counts per word, so adding a session is a ripple-carry add
+    // over whole words. Students are processed a block of words at a time so
+    // the counter planes stay in L1 cache while every session streams past.
+    void tallyAllStudents(size_t studentCount, std::vector<uint32_t>& attended, std::vector<uint32_t>& held) const {
+        attended.assign(studentCount, 0);
+        held.assign(studentCount, 0);
+        size_t words = (studentCount + 63) / 64;
+        for (size_t base = 0; base < words; base += COUNTER_BLOCK) {
+            uint64_t attendedPlanes[COUNTER_PLANES][COUNTER_BLOCK] = {};
+            uint64_t heldPlanes[COUNTER_PLANES][COUNTER_BLOCK] = {};
+            for (const auto& session : sessions) {
+                addToCounters(heldPlanes, session.marked, base);
+                addToCounters(attendedPlanes, session.present, base);
+            }
+            readCounters(attendedPlanes, base, attended);
+            readCounters(heldPlanes, base, held);
+        }
+    }
+
+private:
+    static const size_t COUNTER_BLOCK = 8;   // Words (512 students) per pass
+    static const size_t COUNTER_PLANES = 32; // Counts up to 2^32 sessions
+
+    std::vector<std::vector<uint32_t>> subjectSessions; // Session ids per subject
+    std::vector<AttendanceSession> sessions;
+
+    static void addToCounters(uint64_t planes[][COUNTER_BLOCK], const std::vector<uint64_t>& bits, size_t base) {
+        uint64_t carry[COUNTER_BLOCK];
+        for (size_t w = 0; w < COUNTER_BLOCK; w++) carry[w] = base + w < bits.size() ? bits[base + w] : 0;
+        for (size_t k = 0; k < COUNTER_PLANES; k++) {
+            uint64_t any = 0;
+            for (size_t w = 0; w < COUNTER_BLOCK; w++) {
+                uint64_t overflow = planes[k][w] & carry[w];
+                planes[k][w] ^= carry[w];
+                carry[w] = overflow;
+                any |= overflow;
+            }
+            if (any == 0) return;
+        }
+    }
+
+    static void readCounters(const uint64_t planes[][COUNTER_BLOCK], size_t base, std::vector<uint32_t>& counts) {
+        for (size_t w = 0; w < COUNTER_BLOCK; w++) {
+            for (size_t bit = 0; bit < 64; bit++) {
+                size_t slot = (base + w) * 64 + bit;
+                if (slot >= counts.size()) return;
+                uint32_t count = 0;
+                for (size_t k = 0; k < COUNTER_PLANES; k++) {
+                    count |= static_cast<uint32_t>((planes[k][w] >> bit) & 1) << k;
+                }
+                counts[slot] = count;
+            }
+        }
+    }
+};
+
+const uint32_t AttendanceStore::ALL_SUBJECTS;
+
+// --- Enrollment ---
+// Which students take which subject. A section is simply a subject of its
+// own (e.g. "CS101 - A"). Each roster is a sorted array of student slots, so
+// calling the roll for a 60-student section walks 60 contiguous entries and
+// enrolling or dropping only shifts that one roster.
+class EnrollmentStore {
+public:
+    // Empty when nobody has been enrolled in the subject
+    const std::vector<uint32_t>& roster(uint32_t subject) const {
+        static const std::vector<uint32_t> none;
+        return subject < rosters.size() ? rosters[subject] : none;
+    }
+
+    size_t subjectCount() const { return rosters.size(); }
+
+    bool isEnrolled(uint32_t subject, uint32_t slot) const {
+        const std::vector<uint32_t>& list = roster(subject);
+        return std::binary_search(list.begin(), list.end(), slot);
+    }
+
+    // Adds the slots not already on the roster; returns how many were new.
+    // The batch is sorted and merged in one pass rather than inserted one by one.
+    size_t enroll(uint32_t subject, std::vector<uint32_t> slots) {
+        if (rosters.size() <= subject) rosters.resize(subject + 1);
+        std::vector<uint32_t>& list = rosters[subject];
+        std::sort(slots.begin(), slots.end());
+        slots.erase(std::unique(slots.begin(), slots.end()), slots.end());
+        size_t before = list.size();
+        size_t middle = list.size();
+        for (uint32_t slot : slots) {
+            if (!std::binary_search(list.begin(), list.begin() + middle, slot)) list.push_back(slot);
+        }
+        std::inplace_merge(list.begin(), list.begin() + middle, list.end());
+        return list.size() - before;
+    }
+
+    // Removes the given slots; returns how many were on the roster
+    size_t drop(uint32_t subject, std::vector<uint32_t> slots) {
+        if (subject >= rosters.size()) return 0;
+        std::vector<uint32_t>& list = rosters[subject];
+        std::sort(slots.begin(), slots.end());
+        size_t before = list.size();
+        list.erase(std::remove_if(list.begin(), list.end(), [&](uint32_t slot) {
+            return std::binary_search(slots.begin(), slots.end(), slot);
+        }), list.end());
+        return before - list.size();
+    }
+
+private:
+    std::vector<std::vector<uint32_t>> rosters; // Sorted student slots per subject
+};
+
+// --- Calendar ---
+// Events and meetings with real times. Times are minutes since 1970-01-01 on
+// the college's wall clock (no time zone), so a date typed in is stored as is.
+
+int64_t daysFromCivil(int64_t year, unsigned month, unsigned day) {
+    year -= month <= 2;
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    unsigned yearOfEra = static_cast<unsigned>(year - era * 400);
+    unsigned dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + static_cast<int64_t>(dayOfEra) - 719468;
+}
+
+void civilFromDays(int64_t days, int64_t& year, unsigned& month, unsigned& day) {
+    days += 719468;
+    int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    unsigned dayOfEra = static_cast<unsigned>(days - era * 146097);
+    unsigned yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    unsigned dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    unsigned shifted = (5 * dayOfYear + 2) / 153;
+    day = dayOfYear - (153 * shifted + 2) / 5 + 1;
+    month = shifted < 10 ? shifted + 3 : shifted - 9;
+    year = static_cast<int64_t>(yearOfEra) + era * 400 + (month <= 2);
+}
+
+const char* const MONTH_NAMES[12] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                     "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+bool isValidDate(int64_t year, int month, int day) {
+    static const int monthDays[] = {31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    if (month < 1 || month > 12 || day < 1 || day > monthDays[month - 1]) return false;
+    bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    return !(month == 2 && day == 29 && !leap);
+}
+
+// "2024-03-20 09:30"
+bool parseCalendarTime(const std::string& text, int64_t& minutes) {
+    int year, month, day, hour, minute;
+    char extra;
+    if (sscanf(text.c_str(), " %d-%d-%d %d:%d %c", &year, &month, &day, &hour, &minute, &extra) != 5) return false;
+    if (!isValidDate(year, month, day) || hour < 0 || hour > 23 || minute < 0 || minute > 59) return false;
+    minutes = daysFromCivil(year, month, day) * 1440 + hour * 60 + minute;
+    return true;
+}
+
+// "20 Mar 2024"
+std::string formatDay(int64_t days) {
+    int64_t year;
+    unsigned month, day;
+    civilFromDays(days, year, month, day);
+    char text[32];
+    snprintf(text, sizeof(text), "%02u %s %lld", day, MONTH_NAMES[month - 1], static_cast<long long>(year));
+    return text;
+}
+
+std::string formatCalendarTime(int64_t minutes) {
+    int64_t days = minutes >= 0 ? minutes / 1440 : (minutes - 1439) / 1440;
+    int64_t minuteOfDay = minutes - days * 1440;
+    char time[16];
+    snprintf(time, sizeof(time), ", %02d:%02d", static_cast<int>(minuteOfDay / 60), static_cast<int>(minuteOfDay % 60));
+    return formatDay(days) + time;
+}
+
+const int64_t MAX_LEAVE_DAYS = 120; // Longest range read: about a semester
+
+// Reads leave dates such as "25 Feb 2024", "25-27 Feb 2024", "28 Feb - 2 Mar
+// 2024", "Feb 25-27, 2024" or "2024-02-25 to 2024-02-27" into an inclusive
+// range of at most MAX_LEAVE_DAYS days. A missing year means referenceYear.
+// A range that ends before it starts is refused (e.g. "3-1 Mar"), except
+// that "28 Dec - 2 Jan 2025" starts in the year before.
+bool parseDayRange(const std::string& text, int64_t referenceYear, int64_t& firstDay, int64_t& lastDay) {
+    struct Token {
+        bool isMonth;
+        int64_t value;
+    };
+    std::vector<Token> tokens;
+    bool anyMonth = false;
+    for (size_t i = 0; i < text.size();) {
+        char c = text[i];
+        if (isdigit(static_cast<unsigned char>(c))) {
+            int64_t value = 0;
+            size_t digits = 0;
+            for (; i < text.size() && isdigit(static_cast<unsigned char>(text[i])); i++, digits++) {
+                value = value * 10 + (text[i] - '0');
+            }
+            if (digits > 4) return false;
+            if (i + 1 < text.size() && isalpha(static_cast<unsigned char>(text[i]))) { // 1st, 2nd, 3rd, 25th
+                std::string suffix = normalizeKey(text.substr(i, 2));
+                if (suffix == "st" || suffix == "nd" || suffix == "rd" || suffix == "th") i += 2;
+            }
+            tokens.push_back({false, value});
+        } else if (isalpha(static_cast<unsigned char>(c))) {
+            size_t start = i;
+            while (i < text.size() && isalpha(static_cast<unsigned char>(text[i]))) i++;
+            std::string word = normalizeKey(text.substr(start, i - start));
+            if (word == "to" || word == "till" || word == "until" || word == "from" || word == "and") continue;
+            int month = 0;
+            for (int m = 0; m < 12 && word.size() >= 3; m++) {
+                if (word.compare(0, 3, normalizeKey(MONTH_NAMES[m])) == 0) month = m + 1;
+            }
+            if (month == 0) return false; // e.g. "next Monday"
+            tokens.push_back({true, month});
+            anyMonth = true;
+        } else {
+            i++; // Separators: spaces, '-', ',', '/', '.'
+        }
+    }
+
+    struct Part {
+        int64_t day;
+        int64_t month;
+        int64_t year;
+    };
+    Part parts[2];
+    size_t count = 0;
+    if (!anyMonth) {
+        // All numbers: D/M/Y or Y-M-D, once or twice
+        if (tokens.size() != 3 && tokens.size() != 6) return false;
+        for (size_t t = 0; t < tokens.size(); t += 3) {
+            bool yearFirst = tokens[t].value >= 1000;
+            parts[count++] = {yearFirst ? tokens[t + 2].value : tokens[t].value, tokens[t + 1].value,
+                              yearFirst ? tokens[t].value : tokens[t + 2].value};
+        }
+    } else {
+        int64_t leadingMonth = 0; // "Feb 25-27": a month before its days
+        for (const Token& token : tokens) {
+            if (token.isMonth) {
+                bool assigned = false;
+                for (size_t p = 0; p < count; p++) {
+                    if (parts[p].month == 0) {
+                        parts[p].month = token.value;
+                        assigned = true;
+                    }
+                }
+                leadingMonth = assigned ? 0 : token.value;
+            } else if (token.value >= 1000) {
+                for (size_t p = 0; p < count; p++) {
+                    if (parts[p].year == 0) parts[p].year = token.value;
+                }
+            } else {
+                if (count == 2) return false;
+                parts[count++] = {token.value, leadingMonth, 0};
+            }
+        }
+    }
+    if (count == 0) return false;
+
+    int64_t days[2];
+    for (size_t p = 0; p < count; p++) {
+        if (parts[p].year == 0) parts[p].year = referenceYear;
+        if (parts[p].month > 12 || !isValidDate(parts[p].year, static_cast<int>(parts[p].month), static_cast<int>(parts[p].day))) {
+            return false;
+        }
+        days[p] = daysFromCivil(parts[p].year, static_cast<unsigned>(parts[p].month), static_cast<unsigned>(parts[p].day));
+    }
+    firstDay = days[0];
+    lastDay = count == 2 ? days[1] : days[0];
+    if (firstDay > lastDay && count == 2 && parts[0].year == parts[1].year && parts[0].month > parts[1].month) {
+        // "28 Dec - 2 Jan 2025": the shared year belongs to the end
+        if (!isValidDate(parts[0].year - 1, static_cast<int>(parts[0].month), static_cast<int>(parts[0].day))) return false;
+        firstDay = daysFromCivil(parts[0].year - 1, static_cast<unsigned>(parts[0].month), static_cast<unsigned>(parts[0].day));
+    }
+    return firstDay <= lastDay && lastDay - firstDay < MAX_LEAVE_DAYS;
+}
+
+// A Unix (UTC) time as seconds since 1970-01-01 on the college's wall clock
+int64_t wallClockSeconds(std::time_t time) {
+    std::tm local;
+#ifdef _WIN32
+    localtime_s(&local, &time);
+#else
+    localtime_r(&time, &local);
+#endif
+    return daysFromCivil(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday) * 86400 + local.tm_hour * 3600 +
+           local.tm_min * 60 + local.tm_sec;
+}
+
+int64_t wallClockSeconds() {
+    return wallClockSeconds(std::time(nullptr));
+}
+
+int64_t calendarNow() {
+    return wallClockSeconds() / 60;
+}
+
+// Half-open intervals [start, end) in a treap ordered by start; every node
+// also knows the latest end in its subtree, so a search can skip any
+// subtree that finishes before the range begins. Finding one overlap is
+// O(log n); listing k overlaps is O(log n + k).
+class IntervalIndex {
+public:
+    static const uint32_t npos = 0xFFFFFFFFu;
+
+    size_t size() const { return nodes.size(); }
+
+    void insert(int64_t start, int64_t end, uint32_t id) {
+        state ^= state << 13; state ^= state >> 7; state ^= state << 17; // xorshift
+        nodes.push_back({start, end, end, id, static_cast<uint32_t>(state), npos, npos});
+        root = insertAt(root, static_cast<uint32_t>(nodes.size() - 1));
+    }
+
+    // Id of some interval overlapping [start, end), or npos
+    uint32_t findOverlap(int64_t start, int64_t end) const {
+        uint32_t node = root;
+        while (node != npos) {
+            const Node& n = nodes[node];
+            if (n.start < end && start < n.end) return n.id;
+            // If anything on the left ends after `start` but none of it
+            // overlaps, it all begins at or after `end` - and so does the right
+            node = n.left != npos && nodes[n.left].maxEnd > start ? n.left : n.right;
+        }
+        return npos;
+    }
+
+    // Ids of every interval overlapping [start, end), in start order
+    void findAll(int64_t start, int64_t end, std::vector<uint32_t>& ids) const { collect(root, start, end, ids); }
+
+private:
+    struct Node {
+        int64_t start;
+        int64_t end;
+        int64_t maxEnd;   // Latest end in this subtree
+        uint32_t id;
+        uint32_t priority;
+        uint32_t left;
+        uint32_t right;
+    };
+    std::vector<Node> nodes;
+    uint32_t root = npos;
+    uint64_t state = 88172645463325252ULL;
+
+    void update(uint32_t node) {
+        Node& n = nodes[node];
+        n.maxEnd = n.end;
+        if (n.left != npos) n.maxEnd = std::max(n.maxEnd, nodes[n.left].maxEnd);
+        if (n.right != npos) n.maxEnd = std::max(n.maxEnd, nodes[n.right].maxEnd);
+    }
+
+    uint32_t insertAt(uint32_t node, uint32_t added) {
+        if (node == npos) return added;
+        if (nodes[added].start < nodes[node].start) {
+            uint32_t child = insertAt(nodes[node].left, added);
+            nodes[node].left = child;
+            if (nodes[child].priority > nodes[node].priority) { // Rotate right
+                nodes[node].left = nodes[child].right;
+                nodes[child].right = node;
+                update(node);
+                update(child);
+                return child;
+            }
+        } else {
+            uint32_t child = insertAt(nodes[node].right, added);
+            nodes[node].right = child;
+            if (nodes[child].priority > nodes[node].priority) { // Rotate left
+                nodes[node].right = nodes[child].left;
+                nodes[child].left = node;
+                update(node);
+                update(child);
+                return child;
+            }
+        }
+        update(node);
+        return node;
+    }
+
+    void collect(uint32_t node, int64_t start, int64_t end, std::vector<uint32_t>& ids) const {
+        if (node == npos || nodes[node].maxEnd <= start) return;
+        const Node& n = nodes[node];
+        collect(n.left, start, end, ids);
+        if (n.start >= end) return; // The right subtree starts even later
+        if (start < n.end) ids.push_back(n.id);
+        collect(n.right, start, end, ids);
+    }
+};
+
+const uint32_t IntervalIndex::npos;
+
+// Who an entry is for: one bit per Role
+enum CalendarAudience : uint8_t {
+    AUDIENCE_STUDENTS = 1 << static_cast<int>(Role::STUDENT),
+    AUDIENCE_TEACHERS = 1 << static_cast<int>(Role::TEACHER),
+    AUDIENCE_STAFF = 1 << static_cast<int>(Role::NON_TEACHING_STAFF),
+    AUDIENCE_EVERYONE = AUDIENCE_STUDENTS | AUDIENCE_TEACHERS | AUDIENCE_STAFF
+};
+
+inline uint8_t audienceOf(Role role) { return static_cast<uint8_t>(1 << static_cast<int>(role)); }
+
+struct CalendarEntry {
+    int64_t start;         // Calendar minutes
+    int64_t end;           // Exclusive
+    uint8_t audience;      // CalendarAudience bits
+    bool isMeeting;
+    std::string title;
+    std::string venue;
+    std::string organizer;
+};
+
+// Every entry is indexed by its venue (a venue can only be booked once at a
+// time) and by each audience group it is for (so a group's upcoming list
+// and its clashes are a single tree search).
+class Calendar {
+public:
+    static const uint32_t npos = IntervalIndex::npos;
+    static const size_t AUDIENCE_GROUPS = 3;
+
+    size_t size() const { return entries.size(); }
+    const CalendarEntry& entry(uint32_t id) const { return entries[id]; }
+
+    // An entry already holding the venue during [start, end), or npos
+    uint32_t venueConflict(const std::string& venue, int64_t start, int64_t end) const {
+        auto found = venueIds.find(normalizeKey(venue));
+        return found == venueIds.end() ? npos : byVenue[found->second].findOverlap(start, end);
+    }
+
+    // An entry for any of the same groups overlapping [start, end), or npos
+    uint32_t audienceConflict(uint8_t audience, int64_t start, int64_t end) const {
+        for (size_t group = 0; group < AUDIENCE_GROUPS; group++) {
+            if (!(audience & (1 << group))) continue;
+            uint32_t clash = byAudience[group].findOverlap(start, end);
+            if (clash != npos) return clash;
+        }
+        return npos;
+    }
+
+    uint32_t add(CalendarEntry entry) {
+        uint32_t id = static_cast<uint32_t>(entries.size());
+        std::string key = normalizeKey(entry.venue);
+        auto found = venueIds.find(key);
+        if (found == venueIds.end()) {
+            found = venueIds.emplace(key, static_cast<uint32_t>(byVenue.size())).first;
+            byVenue.emplace_back();
+        }
+        byVenue[found->second].insert(entry.start, entry.end, id);
+        for (size_t group = 0; group < AUDIENCE_GROUPS; group++) {
+            if (entry.audience & (1 << group)) byAudience[group].insert(entry.start, entry.end, id);
+        }
+        entries.push_back(std::move(entry));
+        return id;
+    }
+
+    // Entries for the given groups that overlap [from, to), by start time
+    void upcoming(uint8_t audience, int64_t from, int64_t to, std::vector<uint32_t>& ids) const {
+        ids.clear();
+        size_t groups = 0;
+        for (size_t group = 0; group < AUDIENCE_GROUPS; group++) {
+            if (!(audience & (1 << group))) continue;
+            byAudience[group].findAll(from, to, ids);
+            groups++;
+        }
+        if (groups > 1) { // An entry for several groups is found once per group
+            std::sort(ids.begin(), ids.end(), [&](uint32_t a, uint32_t b) {
+                return entries[a].start != entries[b].start ? entries[a].start < entries[b].start : a < b;
+            });
+            ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+        }
+    }
+
+private:
+    std::vector<CalendarEntry> entries;
+    std::map<std::string, uint32_t> venueIds;
+    std::vector<IntervalIndex> byVenue;
+    IntervalIndex byAudience[AUDIENCE_GROUPS];
+};
+
+const uint32_t Calendar::npos;
+const size_t Calendar::AUDIENCE_GROUPS;
+
+// --- Alerts ---
+// Announcements pushed to users. An alert's text is stored once; each user
+// has a ring of the latest INBOX_CAPACITY alert ids plus two counters
+// (delivered, seen), kept as flat arrays indexed by user handle. The unread
+// badge is a subtraction, and fanning an alert out to 50k students is one
+// small write per recipient, done a batch at a time under the write lock.
+struct AlertRecord {
+    int64_t postedAt;   // Unix seconds
+    std::string from;
+    std::string text;
+};
+
+class AlertCenter {
+public:
+    static const uint32_t INBOX_CAPACITY = 16;
+
+    AlertCenter() = default;
+    AlertCenter(const AlertCenter&) = delete;
+    AlertCenter& operator=(const AlertCenter&) = delete;
+
+    AlertCenter& operator=(AlertCenter&& other) {
+        std::unique_lock<std::shared_timed_mutex> lock(mutex);
+        alerts = std::move(other.alerts);
+        ring = std::move(other.ring);
+        delivered = std::move(other.delivered);
+        seen = std::move(other.seen);
+        return *this;
+    }
+
+    uint32_t post(AlertRecord record) {
+        std::unique_lock<std::shared_timed_mutex> lock(mutex);
+        alerts.push_back(std::move(record));
+        return static_cast<uint32_t>(alerts.size() - 1);
+    }
+
+    size_t alertCount() const {
+        std::shared_lock<std::shared_timed_mutex> lock(mutex);
+        return alerts.size();
+    }
+    AlertRecord alert(uint32_t id) const {
+        std::shared_lock<std::shared_timed_mutex> lock(mutex);
+        return alerts[id];
+    }
+
+    // Pushes an alert into every recipient's inbox. The lock is released
+    // between batches so dashboards reading their badge are not held up.
+    void deliver(uint32_t alert, const std::vector<UserHandle>& recipients) {
+        if (recipients.empty()) return;
+        UserHandle highest = *std::max_element(recipients.begin(), recipients.end());
+        for (size_t begin = 0; begin < recipients.size(); begin += DELIVERY_BATCH) {
+            size_t end = std::min(recipients.size(), begin + DELIVERY_BATCH);
+            std::unique_lock<std::shared_timed_mutex> lock(mutex);
+            if (delivered.size() <= highest) growLocked(highest + 1);
+            for (size_t i = begin; i < end; i++) {
+                UserHandle user = recipients[i];
+                uint32_t count = delivered[user]++;
+                ring[static_cast<size_t>(user) * INBOX_CAPACITY + count % INBOX_CAPACITY] = alert;
+            }
+        }
+    }
+
+    // Unread alerts still held in the inbox (older ones fall off the ring)
+    uint32_t unreadCount(UserHandle user) const {
+        std::shared_lock<std::shared_timed_mutex> lock(mutex);
+        if (user >= delivered.size()) return 0;
+        return std::min(delivered[user] - seen[user], INBOX_CAPACITY);
+    }
+
+    // The inbox, newest first; returns the delivered count to pass to markSeen
+    uint32_t inbox(UserHandle user, std::vector<uint32_t>& newestFirst, uint32_t& unread) const {
+        newestFirst.clear();
+        unread = 0;
+        std::shared_lock<std::shared_timed_mutex> lock(mutex);
+        if (user >= delivered.size()) return 0;
+        uint32_t count = delivered[user];
+        unread = std::min(count - seen[user], INBOX_CAPACITY);
+        for (uint32_t k = 0; k < std::min(count, INBOX_CAPACITY); k++) {
+            newestFirst.push_back(ring[static_cast<size_t>(user) * INBOX_CAPACITY + (count - 1 - k) % INBOX_CAPACITY]);
+        }
+        return count;
+    }
+
+    void markSeen(UserHandle user, uint32_t deliveredCount) {
+        std::unique_lock<std::shared_timed_mutex> lock(mutex);
+        if (user >= delivered.size()) return;
+        seen[user] = std::max(seen[user], std::min(deliveredCount, delivered[user]));
+    }
+
+    size_t inboxCount() const {
+        std::shared_lock<std::shared_timed_mutex> lock(mutex);
+        return delivered.size();
+    }
+    uint32_t seenCount(UserHandle user) const {
+        std::shared_lock<std::shared_timed_mutex> lock(mutex);
+        return user < seen.size() ? seen[user] : 0;
+    }
+
+    // Puts back an inbox saved with inbox() and seenCount()
+    void restoreInbox(UserHandle user, uint32_t deliveredCount, uint32_t seenCount,
+                      const std::vector<uint32_t>& newestFirst) {
+        std::unique_lock<std::shared_timed_mutex> lock(mutex);
+        if (delivered.size() <= user) growLocked(user + 1);
+        delivered[user] = deliveredCount;
+        seen[user] = seenCount;
+        for (uint32_t k = 0; k < newestFirst.size() && k < INBOX_CAPACITY; k++) {
+            ring[static_cast<size_t>(user) * INBOX_CAPACITY + (deliveredCount - 1 - k) % INBOX_CAPACITY] = newestFirst[k];
+        }
+    }
+
+private:
+    static const size_t DELIVERY_BATCH = 4096;
+
+    mutable std::shared_timed_mutex mutex;
+    std::deque<AlertRecord> alerts;
+    std::vector<uint32_t> ring;      // INBOX_CAPACITY alert ids per user
+    std::vector<uint32_t> delivered; // Per user: alerts ever delivered
+    std::vector<uint32_t> seen;      // Per user: delivered count when last read
+
+    void growLocked(size_t userCount) {
+        size_t capacity = std::max(userCount, delivered.size() * 2); // Amortize growth as users register
+        ring.resize(capacity * INBOX_CAPACITY, 0);
+        delivered.resize(capacity, 0);
+        seen.resize(capacity, 0);
+    }
+};
+
+const uint32_t AlertCenter::INBOX_CAPACITY;
+const size_t AlertCenter::DELIVERY_BATCH;
+
+// Who an alert goes to. Role targets carry the user count at the time of
+// posting, so replaying the log reaches exactly the same users.
+struct AlertTarget {
+    uint8_t roles = 0;                  // CalendarAudience bits; 0 means `users` only
+    UserHandle userLimit = 0;
+    std::vector<UserHandle> users;      // Individuals, e.g. a section roster
+};
+
+// --- Leave Index ---
+// Leave notices by the days they cover, for "who is on leave" lists and for
+// excusing students when the roll is called. Locks internally.
+struct LeaveEntry {
+    int64_t firstDay;
+    int64_t lastDay;     // Inclusive
+    UserHandle student;
+    uint32_t notice;     // Position in studentLeaveNotices
+};
+
+class LeaveIndex {
+public:
+    LeaveIndex() = default;
+    LeaveIndex(const LeaveIndex&) = delete;
+    LeaveIndex& operator=(const LeaveIndex&) = delete;
+
+    LeaveIndex& operator=(LeaveIndex&& other) {
+        std::unique_lock<std::shared_timed_mutex> lock(mutex);
+        entries = std::move(other.entries);
+        byDay = std::move(other.byDay);
+        return *this;
+    }
+
+    void add(const LeaveEntry& entry) {
+        std::unique_lock<std::shared_timed_mutex> lock(mutex);
+        byDay.insert(entry.firstDay, entry.lastDay + 1, static_cast<uint32_t>(entries.size()));
+        entries.push_back(entry);
+    }
+
+    // Entries covering any day in [fromDay, toDay], by first day
+    void find(int64_t fromDay, int64_t toDay, std::vector<LeaveEntry>& found) const {
+        std::vector<uint32_t> ids;
+        std::shared_lock<std::shared_timed_mutex> lock(mutex);
+        byDay.findAll(fromDay, toDay + 1, ids);
+        for (uint32_t id : ids) found.push_back(entries[id]);
+    }
+
+    size_t size() const {
+        std::shared_lock<std::shared_timed_mutex> lock(mutex);
+        return entries.size();
+    }
+
+private:
+    mutable std::shared_timed_mutex mutex;
+    std::vector<LeaveEntry> entries;
+    IntervalIndex byDay;
+};
+
+// --- Case Workflow ---
+// Where each complaint and leave notice stands: a status, the teacher who
+// took it, and the counts the teacher dashboard shows. The counts change
+// with every update, so drawing the dashboard never walks the history.
+// Cases are numbered by position in their list. Guarded by casesLock.
+
+enum CaseKind : uint8_t {
+    CASE_COMPLAINT = 0,
+    CASE_LEAVE = 1
+};
+
+// Complaints go open -> acknowledged -> resolved; leave notices go pending
+// -> approved or rejected. Both kinds share the three slots.
+enum CaseStatus : uint8_t {
+    CASE_OPEN = 0,
+    CASE_ACKNOWLEDGED = 1,
+    CASE_RESOLVED = 2,
+    CASE_PENDING = 0,
+    CASE_APPROVED = 1,
+    CASE_REJECTED = 2
+};
+const uint8_t CASE_STATUS_COUNT = 3;
+
+// Resolved complaints and decided leave notices need no more work
+inline bool caseClosed(CaseKind kind, uint8_t status) {
+    return kind == CASE_COMPLAINT ? status == CASE_RESOLVED : status != CASE_PENDING;
+}
+
+const char* caseStatusName(CaseKind kind, uint8_t status) {
+    static const char* const complaintNames[] = {"Open", "Acknowledged", "Resolved"};
+    static const char* const leaveNames[] = {"Pending", "Approved", "Rejected"};
+    return (kind == CASE_COMPLAINT ? complaintNames : leaveNames)[status % CASE_STATUS_COUNT];
+}
+
+class CaseTracker {
+public:
+    size_t size() const { return status.size(); }
+
+    // New cases at the end of the list start open and unassigned
+    void opened(size_t count) {
+        status.resize(status.size() + count, CASE_OPEN);
+        assignee.resize(status.size(), UserDirectory::npos);
+        perStatus[CASE_OPEN] += count;
+    }
+
+    // Drops or opens cases at the end so the tracker covers `count` records
+    void fit(size_t count) {
+        while (status.size() > count) {
+            tally(static_cast<uint32_t>(status.size() - 1), false);
+            status.pop_back();
+            assignee.pop_back();
+        }
+        if (status.size() < count) opened(count - status.size());
+    }
+
+    // Cases the list has but the tracker has not heard of yet read as open
+    uint8_t statusOf(uint32_t id) const { return id < status.size() ? status[id] : static_cast<uint8_t>(CASE_OPEN); }
+    UserHandle assigneeOf(uint32_t id) const { return id < assignee.size() ? assignee[id] : UserDirectory::npos; }
+
+    // False when there is no such case or status
+    bool update(uint32_t id, uint8_t newStatus, UserHandle newAssignee) {
+        if (id >= status.size() || newStatus >= CASE_STATUS_COUNT) return false;
+        tally(id, false);
+        status[id] = newStatus;
+        assignee[id] = newAssignee;
+        tally(id, true);
+        return true;
+    }
+
+    size_t count(uint8_t s) const { return perStatus[s]; }
+
+    // Acknowledged by the teacher and not yet resolved (complaints only)
+    uint32_t activeFor(UserHandle teacher) const { return teacher < active.size() ? active[teacher] : 0; }
+
+    // Cases added since the teacher last opened the list
+    size_t unreadFor(UserHandle teacher) const {
+        uint32_t upTo = seenBy(teacher);
+        return upTo < status.size() ? status.size() - upTo : 0;
+    }
+    uint32_t seenBy(UserHandle teacher) const { return teacher < seen.size() ? seen[teacher] : 0; }
+
+    void markSeen(UserHandle teacher, uint32_t listSize) {
+        if (teacher == UserDirectory::npos) return;
+        if (seen.size() <= teacher) seen.resize(teacher + 1, 0);
+        seen[teacher] = std::max(seen[teacher], listSize);
+    }
+    size_t seenSlots() const { return seen.size(); }
+
+private:
+    std::vector<uint8_t> status;
+    std::vector<UserHandle> assignee;
+    size_t perStatus[CASE_STATUS_COUNT] = {0, 0, 0};
+    std::vector<uint32_t> active; // Per user: acknowledged cases they hold
+    std::vector<uint32_t> seen;   // Per user: list size when they last looked
+
+    void tally(uint32_t id, bool adding) {
+        if (adding) perStatus[status[id]]++;
+        else perStatus[status[id]]--;
+        UserHandle user = assignee[id];
+        if (user == UserDirectory::npos || status[id] != CASE_ACKNOWLEDGED) return;
+        if (active.size() <= user) active.resize(user + 1, 0);
+        if (adding) active[user]++;
+        else active[user]--;
+    }
+};
+
+// --- Text Search ---
+// Inverted index over one text field of an append-only list (complaint
+// messages, leave reasons). Documents are numbered by their position in the
+// list, so each term's postings are appended in order and stay sorted.
+// Each document also keeps its token ids, so a phrase is checked without
+// going back to the text. Every word must match; hits are ranked with BM25.
+
+struct SearchQuery {
+    std::vector<std::string> words;                 // Lowercased
+    std::vector<std::vector<std::string>> phrases;  // Each a run of lowercased words
+    std::string ownerEmail;                         // from:<email>, normalized; empty for anyone
+    bool empty() const { return words.empty() && phrases.empty() && ownerEmail.empty(); }
+};
+
+struct SearchHit {
+    double score;
+    uint32_t doc;
+};
+
+// Best first; equal scores newest first. Also the order pages are cut in.
+inline bool hitBefore(const SearchHit& a, const SearchHit& b) {
+    return a.score != b.score ? a.score > b.score : a.doc > b.doc;
+}
+
+// Calls visit(word) for each run of letters and digits, lowercased. Bytes
+// above 0x7F count as letters so UTF-8 words stay whole.
+template <typename Visit>
+void forEachWord(const std::string& text, Visit visit) {
+    std::string word;
+    for (size_t i = 0; i <= text.size(); i++) {
+        unsigned char c = i < text.size() ? static_cast<unsigned char>(text[i]) : ' ';
+        if (isalnum(c) || c >= 0x80) {
+            word += static_cast<char>(tolower(c));
+        } else if (!word.empty()) {
+            visit(word);
+            word.clear();
+        }
+    }
+}
+
+// Words, "quoted phrases" and from:email, e.g.  wifi "hostel block" from:a@b.com
+SearchQuery parseSearchQuery(const std::string& text) {
+    SearchQuery query;
+    size_t i = 0;
+    while (i < text.size()) {
+        if (isBlank(text[i])) {
+            i++;
+        } else if (text[i] == '"') {
+            size_t close = text.find('"', i + 1);
+            if (close == std::string::npos) close = text.size();
+            std::vector<std::string> phrase;
+            forEachWord(text.substr(i + 1, close - i - 1), [&](const std::string& word) { phrase.push_back(word); });
+            if (phrase.size() == 1) query.words.push_back(phrase[0]);
+            else if (!phrase.empty()) query.phrases.push_back(phrase);
+            i = close + 1;
+        } else {
+            size_t end = i;
+            while (end < text.size() && !isBlank(text[end])) end++;
+            std::string token = text.substr(i, end - i);
+            if (token.size() > 5 && normalizeKey(token.substr(0, 5)) == "from:") {
+                query.ownerEmail = normalizeEmail(token.substr(5));
+            } else {
+                forEachWord(token, [&](const std::string& word) { query.words.push_back(word); });
+            }
+            i = end;
+        }
+    }
+    return query;
+}
+
+class TextIndex {
+public:
+    TextIndex() = default;
+    TextIndex(const TextIndex&) = delete;
+    TextIndex& operator=(const TextIndex&) = delete;
+
+    TextIndex& operator=(TextIndex&& other) {
+        std::unique_lock<std::shared_timed_mutex> lock(mutex);
+        termIndex = std::move(other.termIndex);
+        terms = std::move(other.terms);
+        postings = std::move(other.postings);
+        tokens = std::move(other.tokens);
+        tokenStart = std::move(other.tokenStart);
+        totalLength = other.totalLength;
+        return *this;
+    }
+
+    // Documents must arrive in list order (doc == documentCount())
+    void add(uint32_t doc, const std::string& text, const std::string& ownerEmail) {
+        std::unique_lock<std::shared_timed_mutex> lock(mutex);
+        while (tokenStart.size() <= doc) tokenStart.push_back(static_cast<uint32_t>(tokens.size())); // Gaps stay empty
+        size_t first = tokens.size();
+        forEachWord(text, [&](const std::string& word) { tokens.push_back(internLocked(word)); });
+        for (size_t t = first; t < tokens.size(); t++) addPostingLocked(tokens[t], doc);
+        addPostingLocked(internLocked(ownerTerm(ownerEmail)), doc);
+        totalLength += tokens.size() - first;
+        tokenStart.push_back(static_cast<uint32_t>(tokens.size()));
+    }
+
+    size_t documentCount() const {
+        std::shared_lock<std::shared_timed_mutex> lock(mutex);
+        return tokenStart.empty() ? 0 : tokenStart.size() - 1;
+    }
+
+    // One page of results after `after` (nullptr for the first page), in
+    // hitBefore order; `total` is the number of matches. An empty query
+    // pages through every document, newest first. `page` is only written
+    // once `after` has been read, so the cursor may point into it.
+    void search(const SearchQuery& query, const SearchHit* after, size_t limit,
+                std::vector<SearchHit>& page, size_t& total) const {
+        total = 0;
+        std::shared_lock<std::shared_timed_mutex> lock(mutex);
+        size_t documents = tokenStart.empty() ? 0 : tokenStart.size() - 1;
+        if (query.empty()) {
+            total = documents;
+            uint32_t doc = after == nullptr ? static_cast<uint32_t>(documents) : after->doc;
+            page.clear();
+            while (doc > 0 && page.size() < limit) page.push_back({0.0, --doc});
+            return;
+        }
+
+        // Required terms; the rarest list drives the intersection
+        std::vector<uint32_t> scored;
+        for (const auto& word : query.words) scored.push_back(findLocked(word));
+        for (const auto& phrase : query.phrases) {
+            for (const auto& word : phrase) scored.push_back(findLocked(word));
+        }
+        std::vector<uint32_t> required = scored;
+        if (!query.ownerEmail.empty()) required.push_back(findLocked(ownerTerm(query.ownerEmail)));
+        for (uint32_t term : required) {
+            if (term == OpenHashIndex::npos) {
+                page.clear();
+                return;
+            }
+        }
+        std::sort(required.begin(), required.end());
+        required.erase(std::unique(required.begin(), required.end()), required.end());
+        std::sort(required.begin(), required.end(), [&](uint32_t a, uint32_t b) {
+            return postings[a].size() < postings[b].size();
+        });
+
+        std::vector<std::vector<uint32_t>> phraseTerms;
+        for (const auto& phrase : query.phrases) {
+            phraseTerms.emplace_back();
+            for (const auto& word : phrase) phraseTerms.back().push_back(findLocked(word));
+        }
+
+        // Weight of each required term per occurrence; 0 for the owner filter
+        std::vector<double> idf(required.size(), 0.0);
+        for (size_t r = 0; r < required.size(); r++) {
+            size_t uses = static_cast<size_t>(std::count(scored.begin(), scored.end(), required[r]));
+            double df = static_cast<double>(postings[required[r]].size());
+            idf[r] = uses * std::log(1.0 + (documents - df + 0.5) / (df + 0.5));
+        }
+
+        double averageLength = documents == 0 ? 1.0 : std::max(1.0, static_cast<double>(totalLength) / documents);
+        std::vector<size_t> cursor(required.size(), 0);
+        std::vector<SearchHit> hits;
+        for (const Posting& lead : postings[required[0]]) {
+            bool all = true;
+            for (size_t r = 1; r < required.size() && all; r++) {
+                const std::vector<Posting>& list = postings[required[r]];
+                // Gallop forward: the lists are sorted by doc
+                size_t step = 1, low = cursor[r];
+                while (low + step < list.size() && list[low + step].doc < lead.doc) step *= 2;
+                auto found = std::lower_bound(list.begin() + low, list.begin() + std::min(list.size(), low + step + 1),
+                                              lead.doc, [](const Posting& p, uint32_t doc) { return p.doc < doc; });
+                cursor[r] = static_cast<size_t>(found - list.begin());
+                all = found != list.end() && found->doc == lead.doc;
+            }
+            if (!all) continue;
+            bool phrasesMatch = true;
+            for (size_t p = 0; p < phraseTerms.size() && phrasesMatch; p++) phrasesMatch = containsRun(lead.doc, phraseTerms[p]);
+            if (!phrasesMatch) continue;
+
+            double length = tokenStart[lead.doc + 1] - tokenStart[lead.doc];
+            double norm = BM25_K1 * (1 - BM25_B + BM25_B * length / averageLength);
+            double score = 0;
+            for (size_t r = 0; r < required.size(); r++) {
+                double tf = r == 0 ? lead.count : postings[required[r]][cursor[r]].count;
+                score += idf[r] * tf * (BM25_K1 + 1) / (tf + norm);
+            }
+            hits.push_back({score, lead.doc});
+        }
+
+        total = hits.size();
+        if (after != nullptr) {
+            hits.erase(std::remove_if(hits.begin(), hits.end(), [&](const SearchHit& hit) {
+                return !hitBefore(*after, hit);
+            }), hits.end());
+        }
+        size_t shown = std::min(limit, hits.size());
+        std::partial_sort(hits.begin(), hits.begin() + shown, hits.end(), hitBefore);
+        page.assign(hits.begin(), hits.begin() + shown);
+    }
+
+private:
+    struct Posting {
+        uint32_t doc;
+        uint32_t count; // Occurrences in the document
+    };
+
+    static constexpr double BM25_K1 = 1.2;
+    static constexpr double BM25_B = 0.75;
+
+    mutable std::shared_timed_mutex mutex;
+    OpenHashIndex termIndex;               // Hash of a term -> term id
+    std::vector<std::string> terms;
+    std::vector<std::vector<Posting>> postings; // Per term, sorted by doc
+    std::vector<uint32_t> tokens;          // Term ids of every document, back to back
+    std::vector<uint32_t> tokenStart;      // Per document: first token; one extra at the end
+    uint64_t totalLength = 0;
+
+    // The owner is indexed as a term no word can produce
+    static std::string ownerTerm(const std::string& email) { return "from:" + email; }
+
+    uint32_t findLocked(const std::string& term) const {
+        return termIndex.find(hashString(term), [&](uint32_t id) { return terms[id] == term; });
+    }
+
+    uint32_t internLocked(const std::string& term) {
+        uint32_t id = findLocked(term);
+        if (id != OpenHashIndex::npos) return id;
+        id = static_cast<uint32_t>(terms.size());
+        terms.push_back(term);
+        postings.emplace_back();
+        termIndex.insert(hashString(term), id);
+        return id;
+    }
+
+    void addPostingLocked(uint32_t term, uint32_t doc) {
+        std::vector<Posting>& list = postings[term];
+        if (!list.empty() && list.back().doc == doc) list.back().count++;
+        else list.push_back({doc, 1});
+    }
+
+    bool containsRun(uint32_t doc, const std::vector<uint32_t>& run) const {
+        uint32_t begin = tokenStart[doc], end = tokenStart[doc + 1];
+        for (uint32_t t = begin; t + run.size() <= end; t++) {
+            if (std::equal(run.begin(), run.end(), tokens.begin() + t)) return true;
+        }
+        return false;
+    }
+};
+
+constexpr double TextIndex::BM25_K1;
+constexpr double TextIndex::BM25_B;
+
+// --- Library ---
+// The librarian's catalog. Book fields are packed into a string arena like
+// the user directory's. A book is found by ISBN through a hash index, and
+// by the start of any title or author word through a prefix trie: its nodes
+// sit in one array (first child / next sibling, children in byte order), so
+// type-ahead walks down the typed prefix and then over the subtree below,
+// stopping as soon as a page of matches is found.
+//
+// Loans refer to books by id and borrowers by user handle. Open loans wait
+// in a timing wheel with one bucket per due day. Asking for the overdue
+// list empties the buckets that have since passed onto that list, so the
+// work is proportional to the loans that fell due, not to every loan ever
+// made. Guarded externally by libraryLock; listing overdue loans turns the
+// wheel, so it needs the lock exclusively.
+struct Loan {
+    uint32_t book;
+    UserHandle borrower;
+    int64_t lentDay;     // Days since 1970-01-01
+    int64_t dueDay;      // Overdue from the day after
+    int64_t returnedDay; // NOT_RETURNED while the book is out
+};
+
+// ISBN-10 or ISBN-13 without hyphens or spaces (a final x is upper-cased);
+// empty when the text is not one
+std::string normalizeIsbn(const std::string& text) {
+    std::string isbn;
+    for (char c : text) {
+        if (c >= '0' && c <= '9') isbn += c;
+        else if ((c == 'x' || c == 'X') && isbn.size() == 9) isbn += 'X';
+        else if (c != '-' && c != ' ') return "";
+    }
+    return isbn.size() == 10 || (isbn.size() == 13 && isbn.back() != 'X') ? isbn : "";
+}
+
+class Library {
+public:
+    static const uint32_t npos = 0xFFFFFFFFu;
+    static const int64_t NOT_RETURNED = -1;
+
+    Library() : nodes(1, TrieNode{npos, npos, npos, 0}) {}
+
+    size_t bookCount() const { return isbns.size(); }
+    StrView isbn(uint32_t book) const { return arena.view(isbns[book]); }
+    StrView title(uint32_t book) const { return arena.view(titles[book]); }
+    StrView author(uint32_t book) const { return arena.view(authors[book]); }
+    uint32_t copies(uint32_t book) const { return copyCounts[book]; }
+    uint32_t available(uint32_t book) const { return copyCounts[book] - lentCounts[book]; }
+
+    // isbn must be normalized
+    uint32_t findIsbn(const std::string& isbn) const {
+        uint32_t found = isbnIndex.find(hashString(isbn), [&](uint32_t book) { return arena.view(isbns[book]) == isbn; });
+        return found == OpenHashIndex::npos ? npos : found;
+    }
+
+    // Adds a title, or more copies of one already in the catalog
+    uint32_t addBook(const std::string& isbn, const std::string& title, const std::string& author, uint32_t copies) {
+        uint32_t book = findIsbn(isbn);
+        if (book != npos) {
+            copyCounts[book] += copies;
+            return book;
+        }
+        book = static_cast<uint32_t>(isbns.size());
+        isbns.push_back(arena.store(isbn.data(), isbn.size()));
+        titles.push_back(arena.store(title.data(), title.size()));
+        authors.push_back(arena.store(author.data(), author.size()));
+        copyCounts.push_back(copies);
+        lentCounts.push_back(0);
+        isbnIndex.insert(hashString(isbn), book);
+        forEachWord(title + " " + author, [&](const std::string& word) { addWord(word, book); });
+        return book;
+    }
+
+    // Up to `limit` books with, for every word of the query, a title or
+    // author word starting with it; in the order of the first word's matches
+    void searchPrefix(const std::string& text, size_t limit, std::vector<uint32_t>& books) const {
+        books.clear();
+        std::vector<std::string> prefixes;
+        forEachWord(text, [&](const std::string& word) { prefixes.push_back(word); });
+        if (prefixes.empty() || limit == 0) return;
+        uint32_t node = 0;
+        for (char c : prefixes[0]) {
+            node = childOf(node, c);
+            if (node == npos) return;
+        }
+        // Depth-first over the subtree, in byte order
+        std::vector<uint32_t> pending(1, node);
+        while (!pending.empty() && books.size() < limit) {
+            uint32_t current = pending.back();
+            pending.pop_back();
+            for (uint32_t p = nodes[current].firstPosting; p != npos && books.size() < limit; p = postings[p].next) {
+                uint32_t book = postings[p].book;
+                if (std::find(books.begin(), books.end(), book) == books.end() && matchesAll(book, prefixes)) {
+                    books.push_back(book);
+                }
+            }
+            size_t firstChild = pending.size();
+            for (uint32_t child = nodes[current].firstChild; child != npos; child = nodes[child].nextSibling) {
+                pending.push_back(child);
+            }
+            std::reverse(pending.begin() + firstChild, pending.end()); // Smallest byte is visited first
+        }
+    }
+
+    size_t loanCount() const { return loans.size(); }
+    const Loan& loan(uint32_t id) const { return loans[id]; }
+
+    // Records a loan (one already returned too, when reloading history)
+    uint32_t addLoan(const Loan& loan) {
+        uint32_t id = static_cast<uint32_t>(loans.size());
+        loans.push_back(loan);
+        byBorrower[loan.borrower].push_back(id);
+        if (loan.returnedDay == NOT_RETURNED) {
+            lentCounts[loan.book]++;
+            openCount++;
+            dueOn[loan.dueDay].push_back(id);
+        }
+        return id;
+    }
+
+    bool returnLoan(uint32_t id, int64_t day) {
+        if (id >= loans.size() || loans[id].returnedDay != NOT_RETURNED) return false;
+        loans[id].returnedDay = day;
+        lentCounts[loans[id].book]--;
+        openCount--;
+        return true; // Left in its bucket or on the overdue list until it is next looked at
+    }
+
+    size_t openLoans() const { return openCount; }
+
+    // Every loan of the borrower, oldest first
+    const std::vector<uint32_t>& loansOf(UserHandle borrower) const {
+        static const std::vector<uint32_t> none;
+        auto found = byBorrower.find(borrower);
+        return found == byBorrower.end() ? none : found->second;
+    }
+
+    // The borrower's open loan of the book, or npos
+    uint32_t openLoan(uint32_t book, UserHandle borrower) const {
+        for (uint32_t id : loansOf(borrower)) {
+            if (loans[id].book == book && loans[id].returnedDay == NOT_RETURNED) return id;
+        }
+        return npos;
+    }
+
+    size_t openLoansOf(UserHandle borrower) const {
+        size_t count = 0;
+        for (uint32_t id : loansOf(borrower)) count += loans[id].returnedDay == NOT_RETURNED;
+        return count;
+    }
+
+    // Open loans due before `today`, longest overdue first
+    const std::vector<uint32_t>& overdue(int64_t today) {
+        while (!dueOn.empty() && dueOn.begin()->first < today) {
+            for (uint32_t id : dueOn.begin()->second) {
+                if (loans[id].returnedDay == NOT_RETURNED) overdueLoans.push_back(id);
+            }
+            dueOn.erase(dueOn.begin());
+        }
+        overdueLoans.erase(std::remove_if(overdueLoans.begin(), overdueLoans.end(),
+                                          [&](uint32_t id) { return loans[id].returnedDay != NOT_RETURNED; }),
+                           overdueLoans.end());
+        return overdueLoans;
+    }
+
+private:
+    struct TrieNode {
+        uint32_t firstChild;
+        uint32_t nextSibling;
+        uint32_t firstPosting; // Books with a word ending here
+        char label;
+    };
+    struct Posting {
+        uint32_t book;
+        uint32_t next;
+    };
+
+    StringArena arena;
+    std::vector<PackedString> isbns;
+    std::vector<PackedString> titles;
+    std::vector<PackedString> authors;
+    std::vector<uint32_t> copyCounts;
+    std::vector<uint32_t> lentCounts;
+    OpenHashIndex isbnIndex;
+    std::vector<TrieNode> nodes; // nodes[0] is the root
+    std::vector<Posting> postings;
+    std::vector<Loan> loans;
+    std::map<UserHandle, std::vector<uint32_t>> byBorrower;
+    std::map<int64_t, std::vector<uint32_t>> dueOn; // Due day -> open loans, for days not yet passed
+    std::vector<uint32_t> overdueLoans;             // In the order they fell due
+    size_t openCount = 0;
+
+    uint32_t childOf(uint32_t node, char label) const {
+        for (uint32_t child = nodes[node].firstChild; child != npos; child = nodes[child].nextSibling) {
+            if (nodes[child].label == label) return child;
+            if (static_cast<unsigned char>(nodes[child].label) > static_cast<unsigned char>(label)) break;
+        }
+        return npos;
+    }
+
+    void addWord(const std::string& word, uint32_t book) {
+        uint32_t node = 0;
+        for (char c : word) {
+            uint32_t* link = &nodes[node].firstChild; // Keep siblings in byte order
+            while (*link != npos && static_cast<unsigned char>(nodes[*link].label) < static_cast<unsigned char>(c)) {
+                link = &nodes[*link].nextSibling;
+            }
+            if (*link == npos || nodes[*link].label != c) {
+                uint32_t added = static_cast<uint32_t>(nodes.size());
+                uint32_t next = *link;
+                nodes.push_back(TrieNode{npos, next, npos, c}); // May move nodes, so relink below
+                link = &nodes[node].firstChild;
+                while (*link != next) link = &nodes[*link].nextSibling;
+                *link = added;
+            }
+            node = *link;
+        }
+        uint32_t first = nodes[node].firstPosting;
+        if (first != npos && postings[first].book == book) return; // Same word twice in one book
+        postings.push_back(Posting{book, first});
+        nodes[node].firstPosting = static_cast<uint32_t>(postings.size() - 1);
+    }
+
+    bool matchesAll(uint32_t book, const std::vector<std::string>& prefixes) const {
+        if (prefixes.size() == 1) return true; // The trie walk already matched it
+        std::vector<std::string> words;
+        forEachWord(title(book).str() + " " + author(book).str(), [&](const std::string& word) { words.push_back(word); });
+        for (size_t i = 1; i < prefixes.size(); i++) {
+            bool found = false;
+            for (const std::string& word : words) {
+                if (word.compare(0, prefixes[i].size(), prefixes[i]) == 0) {
+                    found = true;
+                    break;
+                }
+            }
+            if (!found) return false;
+        }
+        return true;
+    }
+};
+
+const uint32_t Library::npos;
+const int64_t Library::NOT_RETURNED;
+
+// --- Grade Store ---
+// Results uploaded by teachers, kept per student slot as a short array of
+// 8-byte entries (students rarely have more than ~50 subjects in total).
+
+// 10-point scale; a grade is stored as its index in this table
+struct GradeScaleEntry {
+    const char* letter;
+    uint8_t points;
+};
+
+const GradeScaleEntry GRADE_SCALE[] = {
+    {"O", 10}, {"A+", 9}, {"A", 8}, {"B+", 7}, {"B", 6}, {"C", 5}, {"P", 4}, {"F", 0}, {"AB", 0}
+};
+const size_t GRADE_SCALE_SIZE = sizeof(GRADE_SCALE) / sizeof(GRADE_SCALE[0]);
+const uint8_t NO_GRADE = 0xFF;
+const int MAX_SEMESTER = 12;
+const int MAX_CREDITS = 10;
+
+// The ranges the upload prompt accepts; stored entries are held to them too
+inline bool validResultTerms(int semester, int credits) {
+    return semester >= 1 && semester <= MAX_SEMESTER && credits >= 1 && credits <= MAX_CREDITS;
+}
+
+// Case-insensitive; surrounding spaces are ignored
+uint8_t parseGrade(const char* text, size_t length) {
+    trimSlice(text, length);
+    if (length == 0 || length > 2) return NO_GRADE;
+    char grade[3] = {asciiUpper(text[0]), length == 2 ? asciiUpper(text[1]) : '\0', '\0'};
+    for (size_t g = 0; g < GRADE_SCALE_SIZE; g++) {
+        const char* letter = GRADE_SCALE[g].letter;
+        if (letter[0] == grade[0] && letter[1] == grade[1]) return static_cast<uint8_t>(g);
+    }
+    return NO_GRADE;
+}
+
+struct GradeEntry {
+    uint32_t subject; // SubjectCatalog id
+    uint8_t semester;
+    uint8_t credits;
+    uint8_t grade; // Index into GRADE_SCALE
+};
+
+class GradeStore {
+public:
+    // Records a student's grade in a subject; a re-upload replaces the old
+    // one. Returns the grade that was replaced, or NO_GRADE.
+    uint8_t set(uint32_t slot, const GradeEntry& entry) {
+        if (perStudent.size() <= slot) perStudent.resize(slot + 1);
+        for (auto& existing : perStudent[slot]) {
+            if (existing.subject == entry.subject) {
+                uint8_t previous = existing.grade;
+                existing = entry;
+                return previous;
+            }
+        }
+        perStudent[slot].push_back(entry);
+        return NO_GRADE;
+    }
+
+    const std::vector<GradeEntry>& gradesOf(uint32_t slot) const {
+        static const std::vector<GradeEntry> none;
+        return slot < perStudent.size() ? perStudent[slot] : none;
+    }
+
+    size_t slotCount() const { return perStudent.size(); }
+
+private:
+    std::vector<std::vector<GradeEntry>> perStudent;
+};
+
+// --- Parallel Helpers ---
+// Splits [0, count) into one contiguous range per core and runs
+// work(begin, end) on each; small jobs run on the calling thread.
+template <typename Work>
+void parallelFor(size_t count, Work work, size_t minimumPerThread = 4096) {
+    unsigned cores = std::thread::hardware_concurrency();
+    size_t threads = std::min<size_t>(cores == 0 ? 1 : cores, count / minimumPerThread);
+    if (threads <= 1) {
+        work(size_t(0), count);
+        return;
+    }
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; t++) {
+        workers.emplace_back(work, count * t / threads, count * (t + 1) / threads);
+    }
+    for (auto& worker : workers) worker.join();
+}
+
+// Sorts chunks in parallel, then merges neighbouring chunks pairwise (each
+// round of merges also in parallel) until one sorted range is left
+template <typename T, typename Less>
+void parallelSort(std::vector<T>& items, Less less) {
+    unsigned cores = std::thread::hardware_concurrency();
+    size_t chunks = std::min<size_t>(cores == 0 ? 1 : cores, items.size() / 16384);
+    if (chunks <= 1) {
+        std::sort(items.begin(), items.end(), less);
+        return;
+    }
+    std::vector<size_t> bounds;
+    for (size_t c = 0; c <= chunks; c++) bounds.push_back(items.size() * c / chunks);
+    parallelFor(chunks, [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; c++) std::sort(items.begin() + bounds[c], items.begin() + bounds[c + 1], less);
+    }, 1);
+    while (bounds.size() > 2) {
+        std::vector<size_t> merged;
+        std::vector<std::thread> mergers;
+        for (size_t c = 0; c + 2 < bounds.size(); c += 2) {
+            size_t first = bounds[c], middle = bounds[c + 1], last = bounds[c + 2];
+            mergers.emplace_back([&items, first, middle, last, less]() {
+                std::inplace_merge(items.begin() + first, items.begin() + middle, items.begin() + last, less);
+            });
+            merged.push_back(first);
+        }
+        for (auto& merger : mergers) merger.join();
+        if (bounds.size() % 2 == 0) merged.push_back(bounds[bounds.size() - 2]); // Odd chunk carried over
+        merged.push_back(bounds.back());
+        bounds.swap(merged);
+    }
+}
+
+// --- Grade Analytics ---
+// SGPA/CGPA per student, grade distributions per subject and the merit
+// list (students ordered by CGPA). Uploads only mark the students they
+// touched; refresh() recomputes just those (in parallel) and merges them
+// back into the already sorted merit list instead of re-sorting everyone.
+
+struct SemesterGpa {
+    uint8_t semester;
+    uint16_t credits;
+    float sgpa;
+};
+
+struct StudentStanding {
+    float cgpa;
+    uint32_t credits;                    // 0 = no results yet, not ranked
+    std::vector<SemesterGpa> semesters;  // In semester order
+};
+
+struct MeritEntry {
+    float cgpa;
+    uint32_t slot;
+};
+
+// Best CGPA first; equal CGPAs in slot order so the list is stable
+inline bool meritBefore(const MeritEntry& a, const MeritEntry& b) {
+    return a.cgpa != b.cgpa ? a.cgpa > b.cgpa : a.slot < b.slot;
+}
+
+struct SubjectStats {
+    uint32_t gradeCounts[GRADE_SCALE_SIZE];
+    uint32_t students() const {
+        uint32_t total = 0;
+        for (size_t g = 0; g < GRADE_SCALE_SIZE; g++) total += gradeCounts[g];
+        return total;
+    }
+};
+
+void computeStanding(const std::vector<GradeEntry>& entries, StudentStanding& standing) {
+    standing.semesters.clear();
+    uint32_t totalCredits = 0;
+    uint32_t totalPoints = 0;
+    for (const auto& entry : entries) {
+        auto semester = std::find_if(standing.semesters.begin(), standing.semesters.end(),
+                                     [&](const SemesterGpa& s) { return s.semester == entry.semester; });
+        if (semester == standing.semesters.end()) {
+            standing.semesters.push_back({entry.semester, 0, 0.0f});
+            semester = standing.semesters.end() - 1;
+        }
+        // sgpa holds weighted points until the final division below
+        semester->credits += entry.credits;
+        semester->sgpa += static_cast<float>(GRADE_SCALE[entry.grade].points * entry.credits);
+        totalCredits += entry.credits;
+        totalPoints += GRADE_SCALE[entry.grade].points * entry.credits;
+    }
+    for (auto& semester : standing.semesters) {
+        if (semester.credits > 0) semester.sgpa /= semester.credits;
+    }
+    std::sort(standing.semesters.begin(), standing.semesters.end(),
+              [](const SemesterGpa& a, const SemesterGpa& b) { return a.semester < b.semester; });
+    standing.credits = totalCredits;
+    standing.cgpa = totalCredits == 0 ? 0.0f : static_cast<float>(totalPoints) / totalCredits;
+}
+
+class GradeAnalytics {
+public:
+    // Called for every stored grade; oldGrade is NO_GRADE for a new entry
+    void gradeChanged(uint32_t slot, uint32_t subject, uint8_t oldGrade, uint8_t newGrade) {
+        if (subjects.size() <= subject) subjects.resize(subject + 1, SubjectStats{});
+        if (oldGrade != NO_GRADE) subjects[subject].gradeCounts[oldGrade]--;
+        subjects[subject].gradeCounts[newGrade]++;
+        markDirty(slot);
+    }
+
+    // Starts over from the grade store (after loading a snapshot)
+    void rebuild(const GradeStore& store) {
+        subjects.clear();
+        standings.clear();
+        merit.clear();
+        dirty.clear();
+        dirtyFlags.clear();
+        for (uint32_t slot = 0; slot < store.slotCount(); slot++) {
+            for (const auto& entry : store.gradesOf(slot)) {
+                if (subjects.size() <= entry.subject) subjects.resize(entry.subject + 1, SubjectStats{});
+                subjects[entry.subject].gradeCounts[entry.grade]++;
+            }
+            markDirty(slot);
+        }
+        refresh(store);
+    }
+
+    // Brings standings and the merit list up to date for the marked students
+    void refresh(const GradeStore& store) {
+        if (dirty.empty()) return;
+        if (standings.size() < store.slotCount()) standings.resize(store.slotCount(), StudentStanding{0.0f, 0, {}});
+
+        parallelFor(dirty.size(), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) computeStanding(store.gradesOf(dirty[i]), standings[dirty[i]]);
+        }, 1024);
+
+        std::vector<MeritEntry> updated;
+        updated.reserve(dirty.size());
+        for (uint32_t slot : dirty) {
+            if (standings[slot].credits > 0) updated.push_back({standings[slot].cgpa, slot});
+        }
+        parallelSort(updated, meritBefore);
+
+        // Drop the stale entries and merge the re-sorted ones back in: O(n)
+        // for the list plus O(d log d) for the d students that changed
+        merit.erase(std::remove_if(merit.begin(), merit.end(),
+                                   [&](const MeritEntry& e) { return dirtyFlags[e.slot] != 0; }),
+                    merit.end());
+        std::vector<MeritEntry> combined;
+        combined.reserve(merit.size() + updated.size());
+        std::merge(merit.begin(), merit.end(), updated.begin(), updated.end(),
+                   std::back_inserter(combined), meritBefore);
+        merit.swap(combined);
+
+        for (uint32_t slot : dirty) dirtyFlags[slot] = 0;
+        dirty.clear();
+    }
+
+    const StudentStanding* standing(uint32_t slot) const {
+        return slot < standings.size() && standings[slot].credits > 0 ? &standings[slot] : nullptr;
+    }
+
+    const std::vector<MeritEntry>& meritList() const { return merit; }
+
+    // 1-based competition rank (ties share a rank); 0 if not ranked
+    size_t rankOf(uint32_t slot) const {
+        const StudentStanding* mine = standing(slot);
+        if (mine == nullptr) return 0;
+        MeritEntry probe{mine->cgpa, 0};
+        auto first = std::lower_bound(merit.begin(), merit.end(), probe, meritBefore);
+        return static_cast<size_t>(first - merit.begin()) + 1;
+    }
+
+    const SubjectStats* subjectStats(uint32_t subject) const {
+        return subject < subjects.size() && subjects[subject].students() > 0 ? &subjects[subject] : nullptr;
+    }
+
+    size_t pendingCount() const { return dirty.size(); }
+
+private:
+    std::vector<StudentStanding> standings; // Per student slot
+    std::vector<MeritEntry> merit;          // Ranked students, best first
+    std::vector<SubjectStats> subjects;     // Per subject id
+    std::vector<uint32_t> dirty;            // Slots whose grades changed since refresh()
+    std::vector<uint8_t> dirtyFlags;
+
+    void markDirty(uint32_t slot) {
+        if (dirtyFlags.size() <= slot) dirtyFlags.resize(slot + 1, 0);
+        if (dirtyFlags[slot]) return;
+        dirtyFlags[slot] = 1;
+        dirty.push_back(slot);
+    }
+};
+
+// Average grade points and the grade at a given percentile of a subject
+double subjectAverage(const SubjectStats& stats) {
+    uint64_t points = 0;
+    for (size_t g = 0; g < GRADE_SCALE_SIZE; g++) points += static_cast<uint64_t>(stats.gradeCounts[g]) * GRADE_SCALE[g].points;
+    return static_cast<double>(points) / stats.students();
+}
+
+// Grade that `percent`% of the students are at or below (grades ordered by points)
+uint8_t subjectPercentileGrade(const SubjectStats& stats, double percent) {
+    uint8_t order[GRADE_SCALE_SIZE];
+    for (size_t g = 0; g < GRADE_SCALE_SIZE; g++) order[g] = static_cast<uint8_t>(g);
+    std::stable_sort(order, order + GRADE_SCALE_SIZE,
+                     [](uint8_t a, uint8_t b) { return GRADE_SCALE[a].points < GRADE_SCALE[b].points; });
+    double needed = stats.students() * percent / 100.0;
+    uint64_t seen = 0;
+    for (uint8_t g : order) {
+        seen += stats.gradeCounts[g];
+        if (seen > 0 && seen >= needed) return g;
+    }
+    return order[GRADE_SCALE_SIZE - 1];
+}
+
+// --- Results Upload Types ---
+struct ParsedGrade {
+    uint32_t slot;  // Student slot the row's ID resolved to
+    uint8_t grade;  // Index into GRADE_SCALE
+};
+
+struct ResultsFileReport {
+    bool opened;
+    size_t bytes;
+    size_t rows;                       // Rows accepted
+    size_t rejected;                   // Rows with an unknown ID or grade
+    std::vector<std::string> problems; // The first few rejected rows, with line numbers
+    double seconds;
+};
+
+// --- Roster Import Types ---
+struct RosterFileReport {
+    bool opened;
+    size_t bytes;
+    size_t rows;                       // Rows that passed the checks and were not repeats
+    size_t rejected;                   // Malformed rows and repeated emails or student IDs
+    std::vector<std::string> problems; // The first few rejected rows, with line numbers
+    double seconds;
+};
+
+// --- Gate Scan Types ---
+
+const char* const DEFAULT_GATE = "Main Gate";
+
+// One scan as read or logged, before its person and gate are interned
+struct GateScan {
+    int64_t time;       // Seconds since 1970-01-01 on the college wall clock
+    std::string person; // A registered user's email, or a visitor's name
+    std::string gate;
+    bool entering;
+};
+
+struct GateScanReport {
+    size_t lines = 0;                  // Non-blank lines read
+    size_t logged = 0;                 // Scans saved and added to the gate log
+    size_t rejected = 0;               // Lines that are not scans
+    size_t unsaved = 0;                // Scans in batches the log could not save
+    std::vector<std::string> problems; // The first few rejected lines, with line numbers
+};
+
+// --- Data Export Types ---
+
+enum ExportDataset : uint8_t {
+    EXPORT_ATTENDANCE, // A row per student per attendance session
+    EXPORT_RESULTS,    // A row per student per graded subject
+    EXPORT_COMPLAINTS,
+    EXPORT_LEAVE,
+    EXPORT_DATASET_COUNT
+};
+const char* const EXPORT_DATASET_NAMES[EXPORT_DATASET_COUNT] = {"attendance", "results", "complaints", "leave"};
+
+enum ExportFormat : uint8_t {
+    EXPORT_CSV,
+    EXPORT_JSON
+};
+
+struct ExportReport {
+    uint64_t rows = 0;
+    uint64_t bytes = 0;  // Of the file written
+    double seconds = 0;
+    double megabytesPerSecond() const { return seconds > 0 ? bytes / (1024.0 * 1024.0) / seconds : 0; }
+};
+
+// --- Binary Encoding Helpers ---
+// Integers are written in the machine's native (little endian on every
+// platform we build for) byte order; strings are a u32 length plus bytes.
+
+class BinaryWriter {
+public:
+    void u8(uint8_t value) { buffer.push_back(static_cast<char>(value)); }
+    void u32(uint32_t value) { raw(&value, sizeof(value)); }
+    void u64(uint64_t value) { raw(&value, sizeof(value)); }
+    void str(const std::string& value) {
+        u32(static_cast<uint32_t>(value.size()));
+        raw(value.data(), value.size());
+    }
+    void raw(const void* bytes, size_t count) {
+        const char* first = static_cast<const char*>(bytes);
+        buffer.insert(buffer.end(), first, first + count);
+    }
+    // Overwrite values written earlier (used for sizes known only at the end)
+    void patchU32(size_t offset, uint32_t value) {
+        memcpy(&buffer[offset], &value, sizeof(value));
+    }
+    void patchU64(size_t offset, uint64_t value) {
+        memcpy(&buffer[offset], &value, sizeof(value));
+    }
+    size_t size() const { return buffer.size(); }
+    const char* data() const { return buffer.data(); }
+    void clear() { buffer.clear(); }
+
+private:
+    std::vector<char> buffer;
+};
+
+// Reads values back without copying; any overrun marks the reader as failed
+class BinaryReader {
+public:
+    BinaryReader(const char* begin, size_t count) : cursor(begin), end(begin + count), ok(true) {}
+
+    uint8_t u8() { uint8_t value = 0; raw(&value, sizeof(value)); return value; }
+    uint32_t u32() { uint32_t value = 0; raw(&value, sizeof(value)); return value; }
+    uint64_t u64() { uint64_t value = 0; raw(&value, sizeof(value)); return value; }
+    StrView str() {
+        uint32_t length = u32();
+        if (!ok || static_cast<size_t>(end - cursor) < length) {
+            ok = false;
+            return StrView{"", 0};
+        }
+        StrView view{cursor, length};
+        cursor += length;
+        return view;
+    }
+    bool good() const { return ok; }
+    bool atEnd() const { return cursor == end; }
+    size_t remaining() const { return static_cast<size_t>(end - cursor); }
+
+private:
+    const char* cursor;
+    const char* end;
+    bool ok;
+
+    void raw(void* out, size_t count) {
+        if (!ok || static_cast<size_t>(end - cursor) < count) {
+            ok = false;
+            return;
+        }
+        memcpy(out, cursor, count);
+        cursor += count;
+    }
+};
+
+// 64-bit checksum that consumes 8 bytes per step, so verifying a large
+// snapshot costs far less than the disk read itself
+uint64_t checksumBytes(const char* bytes, size_t count) {
+    const uint64_t multiplier = 0x9E3779B97F4A7C15ULL;
+    uint64_t hash = count * multiplier;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        uint64_t word;
+        memcpy(&word, bytes + i, sizeof(word));
+        hash = (hash ^ word) * multiplier;
+        hash ^= hash >> 29;
+    }
+    for (; i < count; i++) {
+        hash = (hash ^ static_cast<unsigned char>(bytes[i])) * multiplier;
+    }
+    return hash ^ (hash >> 32);
+}
+
+// --- Memory Mapped Files ---
+// Read-only mapping of a whole file; the contents stay valid until close()
+class MappedFile {
+public:
+    MappedFile() : bytes(nullptr), length(0) {}
+    ~MappedFile() { close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path) {
+        close();
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+            CloseHandle(file);
+            return false;
+        }
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);
+        if (mapping == nullptr) return false;
+        bytes = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        CloseHandle(mapping); // The view keeps the mapping alive
+        if (bytes == nullptr) return false;
+        length = static_cast<size_t>(fileSize.QuadPart);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0) {
+            ::close(fd);
+            return false;
+        }
+        void* mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd); // The mapping keeps the file alive
+        if (mapped == MAP_FAILED) return false;
+        bytes = static_cast<const char*>(mapped);
+        length = static_cast<size_t>(info.st_size);
+#endif
+        return true;
+    }
+
+    void close() {
+        if (bytes == nullptr) return;
+#ifdef _WIN32
+        UnmapViewOfFile(bytes);
+#else
+        munmap(const_cast<char*>(bytes), length);
+#endif
+        bytes = nullptr;
+        length = 0;
+    }
+
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const char* bytes;
+    size_t length;
+};
+
+// Pushes buffered writes of an open file all the way to the disk
+bool syncFile(FILE* file) {
+    if (fflush(file) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+// Writes a file and flushes it to disk before returning
+bool writeFileDurably(const std::string& path, const char* bytes, size_t count) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr) return false;
+    bool ok = fwrite(bytes, 1, count, file) == count && syncFile(file);
+    return fclose(file) == 0 && ok;
+}
+
+// Cuts a file down to its first `length` bytes
+bool truncateFile(const std::string& path, uint64_t length) {
+#ifdef _WIN32
+    FILE* file = fopen(path.c_str(), "r+b");
+    if (file == nullptr) return false;
+    bool ok = _chsize_s(_fileno(file), static_cast<long long>(length)) == 0;
+    return fclose(file) == 0 && ok;
+#else
+    return truncate(path.c_str(), static_cast<off_t>(length)) == 0;
+#endif
+}
+
+// Replaces target with source in one step (readers see the old or the new file)
+bool replaceFile(const std::string& source, const std::string& target) {
+#ifdef _WIN32
+    return MoveFileExA(source.c_str(), target.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return rename(source.c_str(), target.c_str()) == 0;
+#endif
+}
+
+// The path of a file a client named inside `directory`. Only a bare file
+// name is accepted, so a client cannot reach files elsewhere on the server.
+bool fileInDirectory(const std::string& directory, const std::string& name, std::string& path) {
+    if (name.empty() || name == "." || name == ".." || name.find_first_of("/\\:") != std::string::npos) return false;
+    path = directory + "/" + name;
+    return true;
+}
+
+// Creates a directory unless it is already there
+bool ensureDirectory(const std::string& path) {
+#ifdef _WIN32
+    return CreateDirectoryA(path.c_str(), nullptr) != 0 || GetLastError() == ERROR_ALREADY_EXISTS;
+#else
+    return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+#endif
+}
+
+// --- Block Compression ---
+// LZ77 in the manner of LZ4, for archived records: they repeat names,
+// emails and common words, so plain back-references save most of the
+// space and decompressing stays a tight copy loop. A block is a run of
+// sequences: varint literal count, the literals, then a varint match
+// length (0 ends the block) and a varint distance back into the output.
+
+const size_t LZ_MIN_MATCH = 5; // A shorter match costs about what it saves
+const unsigned LZ_HASH_BITS = 12;
+const size_t LZ_MAX_DISTANCE = 65535;
+const uint32_t LZ_NO_POSITION = 0xFFFFFFFF;
+
+void putVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>(value | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+inline bool getVarint(const char*& cursor, const char* end, uint64_t& value) {
+    if (cursor < end && static_cast<unsigned char>(*cursor) < 0x80) { // Almost every count fits one byte
+        value = static_cast<unsigned char>(*cursor++);
+        return true;
+    }
+    value = 0;
+    for (unsigned shift = 0; cursor < end && shift < 64; shift += 7) {
+        unsigned char byte = static_cast<unsigned char>(*cursor++);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (byte < 0x80) return true;
+    }
+    return false;
+}
+
+void compressBlock(const char* input, size_t length, std::string& out) {
+    out.clear();
+    std::vector<uint32_t> lastSeen(size_t(1) << LZ_HASH_BITS, LZ_NO_POSITION); // Latest position of each 4-byte hash
+    size_t anchor = 0, i = 0;
+    while (i + LZ_MIN_MATCH <= length) {
+        uint32_t word;
+        memcpy(&word, input + i, sizeof(word));
+        uint32_t& slot = lastSeen[(word * 2654435761U) >> (32 - LZ_HASH_BITS)];
+        size_t candidate = slot;
+        slot = static_cast<uint32_t>(i);
+        if (candidate == LZ_NO_POSITION || i - candidate > LZ_MAX_DISTANCE ||
+            memcmp(input + candidate, input + i, LZ_MIN_MATCH) != 0) {
+            i++;
+            continue;
+        }
+        size_t match = LZ_MIN_MATCH;
+        while (i + match < length && input[candidate + match] == input[i + match]) match++;
+        putVarint(out, i - anchor);
+        out.append(input + anchor, i - anchor);
+        putVarint(out, match - LZ_MIN_MATCH + 1);
+        putVarint(out, i - candidate);
+        i += match;
+        anchor = i;
+    }
+    putVarint(out, length - anchor);
+    out.append(input + anchor, length - anchor);
+    putVarint(out, 0);
+}
+
+// False if the block is malformed or does not come to exactly rawSize bytes
+bool decompressBlock(const char* input, size_t length, size_t rawSize, std::string& out) {
+    out.resize(rawSize);
+    char* target = &out[0];
+    const char* cursor = input;
+    const char* end = input + length;
+    size_t written = 0;
+    while (true) {
+        uint64_t literals, match, distance;
+        if (!getVarint(cursor, end, literals) || literals > static_cast<size_t>(end - cursor) ||
+            literals > rawSize - written) {
+            return false;
+        }
+        memcpy(target + written, cursor, literals);
+        cursor += literals;
+        written += literals;
+        if (!getVarint(cursor, end, match)) return false;
+        if (match == 0) return cursor == end && written == rawSize;
+        match += LZ_MIN_MATCH - 1;
+        if (!getVarint(cursor, end, distance) || distance == 0 || distance > written || match > rawSize - written) {
+            return false;
+        }
+        if (distance >= match) {
+            memcpy(target + written, target + written - distance, match);
+            written += match;
+        } else {
+            for (size_t from = written - distance; match > 0; match--) target[written++] = target[from++]; // Repeats itself
+        }
+    }
+}
+
+// --- Cold Segments ---
+// Archived records in an immutable file. They are encoded back to back,
+// cut into blocks of about COLD_BLOCK_BYTES at record boundaries, and each
+// block is compressed on its own. The index up front gives every block's
+// record count and place, so reading one record costs a binary search, one
+// block to decompress and decoding just that record. The file is memory
+// mapped: archived records take page cache while they are read, not heap.
+//
+//   header: magic[8] "CALCOLD1" | u32 version | u32 blockCount | u64 first
+//           | u64 count | u64 checksum (over everything after the header)
+//   index:  blockCount x { u32 records | u32 rawSize | u32 size | u64 offset }
+//   blocks: compressed; each decompresses to records x { u32 end } (where
+//           each record stops) followed by the records
+
+const char COLD_MAGIC[8] = {'C', 'A', 'L', 'C', 'O', 'L', 'D', '1'};
+const uint32_t COLD_VERSION = 1;
+const size_t COLD_HEADER_SIZE = 8 + 4 + 4 + 8 + 8 + 8;
+const size_t COLD_INDEX_ENTRY_SIZE = 4 + 4 + 4 + 8;
+const size_t COLD_BLOCK_BYTES = 8 * 1024;
+const size_t COLD_CACHE_BLOCKS = 8; // Decoded blocks each list keeps for paging
+
+class ColdSegment {
+public:
+    struct Block {
+        uint64_t first;   // Position of its first record
+        uint32_t records;
+        uint32_t rawSize;
+        uint32_t size;    // Compressed
+        uint64_t offset;  // Into the file
+    };
+
+    ColdSegment() = default;
+    ColdSegment(const ColdSegment&) = delete;
+    ColdSegment& operator=(const ColdSegment&) = delete;
+
+    // Writes records [first, first + ends.size()), given as their encodings
+    // back to back with `ends` marking where each one stops
+    static bool write(const std::string& path, uint64_t first, const BinaryWriter& records,
+                      const std::vector<size_t>& ends) {
+        std::vector<size_t> cuts; // Record each block stops before
+        size_t blockStart = 0;
+        for (size_t r = 0; r < ends.size(); r++) {
+            if (ends[r] - blockStart >= COLD_BLOCK_BYTES || r + 1 == ends.size()) {
+                cuts.push_back(r + 1);
+                blockStart = ends[r];
+            }
+        }
+
+        BinaryWriter out;
+        out.raw(COLD_MAGIC, sizeof(COLD_MAGIC));
+        out.u32(COLD_VERSION);
+        out.u32(static_cast<uint32_t>(cuts.size()));
+        out.u64(first);
+        out.u64(ends.size());
+        out.u64(0); // checksum, patched below
+        size_t indexOffset = out.size();
+        for (size_t i = 0; i < cuts.size() * COLD_INDEX_ENTRY_SIZE; i++) out.u8(0);
+
+        BinaryWriter block;
+        std::string compressed;
+        size_t record = 0, rawStart = 0;
+        for (size_t b = 0; b < cuts.size(); b++) {
+            size_t rawEnd = ends[cuts[b] - 1];
+            block.clear();
+            for (size_t r = record; r < cuts[b]; r++) block.u32(static_cast<uint32_t>(ends[r] - rawStart));
+            block.raw(records.data() + rawStart, rawEnd - rawStart);
+            compressBlock(block.data(), block.size(), compressed);
+            size_t entry = indexOffset + b * COLD_INDEX_ENTRY_SIZE;
+            out.patchU32(entry, static_cast<uint32_t>(cuts[b] - record));
+            out.patchU32(entry + 4, static_cast<uint32_t>(block.size()));
+            out.patchU32(entry + 8, static_cast<uint32_t>(compressed.size()));
+            out.patchU64(entry + 12, out.size());
+            out.raw(compressed.data(), compressed.size());
+            record = cuts[b];
+            rawStart = rawEnd;
+        }
+        out.patchU64(COLD_HEADER_SIZE - 8, checksumBytes(out.data() + COLD_HEADER_SIZE, out.size() - COLD_HEADER_SIZE));
+
+        std::string temporary = path + ".tmp";
+        return writeFileDurably(temporary, out.data(), out.size()) && replaceFile(temporary, path);
+    }
+
+    // Maps the file and checks it whole, so blocks read later can be trusted
+    bool open(const std::string& path) {
+        blocks.clear();
+        if (!file.open(path)) return false;
+        if (file.size() < COLD_HEADER_SIZE || memcmp(file.data(), COLD_MAGIC, sizeof(COLD_MAGIC)) != 0) {
+            file.close();
+            return false;
+        }
+        BinaryReader header(file.data() + sizeof(COLD_MAGIC), COLD_HEADER_SIZE - sizeof(COLD_MAGIC));
+        uint32_t version = header.u32();
+        uint32_t blockCount = header.u32();
+        firstPosition = header.u64();
+        recordCount = header.u64();
+        uint64_t checksum = header.u64();
+        bool ok = version == COLD_VERSION &&
+                  checksum == checksumBytes(file.data() + COLD_HEADER_SIZE, file.size() - COLD_HEADER_SIZE);
+
+        BinaryReader index(file.data() + COLD_HEADER_SIZE, ok ? file.size() - COLD_HEADER_SIZE : 0);
+        uint64_t position = firstPosition;
+        for (uint32_t b = 0; b < blockCount && ok; b++) {
+            Block block;
+            block.first = position;
+            block.records = index.u32();
+            block.rawSize = index.u32();
+            block.size = index.u32();
+            block.offset = index.u64();
+            ok = index.good() && block.offset <= file.size() && block.size <= file.size() - block.offset;
+            position += block.records;
+            blocks.push_back(block);
+        }
+        if (!ok || position != firstPosition + recordCount) {
+            file.close();
+            blocks.clear();
+            return false;
+        }
+        name = path;
+        return true;
+    }
+
+    const std::string& path() const { return name; }
+    uint64_t first() const { return firstPosition; }
+    uint64_t end() const { return firstPosition + recordCount; }
+    size_t fileSize() const { return file.size(); }
+    size_t blockCount() const { return blocks.size(); }
+    const Block& block(size_t b) const { return blocks[b]; }
+
+    // The block holding `position`, which must be in [first(), end())
+    size_t blockOf(uint64_t position) const {
+        auto after = std::upper_bound(blocks.begin(), blocks.end(), position,
+                                      [](uint64_t p, const Block& block) { return p < block.first; });
+        return static_cast<size_t>(after - blocks.begin()) - 1;
+    }
+
+    bool readBlock(size_t b, std::string& raw) const {
+        return decompressBlock(file.data() + blocks[b].offset, blocks[b].size, blocks[b].rawSize, raw);
+    }
+
+    // Record r of a block read by readBlock; an empty reader if out of range
+    static BinaryReader recordIn(const std::string& raw, uint32_t records, uint32_t r) {
+        size_t table = static_cast<size_t>(records) * 4;
+        uint32_t begin = 0, end = 0;
+        if (r >= records || raw.size() < table) return BinaryReader(raw.data(), 0);
+        if (r > 0) memcpy(&begin, raw.data() + (r - 1) * 4, 4);
+        memcpy(&end, raw.data() + r * 4, 4);
+        if (begin > end || end > raw.size() - table) return BinaryReader(raw.data(), 0);
+        return BinaryReader(raw.data() + table + begin, end - begin);
+    }
+
+private:
+    MappedFile file;
+    std::string name;
+    uint64_t firstPosition = 0;
+    uint64_t recordCount = 0;
+    std::vector<Block> blocks;
+};
+
+// Archived records keep the snapshot encoding (defined with it)
+void encodeRecord(BinaryWriter& out, const Complaint& complaint);
+bool decodeRecord(BinaryReader& in, Complaint& complaint);
+void encodeRecord(BinaryWriter& out, const LeaveNotice& notice);
+bool decodeRecord(BinaryReader& in, LeaveNotice& notice);
+
+// --- Shared Record Lists ---
+// Append-only list that many server sessions add to and read at once, e.g.
+// complaints and leave notices. Appends take the lock exclusively, readers
+// share it, so a burst of submissions only ever waits on other writers of
+// the same list.
+//
+// The oldest records can be archived to cold segments. Positions never
+// change: the segments cover [0, coldCount()) in order and memory holds the
+// rest, so at() reads through to disk for an archived record. The last few
+// blocks read stay decoded, since lists are paged through in order.
+template <typename T>
+class SharedRecordList {
+public:
+    void append(T item) {
+        std::unique_lock<std::shared_timed_mutex> lock(mutex);
+        items.push_back(std::move(item));
+    }
+
+    // Replaces the contents wholesale, archived records too
+    void assign(std::vector<T> loaded) {
+        restore(std::vector<std::unique_ptr<ColdSegment>>(), std::move(loaded));
+    }
+
+    // Snapshot load: the segments (contiguous from position 0), then the
+    // records that were still in memory
+    void restore(std::vector<std::unique_ptr<ColdSegment>> segments, std::vector<T> loaded) {
+        std::unique_lock<std::shared_timed_mutex> lock(mutex);
+        cold = std::move(segments);
+        coldEnd = cold.empty() ? 0 : static_cast<size_t>(cold.back()->end());
+        items.assign(std::make_move_iterator(loaded.begin()), std::make_move_iterator(loaded.end()));
+        std::lock_guard<std::mutex> cacheLock(cacheMutex);
+        cache.clear();
+    }
+
+    size_t size() const {
+        std::shared_lock<std::shared_timed_mutex> lock(mutex);
+        return coldEnd + items.size();
+    }
+    bool empty() const { return size() == 0; }
+
+    // Records archived so far; they come before every record in memory
+    size_t coldCount() const {
+        std::shared_lock<std::shared_timed_mutex> lock(mutex);
+        return coldEnd;
+    }
+
+    void coldPaths(std::vector<std::string>& paths) const {
+        std::shared_lock<std::shared_timed_mutex> lock(mutex);
+        for (const auto& segment : cold) paths.push_back(segment->path());
+    }
+
+    // Appends a whole batch under one lock acquisition; returns the
+    // position of the first item appended
+    size_t appendAll(std::vector<T>& batch) {
+        std::unique_lock<std::shared_timed_mutex> lock(mutex);
+        size_t first = coldEnd + items.size();
+        for (T& item : batch) items.push_back(std::move(item));
+        return first;
+    }
+
+    // A copy of one item, by position
+    T at(size_t index) const {
+        std::shared_lock<std::shared_timed_mutex> lock(mutex);
+        return index >= coldEnd ? items[index - coldEnd] : coldAtLocked(index);
+    }
+
+    // Visits the items from position `first` on, with their positions, under
+    // a shared lock; visit must not call back into this list. Archived items
+    // are decoded a block at a time. False if an archived block could not be
+    // read, in which case the walk stopped there.
+    template <typename Visit>
+    bool forEachFrom(size_t first, Visit visit) const {
+        return forEachIn(first, std::numeric_limits<size_t>::max(), visit);
+    }
+
+    // The same for positions [first, last) only, so a long walk can take
+    // the lock once per range instead of holding it throughout
+    template <typename Visit>
+    bool forEachIn(size_t first, size_t last, Visit visit) const {
+        std::shared_lock<std::shared_timed_mutex> lock(mutex);
+        std::string raw;
+        T item;
+        for (const auto& segment : cold) {
+            if (segment->end() <= first) continue;
+            if (segment->first() >= last) break;
+            for (size_t b = segment->blockOf(std::max<uint64_t>(first, segment->first())); b < segment->blockCount(); b++) {
+                const ColdSegment::Block& block = segment->block(b);
+                if (block.first >= last) break;
+                if (!segment->readBlock(b, raw)) return false;
+                uint64_t stop = std::min<uint64_t>(last, block.first + block.records);
+                for (uint64_t pos = std::max<uint64_t>(first, block.first); pos < stop; pos++) {
+                    BinaryReader in = ColdSegment::recordIn(raw, block.records, static_cast<uint32_t>(pos - block.first));
+                    if (!decodeRecord(in, item)) return false;
+                    visit(static_cast<size_t>(pos), item);
+                }
+            }
+        }
+        size_t stop = std::min(last, coldEnd + items.size());
+        for (size_t i = std::max(first, coldEnd); i < stop; i++) visit(i, items[i - coldEnd]);
+        return true;
+    }
+
+    // Moves the `count` oldest records still in memory into a new segment
+    // file. On failure nothing moves. Only one archive may run at a time.
+    bool archive(size_t count, const std::string& path) {
+        BinaryWriter encoded;
+        std::vector<size_t> ends;
+        size_t first;
+        {
+            std::shared_lock<std::shared_timed_mutex> lock(mutex);
+            first = coldEnd;
+            count = std::min(count, items.size());
+            for (size_t i = 0; i < count; i++) {
+                encodeRecord(encoded, items[i]);
+                ends.push_back(encoded.size());
+            }
+        }
+        if (count == 0) return true;
+        std::unique_ptr<ColdSegment> segment(new ColdSegment);
+        if (!ColdSegment::write(path, first, encoded, ends) || !segment->open(path)) return false;
+
+        std::unique_lock<std::shared_timed_mutex> lock(mutex);
+        cold.push_back(std::move(segment));
+        items.erase(items.begin(), items.begin() + count);
+        coldEnd += count;
+        return true;
+    }
+
+private:
+    struct CachedBlock {
+        const ColdSegment* segment; // nullptr once a read into it failed
+        size_t block;
+        uint64_t lastUse;
+        std::string raw;
+    };
+
+    mutable std::shared_timed_mutex mutex;
+    std::deque<T> items;     // Positions coldEnd on
+    std::vector<std::unique_ptr<ColdSegment>> cold; // Positions [0, coldEnd), in order
+    size_t coldEnd = 0;
+    mutable std::mutex cacheMutex; // Readers share `mutex`, so the cache has its own
+    mutable std::vector<CachedBlock> cache; // Decompressed blocks, at most COLD_CACHE_BLOCKS
+    mutable uint64_t cacheClock = 0;
+
+    // A default record if the block cannot be read (the file was checked
+    // when it was opened, so only a failing disk gets here)
+    T coldAtLocked(size_t index) const {
+        const ColdSegment& segment = **(std::upper_bound(cold.begin(), cold.end(), index,
+            [](size_t position, const std::unique_ptr<ColdSegment>& s) { return position < s->first(); }) - 1);
+        size_t block = segment.blockOf(index);
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        CachedBlock* found = nullptr;
+        for (CachedBlock& cached : cache) {
+            if (cached.segment == &segment && cached.block == block) found = &cached;
+        }
+        if (found == nullptr) {
+            if (cache.size() < COLD_CACHE_BLOCKS) {
+                cache.push_back(CachedBlock());
+                found = &cache.back();
+            } else {
+                found = &*std::min_element(cache.begin(), cache.end(), [](const CachedBlock& a, const CachedBlock& b) {
+                    return a.lastUse < b.lastUse;
+                });
+            }
+            found->segment = segment.readBlock(block, found->raw) ? &segment : nullptr;
+            found->block = block;
+            if (found->segment == nullptr) return T();
+        }
+        found->lastUse = ++cacheClock;
+        const ColdSegment::Block& entry = segment.block(block);
+        BinaryReader in = ColdSegment::recordIn(found->raw, entry.records, static_cast<uint32_t>(index - entry.first));
+        T record;
+        return decodeRecord(in, record) ? record : T();
+    }
+};
+
+// --- Gate Log ---
+// Entries and exits scanned at the college gates, kept as a time series.
+// Events are grouped into one segment per day, and inside a segment each
+// event is three varints: its time as a signed delta from the event before,
+// the person, and the gate with the direction in the low bit. That is
+// about 4-6 bytes an event. Every GATE_CHUNK_EVENTS events the segment
+// notes where the chunk starts and its earliest and latest time, so a time
+// range query decodes only the chunks that overlap the range. Scans that
+// arrive a little out of order (a scanner uploading late) are fine: deltas
+// may be negative and the chunk bounds still hold.
+//
+// People are interned by label: a registered user's email, or a visitor's
+// name as typed at the gate. For each person the log keeps their latest
+// event and the chunks they appear in (chunk numbers, delta-encoded), so
+// "last seen" is a lookup and a person's history decodes only their chunks
+// rather than whole days. Guarded externally by gateLock.
+
+struct GateEvent {
+    int64_t time;    // Seconds since 1970-01-01 on the college wall clock
+    uint32_t person;
+    uint32_t gate;
+    bool entering;
+};
+
+const size_t GATE_CHUNK_EVENTS = 64;
+
+inline int64_t dayOfSeconds(int64_t seconds) {
+    return seconds >= 0 ? seconds / 86400 : (seconds - 86399) / 86400;
+}
+
+class GateLog {
+public:
+    static const uint32_t npos = 0xFFFFFFFFu;
+
+    size_t eventCount() const { return events; }
+    size_t personCount() const { return people.size(); }
+    size_t gateCount() const { return gates.size(); }
+    const std::string& label(uint32_t person) const { return people[person].label; }
+    const std::string& gateName(uint32_t gate) const { return gates[gate]; }
+
+    // Labels match regardless of case; a person keeps the spelling first scanned
+    uint32_t findPerson(const std::string& label) const {
+        uint32_t found = personIndex.find(labelHash(label), [&](uint32_t p) { return sameLabel(people[p].label, label); });
+        return found == OpenHashIndex::npos ? npos : found;
+    }
+
+    uint32_t internPerson(const std::string& label) {
+        uint32_t person = findPerson(label);
+        if (person != npos) return person;
+        person = static_cast<uint32_t>(people.size());
+        people.push_back(Person());
+        people.back().label = label;
+        personIndex.insert(labelHash(label), person);
+        return person;
+    }
+
+    // A college has a handful of gates, so a scan finds them
+    uint32_t internGate(const std::string& name) {
+        for (uint32_t gate = 0; gate < gates.size(); gate++) {
+            if (sameLabel(gates[gate], name)) return gate;
+        }
+        gates.push_back(name);
+        return static_cast<uint32_t>(gates.size() - 1);
+    }
+
+    // person and gate must have been interned
+    void add(const GateEvent& event) {
+        int64_t day = dayOfSeconds(event.time);
+        auto found = segmentOfDay.find(day);
+        uint32_t id;
+        if (found != segmentOfDay.end()) {
+            id = found->second;
+        } else {
+            id = static_cast<uint32_t>(segments.size());
+            segments.emplace_back();
+            segments.back().day = day;
+            segments.back().lastTime = day * 86400;
+            segmentOfDay[day] = id;
+        }
+        DaySegment& segment = segments[id];
+        if (segment.count % GATE_CHUNK_EVENTS == 0) {
+            segment.chunks.push_back({static_cast<uint32_t>(segment.bytes.size()), segment.lastTime, event.time, event.time});
+            chunkRefs.push_back({id, static_cast<uint32_t>(segment.chunks.size() - 1)});
+            segment.openChunk = static_cast<uint32_t>(chunkRefs.size() - 1);
+        }
+        Chunk& chunk = segment.chunks.back();
+        chunk.minTime = std::min(chunk.minTime, event.time);
+        chunk.maxTime = std::max(chunk.maxTime, event.time);
+        int64_t delta = event.time - segment.lastTime;
+        putVarint(segment.bytes, (static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63)); // Zigzag
+        putVarint(segment.bytes, event.person);
+        putVarint(segment.bytes, (static_cast<uint64_t>(event.gate) << 1) | (event.entering ? 1 : 0));
+        segment.lastTime = event.time;
+        segment.count++;
+        events++;
+
+        Person& person = people[event.person];
+        if (person.chunkCount == 0 || person.lastChunk != segment.openChunk) {
+            int64_t step = static_cast<int64_t>(segment.openChunk) - (person.chunkCount == 0 ? 0 : person.lastChunk);
+            putVarint(person.chunks, (static_cast<uint64_t>(step) << 1) ^ static_cast<uint64_t>(step >> 63));
+            person.lastChunk = segment.openChunk;
+            person.chunkCount++;
+        }
+        if (!person.seen || event.time >= person.last.time) {
+            person.seen = true;
+            person.last = event;
+        }
+    }
+
+    // False when the person has never been scanned
+    bool lastSeen(uint32_t person, GateEvent& event) const {
+        if (person >= people.size() || !people[person].seen) return false;
+        event = people[person].last;
+        return true;
+    }
+
+    size_t eventsOn(int64_t day) const {
+        auto found = segmentOfDay.find(day);
+        return found == segmentOfDay.end() ? 0 : segments[found->second].count;
+    }
+
+    // Events from `from` to `to` (inclusive), only entries if enteringOnly,
+    // oldest first
+    void between(int64_t from, int64_t to, bool enteringOnly, std::vector<GateEvent>& found) const {
+        found.clear();
+        for (auto it = segmentOfDay.lower_bound(dayOfSeconds(from)); it != segmentOfDay.end() && it->first <= dayOfSeconds(to); ++it) {
+            collect(segments[it->second], from, to, [&](const GateEvent& event) {
+                return !enteringOnly || event.entering;
+            }, found);
+        }
+        sortByTime(found);
+    }
+
+    // One person's events from `from` to `to`, oldest first
+    void history(uint32_t person, int64_t from, int64_t to, std::vector<GateEvent>& found) const {
+        found.clear();
+        if (person >= people.size()) return;
+        // A person's chunks only repeat when scans for two days interleave
+        std::vector<uint32_t> chunks;
+        chunks.reserve(people[person].chunkCount);
+        const std::string& encoded = people[person].chunks;
+        const char* cursor = encoded.data();
+        int64_t chunk = 0;
+        for (uint64_t step; getVarint(cursor, encoded.data() + encoded.size(), step);) {
+            chunk += static_cast<int64_t>(step >> 1) ^ -static_cast<int64_t>(step & 1);
+            chunks.push_back(static_cast<uint32_t>(chunk));
+        }
+        std::sort(chunks.begin(), chunks.end());
+        chunks.erase(std::unique(chunks.begin(), chunks.end()), chunks.end());
+        for (uint32_t c : chunks) {
+            const DaySegment& segment = segments[chunkRefs[c].segment];
+            collectChunk(segment, chunkRefs[c].chunk, from, to, [&](const GateEvent& event) { return event.person == person; }, found);
+        }
+        sortByTime(found);
+    }
+
+    // Segments in the order they were started, for the snapshot
+    size_t segmentCount() const { return segments.size(); }
+    int64_t segmentDay(size_t id) const { return segments[id].day; }
+    uint32_t segmentEvents(size_t id) const { return segments[id].count; }
+    const std::string& segmentBytes(size_t id) const { return segments[id].bytes; }
+
+    // Adds the events of a saved segment; false if the bytes do not decode
+    // to `count` events of known people and gates
+    bool addSegment(int64_t day, uint32_t count, const std::string& bytes) {
+        std::vector<GateEvent> decoded;
+        decoded.reserve(count);
+        const char* cursor = bytes.data();
+        if (!decode(cursor, bytes.data() + bytes.size(), day * 86400, [&](const GateEvent& event) {
+                if (event.person >= people.size() || event.gate >= gates.size() || dayOfSeconds(event.time) != day) return false;
+                decoded.push_back(event);
+                return true;
+            }) || decoded.size() != count) {
+            return false;
+        }
+        for (const GateEvent& event : decoded) add(event);
+        return true;
+    }
+
+    // Heap bytes, for the benchmark
+    size_t memoryUsage() const {
+        size_t bytes = segments.capacity() * sizeof(DaySegment) + people.capacity() * sizeof(Person) +
+                       chunkRefs.capacity() * sizeof(ChunkRef);
+        for (const DaySegment& segment : segments) bytes += segment.bytes.capacity() + segment.chunks.capacity() * sizeof(Chunk);
+        for (const Person& person : people) bytes += person.chunks.capacity();
+        return bytes;
+    }
+
+private:
+    struct Chunk {
+        uint32_t offset;   // Into the segment's bytes
+        int64_t startTime; // Time of the event before it, which the first delta is from
+        int64_t minTime;
+        int64_t maxTime;
+    };
+
+    struct ChunkRef {
+        uint32_t segment;
+        uint32_t chunk; // Within the segment
+    };
+
+    struct DaySegment {
+        int64_t day = 0;
+        int64_t lastTime = 0;
+        uint32_t count = 0;
+        uint32_t openChunk = 0; // Number of the chunk being filled
+        std::string bytes;
+        std::vector<Chunk> chunks;
+    };
+
+    struct Person {
+        std::string label;
+        bool seen = false;
+        GateEvent last = {0, 0, 0, false};
+        std::string chunks;     // Numbers of the chunks they appear in, as zigzag varint steps
+        uint32_t chunkCount = 0;
+        uint32_t lastChunk = 0;
+    };
+
+    std::vector<DaySegment> segments;
+    std::vector<ChunkRef> chunkRefs; // Chunks numbered in the order they were started
+    std::map<int64_t, uint32_t> segmentOfDay;
+    std::vector<Person> people;
+    OpenHashIndex personIndex; // Hash of a label -> person
+    std::vector<std::string> gates;
+    size_t events = 0;
+
+    static uint64_t labelHash(const std::string& label) {
+        uint64_t hash = 14695981039346656037ULL;
+        for (char c : label) {
+            hash ^= static_cast<unsigned char>(tolower(static_cast<unsigned char>(c)));
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    static bool sameLabel(const std::string& a, const std::string& b) {
+        if (a.size() != b.size()) return false;
+        for (size_t i = 0; i < a.size(); i++) {
+            if (tolower(static_cast<unsigned char>(a[i])) != tolower(static_cast<unsigned char>(b[i]))) return false;
+        }
+        return true;
+    }
+
+    // Calls visit(event) for the events encoded in [cursor, end), the first
+    // one relative to `time`, while visit returns true
+    template <typename Visit>
+    static bool decode(const char*& cursor, const char* end, int64_t time, Visit visit) {
+        uint64_t delta, person, gate;
+        while (cursor < end) {
+            if (!getVarint(cursor, end, delta) || !getVarint(cursor, end, person) || !getVarint(cursor, end, gate)) return false;
+            time += static_cast<int64_t>(delta >> 1) ^ -static_cast<int64_t>(delta & 1);
+            if (!visit(GateEvent{time, static_cast<uint32_t>(person), static_cast<uint32_t>(gate >> 1), (gate & 1) != 0})) return false;
+        }
+        return true;
+    }
+
+    template <typename Keep>
+    void collect(const DaySegment& segment, int64_t from, int64_t to, Keep keep, std::vector<GateEvent>& found) const {
+        for (size_t c = 0; c < segment.chunks.size(); c++) collectChunk(segment, c, from, to, keep, found);
+    }
+
+    template <typename Keep>
+    void collectChunk(const DaySegment& segment, size_t c, int64_t from, int64_t to, Keep keep,
+                      std::vector<GateEvent>& found) const {
+        const Chunk& chunk = segment.chunks[c];
+        if (chunk.maxTime < from || chunk.minTime > to) return;
+        const char* cursor = segment.bytes.data() + chunk.offset;
+        const char* end = segment.bytes.data() + (c + 1 < segment.chunks.size() ? segment.chunks[c + 1].offset : segment.bytes.size());
+        decode(cursor, end, chunk.startTime, [&](const GateEvent& event) {
+            if (event.time >= from && event.time <= to && keep(event)) found.push_back(event);
+            return true;
+        });
+    }
+
+    // Stable, so scans with the same time keep the order they came in
+    static void sortByTime(std::vector<GateEvent>& found) {
+        std::stable_sort(found.begin(), found.end(), [](const GateEvent& a, const GateEvent& b) { return a.time < b.time; });
+    }
+};
+
+const uint32_t GateLog::npos;
+
+// --- Write-Ahead Log ---
+// Every change is appended here (and flushed to disk) before it is applied
+// in memory, so a crash loses nothing that was acknowledged. A background
+// flusher writes whatever has accumulated in one go and fsyncs once per
+// batch ("group commit"): writers that arrive within the commit window share
+// a single fsync instead of paying one each.
+//
+// Frame: u32 payloadLength | u64 checksum | u8 type | u64 lsn | payload
+// The checksum covers type, lsn and payload; a torn frame ends the log.
+
+enum WalRecordType : uint8_t {
+    WAL_ADD_USER = 1,
+    WAL_ADD_COMPLAINT_V1 = 2,    // Unnumbered, written by older builds; still replayed
+    WAL_ADD_LEAVE_NOTICE_V1 = 3,
+    WAL_ADD_ATTENDANCE = 4,
+    WAL_ADD_RESULTS = 5,
+    WAL_ADD_COMPLAINT = 6,
+    WAL_ADD_LEAVE_NOTICE_V2 = 7, // Numbered, without the parsed date range
+    WAL_ENROLLMENT = 8,
+    WAL_ADD_CALENDAR_ENTRY = 9,
+    WAL_PUBLISH_ALERT = 10,
+    WAL_MARK_ALERTS_READ = 11,
+    WAL_ADD_LEAVE_NOTICE = 12,
+    WAL_UPDATE_CASE = 13,
+    WAL_MARK_CASES_SEEN = 14,
+    WAL_IMPORT_USERS = 15,       // A whole roster: u64 count, then that many users
+    WAL_ADD_BOOK = 16,
+    WAL_LEND_BOOK = 17,
+    WAL_RETURN_BOOK = 18,
+    WAL_GATE_SCANS = 19,         // u64 count, then that many scans (see encodeGateScans)
+    WAL_SET_PASSWORD = 20        // u32 user | str stored password (a rehash at login)
+};
+
+const size_t WAL_FRAME_HEADER_SIZE = 4 + 8 + 1 + 8;
+const size_t WAL_CHECKSUM_START = 4 + 8;
+
+class WriteAheadLog {
+public:
+    WriteAheadLog()
+        : file(nullptr), nextLsn(1), appendedLsn(0), writtenLsn(0), durableLsn(0), goodBytes(0), running(false),
+          stopping(false), commitWindow(1000), maxBatchBytes(1 << 20), batches(0) {}
+    ~WriteAheadLog() { close(); }
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    // How long the flusher waits for more writers to join a batch, and how
+    // many buffered bytes end that wait early. A window of 0 flushes at once.
+    void configure(std::chrono::microseconds window, size_t batchBytes) {
+        std::lock_guard<std::mutex> lock(mutex);
+        commitWindow = window;
+        maxBatchBytes = batchBytes;
+    }
+
+    // Opens (or creates) the log for appending; new records follow lastLsn
+    bool open(const std::string& filePath, uint64_t lastLsn) {
+        close();
+        file = fopen(filePath.c_str(), "ab");
+        if (file == nullptr) return false;
+        if (fseek(file, 0, SEEK_END) != 0) {
+            fclose(file);
+            file = nullptr;
+            return false;
+        }
+        goodBytes = static_cast<uint64_t>(ftell(file));
+        path = filePath;
+        nextLsn = lastLsn + 1;
+        appendedLsn = writtenLsn = durableLsn = lastLsn;
+        lostBatches.clear();
+        stopping = false;
+        running = true;
+        flusher = std::thread(&WriteAheadLog::flushLoop, this);
+        return true;
+    }
+
+    bool isOpen() const { return running; }
+
+    // Flushes anything still pending and stops the flusher
+    void close() {
+        if (!running) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wakeFlusher.notify_all();
+        flusher.join();
+        running = false;
+        if (file != nullptr) fclose(file);
+        file = nullptr;
+    }
+
+    // Empties the log once its contents are covered by a snapshot
+    bool reset() {
+        if (!running) return false;
+        std::string filePath = path;
+        uint64_t lastLsn = this->lastLsn();
+        close();
+        return truncateFile(filePath, 0) && open(filePath, lastLsn);
+    }
+
+    // Queues a record and returns its LSN; it is durable once waitDurable(lsn) returns
+    uint64_t append(WalRecordType type, const BinaryWriter& payload) {
+        BinaryWriter frame;
+        frame.u32(static_cast<uint32_t>(payload.size()));
+        frame.u64(0); // checksum, patched once the LSN is known
+        frame.u8(type);
+        frame.u64(0); // lsn
+        frame.raw(payload.data(), payload.size());
+
+        uint64_t lsn;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            lsn = nextLsn++;
+            frame.patchU64(WAL_CHECKSUM_START + 1, lsn);
+            frame.patchU64(4, checksumBytes(frame.data() + WAL_CHECKSUM_START, frame.size() - WAL_CHECKSUM_START));
+            pending.insert(pending.end(), frame.data(), frame.data() + frame.size());
+            appendedLsn = lsn;
+        }
+        wakeFlusher.notify_one();
+        return lsn;
+    }
+
+    // Blocks until the record is on disk; false if the disk write failed.
+    // A failed write loses only its own batch: later records are retried.
+    bool waitDurable(uint64_t lsn) {
+        std::unique_lock<std::mutex> lock(mutex);
+        becameDurable.wait(lock, [&] { return writtenLsn >= lsn; });
+        for (const auto& lost : lostBatches) {
+            if (lsn >= lost.first && lsn <= lost.second) return false;
+        }
+        return durableLsn >= lsn;
+    }
+
+    bool commit(WalRecordType type, const BinaryWriter& payload) {
+        return waitDurable(append(type, payload));
+    }
+
+    uint64_t lastLsn() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return appendedLsn;
+    }
+
+    // Number of write+fsync rounds so far (one per group commit)
+    uint64_t batchesWritten() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return batches;
+    }
+
+private:
+    FILE* file;
+    std::string path;
+    std::thread flusher;
+    std::mutex mutex;
+    std::condition_variable wakeFlusher;
+    std::condition_variable becameDurable;
+    std::vector<char> pending; // Frames not yet written
+    uint64_t nextLsn;
+    uint64_t appendedLsn;
+    uint64_t writtenLsn; // Last LSN whose batch has been written or given up on
+    uint64_t durableLsn;
+    std::vector<std::pair<uint64_t, uint64_t>> lostBatches; // LSN ranges whose write failed
+    uint64_t goodBytes; // Log length after the last complete batch
+    bool running;
+    bool stopping;
+    std::chrono::microseconds commitWindow;
+    size_t maxBatchBytes;
+    uint64_t batches;
+
+    void flushLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wakeFlusher.wait(lock, [&] { return stopping || !pending.empty(); });
+            if (pending.empty()) break; // Stopping with nothing left to write
+
+            // Hold the batch open briefly so concurrent writers can join it
+            if (!stopping && commitWindow.count() > 0 && pending.size() < maxBatchBytes) {
+                wakeFlusher.wait_for(lock, commitWindow, [&] {
+                    return stopping || pending.size() >= maxBatchBytes;
+                });
+            }
+
+            std::vector<char> batch;
+            batch.swap(pending);
+            uint64_t firstLsn = writtenLsn + 1;
+            uint64_t batchLsn = appendedLsn;
+            lock.unlock();
+            bool ok = (file != nullptr || reopen()) && fwrite(batch.data(), 1, batch.size(), file) == batch.size() &&
+                      syncFile(file);
+            if (ok) {
+                goodBytes += batch.size();
+            } else if (file != nullptr) {
+                // Drop whatever part of the batch reached the file so the
+                // next batch follows the last good frame; reopened then
+                fclose(file);
+                file = nullptr;
+                truncateFile(path, goodBytes);
+            }
+            lock.lock();
+
+            batches++;
+            writtenLsn = batchLsn;
+            if (ok) {
+                durableLsn = batchLsn;
+            } else {
+                lostBatches.push_back({firstLsn, batchLsn});
+            }
+            becameDurable.notify_all();
+        }
+    }
+
+    // Flusher thread only: opens the log again after a failed write
+    bool reopen() {
+        if (!truncateFile(path, goodBytes)) return false;
+        file = fopen(path.c_str(), "ab");
+        return file != nullptr;
+    }
+};
+
+// --- Submission Queue ---
+// Complaints and leave notices are pushed onto a lock-free multi-producer /
+// single-consumer queue and the student's session moves on at once. One
+// background consumer drains the queue in batches: it numbers and timestamps
+// each submission, logs the batch with a single wait for the disk, then
+// appends it to the shared lists. Submitting therefore costs the same no
+// matter how slow the disk is or how long a teacher holds a list open.
+
+// Vyukov's intrusive MPSC queue: a push is one atomic exchange plus a store,
+// so producers never wait for each other or for the consumer
+template <typename T>
+class MpscQueue {
+public:
+    MpscQueue() : head(new Node()), tail(head.load()) {}
+    ~MpscQueue() {
+        T ignored;
+        while (pop(ignored)) {}
+        delete tail;
+    }
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // Any thread
+    void push(T value) {
+        Node* node = new Node(std::move(value));
+        Node* previous = head.exchange(node);
+        previous->next.store(node);
+    }
+
+    // Consumer thread only. May miss an item whose push is still half done;
+    // callers find it on their next pass.
+    bool pop(T& value) {
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (next == nullptr) return false;
+        value = std::move(next->value);
+        delete tail;
+        tail = next; // The popped node becomes the new dummy
+        return true;
+    }
+
+private:
+    struct Node {
+        Node() : next(nullptr) {}
+        explicit Node(T item) : next(nullptr), value(std::move(item)) {}
+        std::atomic<Node*> next;
+        T value;
+    };
+
+    std::atomic<Node*> head; // Most recently pushed node
+    Node* tail;              // Dummy node; its successor is the oldest item
+};
+
+struct Submission {
+    enum Kind : uint8_t { COMPLAINT, LEAVE_NOTICE } kind;
+    Complaint complaint;
+    LeaveNotice notice;
+};
+
+class SubmissionQueue {
+public:
+    typedef std::function<void(std::vector<Submission>&)> BatchHandler;
+
+    SubmissionQueue() : submitted(0), stored(0), consumerSleeping(false), stopping(false), maxBatch(256) {}
+    ~SubmissionQueue() { stop(); }
+    SubmissionQueue(const SubmissionQueue&) = delete;
+    SubmissionQueue& operator=(const SubmissionQueue&) = delete;
+
+    // Starts the consumer; handler gets batches of at most batchSize items
+    void start(BatchHandler handler, size_t batchSize) {
+        stop();
+        storeBatch = std::move(handler);
+        maxBatch = batchSize;
+        stopping = false;
+        consumer = std::thread(&SubmissionQueue::consume, this);
+    }
+
+    bool isRunning() const { return consumer.joinable(); }
+
+    // Returns as soon as the submission is queued
+    void submit(Submission submission) {
+        queue.push(std::move(submission));
+        submitted.fetch_add(1);
+        // The consumer announces that it is about to sleep before its last look
+        // at `submitted`, so one of the two always sees the other
+        if (consumerSleeping.load()) {
+            std::lock_guard<std::mutex> lock(mutex);
+            wakeConsumer.notify_one();
+        }
+    }
+
+    // Blocks until everything submitted before the call has been stored
+    void flush() {
+        uint64_t target = submitted.load();
+        std::unique_lock<std::mutex> lock(mutex);
+        batchStored.wait(lock, [&] { return stored >= target || !consumer.joinable(); });
+    }
+
+    // Stores whatever is still queued and ends the consumer. Call once no
+    // more submissions can arrive (e.g. after the server's sessions ended).
+    void stop() {
+        if (!consumer.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wakeConsumer.notify_one();
+        consumer.join();
+        batchStored.notify_all();
+    }
+
+private:
+    MpscQueue<Submission> queue;
+    std::atomic<uint64_t> submitted;
+    uint64_t stored; // Guarded by mutex
+    std::atomic<bool> consumerSleeping;
+    bool stopping;
+    size_t maxBatch;
+    BatchHandler storeBatch;
+    std::thread consumer;
+    std::mutex mutex;
+    std::condition_variable wakeConsumer;
+    std::condition_variable batchStored;
+
+    void consume() {
+        std::vector<Submission> batch;
+        uint64_t taken;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            taken = stored; // Counts carry over when the queue is restarted
+        }
+        while (true) {
+            batch.clear();
+            Submission item;
+            while (batch.size() < maxBatch && queue.pop(item)) batch.push_back(std::move(item));
+
+            if (batch.empty()) {
+                std::unique_lock<std::mutex> lock(mutex);
+                consumerSleeping.store(true);
+                if (submitted.load() == taken) {
+                    if (stopping) break;
+                    wakeConsumer.wait(lock);
+                }
+                consumerSleeping.store(false);
+                continue;
+            }
+
+            taken += batch.size();
+            storeBatch(batch);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stored = taken;
+            }
+            batchStored.notify_all();
+        }
+        consumerSleeping.store(false);
+    }
+};
+
+// --- Metrics ---
+// Latency histograms and counters for the hot paths. Each thread records
+// into its own shard with relaxed loads and stores (no locked instructions,
+// no shared cache lines); a reader sums the shards. Buckets are log-linear
+// like HDR histograms: exact below 16 ns, then 16 per power of two, so a
+// percentile is never off by more than 1/16 (6.25%).
+
+enum MetricOperation : uint8_t {
+    OP_LOGIN,
+    OP_REGISTER,
+    OP_DASHBOARD,       // Drawing a dashboard menu
+    OP_ATTENDANCE_ROLL, // Building the roll, with leave excusals
+    OP_ATTENDANCE_SAVE, // Logging and storing a marked session
+    OP_SUBMIT,          // Queueing a complaint or leave notice
+    OP_STORE_BATCH,     // The consumer logging and storing one batch
+    OP_SEARCH,
+    OP_COUNT
+};
+const char* const OPERATION_NAMES[OP_COUNT] = {"login", "register", "dashboard", "attendance_roll",
+                                               "attendance_save", "submit", "store_batch", "search"};
+
+enum MetricCounter : uint8_t {
+    COUNTER_LOGIN_FAILURES,
+    COUNTER_REGISTRATIONS_REJECTED,
+    COUNTER_STUDENTS_MARKED,
+    COUNTER_SUBMISSIONS_STORED,
+    COUNTER_LOGINS_THROTTLED,
+    COUNTER_PASSWORDS_UPGRADED,
+    COUNTER_COUNT
+};
+const char* const COUNTER_NAMES[COUNTER_COUNT] = {"login_failures", "registrations_rejected", "students_marked",
+                                                  "submissions_stored", "logins_throttled", "passwords_upgraded"};
+
+const uint32_t HISTOGRAM_SUB_BITS = 4;
+const uint32_t HISTOGRAM_SUB_COUNT = 1u << HISTOGRAM_SUB_BITS;
+const uint32_t HISTOGRAM_MAX_EXPONENT = 42; // About 73 minutes; longer values land in the last bucket
+const size_t HISTOGRAM_BUCKETS = (HISTOGRAM_MAX_EXPONENT - HISTOGRAM_SUB_BITS + 2) * HISTOGRAM_SUB_COUNT;
+
+inline size_t histogramBucket(uint64_t nanos) {
+    if (nanos < HISTOGRAM_SUB_COUNT) return static_cast<size_t>(nanos);
+    uint32_t exponent = 63 - static_cast<uint32_t>(__builtin_clzll(nanos));
+    if (exponent > HISTOGRAM_MAX_EXPONENT) return HISTOGRAM_BUCKETS - 1;
+    uint32_t shift = exponent - HISTOGRAM_SUB_BITS;
+    return (shift + 1) * HISTOGRAM_SUB_COUNT + ((nanos >> shift) & (HISTOGRAM_SUB_COUNT - 1));
+}
+
+// Smallest value in the bucket; the bucket ends where the next one starts
+inline uint64_t histogramBucketStart(size_t bucket) {
+    if (bucket < HISTOGRAM_SUB_COUNT) return bucket;
+    uint32_t shift = static_cast<uint32_t>(bucket / HISTOGRAM_SUB_COUNT) - 1;
+    return (HISTOGRAM_SUB_COUNT + bucket % HISTOGRAM_SUB_COUNT) << shift;
+}
+
+struct OperationLatency {
+    uint64_t count = 0;
+    uint64_t totalNanos = 0;
+    uint64_t maxNanos = 0;
+    std::vector<uint64_t> buckets = std::vector<uint64_t>(HISTOGRAM_BUCKETS, 0);
+
+    // Upper edge of the bucket holding the fraction-th value (0.99 for p99)
+    uint64_t percentile(double fraction) const {
+        if (count == 0) return 0;
+        uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(fraction * count)));
+        uint64_t seen = 0;
+        for (size_t b = 0; b < buckets.size(); b++) {
+            seen += buckets[b];
+            if (seen >= rank) return std::min(maxNanos, histogramBucketStart(b + 1) - 1);
+        }
+        return maxNanos;
+    }
+};
+
+struct MetricsSnapshot {
+    OperationLatency operations[OP_COUNT];
+    uint64_t counters[COUNTER_COUNT] = {};
+};
+
+class MetricsRegistry {
+public:
+    MetricsRegistry() = default;
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+    void setEnabled(bool on) { enabled.store(on, std::memory_order_relaxed); }
+
+    void record(MetricOperation op, uint64_t nanos) {
+        Shard& shard = local();
+        bump(shard.buckets[op][histogramBucket(nanos)], 1);
+        bump(shard.count[op], 1);
+        bump(shard.totalNanos[op], nanos);
+        if (nanos > shard.maxNanos[op].load(std::memory_order_relaxed)) {
+            shard.maxNanos[op].store(nanos, std::memory_order_relaxed);
+        }
+    }
+
+    void count(MetricCounter counter, uint64_t amount = 1) {
+        if (isEnabled()) bump(local().counters[counter], amount);
+    }
+
+    // Sums every shard, including those of threads that have ended
+    void snapshot(MetricsSnapshot& out) const {
+        out = MetricsSnapshot();
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& shard : shards) {
+            for (int op = 0; op < OP_COUNT; op++) {
+                OperationLatency& latency = out.operations[op];
+                latency.count += shard->count[op].load(std::memory_order_relaxed);
+                latency.totalNanos += shard->totalNanos[op].load(std::memory_order_relaxed);
+                latency.maxNanos = std::max(latency.maxNanos, shard->maxNanos[op].load(std::memory_order_relaxed));
+                for (size_t b = 0; b < HISTOGRAM_BUCKETS; b++) {
+                    latency.buckets[b] += shard->buckets[op][b].load(std::memory_order_relaxed);
+                }
+            }
+            for (int c = 0; c < COUNTER_COUNT; c++) out.counters[c] += shard->counters[c].load(std::memory_order_relaxed);
+        }
+    }
+
+private:
+    struct Shard {
+        std::atomic<uint64_t> buckets[OP_COUNT][HISTOGRAM_BUCKETS];
+        std::atomic<uint64_t> count[OP_COUNT];
+        std::atomic<uint64_t> totalNanos[OP_COUNT];
+        std::atomic<uint64_t> maxNanos[OP_COUNT];
+        std::atomic<uint64_t> counters[COUNTER_COUNT];
+    };
+
+    // Hands a thread's shard back when the thread ends, for the next thread
+    struct Lease {
+        MetricsRegistry* owner = nullptr;
+        Shard* shard = nullptr;
+        ~Lease() {
+            if (shard == nullptr) return;
+            std::lock_guard<std::mutex> lock(owner->mutex);
+            owner->idle.push_back(shard);
+        }
+    };
+
+    std::atomic<bool> enabled{true};
+    mutable std::mutex mutex; // shards and idle; never taken while recording
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::vector<Shard*> idle;
+
+    // Only the owning thread writes, so a plain add is enough
+    static void bump(std::atomic<uint64_t>& value, uint64_t amount) {
+        value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    Shard& local() {
+        static thread_local Lease lease;
+        if (lease.shard == nullptr) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (idle.empty()) {
+                shards.emplace_back(new Shard()); // Value-initialized: every counter starts at 0
+                idle.push_back(shards.back().get());
+            }
+            lease.owner = this;
+            lease.shard = idle.back();
+            idle.pop_back();
+        }
+        return *lease.shard;
+    }
+};
+
+// Runs a task every interval on a background thread, and once more when stopped
+class PeriodicTask {
+public:
+    PeriodicTask() = default;
+    ~PeriodicTask() { stop(); }
+    PeriodicTask(const PeriodicTask&) = delete;
+    PeriodicTask& operator=(const PeriodicTask&) = delete;
+
+    void start(std::function<void()> work, std::chrono::seconds every) {
+        stop();
+        task = std::move(work);
+        interval = every;
+        stopping = false;
+        worker = std::thread([this]() {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!stopping) {
+                if (wake.wait_for(lock, interval, [this] { return stopping; })) break;
+                lock.unlock();
+                task();
+                lock.lock();
+            }
+            lock.unlock();
+            task();
+        });
+    }
+
+    void stop() {
+        if (!worker.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        worker.join();
+    }
+
+private:
+    std::function<void()> task;
+    std::chrono::seconds interval{10};
+    bool stopping = false; // Guarded by mutex
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+};
+
+// --- Global User & Shared Data Storage (In-memory "database") ---
+// users, the complaint/leave lists and subjects lock internally; the stores
+// below are guarded by their own locks so one kind of traffic never queues
+// behind another. Take at most one of these locks at a time.
+UserDirectory users;
+SharedRecordList<Complaint> studentComplaints;
+SharedRecordList<LeaveNotice> studentLeaveNotices;
+LeaveIndex leaveIndex;     // Dated studentLeaveNotices by day
+TextIndex complaintSearch; // Words of each complaint message, by position in studentComplaints
+TextIndex leaveSearch;     // Words of each leave reason, by position in studentLeaveNotices
+CaseTracker complaintCases; // Status of each studentComplaints entry
+CaseTracker leaveCases;     // Status of each studentLeaveNotices entry
+std::shared_timed_mutex casesLock; // Both trackers; updates log and apply under it
+SubjectCatalog subjects;
+AttendanceStore attendance;
+std::shared_timed_mutex attendanceLock;
+EnrollmentStore enrollment;
+std::shared_timed_mutex enrollmentLock;
+Calendar calendar;
+std::shared_timed_mutex calendarLock;
+Library library;
+std::shared_timed_mutex libraryLock;
+GateLog gateLog;
+std::shared_timed_mutex gateLock;
+AlertCenter alerts;        // Locks internally
+std::mutex alertPublishLock; // Keeps alerts in log order, so replay numbers them the same
+GradeStore grades;
+GradeAnalytics gradeAnalytics;
+std::mutex resultsLock;    // grades and gradeAnalytics (a refresh writes to the analytics)
+std::mutex registrationLock; // Keeps duplicate checks, logging and adding a user in one order
+PasswordWorkers passwordWorkers; // Started by main; hashing runs on the caller until then
+LoginThrottle loginThrottle;
+SubmissionQueue submissions;  // Feeds studentComplaints and studentLeaveNotices
+uint64_t lastSubmissionSequence = 0; // Owned by the submission consumer while it runs
+
+MetricsRegistry metrics;   // Locks internally; recording takes no lock
+PeriodicTask metricsDump;  // Rewrites the --metrics-file, if one was given
+PeriodicTask archiver;     // Moves old records to cold segments while the program runs
+
+// Times its scope into `metrics` (a no-op while metrics are disabled)
+class OperationTimer {
+public:
+    explicit OperationTimer(MetricOperation op) : op(op), running(metrics.isEnabled()) {
+        if (running) start = std::chrono::steady_clock::now();
+    }
+    ~OperationTimer() {
+        if (!running) return;
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        metrics.record(op, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+    OperationTimer(const OperationTimer&) = delete;
+    OperationTimer& operator=(const OperationTimer&) = delete;
+
+private:
+    MetricOperation op;
+    bool running;
+    std::chrono::steady_clock::time_point start;
+};
+
+// --- Durability ---
+const char* const WAL_FILE = "college_alerter.wal";
+WriteAheadLog wal;
+uint64_t snapshotWalLsn = 0; // Last WAL record already folded into the snapshot
+const char* const COLD_FILE_PREFIX = "college_alerter."; // Archive segments, see archiveRecords
+long archiveAfterDays = 365;  // Older (or closed) records are archived; 0 keeps all in memory
+const size_t ARCHIVE_MIN_RECORDS = 1000; // Smaller batches wait, so segments stay few and large
+const long ARCHIVE_INTERVAL_SECONDS = 3600; // How often a running program archives between checkpoints
+const char* const IMPORT_DIR = "imports"; // Roster files are read from here only
+const char* const EXPORT_DIR = "exports"; // Exports are written here only
+
+// --- Function Declarations ---
+void runMainMenu();
+void displayMainMenu(std::ostream& screen);
+void handleRegistration();
+bool handleLogin(UserHandle& loggedInUser); // Pass by reference to store the logged-in user
+
+// The operations behind the menus, shared with batch mode
+enum class RegistrationStatus { REGISTERED, DUPLICATE, NOT_SAVED };
+RegistrationStatus registerUser(const User& newUser);
+UserHandle authenticate(const std::string& email, const std::string& password);
+int64_t loginLockout(const std::string& email);
+size_t hashPlaintextPasswords();
+void submitComplaint(UserHandle student, std::string message);
+void submitLeaveNotice(UserHandle student, LeaveNotice notice);
+void attendanceRoll(const std::string& subjectName, const std::string& date,
+                    std::vector<uint32_t>& roll, std::vector<uint32_t>& onLeave);
+bool saveAttendance(const std::string& subjectName, AttendanceSession session);
+
+// Student Dashboard & Functions
+void showStudentDashboard(UserHandle user);
+void displayCollegeEvents(Role viewer);
+void displayAttendance(UserHandle student);
+void handleComplaintBox(UserHandle student); // Pass student info
+void handleLeaveNotice(UserHandle student); // Pass student info
+void displayResults(UserHandle student);
+
+// Teacher Dashboard & Functions
+void showTeacherDashboard(UserHandle user);
+void displayTeacherMeetings(UserHandle user);
+void handleResultUpload(UserHandle teacher);
+void handleAttendanceTaking();
+void viewStudentComplaints(UserHandle teacher);
+void viewStudentLeaveNotices(UserHandle teacher);
+void displayStudentsOnLeave();
+void displayAttendanceShortages();
+void displayResultsAnalytics();
+void handleEnrollment();
+
+// Non-Teaching Staff Dashboard
+void showNonTeachingStaffDashboard(UserHandle user);
+
+// Results Upload (CSV ingestion)
+bool parseResultsFile(const std::string& path, unsigned threadCount,
+                      std::vector<ParsedGrade>& parsed, ResultsFileReport& report);
+void applyResults(uint32_t subject, uint8_t semester, uint8_t credits, const std::vector<ParsedGrade>& parsed);
+void encodeResults(BinaryWriter& out, uint32_t subject, uint8_t semester, uint8_t credits,
+                   const std::vector<ParsedGrade>& parsed);
+
+// Roster Import
+bool parseRosterFile(const std::string& path, unsigned threadCount, std::vector<User>& parsed,
+                     RosterFileReport& report);
+bool importUsers(std::vector<User>& batch, size_t& skipped);
+void encodeUserBatch(BinaryWriter& out, const std::vector<User>& batch);
+void handleRosterImport();
+
+// Calendar
+void listUpcomingEntries(uint8_t audience);
+void handleCalendarBooking(UserHandle organizer, bool isMeeting);
+void encodeCalendarEntry(BinaryWriter& out, const CalendarEntry& entry);
+
+// Library
+void handleLibrary();
+void encodeBook(BinaryWriter& out, const std::string& isbn, const std::string& title, const std::string& author,
+                uint32_t copies);
+void encodeLoan(BinaryWriter& out, const Loan& loan);
+
+// Gate Log
+void handleGateLog();
+bool parseGateTime(const std::string& text, int64_t& seconds);
+std::string formatGateTime(int64_t seconds);
+std::string gatePersonLabel(const std::string& typed);
+const char* parseGateScan(const std::string& line, GateScan& scan);
+bool recordGateScans(const std::vector<GateScan>& scans);
+void applyGateScans(const std::vector<GateScan>& scans);
+void ingestGateScans(std::istream& in, GateScanReport& report);
+bool importGateScans(const std::string& path, GateScanReport& report);
+void encodeGateScans(BinaryWriter& out, const std::vector<GateScan>& scans);
+
+// Alerts
+void displayAlerts(UserHandle user);
+void handleAnnouncement(UserHandle sender);
+size_t publishAlert(const std::string& from, const std::string& text, AlertTarget target);
+size_t applyAlert(AlertRecord record, const AlertTarget& target);
+void encodeAlert(BinaryWriter& out, const AlertRecord& record, const AlertTarget& target);
+
+// Complaint and Leave Workflow
+CaseTracker& casesOf(CaseKind kind);
+std::string caseSummary(CaseKind kind, UserHandle teacher);
+bool updateCase(CaseKind kind, uint32_t id, uint8_t status, UserHandle assignee);
+void markCasesSeen(CaseKind kind, UserHandle teacher, size_t listSize);
+void handleComplaintUpdate(UserHandle teacher, uint32_t id);
+void handleLeaveDecision(UserHandle teacher, uint32_t id);
+void printCaseStatus(CaseKind kind, uint32_t id);
+void dropRejectedLeave(std::vector<LeaveEntry>& found);
+void keepApprovedLeave(std::vector<LeaveEntry>& found);
+void alertStudent(const std::string& email, UserHandle teacher, const std::string& text);
+
+// Enrollment
+void resolveStudentIds(const std::string& line, std::vector<uint32_t>& slots, std::vector<std::string>& unknown);
+void encodeEnrollment(BinaryWriter& out, uint32_t subject, bool enrolling, const std::vector<uint32_t>& slots);
+size_t applyEnrollment(uint32_t subject, bool enrolling, const std::vector<uint32_t>& slots);
+
+// Helper Function
+void ignoreLine();
+
+// Snapshot Persistence (saves/restores the global stores above)
+const char* const SNAPSHOT_FILE = "college_alerter.snap";
+bool saveSnapshot(const std::string& path);
+bool loadSnapshot(const std::string& path);
+void encodeUser(BinaryWriter& out, const User& user);
+void encodeComplaint(BinaryWriter& out, const Complaint& complaint);
+void encodeLeaveNotice(BinaryWriter& out, const LeaveNotice& notice);
+void encodeAttendanceSession(BinaryWriter& out, const AttendanceSession& session);
+
+// Write-Ahead Log
+uint64_t replayWal(const std::string& path, uint64_t afterLsn);
+bool logMutation(WalRecordType type, const BinaryWriter& payload);
+uint64_t appendMutation(WalRecordType type, const BinaryWriter& payload);
+bool waitForLog(uint64_t lsn);
+bool checkpoint();
+
+// Archival (moves old records to cold segments at checkpoints)
+void archiveRecords();
+std::string coldSegmentPath(const char* list, size_t first);
+
+// Submissions (run on the submission consumer thread)
+void storeSubmissions(std::vector<Submission>& batch);
+void recordComplaints(std::vector<Complaint>& complaints);
+void recordLeaveNotices(std::vector<LeaveNotice>& notices);
+bool leaveEntryFor(const LeaveNotice& notice, uint32_t position, const UserDirectory& directory, LeaveEntry& entry);
+void noteSubmissionSequence(uint64_t& sequence);
+std::string formatTimestamp(int64_t unixSeconds);
+
+// Server Mode (many clients over a local socket; returns when stopped)
+int runServer(int port, const std::string& socketPath);
+
+// Metrics
+void displaySystemStatistics();
+std::string formatNanos(uint64_t nanos);
+std::string formatPrometheus(const MetricsSnapshot& snapshot);
+bool writeMetricsFile(const std::string& path);
+
+// Data Export (CSV/JSON extracts, streamed a batch at a time)
+void handleDataExport();
+bool exportRecords(ExportDataset dataset, ExportFormat format, const std::string& path, ExportReport& report);
+
+// Batch Mode (line commands instead of the menus, for scripts and load tests)
+struct OperationStats {
+    std::string name;           // The command, e.g. "login"
+    std::vector<double> micros; // Latency of each call
+    size_t failed = 0;
+};
+int runBatch(const std::string& path);
+bool runBatchCommand(const std::string& line, std::vector<OperationStats>& stats, std::string& error);
+void printOperationStats(std::vector<OperationStats>& stats);
+void generateBatchScript(size_t userCount, std::vector<std::string>& lines);
+
+// Benchmark Mode
+void runUserDirectoryBenchmark();
+void runUserMemoryBenchmark();
+void runWalBenchmark();
+void runSubmissionBenchmark();
+void runAttendanceBenchmark();
+void runResultsBenchmark();
+void runAnalyticsBenchmark();
+void runCalendarBenchmark();
+void runAlertBenchmark();
+void runSearchBenchmark();
+void runEndToEndBenchmark();
+void runMetricsBenchmark();
+void runRenderBenchmark();
+void runRosterBenchmark();
+void runLibraryBenchmark();
+void runArchiveBenchmark();
+void runGateBenchmark();
+void runPasswordBenchmark();
+void runExportBenchmark();
+
+struct NamedBenchmark {
+    const char* name; // For --bench <name>
+    void (*run)();
+};
+const NamedBenchmark BENCHMARKS[] = {
+    {"users", runUserDirectoryBenchmark},
+    {"memory", runUserMemoryBenchmark},
+    {"wal", runWalBenchmark},
+    {"submissions", runSubmissionBenchmark},
+    {"attendance", runAttendanceBenchmark},
+    {"results", runResultsBenchmark},
+    {"analytics", runAnalyticsBenchmark},
+    {"calendar", runCalendarBenchmark},
+    {"alerts", runAlertBenchmark},
+    {"search", runSearchBenchmark},
+    {"e2e", runEndToEndBenchmark},
+    {"metrics", runMetricsBenchmark},
+    {"render", runRenderBenchmark},
+    {"roster", runRosterBenchmark},
+    {"library", runLibraryBenchmark},
+    {"archive", runArchiveBenchmark},
+    {"gate", runGateBenchmark},
+    {"passwords", runPasswordBenchmark},
+    {"export", runExportBenchmark}
+};
+bool runBenchmarks(const char* only);
+
+// Check Mode
+bool checkRosterRepeats();
+bool checkColdRoundTrip();
+bool checkGateTimes();
+bool checkExportEscaping();
+
+struct NamedCheck {
+    const char* name; // For --check <name>
+    bool (*run)();
+};
+const NamedCheck CHECKS[] = {
+    {"roster", checkRosterRepeats},
+    {"cold", checkColdRoundTrip},
+    {"gate", checkGateTimes},
+    {"export", checkExportEscaping}
+};
+bool runChecks(const char* only, bool& ran);
+
+// --- Main Function ---
+int main(int argc, char* argv[]) {
+    long commitWindowUs = 1000;
+    int serverPort = 0;
+    std::string serverSocketPath;
+    std::string batchPath;
+    std::string metricsPath;
+    long metricsIntervalSeconds = 10;
+    unsigned passwordThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--bench") == 0) {
+            // Measure the storage layer instead of starting the menus; a name
+            // after the flag runs just that benchmark
+            const char* only = i + 1 < argc ? argv[i + 1] : nullptr;
+            passwordIterations = 1; // Logins and registrations measure the stores; "passwords" sets its own cost
+            if (!runBenchmarks(only)) {
+                std::cout << "Unknown benchmark '" << only << "'. Choose from:";
+                for (const NamedBenchmark& benchmark : BENCHMARKS) std::cout << " " << benchmark.name;
+                std::cout << "\n";
+                return 1;
+            }
+            return 0;
+        } else if (strcmp(argv[i], "--check") == 0) {
+            // Run the behaviour checks on their own data and files in the
+            // current directory; a name after the flag runs just that check
+            const char* only = i + 1 < argc ? argv[i + 1] : nullptr;
+            bool ran = false;
+            passwordIterations = 1;
+            bool passed = runChecks(only, ran);
+            if (!ran) {
+                std::cout << "Unknown check '" << only << "'. Choose from:";
+                for (const NamedCheck& check : CHECKS) std::cout << " " << check.name;
+                std::cout << "\n";
+                return 1;
+            }
+            return passed ? 0 : 1;
+        } else if (strcmp(argv[i], "--generate-batch") == 0 && i + 1 < argc) {
+            // A synthetic college as batch commands, e.g. --generate-batch 1000 > day.txt
+            std::vector<std::string> lines;
+            generateBatchScript(strtoul(argv[++i], nullptr, 10), lines);
+            for (const std::string& line : lines) std::cout << line << "\n";
+            return 0;
+        } else if (strcmp(argv[i], "--metrics-file") == 0 && i + 1 < argc) {
+            metricsPath = argv[++i]; // Prometheus text format, rewritten periodically
+        } else if (strcmp(argv[i], "--metrics-interval-s") == 0 && i + 1 < argc) {
+            metricsIntervalSeconds = std::max(1L, atol(argv[++i]));
+        } else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            batchPath = argv[++i]; // A file of commands, or - for stdin
+        } else if (strcmp(argv[i], "--archive-after-days") == 0 && i + 1 < argc) {
+            archiveAfterDays = atol(argv[++i]); // 0 keeps every complaint and leave notice in memory
+        } else if (strcmp(argv[i], "--commit-window-us") == 0 && i + 1 < argc) {
+            // Longer windows batch more submissions per fsync, shorter ones answer sooner
+            commitWindowUs = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--password-iterations") == 0 && i + 1 < argc) {
+            // Cost of new password hashes; older ones are rehashed at their next login
+            passwordIterations = static_cast<uint32_t>(std::max(1L, atol(argv[++i])));
+        } else if (strcmp(argv[i], "--password-threads") == 0 && i + 1 < argc) {
+            passwordThreads = static_cast<unsigned>(std::max(1L, atol(argv[++i])));
+        } else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+            serverPort = atoi(argv[++i]); // TCP port on localhost
+        } else if (strcmp(argv[i], "--serve-unix") == 0 && i + 1 < argc) {
+            serverSocketPath = argv[++i];
+        }
+    }
+
+    // Restore the last saved state; a fresh install starts with the test users
+    if (!loadSnapshot(SNAPSHOT_FILE)) {
+        // Optional: Add default users for easy testing
+        users.add({"Alice Smith", "student@test.com", "pass123", "1234567890", Role::STUDENT, "S1001"});
+        users.add({"Bob Johnson", "student2@test.com", "pass123", "1122334455", Role::STUDENT, "S1002"});
+        users.add({"Prof. Davis", "teacher@test.com", "pass456", "0987654321", Role::TEACHER, "Professor"});
+        users.add({"Mr. Lee", "staff@test.com", "pass789", "5556667777", Role::NON_TEACHING_STAFF, "Librarian"});
+        // Registrars export records and import rosters, so nobody can register as one
+        users.add({"Ms. Rao", "registrar@test.com", "pass789", "5556668888", Role::NON_TEACHING_STAFF, "Registrar"});
+    }
+
+    // Re-apply changes made after the snapshot was taken, then keep logging
+    uint64_t lastLsn = replayWal(WAL_FILE, snapshotWalLsn);
+    gradeAnalytics.rebuild(grades);
+    wal.configure(std::chrono::microseconds(commitWindowUs), 1 << 20);
+    if (!wal.open(WAL_FILE, lastLsn)) {
+        std::cout << "Warning: could not open " << WAL_FILE << "; changes will not survive a crash.\n";
+    }
+    submissions.start(storeSubmissions, 256);
+    passwordWorkers.start(passwordThreads);
+    if (hashPlaintextPasswords() > 0 && !checkpoint()) {
+        std::cout << "Warning: could not save the newly hashed passwords to " << SNAPSHOT_FILE << ".\n";
+    }
+    if (archiveAfterDays > 0) {
+        // A server may run for months between checkpoints; memory stays bounded all the same
+        archiver.start(archiveRecords, std::chrono::seconds(ARCHIVE_INTERVAL_SECONDS));
+    }
+    if (!metricsPath.empty()) {
+        metricsDump.start([metricsPath]() { writeMetricsFile(metricsPath); },
+                          std::chrono::seconds(metricsIntervalSeconds));
+    }
+
+    if (!batchPath.empty()) {
+        int status = runBatch(batchPath);
+        submissions.stop();
+        metricsDump.stop();
+        archiver.stop();
+        passwordWorkers.stop();
+        if (!checkpoint()) {
+            std::cout << "Warning: could not save data to " << SNAPSHOT_FILE << ".\n";
+        }
+        return status;
+    }
+
+    if (serverPort != 0 || !serverSocketPath.empty()) {
+        // Many clients at once; the data is saved after the last session ends
+        int status = runServer(serverPort, serverSocketPath);
+        submissions.stop(); // Store what the last sessions submitted
+        metricsDump.stop();
+        archiver.stop();
+        passwordWorkers.stop();
+        if (!checkpoint()) {
+            std::cout << "Warning: could not save data to " << SNAPSHOT_FILE << ".\n";
+        }
+        return status;
+    }
+
+#ifdef _WIN32
+    enableConsoleEscapes();
+#endif
+    TerminalScreen console(std::cout.rdbuf(), 0);
+    std::ostream consoleOut(&console);
+    std::cin.tie(&consoleOut); // Send each screen before waiting for the answer
+    sessionOutput = &consoleOut;
+    sessionScreen = &console;
+    runMainMenu();
+    consoleOut.flush();
+    sessionScreen = nullptr;
+    sessionOutput = &std::cout;
+    std::cin.tie(&std::cout);
+    submissions.stop();
+    metricsDump.stop();
+    archiver.stop();
+    passwordWorkers.stop();
+    if (!checkpoint()) {
+        std::cout << "Warning: could not save data to " << SNAPSHOT_FILE << ".\n";
+    }
+    return 0;
+}
+
+// --- Function Implementations ---
+
+// The login/register menu; returns when the user picks Exit (or input ends)
+void runMainMenu() {
+    int choice;
+    bool loggedIn = false;
+    UserHandle currentUser = UserDirectory::npos; // The logged-in user, by handle rather than a copy
+
+    while (true) {
+        std::ostringstream screen;
+        displayMainMenu(screen);
+        screen << "Enter your choice: ";
+        presentScreen(screen.str());
+        sessionIn() >> choice;
+
+        if (sessionIn().fail()) {
+            if (sessionIn().eof()) return; // Input closed, e.g. the end of a piped script
+            sessionOut() << "Invalid input. Please enter a number.\n";
+            sessionIn().clear();
+            ignoreLine();
+            sessionOut() << "Press Enter to continue...";
+            ignoreLine(); // Consume the Enter press
+            continue;
+        }
+        ignoreLine(); // Consume the newline character left by cin
+
+        switch (choice) {
+            case 1: // Login
+                clearScreen();
+                loggedIn = handleLogin(currentUser);
+                if (loggedIn) {
+                    switch (users.role(currentUser)) {
+                        case Role::STUDENT:
+                            showStudentDashboard(currentUser);
+                            break;
+                        case Role::TEACHER:
+                            showTeacherDashboard(currentUser);
+                            break;
+                        case Role::NON_TEACHING_STAFF:
+                            showNonTeachingStaffDashboard(currentUser);
+                            break;
+                    }
+                    loggedIn = false; // Reset login status after logout/dashboard exit
+                    currentUser = UserDirectory::npos; // Clear current user
+                }
+                break;
+            case 2: // Register
+                clearScreen();
+                handleRegistration();
+                break;
+            case 3: // Exit
+                sessionOut() << "Exiting College Alerter. Goodbye!\n";
+                return;
+            default:
+                sessionOut() << "Invalid choice. Please try again.\n";
+                sessionOut() << "Press Enter to continue...";
+                sessionIn().get(); // Wait for user press Enter
+                break;
+        }
+    }
+}
+
+void ignoreLine() {
+    sessionIn().ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+}
+
+void displayMainMenu(std::ostream& screen) {
+    screen << "=====================================\n";
+    screen << "        Welcome to College Alerter\n";
+    screen << "=====================================\n";
+    screen << "1. Login\n";
+    screen << "2. Register\n";
+    screen << "3. Exit\n";
+    screen << "=====================================\n";
+}
+
+void handleRegistration() {
+    User newUser;
+    int roleChoice;
+    int staffChoice;
+
+    clearScreen(); // Its answers echo many rows, so the next menu is drawn afresh
+    sessionOut() << "--- Registration ---\n";
+    sessionOut() << "Enter Name: ";
+    std::getline(sessionIn(), newUser.name);
+
+    sessionOut() << "Enter Email: ";
+    std::getline(sessionIn(), newUser.email);
+
+    // Basic check if email already exists
+    if (users.findByEmail(newUser.email) != UserDirectory::npos) {
+        sessionOut() << "\nError: Email already registered.\n";
+        sessionOut() << "Press Enter to return to the main menu...";
+        sessionIn().get();
+        return;
+    }
+
+    sessionOut() << "Enter Phone Number: ";
+    std::getline(sessionIn(), newUser.phone);
+
+    sessionOut() << "Enter Password: ";
+    std::getline(sessionIn(), newUser.password);
+
+    sessionOut() << "\nSelect Role:\n";
+    sessionOut() << "1. Student\n";
+    sessionOut() << "2. Teacher\n";
+    sessionOut() << "3. Non-Teaching Staff\n";
+    sessionOut() << "Enter role choice: ";
+    sessionIn() >> roleChoice;
+
+    while (sessionIn().fail() || (roleChoice < 1 || roleChoice > 3)) {
+         sessionOut() << "Invalid input. Please enter 1, 2, or 3: ";
+         sessionIn().clear();
+         ignoreLine();
+         sessionIn() >> roleChoice;
+    }
+    ignoreLine(); // Consume newline
+
+    switch (roleChoice) {
+        case 1:
+            newUser.role = Role::STUDENT;
+            sessionOut() << "Enter Student ID Number: ";
+            std::getline(sessionIn(), newUser.roleSpecificData);
+            if (users.findByStudentId(newUser.roleSpecificData) != UserDirectory::npos) {
+                sessionOut() << "\nError: Student ID already registered.\n";
+                sessionOut() << "Press Enter to return to the main menu...";
+                sessionIn().get();
+                return;
+            }
+            break;
+        case 2:
+            newUser.role = Role::TEACHER;
+            sessionOut() << "Enter Teacher Position (e.g., Professor, Asst. Professor): ";
+            std::getline(sessionIn(), newUser.roleSpecificData);
+            break;
+        case 3:
+            newUser.role = Role::NON_TEACHING_STAFF;
+            sessionOut() << "\nSelect Non-Teaching Staff Role:\n";
+            sessionOut() << "1. Librarian\n";
+            sessionOut() << "2. Watchman\n";
+            sessionOut() << "3. Other Clerical/Support Staff\n";
+            sessionOut() << "Enter staff role choice: ";
+            sessionIn() >> staffChoice;
+
+             while (sessionIn().fail() || (staffChoice < 1 || staffChoice > 3)) {
+                sessionOut() << "Invalid input. Please enter 1, 2, or 3: ";
+                sessionIn().clear();
+                ignoreLine();
+                sessionIn() >> staffChoice;
+            }
+             ignoreLine(); // Consume newline
+
+            switch (staffChoice) {
+                case 1: newUser.roleSpecificData = "Librarian"; break;
+                case 2: newUser.roleSpecificData = "Watchman"; break;
+                case 3: newUser.roleSpecificData = "Clerical/Support Staff"; break;
+            }
+            break;
+    }
+
+    RegistrationStatus status = registerUser(newUser);
+    if (status == RegistrationStatus::DUPLICATE) {
+        sessionOut() << "\nError: Email or Student ID already registered.\n";
+        sessionOut() << "Press Enter to return to the main menu...";
+        sessionIn().get();
+        return;
+    }
+    if (status == RegistrationStatus::NOT_SAVED) {
+        sessionOut() << "\nError: Could not save the registration. Please try again.\n";
+        sessionOut() << "Press Enter to return to the main menu...";
+        sessionIn().get();
+        return;
+    }
+    sessionOut() << "\nRegistration Successful!\n";
+    sessionOut() << "Press Enter to return to the main menu...";
+    sessionIn().get();
+}
+
+bool isRegistered(const User& user) {
+    return users.findByEmail(user.email) != UserDirectory::npos ||
+           (user.role == Role::STUDENT && users.findByStudentId(user.roleSpecificData) != UserDirectory::npos);
+}
+
+// Only the hash of the password is logged and kept
+RegistrationStatus registerUser(const User& newUser) {
+    OperationTimer timer(OP_REGISTER);
+    if (isRegistered(newUser)) { // Spares the hash; checked again below
+        metrics.count(COUNTER_REGISTRATIONS_REJECTED);
+        return RegistrationStatus::DUPLICATE;
+    }
+    User stored = newUser;
+    passwordWorkers.run([&]() { stored.password = hashPassword(newUser.password, passwordIterations); });
+    BinaryWriter record;
+    encodeUser(record, stored);
+    // Another session may be registering the same email right now; whoever
+    // is logged first must also be the one added, or a replay would differ
+    std::lock_guard<std::mutex> lock(registrationLock);
+    if (isRegistered(stored)) {
+        metrics.count(COUNTER_REGISTRATIONS_REJECTED);
+        return RegistrationStatus::DUPLICATE;
+    }
+    if (!logMutation(WAL_ADD_USER, record)) return RegistrationStatus::NOT_SAVED;
+    users.add(stored);
+    return RegistrationStatus::REGISTERED;
+}
+
+int64_t steadySeconds() {
+    return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Saves a new hash for a password that was still plaintext, or hashed with
+// fewer iterations than now configured. Best effort: the login goes ahead
+// even if the new hash could not be logged.
+void upgradePassword(UserHandle user, const std::string& stored) {
+    BinaryWriter record;
+    record.u32(user);
+    record.str(stored);
+    std::lock_guard<std::mutex> lock(registrationLock); // Log and apply in one order
+    if (!logMutation(WAL_SET_PASSWORD, record)) return;
+    users.setStoredPassword(user, stored);
+    metrics.count(COUNTER_PASSWORDS_UPGRADED);
+}
+
+// Hashes every password still kept as plaintext: the seeded test users, and
+// users from a snapshot or log written before passwords were hashed. Runs
+// at startup before any session; returns how many were hashed, which the
+// caller then saves at once so no plaintext stays on disk.
+size_t hashPlaintextPasswords() {
+    std::vector<UserHandle> plain;
+    for (UserHandle user = 0; user < users.size(); user++) {
+        if (!isHashedPassword(users.storedPassword(user))) plain.push_back(user);
+    }
+    std::vector<std::string> hashed(plain.size());
+    uint32_t iterations = importPasswordIterations();
+    passwordWorkers.runAll(plain.size(), [&](size_t i) {
+        hashed[i] = hashPassword(users.storedPassword(plain[i]).str(), iterations);
+    });
+    for (size_t i = 0; i < plain.size(); i++) users.setStoredPassword(plain[i], hashed[i]);
+    return plain.size();
+}
+
+// Checks the password on the password workers. An email with too many
+// recent failures is refused without hashing anything; an unknown email
+// costs as much as a wrong password, so timing does not reveal who is
+// registered.
+UserHandle authenticate(const std::string& email, const std::string& password) {
+    OperationTimer timer(OP_LOGIN);
+    uint64_t emailHash = hashString(normalizeEmail(email));
+    int64_t now = steadySeconds();
+    if (loginThrottle.lockedFor(emailHash, now) > 0) {
+        metrics.count(COUNTER_LOGINS_THROTTLED);
+        return UserDirectory::npos;
+    }
+    static const std::string decoy = hashPassword("", passwordIterations);
+    UserHandle user = users.findByEmail(email);
+    StrView stored = user != UserDirectory::npos ? users.storedPassword(user) : StrView{decoy.data(), decoy.size()};
+    bool matches = false;
+    std::string upgraded;
+    passwordWorkers.run([&]() {
+        matches = verifyPassword(stored, password) && user != UserDirectory::npos;
+        if (matches && hashIterations(stored) < passwordIterations) upgraded = hashPassword(password, passwordIterations);
+    });
+    if (!upgraded.empty()) upgradePassword(user, upgraded);
+    if (!matches) {
+        loginThrottle.recordFailure(emailHash, now);
+        metrics.count(COUNTER_LOGIN_FAILURES);
+        return UserDirectory::npos;
+    }
+    loginThrottle.recordSuccess(emailHash);
+    return user;
+}
+
+// Seconds until a locked out email may try again, 0 if it is not locked out
+int64_t loginLockout(const std::string& email) {
+    return loginThrottle.lockedFor(hashString(normalizeEmail(email)), steadySeconds());
+}
+
+bool handleLogin(UserHandle& loggedInUser) {
+    std::string email, password;
+    clearScreen();
+    sessionOut() << "--- Login ---\n";
+    sessionOut() << "Enter Email: ";
+    std::getline(sessionIn(), email);
+    sessionOut() << "Enter Password: ";
+    std::getline(sessionIn(), password);
+
+    UserHandle user = authenticate(email, password);
+    if (user != UserDirectory::npos) {
+        sessionOut() << "\nLogin Successful! Welcome, " << users.name(user) << ".\n";
+        loggedInUser = user;
+        sessionOut() << "Press Enter to continue...";
+        sessionIn().get();
+        return true;
+    }
+
+    int64_t lockout = loginLockout(email);
+    if (lockout > 0) {
+        sessionOut() << "\nLogin Failed: Too many failed attempts for this email. Try again in " << (lockout + 59) / 60
+                     << " minute(s).\n";
+    } else {
+        sessionOut() << "\nLogin Failed: Invalid email or password.\n";
+    }
+    sessionOut() << "Press Enter to return to the main menu...";
+    sessionIn().get();
+    return false;
+}
+
+// --- Student Dashboard and Functions ---
+
+void showStudentDashboard(UserHandle user) {
+    int choice;
+    while (true) {
+        {
+            OperationTimer timer(OP_DASHBOARD);
+            std::ostringstream screen;
+            screen << "=====================================\n";
+            screen << "        Student Dashboard - Welcome " << users.name(user) << "\n";
+            screen << "=====================================\n";
+            screen << "1. View College Events\n";
+            screen << "2. View Attendance\n";
+            screen << "3. Submit Complaint\n";
+            screen << "4. Submit Leave Notice\n";
+            screen << "5. View Results\n";
+            screen << "6. View Alerts (" << alerts.unreadCount(user) << " unread)\n";
+            screen << "7. Logout\n";
+            screen << "=====================================\n";
+            screen << "Enter your choice: ";
+            presentScreen(screen.str());
+        }
+        sessionIn() >> choice;
+
+        if (sessionIn().fail()) {
+            if (sessionIn().eof()) return;
+            sessionOut() << "Invalid input. Please enter a number.\n";
+            sessionIn().clear();
+            ignoreLine();
+            sessionOut() << "Press Enter to continue...";
+            ignoreLine();
+            continue;
+        }
+        ignoreLine();
+
+        switch (choice) {
+            case 1: displayCollegeEvents(Role::STUDENT); break;
+            case 2: displayAttendance(user); break;
+            case 3: handleComplaintBox(user); break; // Pass user info
+            case 4: handleLeaveNotice(user); break; // Pass user info
+            case 5: displayResults(user); break;
+            case 6: displayAlerts(user); break;
+            case 7:
+                sessionOut() << "Logging out...\n";
+                sessionOut() << "Press Enter to return to main menu...";
+                sessionIn().get();
+                return;
+            default:
+                sessionOut() << "Invalid choice. Please try again.\n";
+                break;
+        }
+        if (choice != 7) {
+             sessionOut() << "\nPress Enter to return to the Student Dashboard...";
+             sessionIn().get();
+        }
+    }
+}
+
+void displayCollegeEvents(Role viewer) {
+    clearScreen();
+    sessionOut() << "--- Upcoming College Events ---\n";
+    listUpcomingEntries(audienceOf(viewer));
+    sessionOut() << "--------------------------------\n";
+}
+
+void displayAttendance(UserHandle student) {
+    clearScreen();
+    sessionOut() << "--- Your Attendance ---\n";
+    uint32_t slot = users.studentSlot(student);
+
+    AttendanceTally overall{0, 0};
+    std::vector<std::pair<uint32_t, AttendanceTally>> bySubject;
+    if (slot != UserDirectory::NO_STUDENT_SLOT) {
+        std::shared_lock<std::shared_timed_mutex> lock(attendanceLock);
+        for (uint32_t subject = 0; subject < subjects.size(); subject++) {
+            AttendanceTally tally = attendance.studentTally(slot, subject);
+            if (tally.held == 0) continue;
+            overall.attended += tally.attended;
+            overall.held += tally.held;
+            bySubject.push_back({subject, tally});
+        }
+    }
+
+    if (overall.held == 0) {
+        sessionOut() << "No attendance has been recorded for you yet.\n";
+    } else {
+        FormatGuard format(sessionOut());
+        sessionOut() << std::fixed << std::setprecision(1);
+        sessionOut() << "Overall Attendance: " << overall.percent() << "% ("
+                  << overall.attended << "/" << overall.held << " classes)\n\n";
+        sessionOut() << "Subject Wise:\n";
+        for (const auto& entry : bySubject) {
+            sessionOut() << "- " << subjects.name(entry.first) << ": " << entry.second.percent() << "% ("
+                      << entry.second.attended << "/" << entry.second.held << ")\n";
+        }
+    }
+     sessionOut() << "------------------------------------\n";
+}
+
+void handleComplaintBox(UserHandle student) {
+    clearScreen();
+    std::string message;
+    sessionOut() << "--- Submit Complaint ---\n";
+    sessionOut() << "Please type your complaint below and press Enter:\n";
+    sessionOut() << "----------------------------------------------\n";
+    std::getline(sessionIn(), message);
+    sessionOut() << "\n----------------------------------------------\n";
+
+    submitComplaint(student, std::move(message));
+
+    sessionOut() << "Thank you. Your complaint has been queued and will be saved shortly.\n";
+    sessionOut() << "If it cannot be saved you will get an alert asking you to send it again.\n";
+    sessionOut() << "----------------------------------------------\n";
+}
+
+void handleLeaveNotice(UserHandle student) {
+    clearScreen();
+    LeaveNotice newNotice;
+    sessionOut() << "--- Submit Leave Notice ---\n";
+    int64_t year;
+    unsigned month, day;
+    civilFromDays(calendarNow() / 1440, year, month, day);
+    while (true) {
+        sessionOut() << "Enter Date(s) of Leave (e.g., 25 Feb 2024 or 25-27 Feb 2024): ";
+        if (!std::getline(sessionIn(), newNotice.dates) || newNotice.dates.empty()) {
+            sessionOut() << "Leave notice cancelled.\n";
+            return;
+        }
+        if (parseDayRange(newNotice.dates, year, newNotice.firstDay, newNotice.lastDay)) break;
+        sessionOut() << "Could not read those dates. Give a day and month, e.g. 25 Feb 2024, 25-27 Feb 2024 "
+                        "or 28 Feb - 2 Mar 2024.\n";
+    }
+    sessionOut() << "Enter Reason for Leave:\n";
+    sessionOut() << "---------------------------\n";
+    std::getline(sessionIn(), newNotice.reason);
+    sessionOut() << "\n---------------------------\n";
+
+    int64_t days = newNotice.lastDay - newNotice.firstDay + 1;
+    sessionOut() << "Leave notice queued for " << formatDay(newNotice.firstDay);
+    if (days > 1) sessionOut() << " - " << formatDay(newNotice.lastDay);
+    sessionOut() << " (" << days << " day" << (days > 1 ? "s" : "") << ").\n";
+    sessionOut() << "If it cannot be saved you will get an alert asking you to send it again.\n";
+    submitLeaveNotice(student, std::move(newNotice));
+
+    sessionOut() << "---------------------------\n";
+}
+
+// Both are numbered, logged and stored in the background
+void submitComplaint(UserHandle student, std::string message) {
+    OperationTimer timer(OP_SUBMIT);
+    Submission submission;
+    submission.kind = Submission::COMPLAINT;
+    submission.complaint.studentEmail = users.email(student).str();
+    submission.complaint.studentName = users.name(student).str();
+    submission.complaint.message = std::move(message);
+    submissions.submit(std::move(submission));
+}
+
+// The notice's dates must already be parsed into firstDay/lastDay
+void submitLeaveNotice(UserHandle student, LeaveNotice notice) {
+    OperationTimer timer(OP_SUBMIT);
+    notice.studentEmail = users.email(student).str();
+    notice.studentName = users.name(student).str();
+    Submission submission;
+    submission.kind = Submission::LEAVE_NOTICE;
+    submission.notice = std::move(notice);
+    submissions.submit(std::move(submission));
+}
+
+void displayResults(UserHandle student) {
+    clearScreen();
+    sessionOut() << "--- Your Results ---\n";
+    uint32_t slot = users.studentSlot(student);
+    std::lock_guard<std::mutex> lock(resultsLock);
+    std::vector<GradeEntry> entries;
+    if (slot != UserDirectory::NO_STUDENT_SLOT) entries = grades.gradesOf(slot);
+    if (entries.empty()) {
+        sessionOut() << "No results have been uploaded for you yet.\n";
+        sessionOut() << "---------------------------\n";
+        return;
+    }
+
+    gradeAnalytics.refresh(grades);
+    const StudentStanding* standing = gradeAnalytics.standing(slot);
+
+    std::sort(entries.begin(), entries.end(), [](const GradeEntry& a, const GradeEntry& b) {
+        return a.semester != b.semester ? a.semester < b.semester : subjects.name(a.subject) < subjects.name(b.subject);
+    });
+    FormatGuard format(sessionOut());
+    sessionOut() << std::fixed << std::setprecision(2);
+    for (size_t i = 0; i < entries.size(); i++) {
+        const GradeEntry& entry = entries[i];
+        if (i == 0 || entries[i - 1].semester != entry.semester) {
+            sessionOut() << "Semester " << static_cast<int>(entry.semester) << "\n";
+            sessionOut() << "Subject             | Grade\n";
+            sessionOut() << "--------------------|-------\n";
+        }
+        sessionOut() << std::left << std::setw(20) << subjects.name(entry.subject) << "| "
+                  << GRADE_SCALE[entry.grade].letter << "\n" << std::right;
+        if (i + 1 == entries.size() || entries[i + 1].semester != entry.semester) {
+            sessionOut() << "--------------------|-------\n";
+            if (standing == nullptr) continue;
+            for (const auto& semester : standing->semesters) {
+                if (semester.semester == entry.semester) sessionOut() << "SGPA: " << semester.sgpa << "\n\n";
+            }
+        }
+    }
+    if (standing == nullptr) {
+        sessionOut() << "No credits are recorded yet, so there is no CGPA or rank.\n";
+        sessionOut() << "---------------------------\n";
+        return;
+    }
+    sessionOut() << "CGPA: " << standing->cgpa << "\n";
+    sessionOut() << "Class Rank: " << gradeAnalytics.rankOf(slot) << " of " << gradeAnalytics.meritList().size() << "\n";
+    sessionOut() << "---------------------------\n";
+}
+
+
+// --- Teacher Dashboard and Functions ---
+
+void showTeacherDashboard(UserHandle user) {
+    int choice;
+    while (true) {
+        {
+            OperationTimer timer(OP_DASHBOARD);
+            std::ostringstream screen;
+            screen << "=====================================\n";
+            screen << "        Teacher Dashboard - Welcome " << users.name(user) << "\n";
+            screen << "        Position: " << users.roleSpecificData(user) << "\n";
+            screen << "=====================================\n";
+            screen << "1. View/Announce Meetings\n";
+            screen << "2. Upload Student Results\n";
+            screen << "3. Take/Upload Attendance\n";
+            screen << "4. View Student Complaints (" << caseSummary(CASE_COMPLAINT, user) << ")\n";
+            screen << "5. View Student Leave Notices (" << caseSummary(CASE_LEAVE, user) << ")\n";
+            screen << "6. Attendance Shortage Report\n";
+            screen << "7. Results Analytics & Merit List\n";
+            screen << "8. Manage Course Enrollment\n";
+            screen << "9. View Alerts (" << alerts.unreadCount(user) << " unread)\n";
+            screen << "10. Send Announcement\n";
+            screen << "11. Logout\n";
+            screen << "=====================================\n";
+            screen << "Enter your choice: ";
+            presentScreen(screen.str());
+        }
+        sessionIn() >> choice;
+
+        if (sessionIn().fail()) {
+            if (sessionIn().eof()) return;
+            sessionOut() << "Invalid input. Please enter a number.\n";
+            sessionIn().clear();
+            ignoreLine();
+            sessionOut() << "Press Enter to continue...";
+            ignoreLine();
+            continue;
+        }
+        ignoreLine();
+
+        switch (choice) {
+            case 1: displayTeacherMeetings(user); break;
+            case 2: handleResultUpload(user); break;
+            case 3: handleAttendanceTaking(); break;
+            case 4: viewStudentComplaints(user); break;
+            case 5: viewStudentLeaveNotices(user); break;
+            case 6: displayAttendanceShortages(); break;
+            case 7: displayResultsAnalytics(); break;
+            case 8: handleEnrollment(); break;
+            case 9: displayAlerts(user); break;
+            case 10: handleAnnouncement(user); break;
+            case 11:
+                sessionOut() << "Logging out...\n";
+                 sessionOut() << "Press Enter to return to main menu...";
+                sessionIn().get();
+                return; // Exit the teacher dashboard loop
+            default:
+                sessionOut() << "Invalid choice. Please try again.\n";
+                break;
+        }
+         if (choice != 11) {
+             sessionOut() << "\nPress Enter to return to the Teacher Dashboard...";
+             sessionIn().get();
+        }
+    }
+}
+
+void displayTeacherMeetings(UserHandle user) {
+    clearScreen();
+    int choice;
+    sessionOut() << "--- Scheduled/Announced Meetings ---\n";
+    listUpcomingEntries(AUDIENCE_TEACHERS);
+    sessionOut() << "1. Announce a New Meeting\n";
+    sessionOut() << "2. Back\n";
+    sessionOut() << "Enter your choice: ";
+    sessionIn() >> choice;
+    if (sessionIn().fail()) {
+        sessionIn().clear();
+        choice = 2;
+    }
+    ignoreLine();
+    if (choice == 1) handleCalendarBooking(user, true);
+    sessionOut() << "-------------------------------------\n";
+}
+
+void handleResultUpload(UserHandle teacher) {
+    clearScreen();
+    std::string subjectName;
+    std::string filePath;
+    int semester;
+    int credits;
+    sessionOut() << "--- Upload Student Results ---\n";
+    sessionOut() << "Enter Subject Name: ";
+    std::getline(sessionIn(), subjectName);
+    if (subjectName.empty()) {
+        sessionOut() << "Error: Subject name cannot be empty.\n";
+        return;
+    }
+
+    sessionOut() << "Enter Semester (1-" << MAX_SEMESTER << "): ";
+    sessionIn() >> semester;
+    while (sessionIn().fail() || semester < 1 || semester > MAX_SEMESTER) {
+        if (sessionIn().eof()) return;
+        sessionOut() << "Invalid input. Please enter a number from 1 to " << MAX_SEMESTER << ": ";
+        sessionIn().clear();
+        ignoreLine();
+        sessionIn() >> semester;
+    }
+    sessionOut() << "Enter Subject Credits (1-" << MAX_CREDITS << "): ";
+    sessionIn() >> credits;
+    while (sessionIn().fail() || credits < 1 || credits > MAX_CREDITS) {
+        if (sessionIn().eof()) return;
+        sessionOut() << "Invalid input. Please enter a number from 1 to " << MAX_CREDITS << ": ";
+        sessionIn().clear();
+        ignoreLine();
+        sessionIn() >> credits;
+    }
+    ignoreLine(); // Consume newline
+
+    sessionOut() << "Enter path to results file (e.g., C:\\results\\DS_results.csv): ";
+    std::getline(sessionIn(), filePath);
+    sessionOut() << "(Each line: Student ID,Grade  e.g. S1001,A+)\n\n";
+
+    std::vector<ParsedGrade> parsed;
+    ResultsFileReport report;
+    unsigned threads = std::thread::hardware_concurrency();
+    if (!parseResultsFile(filePath, threads == 0 ? 1 : threads, parsed, report)) {
+        sessionOut() << "Error: Could not open results file '" << filePath << "'.\n";
+        sessionOut() << "-----------------------------\n";
+        return;
+    }
+
+    double megabytes = report.bytes / (1024.0 * 1024.0);
+    {
+        FormatGuard format(sessionOut());
+        sessionOut() << std::fixed << std::setprecision(2);
+        sessionOut() << "Read " << report.rows + report.rejected << " rows (" << megabytes << " MB in "
+                  << report.seconds * 1000 << " ms, " << (report.seconds > 0 ? megabytes / report.seconds : 0) << " MB/s).\n";
+    }
+    if (report.rejected > 0) {
+        sessionOut() << report.rejected << " row(s) were rejected:\n";
+        for (const auto& problem : report.problems) sessionOut() << "  " << problem << "\n";
+        if (report.rejected > report.problems.size()) sessionOut() << "  ...\n";
+    }
+
+    if (parsed.empty()) {
+        sessionOut() << "No results were stored.\n";
+    } else {
+        uint32_t subject = subjects.add(subjectName);
+        BinaryWriter record;
+        encodeResults(record, subject, static_cast<uint8_t>(semester), static_cast<uint8_t>(credits), parsed);
+        bool stored;
+        {
+            std::lock_guard<std::mutex> lock(resultsLock); // Log and apply in the same order as other uploads
+            stored = logMutation(WAL_ADD_RESULTS, record);
+            if (stored) {
+                applyResults(subject, static_cast<uint8_t>(semester), static_cast<uint8_t>(credits), parsed);
+                gradeAnalytics.refresh(grades); // Only the students in this upload are recomputed
+            }
+        }
+        if (stored) {
+            sessionOut() << "Results for '" << subjectName << "' (Semester " << semester << ") are now available to "
+                      << parsed.size() << " student(s).\n";
+            AlertTarget target;
+            target.users.reserve(parsed.size());
+            for (const auto& grade : parsed) target.users.push_back(users.userOfStudent(grade.slot));
+            publishAlert(users.name(teacher).str(), "Results for " + subjectName + " (Semester " +
+                         std::to_string(semester) + ") have been published.", std::move(target));
+        } else {
+            sessionOut() << "Error: Results could not be saved. Please try again.\n";
+        }
+    }
+     sessionOut() << "-----------------------------\n";
+}
+
+void handleAttendanceTaking() {
+    clearScreen();
+    std::string subjectName;
+    std::string date;
+    char presentChoice = 0;
+
+    sessionOut() << "--- Take Attendance ---\n";
+    sessionOut() << "Enter Subject Name: ";
+    std::getline(sessionIn(), subjectName);
+    sessionOut() << "Enter Date (e.g., 15 Feb 2024): ";
+    std::getline(sessionIn(), date);
+    sessionOut() << "----------------------\n";
+    sessionOut() << "Mark Attendance (P=Present, A=Absent):\n";
+
+    std::vector<uint32_t> roll, onLeave;
+    attendanceRoll(subjectName, date, roll, onLeave);
+    AttendanceSession session;
+    session.date = date;
+    session.marked.assign(roll.empty() ? 0 : roll.back() / 64 + 1, 0); // Rolls are sorted
+    session.present.assign(session.marked.size(), 0);
+    std::vector<uint32_t> markedSlots; // In the order they were called
+
+    for (uint32_t slot : roll) {
+        UserHandle student = users.userOfStudent(slot);
+        sessionOut() << "- " << users.name(student) << " (" << users.roleSpecificData(student) << "): ";
+        if (std::binary_search(onLeave.begin(), onLeave.end(), slot)) {
+            sessionOut() << "On leave (excused)\n";
+            continue;
+        }
+        while (true) {
+            if (!(sessionIn() >> presentChoice)) {
+                if (sessionIn().eof()) return; // Input closed mid-roll: drop the session
+                presentChoice = 0;
+            }
+            presentChoice = tolower(presentChoice);
+            if (presentChoice == 'p' || presentChoice == 'a') {
+                setBit(session.marked, slot);
+                if (presentChoice == 'p') setBit(session.present, slot);
+                markedSlots.push_back(slot);
+                ignoreLine(); // Consume newline after single char input
+                break;
+            } else {
+                sessionOut() << "Invalid input. Enter 'p' or 'a': ";
+                sessionIn().clear();
+                ignoreLine();
+            }
+        }
+    }
+
+    if (markedSlots.empty()) {
+        sessionOut() << "No students found to take attendance for.\n";
+    } else {
+        sessionOut() << "\n--- Attendance Summary (" << subjectName << " - " << date << ") ---\n";
+        for (uint32_t slot : markedSlots) {
+            sessionOut() << users.name(users.userOfStudent(slot)) << ": "
+                      << (testBit(session.present, slot) ? "Present" : "Absent") << "\n";
+        }
+        for (uint32_t slot : roll) {
+            if (std::binary_search(onLeave.begin(), onLeave.end(), slot)) {
+                sessionOut() << users.name(users.userOfStudent(slot)) << ": On leave\n";
+            }
+        }
+        sessionOut() << "--------------------------------------------------------\n";
+
+        if (saveAttendance(subjectName, std::move(session))) {
+            sessionOut() << "Attendance Recorded.\n";
+        } else {
+            sessionOut() << "Error: Attendance could not be saved. Please try again.\n";
+        }
+    }
+     sessionOut() << "----------------------\n";
+}
+
+// The subject's roster when it has one, otherwise every student, both
+// sorted. Students on approved leave that day are excused: left off the
+// register, so the session does not count against them. Students who
+// register or enroll while the roll is being called join the next session.
+void attendanceRoll(const std::string& subjectName, const std::string& date,
+                    std::vector<uint32_t>& roll, std::vector<uint32_t>& onLeave) {
+    OperationTimer timer(OP_ATTENDANCE_ROLL);
+    roll.clear();
+    onLeave.clear();
+    uint32_t subject = subjects.find(subjectName);
+    if (subject != SubjectCatalog::npos) {
+        std::shared_lock<std::shared_timed_mutex> lock(enrollmentLock);
+        roll = enrollment.roster(subject);
+    }
+    if (roll.empty()) {
+        roll.resize(users.studentCount());
+        for (uint32_t slot = 0; slot < roll.size(); slot++) roll[slot] = slot;
+    }
+
+    int64_t year;
+    unsigned month, day;
+    civilFromDays(calendarNow() / 1440, year, month, day);
+    int64_t firstDay, lastDay;
+    if (parseDayRange(date, year, firstDay, lastDay)) {
+        std::vector<LeaveEntry> found;
+        leaveIndex.find(firstDay, firstDay, found);
+        keepApprovedLeave(found);
+        for (const LeaveEntry& entry : found) onLeave.push_back(users.studentSlot(entry.student));
+        std::sort(onLeave.begin(), onLeave.end());
+    }
+}
+
+// Logs and stores a marked session; false when it could not be saved
+bool saveAttendance(const std::string& subjectName, AttendanceSession session) {
+    OperationTimer timer(OP_ATTENDANCE_SAVE);
+    metrics.count(COUNTER_STUDENTS_MARKED, popcountWords(session.marked.data(), session.marked.size()));
+    session.subject = subjects.add(subjectName);
+    BinaryWriter record;
+    encodeAttendanceSession(record, session);
+    if (!logMutation(WAL_ADD_ATTENDANCE, record)) return false;
+    std::unique_lock<std::shared_timed_mutex> lock(attendanceLock);
+    attendance.addSession(std::move(session));
+    return true;
+}
+
+// Term-end report: college and subject percentages plus every student
+// below the minimum attendance
+void displayAttendanceShortages() {
+    clearScreen();
+    const double minimumPercent = 75.0;
+    sessionOut() << "--- Attendance Shortage Report ---\n";
+    std::shared_lock<std::shared_timed_mutex> lock(attendanceLock);
+    if (attendance.allSessions().empty()) {
+        sessionOut() << "No attendance has been recorded yet.\n";
+        sessionOut() << "----------------------------------\n";
+        return;
+    }
+
+    FormatGuard format(sessionOut());
+    sessionOut() << std::fixed << std::setprecision(1);
+    sessionOut() << "College Overall: " << attendance.collegeTally(AttendanceStore::ALL_SUBJECTS).percent() << "%\n";
+    for (uint32_t subject = 0; subject < subjects.size(); subject++) {
+        AttendanceTally tally = attendance.collegeTally(subject);
+        if (tally.held == 0) continue;
+        sessionOut() << "- " << subjects.name(subject) << ": "
+                  << tally.percent() << "%\n";
+    }
+
+    std::vector<uint32_t> attended, held;
+    attendance.tallyAllStudents(users.studentCount(), attended, held);
+    sessionOut() << "\nStudents below " << minimumPercent << "%:\n";
+    int shortCount = 0;
+    for (uint32_t slot = 0; slot < held.size(); slot++) {
+        if (held[slot] == 0) continue;
+        double percent = 100.0 * attended[slot] / held[slot];
+        if (percent < minimumPercent) {
+            UserHandle student = users.userOfStudent(slot);
+            sessionOut() << "- " << users.name(student) << " (" << users.roleSpecificData(student) << "): " << percent << "% ("
+                      << attended[slot] << "/" << held[slot] << ")\n";
+            shortCount++;
+        }
+    }
+    if (shortCount == 0) sessionOut() << "None.\n";
+    sessionOut() << "----------------------------------\n";
+}
+
+// Merit list plus per-subject averages and grade percentiles
+void displayResultsAnalytics() {
+    clearScreen();
+    std::lock_guard<std::mutex> lock(resultsLock);
+    gradeAnalytics.refresh(grades);
+    const std::vector<MeritEntry>& merit = gradeAnalytics.meritList();
+    sessionOut() << "--- Results Analytics ---\n";
+    if (merit.empty()) {
+        sessionOut() << "No results have been uploaded yet.\n";
+        sessionOut() << "-------------------------\n";
+        return;
+    }
+
+    const size_t shown = 10;
+    FormatGuard format(sessionOut());
+    sessionOut() << std::fixed << std::setprecision(2);
+    sessionOut() << "Merit List (top " << std::min(shown, merit.size()) << " of " << merit.size() << " students)\n";
+    sessionOut() << "Rank | CGPA  | Student\n";
+    sessionOut() << "-----|-------|------------------------------\n";
+    for (size_t i = 0; i < merit.size() && i < shown; i++) {
+        UserHandle student = users.userOfStudent(merit[i].slot);
+        sessionOut() << std::left << std::setw(5) << gradeAnalytics.rankOf(merit[i].slot) << "| " << std::setw(6)
+                  << merit[i].cgpa << "| " << users.name(student) << " (" << users.roleSpecificData(student) << ")\n" << std::right;
+    }
+
+    sessionOut() << "\nSubject Statistics\n";
+    sessionOut() << "Subject             | Students | Average | Median | Top 10%\n";
+    sessionOut() << "--------------------|----------|---------|--------|--------\n";
+    for (uint32_t subject = 0; subject < subjects.size(); subject++) {
+        const SubjectStats* stats = gradeAnalytics.subjectStats(subject);
+        if (stats == nullptr) continue;
+        sessionOut() << std::left << std::setw(20) << subjects.name(subject) << "| " << std::setw(9) << stats->students()
+                  << "| " << std::setw(8) << subjectAverage(*stats) << "| "
+                  << std::setw(7) << GRADE_SCALE[subjectPercentileGrade(*stats, 50)].letter << "| "
+                  << GRADE_SCALE[subjectPercentileGrade(*stats, 90)].letter << "\n" << std::right;
+    }
+    sessionOut() << "-------------------------\n";
+}
+
+// Enroll or drop students on a subject's (or section's) roster; attendance
+// for that subject then calls only this roster
+void handleEnrollment() {
+    clearScreen();
+    std::string subjectName;
+    int choice;
+
+    sessionOut() << "--- Course Enrollment ---\n";
+    sessionOut() << "Enter Subject/Section Name (e.g., CS101 - A): ";
+    std::getline(sessionIn(), subjectName);
+    if (subjectName.empty()) {
+        sessionOut() << "Error: Subject name cannot be empty.\n";
+        return;
+    }
+
+    uint32_t subject = subjects.find(subjectName);
+    std::vector<uint32_t> roster;
+    if (subject != SubjectCatalog::npos) {
+        std::shared_lock<std::shared_timed_mutex> lock(enrollmentLock);
+        roster = enrollment.roster(subject);
+    }
+    sessionOut() << "Currently enrolled: " << roster.size() << " student(s)\n";
+    sessionOut() << "1. Enroll Students\n";
+    sessionOut() << "2. Drop Students\n";
+    sessionOut() << "3. View Roster\n";
+    sessionOut() << "Enter your choice: ";
+    sessionIn() >> choice;
+    if (sessionIn().fail() || choice < 1 || choice > 3) {
+        sessionOut() << "Invalid choice.\n";
+        sessionIn().clear();
+        ignoreLine();
+        return;
+    }
+    ignoreLine();
+
+    if (choice == 3) {
+        sessionOut() << "\n--- Roster: " << subjectName << " ---\n";
+        if (roster.empty()) sessionOut() << "No students are enrolled.\n";
+        for (uint32_t slot : roster) {
+            UserHandle student = users.userOfStudent(slot);
+            sessionOut() << "- " << users.name(student) << " (" << users.roleSpecificData(student) << ")\n";
+        }
+        sessionOut() << "-------------------------\n";
+        return;
+    }
+
+    bool enrolling = choice == 1;
+    std::string line;
+    sessionOut() << "Enter Student IDs (separated by spaces or commas): ";
+    std::getline(sessionIn(), line);
+    std::vector<uint32_t> slots;
+    std::vector<std::string> unknown;
+    resolveStudentIds(line, slots, unknown);
+    for (const auto& id : unknown) sessionOut() << "Unknown student ID: " << id << "\n";
+    if (slots.empty()) {
+        sessionOut() << "No students were " << (enrolling ? "enrolled" : "dropped") << ".\n";
+        return;
+    }
+
+    if (enrolling) subject = subjects.add(subjectName);
+    if (subject == SubjectCatalog::npos) {
+        sessionOut() << "No students are enrolled in '" << subjectName << "'.\n";
+        return;
+    }
+    BinaryWriter record;
+    encodeEnrollment(record, subject, enrolling, slots);
+    std::unique_lock<std::shared_timed_mutex> lock(enrollmentLock); // Log and apply in one order
+    if (logMutation(WAL_ENROLLMENT, record)) {
+        size_t changed = applyEnrollment(subject, enrolling, slots);
+        sessionOut() << changed << " student(s) " << (enrolling ? "enrolled in '" : "dropped from '") << subjectName
+                     << "' (" << enrollment.roster(subject).size() << " now enrolled).\n";
+    } else {
+        sessionOut() << "Error: Enrollment could not be saved. Please try again.\n";
+    }
+}
+
+const size_t SEARCH_PAGE_SIZE = 10;
+
+// Asks for a search, then shows the results a page at a time. The cursor
+// is the last hit shown, so records arriving between pages never repeat or
+// shift what has already been seen. Entering the number of a shown record
+// calls act(position) on it.
+template <typename T, typename Print, typename Act>
+void browseRecords(const SharedRecordList<T>& list, const TextIndex& index, const char* noun, Print print, Act act) {
+    std::string line;
+    sessionOut() << "Search (words, \"a phrase\", from:email), or press Enter to list the newest: ";
+    std::getline(sessionIn(), line);
+    SearchQuery query = parseSearchQuery(line);
+
+    std::vector<SearchHit> page;
+    std::vector<uint32_t> shownDocs;
+    size_t total = 0;
+    bool more = true;
+    while (true) {
+        if (more) {
+            {
+                OperationTimer timer(OP_SEARCH);
+                SearchHit last = page.empty() ? SearchHit{} : page.back();
+                index.search(query, shownDocs.empty() ? nullptr : &last, SEARCH_PAGE_SIZE, page, total);
+            }
+            if (shownDocs.empty()) {
+                sessionOut() << "\n" << total << " " << noun << (total == 1 ? "" : "s") << (query.empty() ? "" : " matched") << ".\n";
+            }
+            for (const SearchHit& hit : page) {
+                shownDocs.push_back(hit.doc);
+                sessionOut() << shownDocs.size() << ". ";
+                print(hit.doc, list.at(hit.doc));
+                sessionOut() << "---------------------------------------\n";
+            }
+            more = !page.empty() && shownDocs.size() < total;
+        }
+        if (shownDocs.empty()) break;
+        if (more) sessionOut() << "Showing " << shownDocs.size() << " of " << total << ". Enter n for the next page, ";
+        else sessionOut() << "Enter ";
+        sessionOut() << "a number to update that " << noun << ", or press Enter to finish: ";
+        if (!std::getline(sessionIn(), line)) break;
+        line = normalizeKey(line);
+        if (more && line == "n") continue;
+        char* end = nullptr;
+        unsigned long number = line.empty() ? 0 : strtoul(line.c_str(), &end, 10);
+        if (number == 0 || *end != '\0' || number > shownDocs.size()) break;
+        act(shownDocs[number - 1]);
+        sessionOut() << "\n";
+        more = false; // Ask again about the page already on screen
+    }
+}
+
+void viewStudentComplaints(UserHandle teacher) {
+    clearScreen();
+    sessionOut() << "--- Received Student Complaints ---\n";
+    size_t listSize = studentComplaints.size();
+    if (listSize == 0) {
+        sessionOut() << "No complaints have been submitted yet.\n";
+    } else {
+        browseRecords(studentComplaints, complaintSearch, "complaint", [](uint32_t id, const Complaint& complaint) {
+            sessionOut() << "From: " << complaint.studentName << " (" << complaint.studentEmail << ")\n";
+            sessionOut() << "   Submitted: " << formatTimestamp(complaint.submittedAt) << " (#" << complaint.sequence << ")\n";
+            sessionOut() << "   Complaint: " << complaint.message << "\n";
+            printCaseStatus(CASE_COMPLAINT, id);
+        }, [&](uint32_t id) { handleComplaintUpdate(teacher, id); });
+        markCasesSeen(CASE_COMPLAINT, teacher, listSize);
+    }
+     sessionOut() << "-----------------------------------\n";
+}
+
+void viewStudentLeaveNotices(UserHandle teacher) {
+    clearScreen();
+    int choice;
+    sessionOut() << "--- Student Leave Notices ---\n";
+    sessionOut() << "1. Who Is On Leave (a date, a range, or this week)\n";
+    sessionOut() << "2. Search and Decide Leave Notices\n";
+    sessionOut() << "Enter your choice: ";
+    sessionIn() >> choice;
+    if (sessionIn().fail() || (choice != 1 && choice != 2)) {
+        sessionOut() << "Invalid choice.\n";
+        sessionIn().clear();
+        ignoreLine();
+        return;
+    }
+    ignoreLine();
+    if (choice == 1) {
+        displayStudentsOnLeave();
+        return;
+    }
+
+    sessionOut() << "\n--- Received Student Leave Notices ---\n";
+    size_t listSize = studentLeaveNotices.size();
+    if (listSize == 0) {
+        sessionOut() << "No leave notices have been submitted yet.\n";
+    } else {
+        browseRecords(studentLeaveNotices, leaveSearch, "leave notice", [](uint32_t id, const LeaveNotice& notice) {
+            sessionOut() << "From: " << notice.studentName << " (" << notice.studentEmail << ")\n";
+            sessionOut() << "   Submitted: " << formatTimestamp(notice.submittedAt) << " (#" << notice.sequence << ")\n";
+            sessionOut() << "   Dates: " << notice.dates << "\n";
+            sessionOut() << "   Reason: " << notice.reason << "\n";
+            printCaseStatus(CASE_LEAVE, id);
+        }, [&](uint32_t id) { handleLeaveDecision(teacher, id); });
+        markCasesSeen(CASE_LEAVE, teacher, listSize);
+    }
+     sessionOut() << "--------------------------------------\n";
+}
+
+// Looks the range up in the leave index rather than reading every notice
+void displayStudentsOnLeave() {
+    std::string line;
+    int64_t today = calendarNow() / 1440;
+    int64_t year;
+    unsigned month, day;
+    civilFromDays(today, year, month, day);
+    int64_t fromDay, toDay;
+    sessionOut() << "Enter a date or range (e.g., 15 Feb 2024 or 12-18 Feb 2024), or press Enter for this week: ";
+    std::getline(sessionIn(), line);
+    if (line.empty()) {
+        fromDay = today - (today + 3) % 7; // Monday; 1 Jan 1970 was a Thursday
+        toDay = fromDay + 6;
+    } else if (!parseDayRange(line, year, fromDay, toDay)) {
+        sessionOut() << "Error: Could not read '" << line << "' as a date or range.\n";
+        return;
+    }
+
+    std::vector<LeaveEntry> found;
+    leaveIndex.find(fromDay, toDay, found);
+    dropRejectedLeave(found);
+    sessionOut() << "\n--- On Leave: " << formatDay(fromDay);
+    if (toDay != fromDay) sessionOut() << " - " << formatDay(toDay);
+    sessionOut() << " ---\n";
+    if (found.empty()) sessionOut() << "Nobody is on leave.\n";
+    for (const LeaveEntry& entry : found) {
+        LeaveNotice notice = studentLeaveNotices.at(entry.notice);
+        sessionOut() << "- " << users.name(entry.student) << " (" << users.roleSpecificData(entry.student) << "): "
+                     << formatDay(entry.firstDay);
+        if (entry.lastDay != entry.firstDay) sessionOut() << " - " << formatDay(entry.lastDay);
+        sessionOut() << "\n  Reason: " << notice.reason << "\n";
+        printCaseStatus(CASE_LEAVE, entry.notice);
+    }
+    sessionOut() << "--------------------------------------\n";
+}
+
+
+// --- Non-Teaching Staff Dashboard ---
+
+void showNonTeachingStaffDashboard(UserHandle user) {
+    int choice;
+    bool isLibrarian = users.roleSpecificData(user) == std::string("Librarian");
+    bool isWatchman = users.roleSpecificData(user) == std::string("Watchman");
+    bool isRegistrar = users.roleSpecificData(user) == std::string("Registrar");
+    while (true) {
+        {
+            OperationTimer timer(OP_DASHBOARD);
+            std::ostringstream screen;
+            screen << "=====================================\n";
+            screen << "   Non-Teaching Staff Dashboard - Welcome " << users.name(user) << "\n";
+            screen << "        Role: " << users.roleSpecificData(user) << "\n";
+            screen << "=====================================\n";
+            screen << "1. View Upcoming Events\n";
+            screen << "2. Schedule College Event\n";
+            screen << "3. View Alerts (" << alerts.unreadCount(user) << " unread)\n";
+            screen << "4. Send Announcement\n";
+            screen << "5. System Statistics\n";
+            screen << "6. Logout\n";
+            // Add staff-specific options here based on roleSpecificData if needed
+            if (isLibrarian) screen << "7. Library: Books, Loans & Overdue\n";
+            if (isWatchman) screen << "7. Gate Log: Scans, Entries & Last Seen\n";
+            if (isRegistrar) screen << "7. Export Records: Attendance, Results & Cases\n";
+            if (isRegistrar) screen << "8. Import User Roster\n"; // Creates accounts, so the registrar's alone
+            screen << "=====================================\n";
+            screen << "Enter your choice: ";
+            presentScreen(screen.str());
+        }
+        sessionIn() >> choice;
+
+        if (sessionIn().fail()) {
+            if (sessionIn().eof()) return;
+            sessionOut() << "Invalid input. Please enter a number.\n";
+            sessionIn().clear();
+            ignoreLine();
+            sessionOut() << "Press Enter to continue...";
+            ignoreLine();
+            continue;
+        }
+        ignoreLine();
+
+        switch (choice) {
+            case 1: displayCollegeEvents(Role::NON_TEACHING_STAFF); break;
+            case 2:
+                clearScreen();
+                sessionOut() << "--- Schedule College Event ---\n";
+                handleCalendarBooking(user, false);
+                break;
+            case 3: displayAlerts(user); break;
+            case 4: handleAnnouncement(user); break;
+            case 5: displaySystemStatistics(); break;
+            case 6:
+                sessionOut() << "Logging out...\n";
+                sessionOut() << "Press Enter to return to main menu...";
+                sessionIn().get();
+                return;
+            case 7:
+                if (isLibrarian) {
+                    handleLibrary();
+                    continue; // The library has its own Back option
+                }
+                if (isWatchman) {
+                    handleGateLog();
+                    continue;
+                }
+                if (isRegistrar) {
+                    handleDataExport();
+                    break;
+                }
+                sessionOut() << "Invalid choice. Please try again.\n";
+                break;
+            case 8:
+                if (isRegistrar) {
+                    handleRosterImport();
+                    break;
+                }
+                sessionOut() << "Invalid choice. Please try again.\n";
+                break;
+            default:
+                sessionOut() << "Invalid choice. Please try again.\n";
+                break;
+        }
+        sessionOut() << "\nPress Enter to return to the Staff Dashboard...";
+        sessionIn().get();
+    }
+}
+
+
+// --- Calendar Screens ---
+
+const int DEFAULT_UPCOMING_DAYS = 30;
+
+void printCalendarEntry(size_t number, const CalendarEntry& entry) {
+    std::string from = formatCalendarTime(entry.start);
+    std::string to = formatCalendarTime(entry.end);
+    if (entry.start / 1440 == (entry.end - 1) / 1440) to = to.substr(to.size() - 5); // Same day: time only
+    sessionOut() << number << ". " << entry.title << (entry.isMeeting ? " (Meeting)" : "") << "\n";
+    sessionOut() << "   When: " << from << " - " << to << "\n";
+    sessionOut() << "   Venue: " << entry.venue << "\n";
+    sessionOut() << "   By: " << entry.organizer << "\n\n";
+}
+
+// Asks how far ahead to look, then lists what the audience has coming up
+// (including anything already under way)
+void listUpcomingEntries(uint8_t audience) {
+    std::string line;
+    sessionOut() << "Show the next how many days? (Enter for " << DEFAULT_UPCOMING_DAYS << "): ";
+    std::getline(sessionIn(), line);
+    int days = atoi(line.c_str());
+    if (days <= 0) days = DEFAULT_UPCOMING_DAYS;
+    sessionOut() << "\n";
+
+    int64_t now = calendarNow();
+    std::vector<uint32_t> ids;
+    std::shared_lock<std::shared_timed_mutex> lock(calendarLock);
+    calendar.upcoming(audience, now, now + static_cast<int64_t>(days) * 1440, ids);
+    if (ids.empty()) sessionOut() << "Nothing is scheduled in the next " << days << " day(s).\n";
+    for (size_t i = 0; i < ids.size(); i++) printCalendarEntry(i + 1, calendar.entry(ids[i]));
+}
+
+// Books a venue for an event (staff) or a meeting (teachers). A venue that
+// is already taken is refused; a clash for the same audience is only noted.
+void handleCalendarBooking(UserHandle organizer, bool isMeeting) {
+    CalendarEntry entry;
+    std::string line;
+    int audienceChoice;
+    entry.isMeeting = isMeeting;
+    entry.organizer = users.name(organizer).str();
+
+    sessionOut() << (isMeeting ? "Meeting" : "Event") << " Title: ";
+    std::getline(sessionIn(), entry.title);
+    sessionOut() << "Venue: ";
+    std::getline(sessionIn(), entry.venue);
+    if (entry.title.empty() || entry.venue.empty()) {
+        sessionOut() << "Error: Title and venue cannot be empty.\n";
+        return;
+    }
+    sessionOut() << "Starts (YYYY-MM-DD HH:MM): ";
+    std::getline(sessionIn(), line);
+    if (!parseCalendarTime(line, entry.start)) {
+        sessionOut() << "Error: '" << line << "' is not a valid date and time.\n";
+        return;
+    }
+    sessionOut() << "Ends (YYYY-MM-DD HH:MM): ";
+    std::getline(sessionIn(), line);
+    if (!parseCalendarTime(line, entry.end) || entry.end <= entry.start) {
+        sessionOut() << "Error: The end must be a valid date and time after the start.\n";
+        return;
+    }
+    sessionOut() << "For: 1. Everyone  2. Students  3. Teachers  4. Staff\n";
+    sessionOut() << "Enter choice: ";
+    sessionIn() >> audienceChoice;
+    if (sessionIn().fail() || audienceChoice < 1 || audienceChoice > 4) {
+        sessionIn().clear();
+        audienceChoice = isMeeting ? 3 : 1;
+        sessionOut() << "Invalid choice; using " << (isMeeting ? "Teachers" : "Everyone") << ".\n";
+    }
+    ignoreLine();
+    const uint8_t audiences[] = {AUDIENCE_EVERYONE, AUDIENCE_STUDENTS, AUDIENCE_TEACHERS, AUDIENCE_STAFF};
+    entry.audience = audiences[audienceChoice - 1];
+
+    BinaryWriter record;
+    encodeCalendarEntry(record, entry);
+    std::unique_lock<std::shared_timed_mutex> lock(calendarLock); // Check, log and add as one step
+    uint32_t clash = calendar.venueConflict(entry.venue, entry.start, entry.end);
+    if (clash != Calendar::npos) {
+        const CalendarEntry& taken = calendar.entry(clash);
+        sessionOut() << "Error: " << taken.venue << " is already booked for '" << taken.title << "' ("
+                     << formatCalendarTime(taken.start) << " - " << formatCalendarTime(taken.end) << ").\n";
+        return;
+    }
+    uint32_t overlap = calendar.audienceConflict(entry.audience, entry.start, entry.end);
+    if (!logMutation(WAL_ADD_CALENDAR_ENTRY, record)) {
+        sessionOut() << "Error: The " << (isMeeting ? "meeting" : "event") << " could not be saved. Please try again.\n";
+        return;
+    }
+    calendar.add(entry);
+    sessionOut() << "'" << entry.title << "' scheduled for " << formatCalendarTime(entry.start) << ".\n";
+    if (overlap != Calendar::npos) {
+        sessionOut() << "Note: it overlaps '" << calendar.entry(overlap).title << "' for the same audience.\n";
+    }
+    lock.unlock();
+
+    AlertTarget target;
+    target.roles = entry.audience;
+    publishAlert(entry.organizer, std::string(isMeeting ? "New meeting: " : "New event: ") + entry.title + " on " +
+                 formatCalendarTime(entry.start) + " at " + entry.venue + ".", std::move(target));
+}
+
+// --- Library Screens ---
+
+const int DEFAULT_LOAN_DAYS = 14;
+const size_t MAX_OPEN_LOANS = 5; // Per borrower
+const size_t LIBRARY_PAGE_SIZE = 10;
+
+// Caller holds libraryLock
+void printBook(const Library& catalog, uint32_t book) {
+    sessionOut() << catalog.isbn(book) << "  " << catalog.title(book) << " by " << catalog.author(book) << " ("
+                 << catalog.available(book) << " of " << catalog.copies(book) << " in)\n";
+}
+
+// Caller holds libraryLock
+void printLoan(const Library& catalog, uint32_t id, int64_t today) {
+    const Loan& loan = catalog.loan(id);
+    sessionOut() << "- " << catalog.title(loan.book) << " (" << catalog.isbn(loan.book) << ") to "
+                 << users.name(loan.borrower) << " <" << users.email(loan.borrower) << ">\n";
+    sessionOut() << "  Lent " << formatDay(loan.lentDay) << ", due " << formatDay(loan.dueDay);
+    if (loan.returnedDay != Library::NOT_RETURNED) sessionOut() << ", returned " << formatDay(loan.returnedDay);
+    else if (loan.dueDay < today) sessionOut() << ", " << today - loan.dueDay << " day(s) overdue";
+    sessionOut() << "\n";
+}
+
+// Reads an ISBN and finds the book; npos (having said why) when it is not in the catalog
+uint32_t promptForBook() {
+    std::string line;
+    sessionOut() << "ISBN: ";
+    std::getline(sessionIn(), line);
+    std::string isbn = normalizeIsbn(line);
+    if (isbn.empty()) {
+        sessionOut() << "Error: '" << line << "' is not an ISBN.\n";
+        return Library::npos;
+    }
+    std::shared_lock<std::shared_timed_mutex> lock(libraryLock);
+    uint32_t book = library.findIsbn(isbn);
+    if (book == Library::npos) sessionOut() << "Error: No book with ISBN " << isbn << " is in the catalog.\n";
+    return book;
+}
+
+// Type-ahead search: an ISBN, or the start of title and author words
+void searchCatalog() {
+    std::string query;
+    sessionOut() << "Search (an ISBN, or the start of title/author words, e.g. 'intro algo'): ";
+    std::getline(sessionIn(), query);
+    std::vector<uint32_t> books;
+    std::shared_lock<std::shared_timed_mutex> lock(libraryLock);
+    std::string isbn = normalizeIsbn(query);
+    uint32_t exact = isbn.empty() ? Library::npos : library.findIsbn(isbn);
+    if (exact != Library::npos) books.push_back(exact);
+    else library.searchPrefix(query, LIBRARY_PAGE_SIZE, books);
+    sessionOut() << "\n";
+    if (books.empty()) sessionOut() << "No books match '" << query << "'.\n";
+    for (uint32_t book : books) printBook(library, book);
+    if (books.size() == LIBRARY_PAGE_SIZE) sessionOut() << "(First " << LIBRARY_PAGE_SIZE << " matches; type more to narrow them.)\n";
+}
+
+void addBookToCatalog() {
+    std::string line, title, author;
+    sessionOut() << "ISBN: ";
+    std::getline(sessionIn(), line);
+    std::string isbn = normalizeIsbn(line);
+    if (isbn.empty()) {
+        sessionOut() << "Error: '" << line << "' is not an ISBN-10 or ISBN-13.\n";
+        return;
+    }
+    {
+        std::shared_lock<std::shared_timed_mutex> lock(libraryLock);
+        uint32_t book = library.findIsbn(isbn);
+        if (book != Library::npos) {
+            sessionOut() << "Already in the catalog: " << library.title(book) << ". Adding copies.\n";
+            title = library.title(book).str();
+            author = library.author(book).str();
+        }
+    }
+    if (title.empty()) {
+        sessionOut() << "Title: ";
+        std::getline(sessionIn(), title);
+        sessionOut() << "Author: ";
+        std::getline(sessionIn(), author);
+        if (normalizeKey(title).empty() || normalizeKey(author).empty()) {
+            sessionOut() << "Error: Title and author cannot be empty.\n";
+            return;
+        }
+    }
+    sessionOut() << "Number of copies (1-1000): ";
+    std::getline(sessionIn(), line);
+    int copies = atoi(line.c_str());
+    if (copies < 1 || copies > 1000) {
+        sessionOut() << "Error: '" << line << "' is not a number of copies from 1 to 1000.\n";
+        return;
+    }
+
+    BinaryWriter record;
+    encodeBook(record, isbn, title, author, static_cast<uint32_t>(copies));
+    std::unique_lock<std::shared_timed_mutex> lock(libraryLock); // Log and add in the same order
+    if (!logMutation(WAL_ADD_BOOK, record)) {
+        sessionOut() << "Error: The book could not be saved. Please try again.\n";
+        return;
+    }
+    uint32_t book = library.addBook(isbn, title, author, static_cast<uint32_t>(copies));
+    sessionOut() << "Saved. ";
+    printBook(library, book);
+}
+
+void lendBook() {
+    uint32_t book = promptForBook();
+    if (book == Library::npos) return;
+    std::string email, line;
+    sessionOut() << "Borrower's email: ";
+    std::getline(sessionIn(), email);
+    UserHandle borrower = users.findByEmail(email);
+    if (borrower == UserDirectory::npos) {
+        sessionOut() << "Error: No user is registered as '" << email << "'.\n";
+        return;
+    }
+    sessionOut() << "Lend for how many days? (Enter for " << DEFAULT_LOAN_DAYS << "): ";
+    std::getline(sessionIn(), line);
+    int days = atoi(line.c_str());
+    if (days <= 0 || days > 365) days = DEFAULT_LOAN_DAYS;
+
+    int64_t today = calendarNow() / 1440;
+    Loan loan{book, borrower, today, today + days, Library::NOT_RETURNED};
+    BinaryWriter record;
+    encodeLoan(record, loan);
+    std::unique_lock<std::shared_timed_mutex> lock(libraryLock); // Check, log and lend as one step
+    if (library.available(book) == 0) {
+        sessionOut() << "Error: Every copy of '" << library.title(book) << "' is out.\n";
+        return;
+    }
+    if (library.openLoan(book, borrower) != Library::npos) {
+        sessionOut() << "Error: " << users.name(borrower) << " already has a copy of this book.\n";
+        return;
+    }
+    if (library.openLoansOf(borrower) >= MAX_OPEN_LOANS) {
+        sessionOut() << "Error: " << users.name(borrower) << " already has " << MAX_OPEN_LOANS << " books out.\n";
+        return;
+    }
+    if (!logMutation(WAL_LEND_BOOK, record)) {
+        sessionOut() << "Error: The loan could not be saved. Please try again.\n";
+        return;
+    }
+    library.addLoan(loan);
+    sessionOut() << "'" << library.title(book) << "' lent to " << users.name(borrower) << ", due back "
+                 << formatDay(loan.dueDay) << ".\n";
+}
+
+void returnBook() {
+    uint32_t book = promptForBook();
+    if (book == Library::npos) return;
+    std::string email;
+    sessionOut() << "Borrower's email: ";
+    std::getline(sessionIn(), email);
+    UserHandle borrower = users.findByEmail(email);
+    if (borrower == UserDirectory::npos) {
+        sessionOut() << "Error: No user is registered as '" << email << "'.\n";
+        return;
+    }
+
+    int64_t today = calendarNow() / 1440;
+    std::unique_lock<std::shared_timed_mutex> lock(libraryLock);
+    uint32_t id = library.openLoan(book, borrower);
+    if (id == Library::npos) {
+        sessionOut() << "Error: " << users.name(borrower) << " has no copy of '" << library.title(book) << "' out.\n";
+        return;
+    }
+    BinaryWriter record;
+    record.u32(id);
+    record.u64(static_cast<uint64_t>(today));
+    if (!logMutation(WAL_RETURN_BOOK, record)) {
+        sessionOut() << "Error: The return could not be saved. Please try again.\n";
+        return;
+    }
+    int64_t late = today - library.loan(id).dueDay;
+    library.returnLoan(id, today);
+    sessionOut() << "'" << library.title(book) << "' returned by " << users.name(borrower);
+    if (late > 0) sessionOut() << ", " << late << " day(s) late";
+    sessionOut() << ".\n";
+}
+
+void displayOverdueLoans() {
+    int64_t today = calendarNow() / 1440;
+    std::unique_lock<std::shared_timed_mutex> lock(libraryLock); // Brings the overdue list up to date
+    const std::vector<uint32_t>& overdue = library.overdue(today);
+    sessionOut() << "\n--- Overdue Loans (" << overdue.size() << ") ---\n";
+    if (overdue.empty()) sessionOut() << "Nothing is overdue.\n";
+    for (uint32_t id : overdue) printLoan(library, id, today);
+}
+
+void displayBorrowerLoans() {
+    std::string email;
+    sessionOut() << "Borrower's email: ";
+    std::getline(sessionIn(), email);
+    UserHandle borrower = users.findByEmail(email);
+    if (borrower == UserDirectory::npos) {
+        sessionOut() << "Error: No user is registered as '" << email << "'.\n";
+        return;
+    }
+    int64_t today = calendarNow() / 1440;
+    std::shared_lock<std::shared_timed_mutex> lock(libraryLock);
+    const std::vector<uint32_t>& loans = library.loansOf(borrower);
+    sessionOut() << "\n--- Loans of " << users.name(borrower) << " (" << library.openLoansOf(borrower) << " out) ---\n";
+    if (loans.empty()) sessionOut() << "No loans yet.\n";
+    for (auto id = loans.rbegin(); id != loans.rend(); ++id) printLoan(library, *id, today); // Newest first
+}
+
+void handleLibrary() {
+    int choice;
+    while (true) {
+        clearScreen();
+        {
+            int64_t today = calendarNow() / 1440;
+            std::unique_lock<std::shared_timed_mutex> lock(libraryLock);
+            size_t overdue = library.overdue(today).size();
+            sessionOut() << "--- Library ---\n";
+            sessionOut() << library.bookCount() << " title(s), " << library.openLoans() << " on loan, " << overdue
+                         << " overdue\n";
+        }
+        sessionOut() << "1. Search Catalog\n";
+        sessionOut() << "2. Add Book / Copies\n";
+        sessionOut() << "3. Lend Book\n";
+        sessionOut() << "4. Return Book\n";
+        sessionOut() << "5. Overdue Loans\n";
+        sessionOut() << "6. Borrower's Loans\n";
+        sessionOut() << "7. Back\n";
+        sessionOut() << "Enter your choice: ";
+        sessionIn() >> choice;
+        if (sessionIn().fail()) {
+            if (sessionIn().eof()) return;
+            sessionIn().clear();
+            choice = 0;
+        }
+        ignoreLine();
+
+        switch (choice) {
+            case 1: searchCatalog(); break;
+            case 2: addBookToCatalog(); break;
+            case 3: lendBook(); break;
+            case 4: returnBook(); break;
+            case 5: displayOverdueLoans(); break;
+            case 6: displayBorrowerLoans(); break;
+            case 7: return;
+            default: sessionOut() << "Invalid choice. Please try again.\n"; break;
+        }
+        sessionOut() << "\nPress Enter to return to the Library...";
+        sessionIn().get();
+    }
+}
+
+
+// --- Gate Log Screens ---
+
+const int DEFAULT_HISTORY_DAYS = 7;
+const size_t GATE_PAGE_SIZE = 20;
+
+// Caller holds gateLock
+void printGateEvent(const GateEvent& event) {
+    const std::string& label = gateLog.label(event.person);
+    UserHandle user = users.findByEmail(label);
+    sessionOut() << formatGateTime(event.time) << "  " << (event.entering ? "IN " : "OUT") << "  "
+                 << gateLog.gateName(event.gate) << "  ";
+    if (user == UserDirectory::npos) sessionOut() << label << " (visitor)\n";
+    else sessionOut() << users.name(user) << " <" << label << ">\n";
+}
+
+// Reads who a query is about; npos (having said why) when they were never scanned
+uint32_t promptForGatePerson() {
+    std::string typed;
+    sessionOut() << "Email, student ID or visitor name: ";
+    std::getline(sessionIn(), typed);
+    std::string label = gatePersonLabel(typed);
+    std::shared_lock<std::shared_timed_mutex> lock(gateLock);
+    uint32_t person = label.empty() ? GateLog::npos : gateLog.findPerson(label);
+    if (person == GateLog::npos) sessionOut() << "No scans for '" << typed << "'.\n";
+    return person;
+}
+
+// Reads a time, or takes `fallback` when the line is empty; false (having
+// said why) if it cannot be read
+bool promptForGateTime(const char* prompt, int64_t fallback, int64_t& seconds) {
+    std::string line;
+    sessionOut() << prompt << " (YYYY-MM-DD HH:MM, Enter for " << formatGateTime(fallback) << "): ";
+    std::getline(sessionIn(), line);
+    if (line.find_first_not_of(" \t\r") == std::string::npos) {
+        seconds = fallback;
+        return true;
+    }
+    if (parseGateTime(line, seconds)) return true;
+    sessionOut() << "Error: '" << line << "' is not a time.\n";
+    return false;
+}
+
+void recordGateScan() {
+    std::string person, direction, gate;
+    sessionOut() << "Email, student ID or visitor name: ";
+    std::getline(sessionIn(), person);
+    sessionOut() << "In or out? ";
+    std::getline(sessionIn(), direction);
+    sessionOut() << "Gate (Enter for " << DEFAULT_GATE << "): ";
+    std::getline(sessionIn(), gate);
+    GateScan scan;
+    std::string line = "," + person + "," + direction + "," + gate;
+    const char* problem = std::count(line.begin(), line.end(), ',') == 3 ? parseGateScan(line, scan)
+                                                                         : "names cannot hold commas";
+    if (problem != nullptr) {
+        sessionOut() << "Error: The scan was not recorded: " << problem << ".\n";
+        return;
+    }
+    if (!recordGateScans(std::vector<GateScan>{scan})) {
+        sessionOut() << "Error: The scan could not be saved. Please try again.\n";
+        return;
+    }
+    sessionOut() << scan.person << " scanned " << (scan.entering ? "in" : "out") << " at " << scan.gate << ", "
+                 << formatGateTime(scan.time) << ".\n";
+}
+
+void printGateScanReport(const GateScanReport& report) {
+    sessionOut() << report.logged << " scan(s) recorded";
+    if (report.lines > 0) sessionOut() << " of " << report.lines << " line(s) read";
+    sessionOut() << ".\n";
+    if (report.rejected > 0) {
+        sessionOut() << report.rejected << " line(s) were rejected:\n";
+        for (const auto& problem : report.problems) sessionOut() << "  " << problem << "\n";
+        if (report.rejected > report.problems.size()) sessionOut() << "  ...\n";
+    }
+    if (report.unsaved > 0) sessionOut() << "Error: " << report.unsaved << " scan(s) could not be saved and were dropped.\n";
+}
+
+// Takes scans as a scanner (or a script on the other end of a server
+// connection) sends them, until "end"
+void runScannerFeed() {
+    sessionOut() << "Send scans, one per line: time,person,in|out,gate  e.g. 1710927015,S1001,in,North Gate\n";
+    sessionOut() << "(Leave the time empty for now. Send 'end' to stop.)\n";
+    sessionOut().flush();
+    GateScanReport report;
+    ingestGateScans(sessionIn(), report);
+    if (!sessionIn()) sessionIn().clear(); // The feed ended without "end"
+    printGateScanReport(report);
+}
+
+void importGateScanFile() {
+    std::string filePath;
+    sessionOut() << "Enter path to scan file: ";
+    std::getline(sessionIn(), filePath);
+    typedef std::chrono::steady_clock Clock;
+    GateScanReport report;
+    auto start = Clock::now();
+    if (!importGateScans(filePath, report)) {
+        sessionOut() << "Error: Could not open scan file '" << filePath << "'.\n";
+        return;
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    printGateScanReport(report);
+    FormatGuard format(sessionOut());
+    sessionOut() << std::fixed << std::setprecision(2) << "(" << seconds * 1000 << " ms)\n";
+}
+
+void displayEntriesBetween() {
+    int64_t now = wallClockSeconds();
+    int64_t from, to;
+    if (!promptForGateTime("From", dayOfSeconds(now) * 86400, from) || !promptForGateTime("To", now, to)) return;
+    if (to < from) std::swap(from, to);
+
+    std::vector<GateEvent> found;
+    std::shared_lock<std::shared_timed_mutex> lock(gateLock);
+    gateLog.between(from, to, true, found);
+    std::vector<uint32_t> people;
+    people.reserve(found.size());
+    for (const auto& event : found) people.push_back(event.person);
+    std::sort(people.begin(), people.end());
+    size_t distinct = static_cast<size_t>(std::unique(people.begin(), people.end()) - people.begin());
+
+    sessionOut() << "\n--- Entries from " << formatGateTime(from) << " to " << formatGateTime(to) << " ---\n";
+    sessionOut() << found.size() << " entr" << (found.size() == 1 ? "y" : "ies") << " by " << distinct << " people.\n";
+    for (size_t i = 0; i < found.size() && i < GATE_PAGE_SIZE; i++) printGateEvent(found[i]);
+    if (found.size() > GATE_PAGE_SIZE) sessionOut() << "... and " << found.size() - GATE_PAGE_SIZE << " more.\n";
+}
+
+void displayLastSeen() {
+    uint32_t person = promptForGatePerson();
+    if (person == GateLog::npos) return;
+    std::shared_lock<std::shared_timed_mutex> lock(gateLock);
+    GateEvent event;
+    if (!gateLog.lastSeen(person, event)) return;
+    sessionOut() << "\nLast seen: ";
+    printGateEvent(event);
+    sessionOut() << (event.entering ? "Still inside.\n" : "Has left.\n");
+}
+
+void displayGateHistory() {
+    uint32_t person = promptForGatePerson();
+    if (person == GateLog::npos) return;
+    std::string line;
+    sessionOut() << "Show how many days back? (Enter for " << DEFAULT_HISTORY_DAYS << "): ";
+    std::getline(sessionIn(), line);
+    int days = atoi(line.c_str());
+    if (days <= 0) days = DEFAULT_HISTORY_DAYS;
+
+    int64_t now = wallClockSeconds();
+    int64_t from = (dayOfSeconds(now) - days + 1) * 86400;
+    std::vector<GateEvent> found;
+    std::shared_lock<std::shared_timed_mutex> lock(gateLock);
+    gateLog.history(person, from, now, found);
+    sessionOut() << "\n--- " << gateLog.label(person) << ", last " << days << " day(s) ---\n";
+    if (found.empty()) sessionOut() << "No scans.\n";
+    for (auto event = found.rbegin(); event != found.rend(); ++event) printGateEvent(*event); // Newest first
+}
+
+void handleGateLog() {
+    int choice;
+    while (true) {
+        clearScreen();
+        {
+            int64_t today = dayOfSeconds(wallClockSeconds());
+            std::shared_lock<std::shared_timed_mutex> lock(gateLock);
+            sessionOut() << "--- Gate Log ---\n";
+            sessionOut() << gateLog.eventsOn(today) << " scan(s) today, " << gateLog.eventCount() << " in all, "
+                         << gateLog.personCount() << " people\n";
+        }
+        sessionOut() << "1. Record a Scan\n";
+        sessionOut() << "2. Scanner Feed\n";
+        sessionOut() << "3. Import Scan File\n";
+        sessionOut() << "4. Who Entered Between\n";
+        sessionOut() << "5. Last Seen\n";
+        sessionOut() << "6. Person's History\n";
+        sessionOut() << "7. Back\n";
+        sessionOut() << "Enter your choice: ";
+        sessionIn() >> choice;
+        if (sessionIn().fail()) {
+            if (sessionIn().eof()) return;
+            sessionIn().clear();
+            choice = 0;
+        }
+        ignoreLine();
+
+        switch (choice) {
+            case 1: recordGateScan(); break;
+            case 2: runScannerFeed(); break;
+            case 3: importGateScanFile(); break;
+            case 4: displayEntriesBetween(); break;
+            case 5: displayLastSeen(); break;
+            case 6: displayGateHistory(); break;
+            case 7: return;
+            default: sessionOut() << "Invalid choice. Please try again.\n"; break;
+        }
+        sessionOut() << "\nPress Enter to return to the Gate Log...";
+        sessionIn().get();
+    }
+}
+
+// --- Complaint and Leave Workflow ---
+
+CaseTracker& casesOf(CaseKind kind) {
+    return kind == CASE_COMPLAINT ? complaintCases : leaveCases;
+}
+
+// Dashboard counts, e.g. "2 new, 5 open, 1 yours"; reads counters only
+std::string caseSummary(CaseKind kind, UserHandle teacher) {
+    std::shared_lock<std::shared_timed_mutex> lock(casesLock);
+    const CaseTracker& cases = casesOf(kind);
+    std::string summary = std::to_string(cases.unreadFor(teacher)) + " new, ";
+    if (kind == CASE_LEAVE) return summary + std::to_string(cases.count(CASE_PENDING)) + " pending";
+    return summary + std::to_string(cases.count(CASE_OPEN) + cases.count(CASE_ACKNOWLEDGED)) + " open, " +
+           std::to_string(cases.activeFor(teacher)) + " yours";
+}
+
+// "Who is on leave" lists pending notices with their status, but not
+// rejected ones
+void dropRejectedLeave(std::vector<LeaveEntry>& found) {
+    std::shared_lock<std::shared_timed_mutex> lock(casesLock);
+    found.erase(std::remove_if(found.begin(), found.end(), [](const LeaveEntry& entry) {
+        return leaveCases.statusOf(entry.notice) == CASE_REJECTED;
+    }), found.end());
+}
+
+// Only a teacher's approval excuses a student from the roll call
+void keepApprovedLeave(std::vector<LeaveEntry>& found) {
+    std::shared_lock<std::shared_timed_mutex> lock(casesLock);
+    found.erase(std::remove_if(found.begin(), found.end(), [](const LeaveEntry& entry) {
+        return leaveCases.statusOf(entry.notice) != CASE_APPROVED;
+    }), found.end());
+}
+
+void printCaseStatus(CaseKind kind, uint32_t id) {
+    uint8_t status;
+    UserHandle assignee;
+    {
+        std::shared_lock<std::shared_timed_mutex> lock(casesLock);
+        status = casesOf(kind).statusOf(id);
+        assignee = casesOf(kind).assigneeOf(id);
+    }
+    sessionOut() << "   Status: " << caseStatusName(kind, status);
+    if (assignee != UserDirectory::npos) sessionOut() << " (" << users.name(assignee) << ")";
+    sessionOut() << "\n";
+}
+
+// Logs and applies a status change; false when it could not be saved
+bool updateCase(CaseKind kind, uint32_t id, uint8_t status, UserHandle assignee) {
+    BinaryWriter record;
+    record.u8(kind);
+    record.u32(id);
+    record.u8(status);
+    record.u32(assignee);
+    std::unique_lock<std::shared_timed_mutex> lock(casesLock);
+    if (id >= casesOf(kind).size() || !logMutation(WAL_UPDATE_CASE, record)) return false;
+    return casesOf(kind).update(id, status, assignee);
+}
+
+void markCasesSeen(CaseKind kind, UserHandle teacher, size_t listSize) {
+    BinaryWriter record;
+    record.u8(kind);
+    record.u32(teacher);
+    record.u32(static_cast<uint32_t>(listSize));
+    std::unique_lock<std::shared_timed_mutex> lock(casesLock);
+    if (casesOf(kind).seenBy(teacher) >= listSize) return;
+    if (logMutation(WAL_MARK_CASES_SEEN, record)) casesOf(kind).markSeen(teacher, static_cast<uint32_t>(listSize));
+}
+
+// Tells the student who filed a case what happened to it
+void alertStudent(const std::string& email, UserHandle teacher, const std::string& text) {
+    AlertTarget target;
+    UserHandle student = users.findByEmail(email);
+    if (student == UserDirectory::npos) return;
+    target.users.push_back(student);
+    publishAlert(users.name(teacher).str(), text, std::move(target));
+}
+
+void handleComplaintUpdate(UserHandle teacher, uint32_t id) {
+    int choice;
+    Complaint complaint = studentComplaints.at(id);
+    sessionOut() << "Update complaint #" << complaint.sequence << " from " << complaint.studentName << ":\n";
+    sessionOut() << "1. Acknowledge (take it on)\n";
+    sessionOut() << "2. Mark Resolved\n";
+    sessionOut() << "3. Reopen\n";
+    sessionOut() << "Enter your choice: ";
+    sessionIn() >> choice;
+    if (sessionIn().fail() || choice < 1 || choice > 3) {
+        sessionOut() << "Invalid choice, the complaint is unchanged.\n";
+        sessionIn().clear();
+        ignoreLine();
+        return;
+    }
+    ignoreLine();
+
+    static const uint8_t statuses[] = {CASE_ACKNOWLEDGED, CASE_RESOLVED, CASE_OPEN};
+    uint8_t status = statuses[choice - 1];
+    UserHandle assignee = status == CASE_OPEN ? UserDirectory::npos : teacher;
+    if (!updateCase(CASE_COMPLAINT, id, status, assignee)) {
+        sessionOut() << "Error: The complaint could not be updated. Please try again.\n";
+        return;
+    }
+    sessionOut() << "Complaint #" << complaint.sequence << " is now " << caseStatusName(CASE_COMPLAINT, status) << ".\n";
+    if (status != CASE_OPEN) {
+        alertStudent(complaint.studentEmail, teacher, "Your complaint #" + std::to_string(complaint.sequence) +
+                     " was " + (status == CASE_RESOLVED ? "resolved." : "acknowledged."));
+    }
+}
+
+void handleLeaveDecision(UserHandle teacher, uint32_t id) {
+    int choice;
+    LeaveNotice notice = studentLeaveNotices.at(id);
+    sessionOut() << "Leave for " << notice.dates << " from " << notice.studentName << ":\n";
+    sessionOut() << "1. Approve\n";
+    sessionOut() << "2. Reject\n";
+    sessionOut() << "Enter your choice: ";
+    sessionIn() >> choice;
+    if (sessionIn().fail() || (choice != 1 && choice != 2)) {
+        sessionOut() << "Invalid choice, the notice is unchanged.\n";
+        sessionIn().clear();
+        ignoreLine();
+        return;
+    }
+    ignoreLine();
+
+    uint8_t status = choice == 1 ? CASE_APPROVED : CASE_REJECTED;
+    if (!updateCase(CASE_LEAVE, id, status, teacher)) {
+        sessionOut() << "Error: The decision could not be saved. Please try again.\n";
+        return;
+    }
+    sessionOut() << "Leave " << (status == CASE_APPROVED ? "approved" : "rejected") << ".\n";
+    alertStudent(notice.studentEmail, teacher, "Your leave for " + notice.dates + " was " +
+                 (status == CASE_APPROVED ? "approved." : "rejected."));
+}
+
+// --- Alert Screens ---
+
+void displayAlerts(UserHandle user) {
+    clearScreen();
+    std::vector<uint32_t> ids;
+    uint32_t unread;
+    uint32_t deliveredCount = alerts.inbox(user, ids, unread);
+    sessionOut() << "--- Your Alerts (" << unread << " unread) ---\n";
+    if (ids.empty()) sessionOut() << "No alerts yet.\n";
+    for (uint32_t k = 0; k < ids.size(); k++) {
+        AlertRecord record = alerts.alert(ids[k]);
+        sessionOut() << (k < unread ? "* " : "  ") << "[" << formatTimestamp(record.postedAt) << "] "
+                     << record.from << ": " << record.text << "\n";
+    }
+    sessionOut() << "------------------------------\n";
+
+    if (unread > 0) {
+        BinaryWriter record;
+        record.u32(user);
+        record.u32(deliveredCount);
+        if (logMutation(WAL_MARK_ALERTS_READ, record)) alerts.markSeen(user, deliveredCount);
+    }
+}
+
+void handleAnnouncement(UserHandle sender) {
+    clearScreen();
+    int choice;
+    AlertTarget target;
+    std::string line;
+
+    sessionOut() << "--- Send Announcement ---\n";
+    sessionOut() << "Send to:\n";
+    sessionOut() << "1. Everyone\n";
+    sessionOut() << "2. All Students\n";
+    sessionOut() << "3. All Teachers\n";
+    sessionOut() << "4. All Non-Teaching Staff\n";
+    sessionOut() << "5. A Subject/Section Roster\n";
+    sessionOut() << "6. One Person (email or student ID)\n";
+    sessionOut() << "Enter your choice: ";
+    sessionIn() >> choice;
+    if (sessionIn().fail() || choice < 1 || choice > 6) {
+        sessionOut() << "Invalid choice.\n";
+        sessionIn().clear();
+        ignoreLine();
+        return;
+    }
+    ignoreLine();
+
+    const uint8_t roleTargets[] = {AUDIENCE_EVERYONE, AUDIENCE_STUDENTS, AUDIENCE_TEACHERS, AUDIENCE_STAFF};
+    if (choice <= 4) {
+        target.roles = roleTargets[choice - 1];
+    } else if (choice == 5) {
+        sessionOut() << "Enter Subject/Section Name: ";
+        std::getline(sessionIn(), line);
+        uint32_t subject = subjects.find(line);
+        std::vector<uint32_t> roster;
+        if (subject != SubjectCatalog::npos) {
+            std::shared_lock<std::shared_timed_mutex> lock(enrollmentLock);
+            roster = enrollment.roster(subject);
+        }
+        if (roster.empty()) {
+            sessionOut() << "No students are enrolled in '" << line << "'.\n";
+            return;
+        }
+        for (uint32_t slot : roster) target.users.push_back(users.userOfStudent(slot));
+    } else {
+        sessionOut() << "Enter Email or Student ID: ";
+        std::getline(sessionIn(), line);
+        UserHandle recipient = users.findByEmail(line);
+        if (recipient == UserDirectory::npos) recipient = users.findByStudentId(line);
+        if (recipient == UserDirectory::npos) {
+            sessionOut() << "Error: No user with email or student ID '" << line << "'.\n";
+            return;
+        }
+        target.users.push_back(recipient);
+    }
+
+    sessionOut() << "Message: ";
+    std::getline(sessionIn(), line);
+    if (line.empty()) {
+        sessionOut() << "Error: Message cannot be empty.\n";
+        return;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    size_t reached = publishAlert(users.name(sender).str(), line, std::move(target));
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (reached == 0) {
+        sessionOut() << "The announcement reached nobody (or could not be saved).\n";
+    } else {
+        FormatGuard format(sessionOut());
+        sessionOut() << std::fixed << std::setprecision(2);
+        sessionOut() << "Announcement delivered to " << reached << " user(s) in " << ms << " ms.\n";
+    }
+}
+
+// --- Snapshot Persistence ---
+// Layout: header, section table, then section payloads. Each section is a
+// record count followed by length-prefixed fields. Unknown sections are
+// skipped, so new sections can be added without breaking older snapshots.
+//
+//   header:  magic[8] "CALSNAP1" | u32 version | u32 sectionCount
+//            | u64 payloadSize | u64 checksum (over everything after the header)
+//   table:   sectionCount x { u32 tag | u32 reserved | u64 offset | u64 size }
+
+const char SNAPSHOT_MAGIC[8] = {'C', 'A', 'L', 'S', 'N', 'A', 'P', '1'};
+const uint32_t SNAPSHOT_VERSION = 1;
+const size_t SNAPSHOT_HEADER_SIZE = 8 + 4 + 4 + 8 + 8;
+const size_t SNAPSHOT_SECTION_ENTRY_SIZE = 4 + 4 + 8 + 8;
+
+enum SnapshotSection : uint32_t {
+    SECTION_META = 0x4154454D,        // "META": u64 WAL position the snapshot covers
+    SECTION_USERS = 0x52455355,       // "USER"
+    SECTION_COMPLAINTS_V1 = 0x4C504D43,   // "CMPL": before submission numbers; still read
+    SECTION_LEAVE_NOTICES_V1 = 0x5641454C, // "LEAV"
+    SECTION_COMPLAINTS = 0x32504D43,      // "CMP2"
+    SECTION_LEAVE_NOTICES_V2 = 0x3256454C, // "LEV2": before parsed date ranges; still read
+    SECTION_LEAVE_NOTICES = 0x3356454C,   // "LEV3"
+    SECTION_ATTENDANCE = 0x4E545441,    // "ATTN"
+    SECTION_SUBJECTS = 0x4A425553,      // "SUBJ": names in id order, before ATTN/GRDS
+    SECTION_GRADES = 0x53445247,        // "GRDS"
+    SECTION_ENROLLMENT = 0x4C524E45,    // "ENRL": per subject id, its sorted roster
+    SECTION_CALENDAR = 0x4E4C4143,      // "CALN"
+    SECTION_ALERTS = 0x54524C41,        // "ALRT": alert texts, then the non-empty inboxes
+    SECTION_CASES = 0x45534143,         // "CASE": complaint then leave statuses, each with who has seen how many
+    SECTION_LIBRARY = 0x5242494C,       // "LIBR": books, then every loan in the order it was made
+    SECTION_COLD = 0x444C4F43,          // "COLD": per list (complaints, leave), the segment files before CMP2/LEV3
+    SECTION_GATE = 0x45544147           // "GATE": people, gates, then each day's encoded scans
+};
+
+void encodeUser(BinaryWriter& out, const User& user) {
+    out.str(user.name);
+    out.str(user.email);
+    out.str(user.password);
+    out.str(user.phone);
+    out.u8(static_cast<uint8_t>(user.role));
+    out.str(user.roleSpecificData);
+}
+
+void encodeUserBatch(BinaryWriter& out, const std::vector<User>& batch) {
+    out.u64(batch.size());
+    for (const User& user : batch) encodeUser(out, user);
+}
+
+void encodeComplaint(BinaryWriter& out, const Complaint& complaint) {
+    out.u64(complaint.sequence);
+    out.u64(static_cast<uint64_t>(complaint.submittedAt));
+    out.str(complaint.studentEmail);
+    out.str(complaint.studentName);
+    out.str(complaint.message);
+}
+
+void encodeLeaveNotice(BinaryWriter& out, const LeaveNotice& notice) {
+    out.u64(notice.sequence);
+    out.u64(static_cast<uint64_t>(notice.submittedAt));
+    out.str(notice.studentEmail);
+    out.str(notice.studentName);
+    out.str(notice.dates);
+    out.str(notice.reason);
+    out.u64(static_cast<uint64_t>(notice.firstDay));
+    out.u64(static_cast<uint64_t>(notice.lastDay));
+}
+
+// Sessions carry their subject by name so replay can re-create the subject
+void encodeAttendanceSession(BinaryWriter& out, const AttendanceSession& session) {
+    out.str(subjects.name(session.subject));
+    out.str(session.date);
+    out.u32(static_cast<uint32_t>(session.marked.size()));
+    out.raw(session.marked.data(), session.marked.size() * sizeof(uint64_t));
+    out.raw(session.present.data(), session.present.size() * sizeof(uint64_t));
+}
+
+// One upload: the subject travels by name, grades by student slot
+void encodeResults(BinaryWriter& out, uint32_t subject, uint8_t semester, uint8_t credits,
+                   const std::vector<ParsedGrade>& parsed) {
+    out.str(subjects.name(subject));
+    out.u8(semester);
+    out.u8(credits);
+    out.u64(parsed.size());
+    for (const auto& grade : parsed) {
+        out.u32(grade.slot);
+        out.u8(grade.grade);
+    }
+}
+
+// One roster change: the subject travels by name, students by slot
+void encodeEnrollment(BinaryWriter& out, uint32_t subject, bool enrolling, const std::vector<uint32_t>& slots) {
+    out.str(subjects.name(subject));
+    out.u8(enrolling ? 1 : 0);
+    out.u64(slots.size());
+    for (uint32_t slot : slots) out.u32(slot);
+}
+
+void encodeCalendarEntry(BinaryWriter& out, const CalendarEntry& entry) {
+    out.u64(static_cast<uint64_t>(entry.start));
+    out.u64(static_cast<uint64_t>(entry.end));
+    out.u8(entry.audience);
+    out.u8(entry.isMeeting ? 1 : 0);
+    out.str(entry.title);
+    out.str(entry.venue);
+    out.str(entry.organizer);
+}
+
+void encodeBook(BinaryWriter& out, const std::string& isbn, const std::string& title, const std::string& author,
+                uint32_t copies) {
+    out.str(isbn);
+    out.str(title);
+    out.str(author);
+    out.u32(copies);
+}
+
+void encodeLoan(BinaryWriter& out, const Loan& loan) {
+    out.u32(loan.book);
+    out.u32(loan.borrower);
+    out.u64(static_cast<uint64_t>(loan.lentDay));
+    out.u64(static_cast<uint64_t>(loan.dueDay));
+    out.u64(static_cast<uint64_t>(loan.returnedDay));
+}
+
+void encodeGateScans(BinaryWriter& out, const std::vector<GateScan>& scans) {
+    out.u64(scans.size());
+    for (const auto& scan : scans) {
+        out.u64(static_cast<uint64_t>(scan.time));
+        out.str(scan.person);
+        out.str(scan.gate);
+        out.u8(scan.entering ? 1 : 0);
+    }
+}
+
+void encodeAlertRecord(BinaryWriter& out, const AlertRecord& record) {
+    out.u64(static_cast<uint64_t>(record.postedAt));
+    out.str(record.from);
+    out.str(record.text);
+}
+
+void encodeAlert(BinaryWriter& out, const AlertRecord& record, const AlertTarget& target) {
+    encodeAlertRecord(out, record);
+    out.u8(target.roles);
+    out.u32(target.userLimit);
+    out.u64(target.users.size());
+    for (UserHandle user : target.users) out.u32(user);
+}
+
+void encodeGradeEntry(BinaryWriter& out, const GradeEntry& entry) {
+    out.u32(entry.subject);
+    out.u8(entry.semester);
+    out.u8(entry.credits);
+    out.u8(entry.grade);
+}
+
+bool decodeUser(BinaryReader& in, User& user) {
+    user.name = in.str().str();
+    user.email = in.str().str();
+    user.password = in.str().str();
+    user.phone = in.str().str();
+    uint8_t role = in.u8();
+    user.role = static_cast<Role>(role);
+    user.roleSpecificData = in.str().str();
+    return in.good() && role <= static_cast<uint8_t>(Role::NON_TEACHING_STAFF);
+}
+
+// Records from older builds (numbered == false) get the next free number
+bool decodeComplaint(BinaryReader& in, Complaint& complaint, bool numbered) {
+    if (numbered) {
+        complaint.sequence = in.u64();
+        complaint.submittedAt = static_cast<int64_t>(in.u64());
+    }
+    complaint.studentEmail = in.str().str();
+    complaint.studentName = in.str().str();
+    complaint.message = in.str().str();
+    return in.good();
+}
+
+// Version 1 records are unnumbered, version 2 lack the parsed date range:
+// their dates are read now, taking a missing year from when they were sent
+bool decodeLeaveNotice(BinaryReader& in, LeaveNotice& notice, int version) {
+    if (version >= 2) {
+        notice.sequence = in.u64();
+        notice.submittedAt = static_cast<int64_t>(in.u64());
+    }
+    notice.studentEmail = in.str().str();
+    notice.studentName = in.str().str();
+    notice.dates = in.str().str();
+    notice.reason = in.str().str();
+    if (version >= 3) {
+        notice.firstDay = static_cast<int64_t>(in.u64());
+        notice.lastDay = static_cast<int64_t>(in.u64());
+    } else {
+        int64_t year;
+        unsigned month, day;
+        civilFromDays(notice.submittedAt != 0 ? notice.submittedAt / 86400 : calendarNow() / 1440, year, month, day);
+        if (!parseDayRange(notice.dates, year, notice.firstDay, notice.lastDay)) notice.lastDay = notice.firstDay - 1;
+    }
+    return in.good();
+}
+
+// Archived records, in the current layout
+void encodeRecord(BinaryWriter& out, const Complaint& complaint) {
+    encodeComplaint(out, complaint);
+}
+
+bool decodeRecord(BinaryReader& in, Complaint& complaint) {
+    return decodeComplaint(in, complaint, true);
+}
+
+void encodeRecord(BinaryWriter& out, const LeaveNotice& notice) {
+    encodeLeaveNotice(out, notice);
+}
+
+bool decodeRecord(BinaryReader& in, LeaveNotice& notice) {
+    return decodeLeaveNotice(in, notice, 3);
+}
+
+bool decodeAttendanceSession(BinaryReader& in, SubjectCatalog& catalog, AttendanceSession& session) {
+    std::string subject = in.str().str();
+    session.date = in.str().str();
+    uint32_t words = in.u32();
+    session.marked.resize(words);
+    session.present.resize(words);
+    for (uint32_t w = 0; w < words; w++) session.marked[w] = in.u64();
+    for (uint32_t w = 0; w < words; w++) session.present[w] = in.u64();
+    if (!in.good()) return false;
+    session.subject = catalog.add(subject);
+    return true;
+}
+
+bool decodeCalendarEntry(BinaryReader& in, CalendarEntry& entry) {
+    entry.start = static_cast<int64_t>(in.u64());
+    entry.end = static_cast<int64_t>(in.u64());
+    entry.audience = in.u8();
+    entry.isMeeting = in.u8() != 0;
+    entry.title = in.str().str();
+    entry.venue = in.str().str();
+    entry.organizer = in.str().str();
+    return in.good() && entry.start < entry.end && (entry.audience & ~AUDIENCE_EVERYONE) == 0;
+}
+
+// Adds the book read from `in` to the library; false if malformed
+bool decodeBook(BinaryReader& in, Library& into) {
+    std::string isbn = in.str().str();
+    std::string title = in.str().str();
+    std::string author = in.str().str();
+    uint32_t copies = in.u32();
+    if (!in.good() || normalizeIsbn(isbn) != isbn) return false;
+    into.addBook(isbn, title, author, copies);
+    return true;
+}
+
+bool decodeLoan(BinaryReader& in, const Library& into, size_t userCount, Loan& loan) {
+    loan.book = in.u32();
+    loan.borrower = in.u32();
+    loan.lentDay = static_cast<int64_t>(in.u64());
+    loan.dueDay = static_cast<int64_t>(in.u64());
+    loan.returnedDay = static_cast<int64_t>(in.u64());
+    return in.good() && loan.book < into.bookCount() && loan.borrower < userCount &&
+           (loan.returnedDay != Library::NOT_RETURNED || into.available(loan.book) > 0);
+}
+
+bool decodeGateScans(BinaryReader& in, std::vector<GateScan>& scans) {
+    uint64_t count = in.u64();
+    for (uint64_t n = 0; n < count && in.good(); n++) {
+        GateScan scan;
+        scan.time = static_cast<int64_t>(in.u64());
+        scan.person = in.str().str();
+        scan.gate = in.str().str();
+        scan.entering = in.u8() != 0;
+        if (in.good()) scans.push_back(std::move(scan));
+    }
+    return in.good();
+}
+
+bool decodeAlertRecord(BinaryReader& in, AlertRecord& record) {
+    record.postedAt = static_cast<int64_t>(in.u64());
+    record.from = in.str().str();
+    record.text = in.str().str();
+    return in.good();
+}
+
+bool decodeGradeEntry(BinaryReader& in, const SubjectCatalog& catalog, GradeEntry& entry) {
+    entry.subject = in.u32();
+    entry.semester = in.u8();
+    entry.credits = in.u8();
+    entry.grade = in.u8();
+    return in.good() && entry.subject < catalog.size() && entry.grade < GRADE_SCALE_SIZE &&
+           validResultTerms(entry.semester, entry.credits);
+}
+
+bool saveSnapshot(const std::string& path) {
+    const uint32_t sectionCount = 14;
+    BinaryWriter out;
+    out.raw(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    out.u32(SNAPSHOT_VERSION);
+    out.u32(sectionCount);
+    out.u64(0); // payloadSize, patched below
+    out.u64(0); // checksum, patched below
+
+    size_t tableOffset = out.size();
+    for (uint32_t i = 0; i < sectionCount * SNAPSHOT_SECTION_ENTRY_SIZE; i++) out.u8(0);
+
+    size_t entry = tableOffset;
+    auto writeSection = [&](uint32_t tag, size_t start) {
+        out.patchU32(entry, tag);
+        out.patchU64(entry + 8, start);
+        out.patchU64(entry + 16, out.size() - start);
+        entry += SNAPSHOT_SECTION_ENTRY_SIZE;
+    };
+
+    size_t start = out.size();
+    out.u64(1);
+    out.u64(snapshotWalLsn);
+    writeSection(SECTION_META, start);
+
+    start = out.size();
+    size_t subjectCount = subjects.size();
+    out.u64(subjectCount);
+    for (uint32_t subject = 0; subject < subjectCount; subject++) out.str(subjects.name(subject));
+    writeSection(SECTION_SUBJECTS, start);
+
+    start = out.size();
+    size_t userCount = users.size();
+    out.u64(userCount);
+    for (UserHandle user = 0; user < userCount; user++) encodeUser(out, users.get(user));
+    writeSection(SECTION_USERS, start);
+
+    // Archived records stay in their segments; the snapshot names the files
+    // and holds only the records after them
+    start = out.size();
+    out.u64(2);
+    size_t coldComplaints = studentComplaints.coldCount();
+    size_t coldNotices = studentLeaveNotices.coldCount();
+    std::vector<std::string> paths;
+    studentComplaints.coldPaths(paths);
+    out.u32(static_cast<uint32_t>(paths.size()));
+    for (const std::string& segment : paths) out.str(segment);
+    paths.clear();
+    studentLeaveNotices.coldPaths(paths);
+    out.u32(static_cast<uint32_t>(paths.size()));
+    for (const std::string& segment : paths) out.str(segment);
+    writeSection(SECTION_COLD, start);
+
+    start = out.size();
+    uint64_t written = 0;
+    out.u64(0); // count, patched once the list has been walked under its lock
+    studentComplaints.forEachFrom(coldComplaints, [&](size_t, const Complaint& complaint) {
+        encodeComplaint(out, complaint);
+        written++;
+    });
+    out.patchU64(start, written);
+    writeSection(SECTION_COMPLAINTS, start);
+
+    start = out.size();
+    written = 0;
+    out.u64(0);
+    studentLeaveNotices.forEachFrom(coldNotices, [&](size_t, const LeaveNotice& notice) {
+        encodeLeaveNotice(out, notice);
+        written++;
+    });
+    out.patchU64(start, written);
+    writeSection(SECTION_LEAVE_NOTICES, start);
+
+    start = out.size();
+    {
+        std::shared_lock<std::shared_timed_mutex> lock(attendanceLock);
+        out.u64(attendance.allSessions().size());
+        for (const auto& session : attendance.allSessions()) encodeAttendanceSession(out, session);
+    }
+    writeSection(SECTION_ATTENDANCE, start);
+
+    start = out.size();
+    {
+        std::shared_lock<std::shared_timed_mutex> lock(enrollmentLock);
+        out.u64(enrollment.subjectCount());
+        for (uint32_t subject = 0; subject < enrollment.subjectCount(); subject++) {
+            const std::vector<uint32_t>& roster = enrollment.roster(subject);
+            out.u32(static_cast<uint32_t>(roster.size()));
+            for (uint32_t slot : roster) out.u32(slot);
+        }
+    }
+    writeSection(SECTION_ENROLLMENT, start);
+
+    start = out.size();
+    {
+        std::shared_lock<std::shared_timed_mutex> lock(calendarLock);
+        out.u64(calendar.size());
+        for (uint32_t id = 0; id < calendar.size(); id++) encodeCalendarEntry(out, calendar.entry(id));
+    }
+    writeSection(SECTION_CALENDAR, start);
+
+    start = out.size();
+    {
+        std::lock_guard<std::mutex> lock(alertPublishLock); // Inboxes only point at alerts saved here
+        size_t alertCount = alerts.alertCount();
+        out.u64(alertCount);
+        for (uint32_t id = 0; id < alertCount; id++) encodeAlertRecord(out, alerts.alert(id));
+        size_t countAt = out.size();
+        uint64_t inboxes = 0;
+        out.u64(0); // Non-empty inboxes, patched below
+        std::vector<uint32_t> ids;
+        uint32_t unread;
+        for (UserHandle user = 0; user < alerts.inboxCount(); user++) {
+            uint32_t deliveredCount = alerts.inbox(user, ids, unread);
+            if (deliveredCount == 0) continue;
+            out.u32(user);
+            out.u32(deliveredCount);
+            out.u32(alerts.seenCount(user));
+            out.u8(static_cast<uint8_t>(ids.size()));
+            for (uint32_t id : ids) out.u32(id);
+            inboxes++;
+        }
+        out.patchU64(countAt, inboxes);
+    }
+    writeSection(SECTION_ALERTS, start);
+
+    start = out.size();
+    {
+        std::shared_lock<std::shared_timed_mutex> lock(casesLock);
+        out.u64(2);
+        for (const CaseTracker* cases : {&complaintCases, &leaveCases}) {
+            out.u64(cases->size());
+            for (uint32_t id = 0; id < cases->size(); id++) {
+                out.u8(cases->statusOf(id));
+                out.u32(cases->assigneeOf(id));
+            }
+            size_t countAt = out.size();
+            uint32_t teachers = 0;
+            out.u32(0); // Teachers who have looked, patched below
+            for (UserHandle teacher = 0; teacher < cases->seenSlots(); teacher++) {
+                if (cases->seenBy(teacher) == 0) continue;
+                out.u32(teacher);
+                out.u32(cases->seenBy(teacher));
+                teachers++;
+            }
+            out.patchU32(countAt, teachers);
+        }
+    }
+    writeSection(SECTION_CASES, start);
+
+    start = out.size();
+    {
+        std::shared_lock<std::shared_timed_mutex> lock(libraryLock);
+        out.u64(library.bookCount());
+        for (uint32_t book = 0; book < library.bookCount(); book++) {
+            encodeBook(out, library.isbn(book).str(), library.title(book).str(), library.author(book).str(),
+                       library.copies(book));
+        }
+        out.u64(library.loanCount());
+        for (uint32_t id = 0; id < library.loanCount(); id++) encodeLoan(out, library.loan(id));
+    }
+    writeSection(SECTION_LIBRARY, start);
+
+    start = out.size();
+    {
+        std::shared_lock<std::shared_timed_mutex> lock(gateLock);
+        out.u64(gateLog.personCount());
+        for (uint32_t person = 0; person < gateLog.personCount(); person++) out.str(gateLog.label(person));
+        out.u32(static_cast<uint32_t>(gateLog.gateCount()));
+        for (uint32_t gate = 0; gate < gateLog.gateCount(); gate++) out.str(gateLog.gateName(gate));
+        out.u64(gateLog.segmentCount());
+        for (size_t id = 0; id < gateLog.segmentCount(); id++) {
+            out.u64(static_cast<uint64_t>(gateLog.segmentDay(id)));
+            out.u32(gateLog.segmentEvents(id));
+            out.str(gateLog.segmentBytes(id));
+        }
+    }
+    writeSection(SECTION_GATE, start);
+
+    start = out.size();
+    std::lock_guard<std::mutex> lock(resultsLock);
+    out.u64(grades.slotCount());
+    for (uint32_t slot = 0; slot < grades.slotCount(); slot++) {
+        const std::vector<GradeEntry>& entries = grades.gradesOf(slot);
+        out.u32(static_cast<uint32_t>(entries.size()));
+        for (const auto& entry : entries) encodeGradeEntry(out, entry);
+    }
+    writeSection(SECTION_GRADES, start);
+
+    size_t payloadSize = out.size() - SNAPSHOT_HEADER_SIZE;
+    out.patchU64(16, payloadSize);
+    out.patchU64(24, checksumBytes(out.data() + SNAPSHOT_HEADER_SIZE, payloadSize));
+
+    // Write next to the old snapshot and swap, so a crash never leaves half a file
+    std::string temporary = path + ".tmp";
+    return writeFileDurably(temporary, out.data(), out.size()) && replaceFile(temporary, path);
+}
+
+bool loadSnapshot(const std::string& path) {
+    MappedFile file;
+    if (!file.open(path)) return false; // No snapshot yet
+    if (file.size() < SNAPSHOT_HEADER_SIZE || memcmp(file.data(), SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) {
+        std::cout << "Warning: " << path << " is not a College Alerter snapshot, ignoring it.\n";
+        return false;
+    }
+
+    BinaryReader header(file.data() + sizeof(SNAPSHOT_MAGIC), SNAPSHOT_HEADER_SIZE - sizeof(SNAPSHOT_MAGIC));
+    uint32_t version = header.u32();
+    uint32_t sectionCount = header.u32();
+    uint64_t payloadSize = header.u64();
+    uint64_t checksum = header.u64();
+    if (version != SNAPSHOT_VERSION) {
+        std::cout << "Warning: " << path << " has unsupported version " << version << ", ignoring it.\n";
+        return false;
+    }
+    if (payloadSize != file.size() - SNAPSHOT_HEADER_SIZE ||
+        checksum != checksumBytes(file.data() + SNAPSHOT_HEADER_SIZE, payloadSize)) {
+        std::cout << "Warning: " << path << " is damaged (checksum mismatch), ignoring it.\n";
+        return false;
+    }
+
+    BinaryReader table(file.data() + SNAPSHOT_HEADER_SIZE, payloadSize);
+    UserDirectory loadedUsers;
+    std::vector<Complaint> loadedComplaints;
+    std::vector<LeaveNotice> loadedNotices;
+    std::vector<std::unique_ptr<ColdSegment>> coldComplaints, coldNotices;
+    SubjectCatalog loadedSubjects;
+    AttendanceStore loadedAttendance;
+    EnrollmentStore loadedEnrollment;
+    Calendar loadedCalendar;
+    Library loadedLibrary;
+    GateLog loadedGateLog;
+    AlertCenter loadedAlerts;
+    CaseTracker loadedComplaintCases, loadedLeaveCases;
+    GradeStore loadedGrades;
+    uint64_t loadedWalLsn = 0;
+    bool ok = true;
+    for (uint32_t i = 0; i < sectionCount && ok; i++) {
+        uint32_t tag = table.u32();
+        table.u32(); // reserved
+        uint64_t offset = table.u64();
+        uint64_t size = table.u64();
+        if (!table.good() || offset > file.size() || size > file.size() - offset) {
+            ok = false;
+            break;
+        }
+
+        BinaryReader in(file.data() + offset, size);
+        uint64_t count = in.u64();
+        switch (tag) {
+            case SECTION_META:
+                loadedWalLsn = in.u64();
+                ok = in.good() && count == 1;
+                break;
+            case SECTION_USERS:
+                loadedUsers.reserve(count);
+                for (uint64_t n = 0; n < count && ok; n++) {
+                    User user;
+                    ok = decodeUser(in, user);
+                    if (ok) loadedUsers.addTrusted(std::move(user)); // Checksum already vouched for it
+                }
+                break;
+            case SECTION_COMPLAINTS:
+            case SECTION_COMPLAINTS_V1:
+                loadedComplaints.resize(count);
+                for (uint64_t n = 0; n < count && ok; n++) {
+                    ok = decodeComplaint(in, loadedComplaints[n], tag == SECTION_COMPLAINTS);
+                    noteSubmissionSequence(loadedComplaints[n].sequence);
+                }
+                break;
+            case SECTION_LEAVE_NOTICES:
+            case SECTION_LEAVE_NOTICES_V2:
+            case SECTION_LEAVE_NOTICES_V1:
+                loadedNotices.resize(count);
+                for (uint64_t n = 0; n < count && ok; n++) {
+                    ok = decodeLeaveNotice(in, loadedNotices[n], tag == SECTION_LEAVE_NOTICES ? 3 :
+                                                                 tag == SECTION_LEAVE_NOTICES_V2 ? 2 : 1);
+                    noteSubmissionSequence(loadedNotices[n].sequence);
+                }
+                break;
+            case SECTION_COLD: {
+                std::vector<std::unique_ptr<ColdSegment>>* lists[] = {&coldComplaints, &coldNotices};
+                for (uint64_t k = 0; k < count && k < 2 && ok; k++) {
+                    uint32_t segments = in.u32();
+                    for (uint32_t n = 0; n < segments && ok; n++) {
+                        std::string segmentPath = in.str().str();
+                        std::unique_ptr<ColdSegment> segment(new ColdSegment);
+                        uint64_t expected = lists[k]->empty() ? 0 : lists[k]->back()->end();
+                        ok = in.good() && segment->open(segmentPath) && segment->first() == expected;
+                        if (!ok) std::cout << "Warning: archive " << segmentPath << " is missing or damaged.\n";
+                        else lists[k]->push_back(std::move(segment));
+                    }
+                }
+                break;
+            }
+            case SECTION_SUBJECTS:
+                for (uint64_t n = 0; n < count && ok; n++) {
+                    loadedSubjects.add(in.str().str());
+                    ok = in.good();
+                }
+                break;
+            case SECTION_GRADES:
+                for (uint64_t slot = 0; slot < count && ok; slot++) {
+                    uint32_t entries = in.u32();
+                    for (uint32_t e = 0; e < entries && ok; e++) {
+                        GradeEntry entry;
+                        ok = decodeGradeEntry(in, loadedSubjects, entry);
+                        if (ok) loadedGrades.set(static_cast<uint32_t>(slot), entry);
+                    }
+                    ok = ok && in.good();
+                }
+                break;
+            case SECTION_ATTENDANCE:
+                for (uint64_t n = 0; n < count && ok; n++) {
+                    AttendanceSession session;
+                    ok = decodeAttendanceSession(in, loadedSubjects, session);
+                    if (ok) loadedAttendance.addSession(std::move(session));
+                }
+                break;
+            case SECTION_ENROLLMENT:
+                ok = count <= loadedSubjects.size();
+                for (uint64_t subject = 0; subject < count && ok; subject++) {
+                    uint32_t size = in.u32();
+                    ok = in.good() && size <= in.remaining() / sizeof(uint32_t);
+                    std::vector<uint32_t> roster(ok ? size : 0);
+                    for (auto& slot : roster) slot = in.u32();
+                    ok = ok && in.good() && std::all_of(roster.begin(), roster.end(), [&](uint32_t slot) {
+                        return slot < loadedUsers.studentCount();
+                    });
+                    if (ok) loadedEnrollment.enroll(static_cast<uint32_t>(subject), std::move(roster));
+                }
+                break;
+            case SECTION_CALENDAR:
+                for (uint64_t n = 0; n < count && ok; n++) {
+                    CalendarEntry entry;
+                    ok = decodeCalendarEntry(in, entry);
+                    if (ok) loadedCalendar.add(std::move(entry));
+                }
+                break;
+            case SECTION_ALERTS: {
+                for (uint64_t n = 0; n < count && ok; n++) {
+                    AlertRecord record;
+                    ok = decodeAlertRecord(in, record);
+                    if (ok) loadedAlerts.post(std::move(record));
+                }
+                uint64_t inboxes = in.u64();
+                std::vector<uint32_t> ids;
+                for (uint64_t n = 0; n < inboxes && ok; n++) {
+                    UserHandle user = in.u32();
+                    uint32_t deliveredCount = in.u32();
+                    uint32_t seenCount = in.u32();
+                    ids.resize(in.u8());
+                    for (auto& id : ids) id = in.u32();
+                    ok = in.good() && user < loadedUsers.size() && seenCount <= deliveredCount &&
+                         ids.size() <= AlertCenter::INBOX_CAPACITY && ids.size() <= deliveredCount &&
+                         std::all_of(ids.begin(), ids.end(), [&](uint32_t id) { return id < count; });
+                    if (ok) loadedAlerts.restoreInbox(user, deliveredCount, seenCount, ids);
+                }
+                break;
+            }
+            case SECTION_LIBRARY: {
+                for (uint64_t n = 0; n < count && ok; n++) ok = decodeBook(in, loadedLibrary);
+                uint64_t loans = in.u64();
+                for (uint64_t n = 0; n < loans && ok; n++) {
+                    Loan loan;
+                    ok = decodeLoan(in, loadedLibrary, loadedUsers.size(), loan);
+                    if (ok) loadedLibrary.addLoan(loan);
+                }
+                ok = ok && in.good();
+                break;
+            }
+            case SECTION_GATE: {
+                for (uint64_t n = 0; n < count && ok; n++) {
+                    std::string label = in.str().str();
+                    ok = in.good() && loadedGateLog.internPerson(label) == n; // Labels are unique
+                }
+                uint32_t gates = in.u32();
+                for (uint32_t n = 0; n < gates && ok; n++) {
+                    std::string name = in.str().str();
+                    ok = in.good() && loadedGateLog.internGate(name) == n;
+                }
+                uint64_t segments = in.u64();
+                for (uint64_t n = 0; n < segments && ok; n++) {
+                    int64_t day = static_cast<int64_t>(in.u64());
+                    uint32_t events = in.u32();
+                    std::string bytes = in.str().str();
+                    ok = in.good() && loadedGateLog.addSegment(day, events, bytes);
+                }
+                ok = ok && in.good();
+                break;
+            }
+            case SECTION_CASES: {
+                CaseTracker* trackers[] = {&loadedComplaintCases, &loadedLeaveCases};
+                for (uint64_t k = 0; k < count && k < 2 && ok; k++) {
+                    CaseTracker& cases = *trackers[k];
+                    uint64_t records = in.u64();
+                    ok = in.good() && records <= size;
+                    if (ok) cases.opened(records);
+                    for (uint32_t id = 0; id < records && ok; id++) {
+                        uint8_t status = in.u8();
+                        UserHandle assignee = in.u32();
+                        ok = in.good() && cases.update(id, status, assignee);
+                    }
+                    uint32_t teachers = in.u32();
+                    for (uint32_t n = 0; n < teachers && ok; n++) {
+                        UserHandle teacher = in.u32();
+                        uint32_t listSize = in.u32();
+                        ok = in.good() && teacher < loadedUsers.size();
+                        if (ok) cases.markSeen(teacher, listSize);
+                    }
+                }
+                break;
+            }
+            default:
+                break; // Section written by a newer build, skip it
+        }
+    }
+    if (!ok) {
+        std::cout << "Warning: " << path << " has malformed records, ignoring it.\n";
+        return false;
+    }
+
+    // Nothing can fail from here on, so the lists take their records now and
+    // the indexes are rebuilt by reading them back, archived records included
+    studentComplaints.restore(std::move(coldComplaints), std::move(loadedComplaints));
+    studentLeaveNotices.restore(std::move(coldNotices), std::move(loadedNotices));
+    LeaveIndex loadedLeave;
+    TextIndex loadedComplaintSearch, loadedLeaveSearch;
+    bool complaintsRead = studentComplaints.forEachFrom(0, [&](size_t n, const Complaint& complaint) {
+        loadedComplaintSearch.add(static_cast<uint32_t>(n), complaint.message, normalizeEmail(complaint.studentEmail));
+        uint64_t sequence = complaint.sequence; // Archived records count toward the numbering too
+        noteSubmissionSequence(sequence);
+    });
+    bool noticesRead = studentLeaveNotices.forEachFrom(0, [&](size_t n, const LeaveNotice& notice) {
+        LeaveEntry entry;
+        if (leaveEntryFor(notice, static_cast<uint32_t>(n), loadedUsers, entry)) loadedLeave.add(entry);
+        loadedLeaveSearch.add(static_cast<uint32_t>(n), notice.reason, normalizeEmail(notice.studentEmail));
+        uint64_t sequence = notice.sequence;
+        noteSubmissionSequence(sequence);
+    });
+    if (!complaintsRead || !noticesRead) {
+        std::cout << "Warning: an archive could not be read back; search and leave lists will miss its records.\n";
+    }
+    // The lists are saved before the trackers, so a tracker may have run ahead
+    loadedComplaintCases.fit(studentComplaints.size());
+    loadedLeaveCases.fit(studentLeaveNotices.size());
+
+    users = std::move(loadedUsers);
+    leaveIndex = std::move(loadedLeave);
+    complaintSearch = std::move(loadedComplaintSearch);
+    leaveSearch = std::move(loadedLeaveSearch);
+    complaintCases = std::move(loadedComplaintCases);
+    leaveCases = std::move(loadedLeaveCases);
+    subjects = std::move(loadedSubjects);
+    attendance = std::move(loadedAttendance);
+    enrollment = std::move(loadedEnrollment);
+    calendar = std::move(loadedCalendar);
+    library = std::move(loadedLibrary);
+    gateLog = std::move(loadedGateLog);
+    alerts = std::move(loadedAlerts);
+    grades = std::move(loadedGrades);
+    snapshotWalLsn = loadedWalLsn;
+    return true;
+}
+
+// --- Write-Ahead Log Replay and Checkpoints ---
+
+// Logs a change before it is applied; false means it could not be made durable
+bool logMutation(WalRecordType type, const BinaryWriter& payload) {
+    return waitForLog(appendMutation(type, payload));
+}
+
+// Queues a change for the log without waiting; 0 when persistence is off
+// (e.g. benchmark mode). Batches append every record, then wait once.
+uint64_t appendMutation(WalRecordType type, const BinaryWriter& payload) {
+    return wal.isOpen() ? wal.append(type, payload) : 0;
+}
+
+bool waitForLog(uint64_t lsn) {
+    return lsn == 0 || wal.waitDurable(lsn);
+}
+
+bool applyWalRecord(uint8_t type, BinaryReader& in) {
+    switch (type) {
+        case WAL_ADD_USER: {
+            User user;
+            if (!decodeUser(in, user)) return false;
+            users.add(user); // A duplicate was already rejected when it was first logged
+            return true;
+        }
+        case WAL_IMPORT_USERS: {
+            uint64_t count = in.u64();
+            std::vector<User> batch;
+            for (uint64_t n = 0; n < count && in.good(); n++) {
+                batch.emplace_back();
+                if (!decodeUser(in, batch.back())) return false;
+            }
+            if (!in.good()) return false;
+            users.dropRegistered(batch); // Already empty of duplicates when it was logged
+            users.addBatch(batch);
+            return true;
+        }
+        case WAL_ADD_COMPLAINT:
+        case WAL_ADD_COMPLAINT_V1: {
+            std::vector<Complaint> complaints(1);
+            if (!decodeComplaint(in, complaints[0], type == WAL_ADD_COMPLAINT)) return false;
+            noteSubmissionSequence(complaints[0].sequence);
+            recordComplaints(complaints);
+            return true;
+        }
+        case WAL_ADD_LEAVE_NOTICE:
+        case WAL_ADD_LEAVE_NOTICE_V2:
+        case WAL_ADD_LEAVE_NOTICE_V1: {
+            std::vector<LeaveNotice> notices(1);
+            int version = type == WAL_ADD_LEAVE_NOTICE ? 3 : type == WAL_ADD_LEAVE_NOTICE_V2 ? 2 : 1;
+            if (!decodeLeaveNotice(in, notices[0], version)) return false;
+            noteSubmissionSequence(notices[0].sequence);
+            recordLeaveNotices(notices);
+            return true;
+        }
+        case WAL_ADD_ATTENDANCE: {
+            AttendanceSession session;
+            if (!decodeAttendanceSession(in, subjects, session)) return false;
+            attendance.addSession(std::move(session));
+            return true;
+        }
+        case WAL_ADD_RESULTS: {
+            std::string subjectName = in.str().str();
+            uint8_t semester = in.u8();
+            uint8_t credits = in.u8();
+            uint64_t count = in.u64();
+            if (!in.good() || !validResultTerms(semester, credits)) return false;
+            std::vector<ParsedGrade> parsed;
+            for (uint64_t n = 0; n < count && in.good(); n++) {
+                ParsedGrade grade;
+                grade.slot = in.u32();
+                grade.grade = in.u8();
+                if (grade.grade >= GRADE_SCALE_SIZE) return false;
+                parsed.push_back(grade);
+            }
+            if (!in.good()) return false;
+            applyResults(subjects.add(subjectName), semester, credits, parsed);
+            return true;
+        }
+        case WAL_ENROLLMENT: {
+            std::string subjectName = in.str().str();
+            bool enrolling = in.u8() != 0;
+            uint64_t count = in.u64();
+            std::vector<uint32_t> slots;
+            for (uint64_t n = 0; n < count && in.good(); n++) slots.push_back(in.u32());
+            if (!in.good()) return false;
+            size_t students = users.studentCount();
+            for (uint32_t slot : slots) {
+                if (slot >= students) return false;
+            }
+            applyEnrollment(subjects.add(subjectName), enrolling, slots);
+            return true;
+        }
+        case WAL_ADD_CALENDAR_ENTRY: {
+            CalendarEntry entry;
+            if (!decodeCalendarEntry(in, entry)) return false;
+            calendar.add(std::move(entry));
+            return true;
+        }
+        case WAL_ADD_BOOK:
+            return decodeBook(in, library);
+        case WAL_LEND_BOOK: {
+            Loan loan;
+            if (!decodeLoan(in, library, users.size(), loan)) return false;
+            library.addLoan(loan);
+            return true;
+        }
+        case WAL_RETURN_BOOK: {
+            uint32_t id = in.u32();
+            int64_t day = static_cast<int64_t>(in.u64());
+            return in.good() && library.returnLoan(id, day);
+        }
+        case WAL_PUBLISH_ALERT: {
+            AlertRecord record;
+            AlertTarget target;
+            decodeAlertRecord(in, record);
+            target.roles = in.u8();
+            target.userLimit = in.u32();
+            uint64_t count = in.u64();
+            for (uint64_t n = 0; n < count && in.good(); n++) target.users.push_back(in.u32());
+            if (!in.good() || target.userLimit > users.size()) return false;
+            for (UserHandle user : target.users) {
+                if (user >= users.size()) return false;
+            }
+            applyAlert(std::move(record), target);
+            return true;
+        }
+        case WAL_MARK_ALERTS_READ: {
+            UserHandle user = in.u32();
+            uint32_t deliveredCount = in.u32();
+            if (!in.good() || user >= users.size()) return false;
+            alerts.markSeen(user, deliveredCount);
+            return true;
+        }
+        case WAL_UPDATE_CASE: {
+            uint8_t kind = in.u8();
+            uint32_t id = in.u32();
+            uint8_t status = in.u8();
+            UserHandle assignee = in.u32();
+            if (!in.good() || kind > CASE_LEAVE) return false;
+            casesOf(static_cast<CaseKind>(kind)).update(id, status, assignee);
+            return true;
+        }
+        case WAL_MARK_CASES_SEEN: {
+            uint8_t kind = in.u8();
+            UserHandle teacher = in.u32();
+            uint32_t listSize = in.u32();
+            if (!in.good() || kind > CASE_LEAVE) return false;
+            casesOf(static_cast<CaseKind>(kind)).markSeen(teacher, listSize);
+            return true;
+        }
+        case WAL_SET_PASSWORD: {
+            UserHandle user = in.u32();
+            std::string stored = in.str().str();
+            if (!in.good() || user >= users.size()) return false;
+            users.setStoredPassword(user, stored);
+            return true;
+        }
+        case WAL_GATE_SCANS: {
+            std::vector<GateScan> scans;
+            if (!decodeGateScans(in, scans)) return false;
+            applyGateScans(scans);
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+// Re-applies logged changes newer than afterLsn and returns the last LSN in
+// the log. A torn or damaged tail (crash mid-write) is cut off.
+uint64_t replayWal(const std::string& path, uint64_t afterLsn) {
+    MappedFile file;
+    if (!file.open(path)) return afterLsn; // No log yet, or it is empty
+
+    uint64_t lastLsn = afterLsn;
+    size_t offset = 0;
+    while (file.size() - offset >= WAL_FRAME_HEADER_SIZE) {
+        const char* frame = file.data() + offset;
+        BinaryReader header(frame, WAL_FRAME_HEADER_SIZE);
+        uint32_t length = header.u32();
+        uint64_t checksum = header.u64();
+        uint8_t type = header.u8();
+        uint64_t lsn = header.u64();
+        if (length > file.size() - offset - WAL_FRAME_HEADER_SIZE) break;
+        if (checksum != checksumBytes(frame + WAL_CHECKSUM_START, WAL_FRAME_HEADER_SIZE - WAL_CHECKSUM_START + length)) break;
+
+        if (lsn > afterLsn) {
+            BinaryReader payload(frame + WAL_FRAME_HEADER_SIZE, length);
+            if (!applyWalRecord(type, payload)) {
+                std::cout << "Warning: " << path << " has an unreadable record at LSN " << lsn << ".\n";
+                break;
+            }
+        }
+        if (lsn > lastLsn) lastLsn = lsn;
+        offset += WAL_FRAME_HEADER_SIZE + length;
+    }
+
+    size_t fileSize = file.size();
+    file.close();
+    if (offset < fileSize) {
+        std::cout << "Warning: discarding " << (fileSize - offset) << " damaged bytes at the end of " << path << ".\n";
+        truncateFile(path, offset);
+    }
+    return lastLsn;
+}
+
+// Folds everything logged so far into a fresh snapshot, then empties the log.
+// The snapshot remembers the last LSN it covers, so a crash between the two
+// steps only replays records that are skipped anyway.
+bool checkpoint() {
+    if (wal.isOpen()) snapshotWalLsn = wal.lastLsn();
+    archiveRecords();
+    if (!saveSnapshot(SNAPSHOT_FILE)) return false;
+    return !wal.isOpen() || wal.reset();
+}
+
+// --- Archival ---
+// Complaints and leave notices past archiveAfterDays, or closed, leave
+// memory for cold segments every ARCHIVE_INTERVAL_SECONDS and at each
+// checkpoint; the two never overlap. Positions leave in
+// order, so the oldest open record holds back everything after it. The
+// snapshot saved next lists the new segment; a crash before then leaves the
+// old snapshot in charge, and the retry overwrites the unused file.
+
+// How many of the records still in memory, oldest first, may be archived
+template <typename T>
+size_t archivableRecords(const SharedRecordList<T>& list, CaseKind kind, int64_t cutoff) {
+    size_t first = list.coldCount();
+    std::vector<uint8_t> status;
+    {
+        std::shared_lock<std::shared_timed_mutex> lock(casesLock);
+        const CaseTracker& cases = casesOf(kind);
+        for (size_t id = first; id < cases.size(); id++) status.push_back(cases.statusOf(static_cast<uint32_t>(id)));
+    }
+    size_t count = 0;
+    bool blocked = false;
+    bool read = list.forEachFrom(first, [&](size_t pos, const T& record) {
+        uint8_t s = pos - first < status.size() ? status[pos - first] : static_cast<uint8_t>(CASE_OPEN);
+        blocked = blocked || (record.submittedAt > cutoff && !caseClosed(kind, s));
+        if (!blocked) count++;
+    });
+    return read ? count : 0;
+}
+
+// e.g. college_alerter.complaints.0.cold, named by the first position it holds
+std::string coldSegmentPath(const char* list, size_t first) {
+    return std::string(COLD_FILE_PREFIX) + list + "." + std::to_string(first) + ".cold";
+}
+
+void archiveRecords() {
+    if (archiveAfterDays <= 0) return;
+    int64_t cutoff = static_cast<int64_t>(std::time(nullptr)) - static_cast<int64_t>(archiveAfterDays) * 86400;
+    size_t count = archivableRecords(studentComplaints, CASE_COMPLAINT, cutoff);
+    if (count >= ARCHIVE_MIN_RECORDS &&
+        !studentComplaints.archive(count, coldSegmentPath("complaints", studentComplaints.coldCount()))) {
+        std::cout << "Warning: could not archive old complaints; they stay in memory.\n";
+    }
+    count = archivableRecords(studentLeaveNotices, CASE_LEAVE, cutoff);
+    if (count >= ARCHIVE_MIN_RECORDS &&
+        !studentLeaveNotices.archive(count, coldSegmentPath("leave", studentLeaveNotices.coldCount()))) {
+        std::cout << "Warning: could not archive old leave notices; they stay in memory.\n";
+    }
+}
+
+// --- Submission Storage ---
+
+// Runs on the submission consumer: numbers, timestamps, logs and stores one
+// batch. Every record is appended to the log first and the batch waits for
+// the disk once, so a burst of submissions shares a single fsync.
+void storeSubmissions(std::vector<Submission>& batch) {
+    OperationTimer timer(OP_STORE_BATCH);
+    metrics.count(COUNTER_SUBMISSIONS_STORED, batch.size());
+    int64_t now = static_cast<int64_t>(std::time(nullptr));
+    std::vector<Complaint> complaints;
+    std::vector<LeaveNotice> notices;
+    uint64_t lastLsn = 0;
+    BinaryWriter record;
+    for (Submission& submission : batch) {
+        record.clear();
+        if (submission.kind == Submission::COMPLAINT) {
+            submission.complaint.sequence = ++lastSubmissionSequence;
+            submission.complaint.submittedAt = now;
+            encodeComplaint(record, submission.complaint);
+            lastLsn = appendMutation(WAL_ADD_COMPLAINT, record);
+            complaints.push_back(std::move(submission.complaint));
+        } else {
+            submission.notice.sequence = ++lastSubmissionSequence;
+            submission.notice.submittedAt = now;
+            encodeLeaveNotice(record, submission.notice);
+            lastLsn = appendMutation(WAL_ADD_LEAVE_NOTICE, record);
+            notices.push_back(std::move(submission.notice));
+        }
+    }
+    if (!waitForLog(lastLsn)) {
+        // Records are found by list position, so one missing from the log
+        // must not be stored either: replay would shift every later one.
+        // The students were only told it was queued; ask them to resend.
+        std::cout << "Warning: " << batch.size() << " submission(s) could not be written to " << WAL_FILE << ".\n";
+        AlertTarget target;
+        for (const Complaint& complaint : complaints) target.users.push_back(users.findByEmail(complaint.studentEmail));
+        for (const LeaveNotice& notice : notices) target.users.push_back(users.findByEmail(notice.studentEmail));
+        target.users.erase(std::remove(target.users.begin(), target.users.end(), UserDirectory::npos), target.users.end());
+        publishAlert("College Portal", "Your latest complaint or leave notice could not be saved. Please submit it again.",
+                     std::move(target));
+        return;
+    }
+    if (!complaints.empty()) recordComplaints(complaints);
+    if (!notices.empty()) recordLeaveNotices(notices);
+}
+
+// The index entry for a dated notice whose student is known
+bool leaveEntryFor(const LeaveNotice& notice, uint32_t position, const UserDirectory& directory, LeaveEntry& entry) {
+    if (notice.lastDay < notice.firstDay) return false;
+    entry.student = directory.findByEmail(notice.studentEmail);
+    if (entry.student == UserDirectory::npos) return false;
+    entry.firstDay = notice.firstDay;
+    entry.lastDay = notice.lastDay;
+    entry.notice = position;
+    return true;
+}
+
+// Only the submission consumer and log replay append, one batch at a time,
+// so documents reach the search indexes in list order.
+
+// Appends complaints to studentComplaints and indexes their words
+void recordComplaints(std::vector<Complaint>& complaints) {
+    size_t first = studentComplaints.appendAll(complaints);
+    studentComplaints.forEachFrom(first, [](size_t pos, const Complaint& complaint) {
+        complaintSearch.add(static_cast<uint32_t>(pos), complaint.message, normalizeEmail(complaint.studentEmail));
+    });
+    std::unique_lock<std::shared_timed_mutex> lock(casesLock);
+    complaintCases.opened(complaints.size());
+}
+
+// Appends notices to studentLeaveNotices and indexes their dates and words
+void recordLeaveNotices(std::vector<LeaveNotice>& notices) {
+    std::vector<LeaveEntry> entries;
+    for (uint32_t n = 0; n < notices.size(); n++) {
+        LeaveEntry entry;
+        if (leaveEntryFor(notices[n], n, users, entry)) entries.push_back(entry);
+    }
+    size_t first = studentLeaveNotices.appendAll(notices);
+    for (LeaveEntry& entry : entries) {
+        entry.notice += static_cast<uint32_t>(first);
+        leaveIndex.add(entry);
+    }
+    studentLeaveNotices.forEachFrom(first, [](size_t pos, const LeaveNotice& notice) {
+        leaveSearch.add(static_cast<uint32_t>(pos), notice.reason, normalizeEmail(notice.studentEmail));
+    });
+    std::unique_lock<std::shared_timed_mutex> lock(casesLock);
+    leaveCases.opened(notices.size());
+}
+
+// Keeps numbering past everything loaded; unnumbered (older) records get
+// the next number in the order they are read
+void noteSubmissionSequence(uint64_t& sequence) {
+    if (sequence == 0) {
+        sequence = ++lastSubmissionSequence;
+    } else if (sequence > lastSubmissionSequence) {
+        lastSubmissionSequence = sequence;
+    }
+}
+
+std::string formatTimestamp(int64_t unixSeconds) {
+    if (unixSeconds == 0) return "unknown";
+    std::time_t time = static_cast<std::time_t>(unixSeconds);
+    std::tm local;
+#ifdef _WIN32
+    localtime_s(&local, &time);
+#else
+    localtime_r(&time, &local);
+#endif
+    char text[32];
+    strftime(text, sizeof(text), "%d %b %Y %H:%M", &local);
+    return text;
+}
+
+// --- Results Upload (CSV Ingestion) ---
+// The file is memory mapped and split into one chunk per thread at line
+// boundaries. Each worker walks its chunk with memchr and looks fields up as
+// pointer/length slices, so no std::string is made per row (only for the few
+// rejected rows that get reported). Workers only read the user directory.
+
+// One thread's share of a file, cut at line boundaries, and what its parser
+// made of it
+template <typename Row>
+struct FileChunk {
+    const char* begin;
+    const char* end;
+    bool firstInFile;
+    std::vector<Row> parsed;
+    size_t lines;
+    size_t rejected;
+    std::vector<std::pair<size_t, std::string>> problems; // (line within chunk, message)
+};
+
+typedef FileChunk<ParsedGrade> ResultsChunk;
+
+const size_t MAX_REPORTED_PROBLEMS = 10;
+
+// Maps the file, splits it into up to threadCount chunks and runs
+// parseChunk on each, one thread per chunk. Then, in file order, adds each
+// chunk's rejected rows and problems (now with file line numbers) to the
+// report and calls join(chunk, linesBefore) for its rows. False only when
+// the file cannot be opened.
+template <typename Row, typename Report, typename Join>
+bool parseFileChunks(const std::string& path, unsigned threadCount, void (*parseChunk)(FileChunk<Row>&),
+                     Report& report, Join join) {
+    MappedFile file;
+    if (!file.open(path)) {
+        // An empty file cannot be mapped but is still a valid (empty) upload
+        FILE* probe = fopen(path.c_str(), "rb");
+        if (probe == nullptr) return false;
+        fclose(probe);
+        report.opened = true;
+        return true;
+    }
+    report.opened = true;
+    report.bytes = file.size();
+
+    // Small files are not worth the thread start-up cost
+    const size_t minimumChunk = 1 << 20;
+    size_t chunkCount = std::max<size_t>(1, std::min<size_t>(threadCount, file.size() / minimumChunk));
+    std::vector<FileChunk<Row>> chunks(chunkCount);
+    const char* begin = file.data();
+    const char* end = file.data() + file.size();
+    for (size_t c = 0; c < chunkCount; c++) {
+        const char* chunkEnd = c + 1 == chunkCount ? end : file.data() + file.size() * (c + 1) / chunkCount;
+        if (chunkEnd < begin) chunkEnd = begin;
+        const char* newline = static_cast<const char*>(memchr(chunkEnd, '\n', end - chunkEnd));
+        chunkEnd = newline == nullptr ? end : newline + 1;
+        chunks[c] = FileChunk<Row>{begin, chunkEnd, c == 0, {}, 0, 0, {}};
+        begin = chunkEnd;
+    }
+
+    if (chunkCount == 1) {
+        parseChunk(chunks[0]);
+    } else {
+        std::vector<std::thread> workers;
+        for (auto& chunk : chunks) workers.emplace_back(parseChunk, std::ref(chunk));
+        for (auto& worker : workers) worker.join();
+    }
+
+    size_t linesBefore = 0;
+    for (auto& chunk : chunks) {
+        report.rejected += chunk.rejected;
+        for (const auto& problem : chunk.problems) {
+            if (report.problems.size() < MAX_REPORTED_PROBLEMS) {
+                report.problems.push_back("Line " + std::to_string(linesBefore + problem.first) + ": " + problem.second);
+            }
+        }
+        join(chunk, linesBefore);
+        linesBefore += chunk.lines;
+    }
+    return true;
+}
+
+// A row waiting for its student ID to be looked up with the rest of its batch
+struct PendingResultRow {
+    StrView id;
+    StrView line;
+    size_t lineNumber;
+    uint8_t grade;
+};
+
+void resolveResultRows(ResultsChunk& chunk, const PendingResultRow* rows, size_t count) {
+    if (count == 0) return;
+    StrView ids[UserDirectory::MAX_ID_BATCH];
+    uint32_t found[UserDirectory::MAX_ID_BATCH];
+    for (size_t i = 0; i < count; i++) ids[i] = rows[i].id;
+    users.findStudentSlots(ids, count, found);
+
+    for (size_t i = 0; i < count; i++) {
+        const PendingResultRow& row = rows[i];
+        if (row.grade != NO_GRADE && found[i] != UserDirectory::NO_STUDENT_SLOT) {
+            chunk.parsed.push_back({found[i], row.grade});
+        } else if (chunk.firstInFile && row.lineNumber == 1 && row.grade == NO_GRADE) {
+            // A header row such as "Student ID,Grade"
+        } else {
+            chunk.rejected++;
+            if (chunk.problems.size() < MAX_REPORTED_PROBLEMS) {
+                const char* reason = row.id.data == nullptr ? "expected 'Student ID,Grade'"
+                                     : found[i] == UserDirectory::NO_STUDENT_SLOT ? "unknown student ID"
+                                     : "unknown grade";
+                chunk.problems.push_back({row.lineNumber, std::string(reason) + ": '" + row.line.str() + "'"});
+            }
+        }
+    }
+}
+
+void parseResultsChunk(ResultsChunk& chunk) {
+    PendingResultRow batch[UserDirectory::MAX_ID_BATCH];
+    size_t pending = 0;
+    const char* cursor = chunk.begin;
+    while (cursor < chunk.end) {
+        const char* lineEnd = static_cast<const char*>(memchr(cursor, '\n', chunk.end - cursor));
+        if (lineEnd == nullptr) lineEnd = chunk.end;
+        const char* next = lineEnd < chunk.end ? lineEnd + 1 : chunk.end;
+        if (lineEnd > cursor && lineEnd[-1] == '\r') lineEnd--;
+        chunk.lines++;
+
+        bool blank = true;
+        for (const char* c = cursor; c < lineEnd && blank; c++) blank = isBlank(*c);
+        if (!blank) {
+            PendingResultRow& row = batch[pending++];
+            row.line = StrView{cursor, static_cast<size_t>(lineEnd - cursor)};
+            row.lineNumber = chunk.lines;
+            const char* comma = static_cast<const char*>(memchr(cursor, ',', lineEnd - cursor));
+            if (comma == nullptr) {
+                row.id = StrView{nullptr, 0};
+                row.grade = NO_GRADE;
+            } else {
+                const char* gradeEnd = static_cast<const char*>(memchr(comma + 1, ',', lineEnd - comma - 1));
+                if (gradeEnd == nullptr) gradeEnd = lineEnd;
+                row.id = StrView{cursor, static_cast<size_t>(comma - cursor)};
+                row.grade = parseGrade(comma + 1, gradeEnd - comma - 1);
+            }
+            if (pending == UserDirectory::MAX_ID_BATCH) {
+                resolveResultRows(chunk, batch, pending);
+                pending = 0;
+            }
+        }
+        cursor = next;
+    }
+    resolveResultRows(chunk, batch, pending);
+}
+
+bool parseResultsFile(const std::string& path, unsigned threadCount,
+                      std::vector<ParsedGrade>& parsed, ResultsFileReport& report) {
+    typedef std::chrono::steady_clock Clock;
+    report = ResultsFileReport{false, 0, 0, 0, {}, 0.0};
+    parsed.clear();
+    Clock::time_point start = Clock::now();
+    bool opened = parseFileChunks(path, threadCount, parseResultsChunk, report, [&](ResultsChunk& chunk, size_t) {
+        parsed.insert(parsed.end(), chunk.parsed.begin(), chunk.parsed.end());
+    });
+    report.rows = parsed.size();
+    report.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return opened;
+}
+
+void applyResults(uint32_t subject, uint8_t semester, uint8_t credits, const std::vector<ParsedGrade>& parsed) {
+    for (const auto& grade : parsed) {
+        uint8_t previous = grades.set(grade.slot, GradeEntry{subject, semester, credits, grade.grade});
+        gradeAnalytics.gradeChanged(grade.slot, subject, previous, grade.grade);
+    }
+}
+
+// --- Roster Import ---
+// Onboards many users from a CSV file, one per line:
+//   Name,Email,Phone,Password,Role,Details
+// where Role is student, teacher or staff and Details is the student ID,
+// the teacher's position or the staff role. Fields cannot hold commas; a
+// header row is skipped. The file is parsed on all cores the way a results
+// upload is. Repeated emails and student IDs are then found in parallel as
+// well, and the rows left are logged as one record and added in one step.
+
+struct RosterRow {
+    User user;
+    uint64_t emailHash;
+    uint64_t idHash;   // 0 unless the row is a student
+    size_t lineNumber; // Within its chunk until the chunks are joined
+};
+
+typedef FileChunk<RosterRow> RosterChunk;
+
+const char* const DEFAULT_STAFF_ROLE = "Clerical/Support Staff";
+
+// Checks one line and fills in a normalized user; null on success, else why
+// the row was refused
+const char* parseRosterRow(const char* line, const char* lineEnd, User& user) {
+    StrView fields[6];
+    size_t count = 0;
+    const char* cursor = line;
+    while (true) {
+        const char* comma = static_cast<const char*>(memchr(cursor, ',', lineEnd - cursor));
+        const char* fieldEnd = comma == nullptr ? lineEnd : comma;
+        if (count == 6) return "expected 'Name,Email,Phone,Password,Role,Details'";
+        const char* text = cursor;
+        size_t length = static_cast<size_t>(fieldEnd - cursor);
+        trimSlice(text, length);
+        fields[count++] = StrView{text, length};
+        if (comma == nullptr) break;
+        cursor = comma + 1;
+    }
+    if (count != 6) return "expected 'Name,Email,Phone,Password,Role,Details'";
+
+    std::string role = normalizeKey(fields[4].str());
+    if (role == "student") user.role = Role::STUDENT;
+    else if (role == "teacher") user.role = Role::TEACHER;
+    else if (role == "staff") user.role = Role::NON_TEACHING_STAFF;
+    else return "unknown role";
+    if (fields[0].size == 0) return "missing name";
+    if (fields[1].size == 0 || memchr(fields[1].data, '@', fields[1].size) == nullptr) return "invalid email";
+    if (fields[3].size == 0) return "missing password";
+    if (user.role == Role::STUDENT && fields[5].size == 0) return "missing student ID";
+
+    user.name = fields[0].str();
+    user.email = normalizeEmail(fields[1].str());
+    user.phone = fields[2].str();
+    user.password = fields[3].str();
+    if (user.role == Role::STUDENT) user.roleSpecificData = normalizeStudentId(fields[5].str());
+    else if (user.role == Role::NON_TEACHING_STAFF && fields[5].size == 0) user.roleSpecificData = DEFAULT_STAFF_ROLE;
+    else user.roleSpecificData = fields[5].str();
+    return nullptr;
+}
+
+void parseRosterChunk(RosterChunk& chunk) {
+    const char* cursor = chunk.begin;
+    while (cursor < chunk.end) {
+        const char* lineEnd = static_cast<const char*>(memchr(cursor, '\n', chunk.end - cursor));
+        if (lineEnd == nullptr) lineEnd = chunk.end;
+        const char* next = lineEnd < chunk.end ? lineEnd + 1 : chunk.end;
+        if (lineEnd > cursor && lineEnd[-1] == '\r') lineEnd--;
+        chunk.lines++;
+
+        bool blank = true;
+        for (const char* c = cursor; c < lineEnd && blank; c++) blank = isBlank(*c);
+        if (!blank) {
+            RosterRow row;
+            const char* reason = parseRosterRow(cursor, lineEnd, row.user);
+            if (reason == nullptr) {
+                row.emailHash = hashString(row.user.email);
+                row.idHash = row.user.role == Role::STUDENT ? hashString(row.user.roleSpecificData) : 0;
+                row.lineNumber = chunk.lines;
+                chunk.parsed.push_back(std::move(row));
+            } else if (chunk.firstInFile && chunk.lines == 1) {
+                // A header row such as "Name,Email,Phone,Password,Role,Details"
+            } else {
+                chunk.rejected++;
+                if (chunk.problems.size() < MAX_REPORTED_PROBLEMS) {
+                    chunk.problems.push_back({chunk.lines, reason}); // Not the line itself: it may hold a password
+                }
+            }
+        }
+        cursor = next;
+    }
+}
+
+// Flags each row whose email (or student ID) already appeared on an earlier
+// accepted row. Thread t owns the keys whose hash falls in its share of the
+// hash space and is the only one to write those rows' flags, so the threads
+// share nothing but the read-only rows. Emails are settled first: a row
+// refused for its email must not claim its student ID.
+void markRepeatedRows(const std::vector<RosterRow>& rows, unsigned threadCount,
+                      std::vector<uint8_t>& repeatedEmail, std::vector<uint8_t>& repeatedId) {
+    repeatedEmail.assign(rows.size(), 0);
+    repeatedId.assign(rows.size(), 0);
+    const size_t minimumRowsPerThread = 10000;
+    unsigned shares = static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(threadCount, rows.size() / minimumRowsPerThread)));
+    auto shareOf = [shares](uint64_t hash) {
+        return static_cast<unsigned>((hash >> 32) * shares >> 32); // Top bits; the index probes by the low ones
+    };
+    auto markEmails = [&](unsigned share) {
+        OpenHashIndex emails;
+        emails.reserve(rows.size() / shares + 16);
+        for (uint32_t r = 0; r < rows.size(); r++) {
+            const RosterRow& row = rows[r];
+            if (shareOf(row.emailHash) != share) continue;
+            uint32_t earlier = emails.find(row.emailHash, [&](uint32_t other) { return rows[other].user.email == row.user.email; });
+            if (earlier != OpenHashIndex::npos) repeatedEmail[r] = 1;
+            else emails.insert(row.emailHash, r);
+        }
+    };
+    auto markIds = [&](unsigned share) {
+        OpenHashIndex ids;
+        ids.reserve(rows.size() / shares + 16);
+        for (uint32_t r = 0; r < rows.size(); r++) {
+            const RosterRow& row = rows[r];
+            if (row.user.role != Role::STUDENT || repeatedEmail[r] || shareOf(row.idHash) != share) continue;
+            uint32_t earlier = ids.find(row.idHash, [&](uint32_t other) {
+                return rows[other].user.roleSpecificData == row.user.roleSpecificData;
+            });
+            if (earlier != OpenHashIndex::npos) repeatedId[r] = 1;
+            else ids.insert(row.idHash, r);
+        }
+    };
+    auto runShares = [shares](const std::function<void(unsigned)>& markShare) {
+        if (shares == 1) {
+            markShare(0);
+            return;
+        }
+        std::vector<std::thread> workers;
+        for (unsigned share = 0; share < shares; share++) workers.emplace_back(markShare, share);
+        for (auto& worker : workers) worker.join();
+    };
+    runShares(markEmails);
+    runShares(markIds);
+}
+
+bool parseRosterFile(const std::string& path, unsigned threadCount, std::vector<User>& parsed,
+                     RosterFileReport& report) {
+    typedef std::chrono::steady_clock Clock;
+    report = RosterFileReport{false, 0, 0, 0, {}, 0.0};
+    parsed.clear();
+    Clock::time_point start = Clock::now();
+
+    std::vector<RosterRow> rows;
+    bool opened = parseFileChunks(path, threadCount, parseRosterChunk, report, [&](RosterChunk& chunk, size_t linesBefore) {
+        for (auto& row : chunk.parsed) {
+            row.lineNumber += linesBefore;
+            rows.push_back(std::move(row));
+        }
+    });
+    if (!opened) return false;
+
+    std::vector<uint8_t> repeatedEmail, repeatedId;
+    markRepeatedRows(rows, threadCount, repeatedEmail, repeatedId);
+    parsed.reserve(rows.size());
+    for (size_t r = 0; r < rows.size(); r++) {
+        if (!repeatedEmail[r] && !repeatedId[r]) {
+            parsed.push_back(std::move(rows[r].user));
+            continue;
+        }
+        report.rejected++;
+        if (report.problems.size() < MAX_REPORTED_PROBLEMS) {
+            const User& user = rows[r].user;
+            report.problems.push_back("Line " + std::to_string(rows[r].lineNumber) + ": " +
+                                      (repeatedEmail[r] ? "email " + user.email : "student ID " + user.roleSpecificData) +
+                                      " already appears on an earlier line");
+        }
+    }
+    report.rows = parsed.size();
+    report.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return true;
+}
+
+// Registers a parsed roster as one change: the users whose email or student
+// ID is already registered are left out (counted in skipped), and the rest
+// are logged as a single record and added under one lock. False when the
+// batch could not be saved, in which case none of it was added. Passwords
+// are hashed on every password worker, outside the registration lock; the
+// check is repeated afterwards for anyone who registered meanwhile. The
+// hashes use importPasswordIterations(), and logins go ahead of them.
+bool importUsers(std::vector<User>& batch, size_t& skipped) {
+    skipped = users.dropRegistered(batch);
+    uint32_t iterations = importPasswordIterations();
+    passwordWorkers.runAll(batch.size(), [&](size_t u) {
+        batch[u].password = hashPassword(batch[u].password, iterations);
+    });
+    std::lock_guard<std::mutex> lock(registrationLock); // Nobody registers between the check and the add
+    skipped += users.dropRegistered(batch);
+    if (batch.empty()) return true;
+    BinaryWriter record;
+    encodeUserBatch(record, batch);
+    if (!logMutation(WAL_IMPORT_USERS, record)) return false;
+    users.addBatch(batch);
+    return true;
+}
+
+void handleRosterImport() {
+    clearScreen();
+    std::string fileName, filePath;
+    sessionOut() << "--- Import User Roster ---\n";
+    sessionOut() << "Enter the name of a roster file in the '" << IMPORT_DIR << "' folder (e.g., first_year.csv): ";
+    std::getline(sessionIn(), fileName);
+    if (!fileInDirectory(IMPORT_DIR, fileName, filePath)) {
+        sessionOut() << "Error: Give just a file name, without any folders.\n";
+        sessionOut() << "--------------------------\n";
+        return;
+    }
+    sessionOut() << "(Each line: Name,Email,Phone,Password,Role,Details  e.g. Asha Rao,asha@college.edu,9876543210,pw,student,S1001)\n\n";
+
+    std::vector<User> parsed;
+    RosterFileReport report;
+    unsigned threads = std::thread::hardware_concurrency();
+    if (!parseRosterFile(filePath, threads == 0 ? 1 : threads, parsed, report)) {
+        sessionOut() << "Error: Could not open roster file '" << fileName << "'.\n";
+        sessionOut() << "--------------------------\n";
+        return;
+    }
+
+    double megabytes = report.bytes / (1024.0 * 1024.0);
+    {
+        FormatGuard format(sessionOut());
+        sessionOut() << std::fixed << std::setprecision(2);
+        sessionOut() << "Read " << report.rows + report.rejected << " rows (" << megabytes << " MB in "
+                     << report.seconds * 1000 << " ms).\n";
+    }
+    if (report.rejected > 0) {
+        sessionOut() << report.rejected << " row(s) were rejected:\n";
+        for (const auto& problem : report.problems) sessionOut() << "  " << problem << "\n";
+        if (report.rejected > report.problems.size()) sessionOut() << "  ...\n";
+    }
+
+    size_t skipped = 0;
+    if (parsed.empty()) {
+        sessionOut() << "No users were imported.\n";
+    } else if (!importUsers(parsed, skipped)) {
+        sessionOut() << "Error: The roster could not be saved, so nobody was imported. Please try again.\n";
+    } else {
+        if (skipped > 0) sessionOut() << skipped << " user(s) were already registered and were skipped.\n";
+        sessionOut() << parsed.size() << " user(s) imported.\n";
+    }
+    sessionOut() << "--------------------------\n";
+}
+
+// --- Gate Scans ---
+// Scans come in as lines "time,person,in|out,gate" from a scanner feed, a
+// file, or a watchman at the menu. An empty time means now and a missing
+// gate means the main gate. The time is Unix seconds (what scanners send,
+// moved to the wall clock like everything else in the log) or
+// "2024-03-20 09:30[:15]" on the wall clock. A person is found by email or student ID
+// and logged under their email; anyone else is a visitor, logged by name.
+
+const size_t GATE_BATCH_SCANS = 4096; // Scans per log record while a feed or file streams in
+
+// A scanner's Unix time on the wall clock. Feeds send scans in time order,
+// so the zone offset is looked up once per quarter hour (offsets only ever
+// change on a quarter hour) rather than per scan.
+int64_t gateWallClock(int64_t unixSeconds) {
+    thread_local int64_t cachedQuarter = INT64_MIN;
+    thread_local int64_t cachedOffset = 0;
+    int64_t quarter = unixSeconds >= 0 ? unixSeconds / 900 : (unixSeconds - 899) / 900;
+    if (quarter != cachedQuarter) {
+        cachedOffset = wallClockSeconds(static_cast<std::time_t>(quarter * 900)) - quarter * 900;
+        cachedQuarter = quarter;
+    }
+    return unixSeconds + cachedOffset;
+}
+
+bool parseGateTime(const std::string& text, int64_t& seconds) {
+    size_t first = text.find_first_not_of(" \t\r");
+    if (first != std::string::npos && isdigit(static_cast<unsigned char>(text[first])) &&
+        text.find_first_not_of("0123456789 \t\r", first) == std::string::npos) {
+        seconds = gateWallClock(strtoll(text.c_str() + first, nullptr, 10));
+        return true;
+    }
+    int year, month, day, hour, minute, second;
+    char extra;
+    if (sscanf(text.c_str(), " %d-%d-%d %d:%d:%d %c", &year, &month, &day, &hour, &minute, &second, &extra) == 6) {
+        if (!isValidDate(year, month, day) || hour < 0 || hour > 23 || minute < 0 || minute > 59 || second < 0 ||
+            second > 59) {
+            return false;
+        }
+        seconds = daysFromCivil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second;
+        return true;
+    }
+    int64_t minutes;
+    if (!parseCalendarTime(text, minutes)) return false;
+    seconds = minutes * 60;
+    return true;
+}
+
+// "20 Mar 2024, 09:30:15"
+std::string formatGateTime(int64_t seconds) {
+    int64_t minutes = seconds >= 0 ? seconds / 60 : (seconds - 59) / 60;
+    char text[8];
+    snprintf(text, sizeof(text), ":%02d", static_cast<int>(seconds - minutes * 60));
+    return formatCalendarTime(minutes) + text;
+}
+
+// The label a person is logged under; empty if nothing was typed
+std::string gatePersonLabel(const std::string& typed) {
+    UserHandle user = users.findByEmail(typed);
+    if (user == UserDirectory::npos) user = users.findByStudentId(typed);
+    if (user != UserDirectory::npos) return users.email(user).str();
+    size_t first = typed.find_first_not_of(" \t\r\n");
+    if (first == std::string::npos) return "";
+    return typed.substr(first, typed.find_last_not_of(" \t\r\n") - first + 1);
+}
+
+// Null on success, else why the line is not a scan
+const char* parseGateScan(const std::string& line, GateScan& scan) {
+    std::string fields[4];
+    size_t count = 0, start = 0;
+    while (true) {
+        size_t comma = line.find(',', start);
+        if (count == 4) return "expected 'time,person,in|out,gate'";
+        fields[count++] = line.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+        if (comma == std::string::npos) break;
+        start = comma + 1;
+    }
+    if (count < 3) return "expected 'time,person,in|out,gate'";
+    if (fields[0].find_first_not_of(" \t") == std::string::npos) scan.time = wallClockSeconds();
+    else if (!parseGateTime(fields[0], scan.time)) return "the time is not seconds or 'YYYY-MM-DD HH:MM[:SS]'";
+    scan.person = gatePersonLabel(fields[1]);
+    if (scan.person.empty()) return "no person";
+    std::string direction = normalizeKey(fields[2]);
+    if (direction == "in") scan.entering = true;
+    else if (direction == "out") scan.entering = false;
+    else return "the direction is not 'in' or 'out'";
+    size_t first = count == 4 ? fields[3].find_first_not_of(" \t\r") : std::string::npos;
+    if (first == std::string::npos) scan.gate = DEFAULT_GATE;
+    else scan.gate = fields[3].substr(first, fields[3].find_last_not_of(" \t\r") - first + 1);
+    return nullptr;
+}
+
+// Caller holds gateLock exclusively (or is replaying the log)
+void applyGateScans(const std::vector<GateScan>& scans) {
+    for (const auto& scan : scans) {
+        gateLog.add(GateEvent{scan.time, gateLog.internPerson(scan.person), gateLog.internGate(scan.gate), scan.entering});
+    }
+}
+
+// Logs scans as one record and adds them; false when they could not be
+// saved, in which case none were added
+bool recordGateScans(const std::vector<GateScan>& scans) {
+    if (scans.empty()) return true;
+    BinaryWriter record;
+    encodeGateScans(record, scans);
+    std::unique_lock<std::shared_timed_mutex> lock(gateLock); // The log and the gate log agree on order
+    if (!logMutation(WAL_GATE_SCANS, record)) return false;
+    applyGateScans(scans);
+    return true;
+}
+
+// Reads scan lines until a line "end" or the end of input and records them
+// in batches. A batch is closed when it is full or when no more input is
+// waiting, so a file goes in GATE_BATCH_SCANS at a time while a live feed
+// is recorded as each burst of scans arrives.
+void ingestGateScans(std::istream& in, GateScanReport& report) {
+    std::vector<GateScan> batch;
+    std::string line;
+    size_t lineNumber = 0;
+    while (true) {
+        bool more = static_cast<bool>(std::getline(in, line));
+        if (more && normalizeKey(line) == "end") more = false;
+        if (more) {
+            lineNumber++;
+            if (line.find_first_not_of(" \t\r") != std::string::npos) {
+                report.lines++;
+                GateScan scan;
+                const char* problem = parseGateScan(line, scan);
+                if (problem == nullptr) {
+                    batch.push_back(std::move(scan));
+                } else {
+                    report.rejected++;
+                    if (report.problems.size() < MAX_REPORTED_PROBLEMS) {
+                        report.problems.push_back("Line " + std::to_string(lineNumber) + ": " + problem);
+                    }
+                }
+            }
+        }
+        if (!batch.empty() && (!more || batch.size() >= GATE_BATCH_SCANS || in.rdbuf()->in_avail() <= 0)) {
+            if (recordGateScans(batch)) report.logged += batch.size();
+            else report.unsaved += batch.size();
+            batch.clear();
+        }
+        if (!more) return;
+    }
+}
+
+// False when the file cannot be opened
+bool importGateScans(const std::string& path, GateScanReport& report) {
+    std::ifstream file(path);
+    if (!file) return false;
+    ingestGateScans(file, report);
+    return true;
+}
+
+// --- Alert Publishing ---
+
+// Logs and delivers an alert; returns how many inboxes it reached (0 when
+// it could not be saved)
+size_t publishAlert(const std::string& from, const std::string& text, AlertTarget target) {
+    AlertRecord record{static_cast<int64_t>(std::time(nullptr)), from, text};
+    std::lock_guard<std::mutex> lock(alertPublishLock);
+    if (target.roles != 0) target.userLimit = static_cast<UserHandle>(users.size());
+    BinaryWriter payload;
+    encodeAlert(payload, record, target);
+    if (!logMutation(WAL_PUBLISH_ALERT, payload)) return 0;
+    return applyAlert(std::move(record), target);
+}
+
+size_t applyAlert(AlertRecord record, const AlertTarget& target) {
+    std::vector<UserHandle> recipients;
+    if (target.roles != 0) users.usersWithRoles(target.roles, target.userLimit, recipients);
+    UserHandle userCount = static_cast<UserHandle>(users.size());
+    for (UserHandle user : target.users) {
+        if (user < userCount) recipients.push_back(user);
+    }
+    uint32_t id = alerts.post(std::move(record));
+    alerts.deliver(id, recipients);
+    return recipients.size();
+}
+
+// --- Enrollment ---
+
+// Splits a line of student IDs on spaces and commas and resolves them in
+// batches. Duplicates are harmless; the roster merge drops them.
+void resolveStudentIds(const std::string& line, std::vector<uint32_t>& slots, std::vector<std::string>& unknown) {
+    StrView ids[UserDirectory::MAX_ID_BATCH];
+    uint32_t found[UserDirectory::MAX_ID_BATCH];
+    size_t pending = 0;
+    auto flush = [&]() {
+        users.findStudentSlots(ids, pending, found);
+        for (size_t i = 0; i < pending; i++) {
+            if (found[i] == UserDirectory::NO_STUDENT_SLOT) unknown.push_back(ids[i].str());
+            else slots.push_back(found[i]);
+        }
+        pending = 0;
+    };
+
+    size_t start = 0;
+    while (start < line.size()) {
+        size_t end = line.find_first_of(" ,\t", start);
+        if (end == std::string::npos) end = line.size();
+        if (end > start) {
+            ids[pending++] = StrView{line.data() + start, end - start};
+            if (pending == UserDirectory::MAX_ID_BATCH) flush();
+        }
+        start = end + 1;
+    }
+    if (pending > 0) flush();
+}
+
+// Caller holds enrollmentLock exclusively (replay runs before any session)
+size_t applyEnrollment(uint32_t subject, bool enrolling, const std::vector<uint32_t>& slots) {
+    return enrolling ? enrollment.enroll(subject, slots) : enrollment.drop(subject, slots);
+}
+
+// --- Server Mode ---
+// Serves the same menus to many clients at once over TCP on localhost or a
+// Unix domain socket (connect with e.g. `nc localhost 7070`). One event loop
+// thread owns every socket: it accepts, reads what has arrived and writes
+// queued output without blocking, using epoll on Linux and poll() elsewhere.
+// The menus are ordinary blocking code, so each session runs them on its own
+// thread whose sessionIn()/sessionOut() are fed by the event loop; a session
+// waiting for its user costs no socket time and no CPU.
+
+#ifndef _WIN32
+
+struct SessionClosed {}; // Thrown out of a session's input once its client is gone
+
+const size_t MAX_PENDING_INPUT = 64 * 1024; // Unread input per client before we stop reading its socket
+
+void setNonBlocking(int fd) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+}
+
+class SocketPoller {
+public:
+    struct Event {
+        int fd;
+        bool readable; // Also set on hangup/error, so the next read sees it
+        bool writable;
+    };
+
+#if defined(__linux__)
+    SocketPoller() : epollFd(epoll_create1(EPOLL_CLOEXEC)) {}
+    ~SocketPoller() { if (epollFd >= 0) ::close(epollFd); }
+
+    bool add(int fd) { return control(EPOLL_CTL_ADD, fd, EPOLLIN); }
+    void watch(int fd, bool reads, bool writes) {
+        uint32_t interest = 0;
+        if (reads) interest |= EPOLLIN;
+        if (writes) interest |= EPOLLOUT;
+        control(EPOLL_CTL_MOD, fd, interest);
+    }
+    void remove(int fd) { epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr); }
+
+    void wait(std::vector<Event>& events, int timeoutMs) {
+        epoll_event ready[64];
+        int count = epoll_wait(epollFd, ready, 64, timeoutMs);
+        events.clear();
+        for (int i = 0; i < count; i++) {
+            events.push_back({ready[i].data.fd, (ready[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0,
+                              (ready[i].events & EPOLLOUT) != 0});
+        }
+    }
+
+private:
+    int epollFd;
+
+    bool control(int operation, int fd, uint32_t interest) {
+        epoll_event event{};
+        event.events = interest;
+        event.data.fd = fd;
+        return epoll_ctl(epollFd, operation, fd, &event) == 0;
+    }
+#else
+    bool add(int fd) {
+        interest[fd] = POLLIN;
+        return true;
+    }
+    void watch(int fd, bool reads, bool writes) {
+        interest[fd] = static_cast<short>((reads ? POLLIN : 0) | (writes ? POLLOUT : 0));
+    }
+    void remove(int fd) { interest.erase(fd); }
+
+    void wait(std::vector<Event>& events, int timeoutMs) {
+        std::vector<pollfd> fds;
+        for (const auto& entry : interest) fds.push_back({entry.first, entry.second, 0});
+        int count = poll(fds.data(), fds.size(), timeoutMs);
+        events.clear();
+        for (size_t i = 0; i < fds.size() && count > 0; i++) {
+            if (fds[i].revents == 0) continue;
+            events.push_back({fds[i].fd, (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) != 0,
+                              (fds[i].revents & POLLOUT) != 0});
+        }
+    }
+
+private:
+    std::map<int, short> interest;
+#endif
+};
+
+// Session threads report "I have output" or "I am done" here; a byte on the
+// pipe wakes the event loop, which then collects the reporting sessions
+class WakeQueue {
+public:
+    WakeQueue() : pipeFds{-1, -1} {}
+    ~WakeQueue() {
+        if (pipeFds[0] >= 0) ::close(pipeFds[0]);
+        if (pipeFds[1] >= 0) ::close(pipeFds[1]);
+    }
+
+    bool open() {
+        if (pipe(pipeFds) != 0) return false;
+        setNonBlocking(pipeFds[0]);
+        setNonBlocking(pipeFds[1]);
+        return true;
+    }
+
+    int readFd() const { return pipeFds[0]; }
+
+    void post(int sessionFd) {
+        bool first;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            first = ready.empty();
+            ready.push_back(sessionFd);
+        }
+        if (first) {
+            char byte = 0;
+            ssize_t ignored = ::write(pipeFds[1], &byte, 1); // A full pipe already means "wake up"
+            (void)ignored;
+        }
+    }
+
+    void drain(std::vector<int>& sessionFds) {
+        char bytes[64];
+        while (::read(pipeFds[0], bytes, sizeof(bytes)) > 0) {}
+        std::lock_guard<std::mutex> lock(mutex);
+        sessionFds.swap(ready);
+        ready.clear();
+    }
+
+private:
+    int pipeFds[2];
+    std::mutex mutex;
+    std::vector<int> ready;
+};
+
+// One connected client. Input flows event loop -> session thread, output the
+// other way; both directions are plain byte queues under one small lock.
+class ClientSession {
+public:
+    ClientSession(int socket, WakeQueue& wakeups)
+        : fd(socket), connected(true), watchingWrites(false), readsPaused(false), wakeups(wakeups), inputClosed(false),
+          finished(false) {}
+
+    // Event loop side. False once as much input is waiting as we buffer; the
+    // loop then stops reading the socket (so TCP holds the client back, as
+    // when a scanner uploads a backlog) until the session has read some.
+    bool receive(const char* bytes, size_t count) {
+        bool room;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (size_t i = 0; i < count; i++) {
+                if (bytes[i] != '\r') input.push_back(bytes[i]); // Telnet style clients send CRLF
+            }
+            room = input.size() < MAX_PENDING_INPUT;
+        }
+        inputChanged.notify_one();
+        return room;
+    }
+
+    bool hasRoom() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return input.size() < MAX_PENDING_INPUT;
+    }
+
+    void closeInput() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            inputClosed = true;
+        }
+        inputChanged.notify_one();
+    }
+
+    // Moves queued output to the end of `into`; true once the menu has ended
+    bool takeOutput(std::string& into) {
+        std::lock_guard<std::mutex> lock(mutex);
+        into += output;
+        output.clear();
+        return finished;
+    }
+
+    // Session thread side. Blocks until input arrives; throws SessionClosed
+    // when there will be none.
+    size_t read(char* buffer, size_t capacity) {
+        std::unique_lock<std::mutex> lock(mutex);
+        inputChanged.wait(lock, [&] { return !input.empty() || inputClosed; });
+        if (input.empty()) throw SessionClosed();
+        bool wasFull = input.size() >= MAX_PENDING_INPUT;
+        size_t count = std::min(capacity, input.size());
+        std::copy(input.begin(), input.begin() + count, buffer);
+        input.erase(0, count);
+        lock.unlock();
+        if (wasFull) wakeups.post(fd); // The event loop can read the socket again
+        return count;
+    }
+
+    void write(const char* bytes, size_t count) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            output.append(bytes, count);
+        }
+        wakeups.post(fd);
+    }
+
+    void finish() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            finished = true;
+        }
+        wakeups.post(fd);
+    }
+
+    // Owned by the event loop
+    const int fd;
+    bool connected;
+    bool watchingWrites;
+    bool readsPaused;   // Input is full; the socket is not being read
+    std::string unsent; // Output the socket has not taken yet
+    std::thread worker;
+
+private:
+    WakeQueue& wakeups;
+    std::mutex mutex;
+    std::condition_variable inputChanged;
+    std::string input;
+    std::string output;
+    bool inputClosed;
+    bool finished;
+};
+
+// Stream buffers connecting a session thread's iostreams to its client
+class SessionInputBuffer : public std::streambuf {
+public:
+    explicit SessionInputBuffer(ClientSession& session) : session(session) {}
+
+protected:
+    int_type underflow() override {
+        size_t count = session.read(buffer, sizeof(buffer));
+        setg(buffer, buffer, buffer + count);
+        return traits_type::to_int_type(buffer[0]);
+    }
+
+private:
+    ClientSession& session;
+    char buffer[4096];
+};
+
+class SessionOutputBuffer : public std::streambuf {
+public:
+    explicit SessionOutputBuffer(ClientSession& session) : session(session) { setp(buffer, buffer + sizeof(buffer)); }
+
+protected:
+    int_type overflow(int_type c) override {
+        sync();
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+
+    int sync() override {
+        if (pptr() > pbase()) session.write(pbase(), pptr() - pbase());
+        setp(buffer, buffer + sizeof(buffer));
+        return 0;
+    }
+
+private:
+    ClientSession& session;
+    char buffer[4096];
+};
+
+void runSession(ClientSession* session) {
+    SessionInputBuffer inputBuffer(*session);
+    SessionOutputBuffer outputBuffer(*session);
+    TerminalScreen screen(&outputBuffer, DEFAULT_TERMINAL_ROWS);
+    std::istream input(&inputBuffer);
+    std::ostream output(&screen);
+    input.tie(&output);                 // Prompts are sent before we wait for the answer
+    input.exceptions(std::ios::badbit); // Lets SessionClosed unwind out of any prompt
+    sessionInput = &input;
+    sessionOutput = &output;
+    sessionScreen = &screen;
+    try {
+        runMainMenu();
+    } catch (const SessionClosed&) {
+        // The client disconnected mid-menu; everything it submitted is already logged
+    }
+    output.flush();
+    session->finish();
+}
+
+class SessionServer {
+public:
+    SessionServer() : listenFd(-1) {}
+    ~SessionServer() {
+        if (listenFd >= 0) ::close(listenFd);
+    }
+
+    bool listenTcp(int port) {
+        listenFd = socket(AF_INET, SOCK_STREAM, 0);
+        if (listenFd < 0) return false;
+        int reuse = 1;
+        setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(port));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK); // Local clients only; there is no encryption
+        return finishListening(reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    }
+
+    bool listenUnix(const std::string& path) {
+        sockaddr_un address{};
+        if (path.size() >= sizeof(address.sun_path)) return false;
+        listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listenFd < 0) return false;
+        address.sun_family = AF_UNIX;
+        memcpy(address.sun_path, path.c_str(), path.size() + 1);
+        unlink(path.c_str()); // Left behind by an earlier run
+        return finishListening(reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    }
+
+    // Serves clients until stopRequested is set, then ends every session
+    void run(const volatile std::sig_atomic_t& stopRequested) {
+        if (!wakeups.open() || !poller.add(listenFd) || !poller.add(wakeups.readFd())) return;
+        std::vector<SocketPoller::Event> events;
+        std::vector<int> ready;
+        while (!stopRequested) {
+            poller.wait(events, 200); // The timeout only bounds how long a stop request waits
+            for (const auto& event : events) {
+                if (event.fd == listenFd) {
+                    acceptClients();
+                } else if (event.fd != wakeups.readFd()) {
+                    auto found = sessions.find(event.fd);
+                    if (found == sessions.end()) continue;
+                    if (event.readable) receiveFrom(*found->second);
+                    pump(event.fd);
+                }
+            }
+            wakeups.drain(ready);
+            for (int fd : ready) pump(fd);
+        }
+
+        // Unblock every session thread, then wait for them to leave their menus
+        for (auto& entry : sessions) entry.second->closeInput();
+        for (auto& entry : sessions) {
+            entry.second->worker.join();
+            ::close(entry.first);
+        }
+        sessions.clear();
+    }
+
+private:
+    int listenFd;
+    SocketPoller poller;
+    WakeQueue wakeups;
+    std::map<int, std::unique_ptr<ClientSession>> sessions; // By socket
+
+    bool finishListening(const sockaddr* address, socklen_t length) {
+        if (bind(listenFd, address, length) != 0 || listen(listenFd, SOMAXCONN) != 0) return false;
+        setNonBlocking(listenFd);
+        return true;
+    }
+
+    void acceptClients() {
+        while (true) {
+            int client = accept(listenFd, nullptr, nullptr);
+            if (client < 0) return; // EAGAIN: nobody else is waiting
+            setNonBlocking(client);
+            if (!poller.add(client)) {
+                ::close(client);
+                continue;
+            }
+            std::unique_ptr<ClientSession> session(new ClientSession(client, wakeups));
+            session->worker = std::thread(runSession, session.get());
+            sessions[client] = std::move(session);
+        }
+    }
+
+    void receiveFrom(ClientSession& session) {
+        if (!session.connected) return;
+        char buffer[4096];
+        ssize_t count = recv(session.fd, buffer, sizeof(buffer), 0);
+        if (count > 0) {
+            if (!session.receive(buffer, static_cast<size_t>(count)) && !session.readsPaused) {
+                session.readsPaused = true;
+                poller.watch(session.fd, false, session.watchingWrites);
+            }
+        } else if (count == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            disconnect(session);
+        }
+    }
+
+    // The socket is kept open (but unwatched) until the session thread has
+    // finished, so its descriptor cannot be reused by a new client meanwhile
+    void disconnect(ClientSession& session) {
+        poller.remove(session.fd);
+        shutdown(session.fd, SHUT_RDWR);
+        session.connected = false;
+        session.unsent.clear();
+        session.closeInput();
+    }
+
+    // Sends what the session has queued; closes it once its menu has ended
+    // and everything has been sent
+    void pump(int fd) {
+        auto found = sessions.find(fd);
+        if (found == sessions.end()) return;
+        ClientSession& session = *found->second;
+        bool finished = session.takeOutput(session.unsent);
+        if (!session.connected) session.unsent.clear();
+
+        size_t sentTotal = 0;
+        while (sentTotal < session.unsent.size()) {
+            ssize_t sent = send(fd, session.unsent.data() + sentTotal, session.unsent.size() - sentTotal, 0);
+            if (sent > 0) {
+                sentTotal += static_cast<size_t>(sent);
+            } else if (sent < 0 && errno == EINTR) {
+                continue;
+            } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            } else {
+                disconnect(session);
+                break;
+            }
+        }
+        session.unsent.erase(0, sentTotal);
+
+        bool resumeReads = session.readsPaused && session.hasRoom();
+        if (session.connected && (resumeReads || session.watchingWrites != !session.unsent.empty())) {
+            session.watchingWrites = !session.unsent.empty();
+            session.readsPaused = session.readsPaused && !resumeReads;
+            poller.watch(fd, !session.readsPaused, session.watchingWrites);
+        }
+        if (finished && session.unsent.empty()) {
+            if (session.connected) poller.remove(fd);
+            session.worker.join();
+            ::close(fd);
+            sessions.erase(found);
+        }
+    }
+};
+
+volatile std::sig_atomic_t serverStopRequested = 0;
+
+void requestServerStop(int) {
+    serverStopRequested = 1;
+}
+
+#endif
+
+int runServer(int port, const std::string& socketPath) {
+#ifdef _WIN32
+    (void)port;
+    (void)socketPath;
+    std::cout << "Server mode is not supported on Windows yet.\n";
+    return 1;
+#else
+    SessionServer server;
+    bool listening = socketPath.empty() ? server.listenTcp(port) : server.listenUnix(socketPath);
+    std::string endpoint = socketPath.empty() ? "127.0.0.1:" + std::to_string(port) : socketPath;
+    if (!listening) {
+        std::cout << "Error: could not listen on " << endpoint << ".\n";
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN); // A client vanishing mid-send is handled as a disconnect
+    signal(SIGINT, requestServerStop);
+    signal(SIGTERM, requestServerStop);
+    std::cout << "College Alerter is serving on " << endpoint << ". Press Ctrl+C to stop.\n";
+    server.run(serverStopRequested);
+    if (!socketPath.empty()) unlink(socketPath.c_str());
+    std::cout << "Server stopped.\n";
+    return 0;
+#endif
+}
+
+// --- Metrics Screens and Export ---
+
+std::string formatNanos(uint64_t nanos) {
+    char text[32];
+    if (nanos < 1000) snprintf(text, sizeof(text), "%llu ns", static_cast<unsigned long long>(nanos));
+    else if (nanos < 1000000) snprintf(text, sizeof(text), "%.1f us", nanos / 1e3);
+    else if (nanos < 1000000000) snprintf(text, sizeof(text), "%.2f ms", nanos / 1e6);
+    else snprintf(text, sizeof(text), "%.2f s", nanos / 1e9);
+    return text;
+}
+
+void displaySystemStatistics() {
+    clearScreen();
+    MetricsSnapshot snapshot;
+    metrics.snapshot(snapshot);
+    sessionOut() << "--- System Statistics (since start) ---\n";
+    if (!metrics.isEnabled()) sessionOut() << "(Metrics are switched off.)\n";
+    sessionOut() << std::left << std::setw(17) << "Operation" << std::setw(10) << "Count" << std::setw(11) << "Mean"
+                 << std::setw(11) << "p50" << std::setw(11) << "p99" << "Max\n";
+    for (int op = 0; op < OP_COUNT; op++) {
+        const OperationLatency& latency = snapshot.operations[op];
+        if (latency.count == 0) continue;
+        sessionOut() << std::setw(17) << OPERATION_NAMES[op] << std::setw(10) << latency.count << std::setw(11)
+                     << formatNanos(latency.totalNanos / latency.count) << std::setw(11)
+                     << formatNanos(latency.percentile(0.50)) << std::setw(11) << formatNanos(latency.percentile(0.99))
+                     << formatNanos(latency.maxNanos) << "\n";
+    }
+    sessionOut() << "\n";
+    for (int c = 0; c < COUNTER_COUNT; c++) {
+        sessionOut() << std::setw(28) << COUNTER_NAMES[c] << snapshot.counters[c] << "\n";
+    }
+    sessionOut() << std::right;
+    sessionOut() << "Users: " << users.size() << ", complaints: " << studentComplaints.size() << " ("
+                 << studentComplaints.coldCount() << " archived), leave notices: " << studentLeaveNotices.size()
+                 << " (" << studentLeaveNotices.coldCount() << " archived)\n";
+    sessionOut() << "---------------------------------------\n";
+}
+
+// Histograms with power-of-four buckets from about 1 us to 17 s (bucket
+// edges fall on powers of two, so the counts are exact), plus the counters
+std::string formatPrometheus(const MetricsSnapshot& snapshot) {
+    std::string out;
+    char line[160];
+    out += "# HELP college_alerter_operation_seconds Time spent in each operation.\n";
+    out += "# TYPE college_alerter_operation_seconds histogram\n";
+    for (int op = 0; op < OP_COUNT; op++) {
+        const OperationLatency& latency = snapshot.operations[op];
+        uint64_t cumulative = 0;
+        size_t bucket = 0;
+        for (uint32_t exponent = 10; exponent <= 34; exponent += 2) {
+            uint64_t edge = 1ULL << exponent; // Values below this
+            while (bucket < HISTOGRAM_BUCKETS && histogramBucketStart(bucket) < edge) cumulative += latency.buckets[bucket++];
+            snprintf(line, sizeof(line), "college_alerter_operation_seconds_bucket{operation=\"%s\",le=\"%g\"} %llu\n",
+                     OPERATION_NAMES[op], edge / 1e9, static_cast<unsigned long long>(cumulative));
+            out += line;
+        }
+        snprintf(line, sizeof(line), "college_alerter_operation_seconds_bucket{operation=\"%s\",le=\"+Inf\"} %llu\n",
+                 OPERATION_NAMES[op], static_cast<unsigned long long>(latency.count));
+        out += line;
+        snprintf(line, sizeof(line), "college_alerter_operation_seconds_sum{operation=\"%s\"} %.9f\n",
+                 OPERATION_NAMES[op], latency.totalNanos / 1e9);
+        out += line;
+        snprintf(line, sizeof(line), "college_alerter_operation_seconds_count{operation=\"%s\"} %llu\n",
+                 OPERATION_NAMES[op], static_cast<unsigned long long>(latency.count));
+        out += line;
+    }
+    for (int c = 0; c < COUNTER_COUNT; c++) {
+        snprintf(line, sizeof(line), "# TYPE college_alerter_%s_total counter\ncollege_alerter_%s_total %llu\n",
+                 COUNTER_NAMES[c], COUNTER_NAMES[c], static_cast<unsigned long long>(snapshot.counters[c]));
+        out += line;
+    }
+    return out;
+}
+
+// Scrapers read the old file or the new one, never half of it
+bool writeMetricsFile(const std::string& path) {
+    MetricsSnapshot snapshot;
+    metrics.snapshot(snapshot);
+    std::string text = formatPrometheus(snapshot);
+    std::string temporary = path + ".tmp";
+    FILE* file = fopen(temporary.c_str(), "wb");
+    if (file == nullptr) return false;
+    bool ok = fwrite(text.data(), 1, text.size(), file) == text.size();
+    return fclose(file) == 0 && ok && replaceFile(temporary, path);
+}
+
+// --- Data Export ---
+// Attendance, results, complaints and leave notices out to CSV (RFC 4180
+// quoting, a header row) or JSON (an array with one object per line) for the
+// registrar's extracts. Records are copied out of their store a batch at a
+// time under its lock and formatted straight into one large buffer, which
+// goes to the file in a single write whenever it fills. So an export of any
+// size holds one batch and one buffer, and sessions keep saving while it
+// runs. The file is written under a temporary name and renamed once
+// complete, so a nightly job never picks up half an extract.
+
+const size_t EXPORT_BUFFER_BYTES = 1 << 20;
+const size_t EXPORT_BATCH_RECORDS = 4096; // Records copied out per lock acquisition
+
+const char* const ATTENDANCE_COLUMNS[] = {"session", "subject", "date", "student_id", "student_name", "status"};
+const char* const RESULTS_COLUMNS[] = {"student_id", "student_name", "subject", "semester", "credits", "grade",
+                                       "points"};
+const char* const COMPLAINT_COLUMNS[] = {"number", "submitted_at", "student_email", "student_name", "status",
+                                         "message"};
+const char* const LEAVE_COLUMNS[] = {"number", "submitted_at", "student_email", "student_name", "dates",
+                                     "first_day", "last_day", "status", "reason"};
+
+// Rows are written field by field in column order, each followed by endRow()
+class ExportWriter {
+public:
+    ExportWriter(ExportFormat format, const char* const* columns, size_t columnCount)
+        : format(format), columns(columns), columnCount(columnCount), buffer(new char[EXPORT_BUFFER_BYTES]) {
+        for (size_t c = 0; c < columnCount; c++) keys.push_back("\"" + std::string(columns[c]) + "\":");
+    }
+    ~ExportWriter() {
+        if (file == nullptr) return;
+        fclose(file);
+        remove(temporary.c_str());
+    }
+    ExportWriter(const ExportWriter&) = delete;
+    ExportWriter& operator=(const ExportWriter&) = delete;
+
+    bool open(const std::string& path) {
+        target = path;
+        temporary = path + ".tmp";
+        file = fopen(temporary.c_str(), "wb");
+        if (file == nullptr) return false;
+        setvbuf(file, nullptr, _IONBF, 0); // Rows are buffered here already; stdio would copy them again
+        if (format == EXPORT_JSON) {
+            put("[", 1);
+            return true;
+        }
+        for (size_t c = 0; c < columnCount; c++) {
+            if (c > 0) put(",", 1);
+            put(columns[c], strlen(columns[c]));
+        }
+        put("\n", 1);
+        return true;
+    }
+
+    void text(const char* data, size_t size) {
+        beginField();
+        if (format == EXPORT_CSV) csvText(data, size);
+        else jsonText(data, size);
+    }
+    void text(StrView value) { text(value.data, value.size); }
+    void text(const std::string& value) { text(value.data(), value.size()); }
+    void text(const char* value) { text(value, strlen(value)); }
+
+    void number(int64_t value) {
+        beginField();
+        char digits[24];
+        char* end = digits + sizeof(digits);
+        char* p = end;
+        uint64_t magnitude = value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+        do {
+            *--p = static_cast<char>('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude != 0);
+        if (value < 0) *--p = '-';
+        put(p, static_cast<size_t>(end - p));
+    }
+
+    // Days since 1970-01-01 as "2024-02-25"
+    void day(int64_t days) {
+        char out[40];
+        isoField(out, formatIsoDay(days, out));
+    }
+
+    // Unix time as "2024-02-25T10:30:00Z"
+    void time(int64_t unixSeconds) {
+        int64_t days = unixSeconds >= 0 ? unixSeconds / 86400 : (unixSeconds - 86399) / 86400;
+        unsigned second = static_cast<unsigned>(unixSeconds - days * 86400);
+        char out[40];
+        size_t length = formatIsoDay(days, out);
+        out[length] = 'T';
+        twoDigits(out + length + 1, second / 3600);
+        out[length + 3] = ':';
+        twoDigits(out + length + 4, second / 60 % 60);
+        out[length + 6] = ':';
+        twoDigits(out + length + 7, second % 60);
+        out[length + 9] = 'Z';
+        isoField(out, length + 10);
+    }
+
+    // An empty CSV field, or null in JSON
+    void missing() {
+        beginField();
+        if (format == EXPORT_JSON) put("null", 4);
+    }
+
+    void endRow() {
+        put(format == EXPORT_CSV ? "\n" : "}", 1);
+        column = 0;
+        rows++;
+    }
+
+    // Writes what is buffered, syncs, and moves the file into place; false
+    // (and no file) if any write failed
+    bool finish() {
+        if (format == EXPORT_JSON) put("\n]\n", 3);
+        flush();
+        bool ok = !failed && syncFile(file);
+        ok = fclose(file) == 0 && ok;
+        file = nullptr;
+        ok = ok && replaceFile(temporary, target);
+        if (!ok) remove(temporary.c_str());
+        return ok;
+    }
+
+    uint64_t rowCount() const { return rows; }
+    uint64_t byteCount() const { return bytes + used; }
+
+private:
+    ExportFormat format;
+    const char* const* columns;
+    size_t columnCount;
+    std::vector<std::string> keys; // "\"name\":" per column, for JSON
+    std::unique_ptr<char[]> buffer;
+    size_t used = 0;
+    FILE* file = nullptr;
+    std::string target, temporary;
+    size_t column = 0;
+    uint64_t rows = 0;
+    uint64_t bytes = 0; // Handed to the file so far
+    bool failed = false;
+
+    void put(const char* data, size_t size) {
+        if (size > EXPORT_BUFFER_BYTES - used) {
+            flush();
+            if (size >= EXPORT_BUFFER_BYTES) {
+                write(data, size); // Straight from the record rather than through the buffer
+                return;
+            }
+        }
+        memcpy(buffer.get() + used, data, size);
+        used += size;
+    }
+
+    void flush() {
+        if (used > 0) write(buffer.get(), used);
+        used = 0;
+    }
+
+    void write(const char* data, size_t size) {
+        if (!failed && fwrite(data, 1, size, file) != size) failed = true;
+        bytes += size;
+    }
+
+    void beginField() {
+        if (format == EXPORT_CSV) {
+            if (column > 0) put(",", 1);
+        } else {
+            if (column == 0) put(rows == 0 ? "\n{" : ",\n{", rows == 0 ? 2 : 3);
+            else put(",", 1);
+            const std::string& key = keys[column < keys.size() ? column : keys.size() - 1];
+            put(key.data(), key.size());
+        }
+        column++;
+    }
+
+    // Quoted only when it holds a comma, quote or line break; quotes double
+    void csvText(const char* data, size_t size) {
+        size_t special = 0;
+        while (special < size && data[special] != ',' && data[special] != '"' && data[special] != '\n' &&
+               data[special] != '\r') {
+            special++;
+        }
+        if (special == size) {
+            put(data, size);
+            return;
+        }
+        put("\"", 1);
+        size_t start = 0;
+        for (size_t i = special; i < size; i++) {
+            if (data[i] != '"') continue;
+            put(data + start, i + 1 - start);
+            start = i; // The quote goes out again with the next run
+        }
+        put(data + start, size - start);
+        put("\"", 1);
+    }
+
+    // Bytes pass through as they are (text is stored as typed, in UTF-8);
+    // quotes, backslashes and control characters are escaped
+    void jsonText(const char* data, size_t size) {
+        put("\"", 1);
+        size_t start = 0;
+        for (size_t i = 0; i < size; i++) {
+            unsigned char c = static_cast<unsigned char>(data[i]);
+            if (c >= 0x20 && c != '"' && c != '\\') continue;
+            put(data + start, i - start);
+            char escape[8] = {'\\', static_cast<char>(c), 0};
+            size_t length = 2;
+            if (c == '\n') escape[1] = 'n';
+            else if (c == '\r') escape[1] = 'r';
+            else if (c == '\t') escape[1] = 't';
+            else if (c < 0x20) length = static_cast<size_t>(snprintf(escape, sizeof(escape), "\\u%04x", c));
+            put(escape, length);
+            start = i + 1;
+        }
+        put(data + start, size - start);
+        put("\"", 1);
+    }
+
+    // Dates and times hold no characters that need escaping
+    void isoField(const char* text, size_t length) {
+        beginField();
+        if (format == EXPORT_JSON) put("\"", 1);
+        put(text, length);
+        if (format == EXPORT_JSON) put("\"", 1);
+    }
+
+    static void twoDigits(char* out, unsigned value) {
+        out[0] = static_cast<char>('0' + value / 10);
+        out[1] = static_cast<char>('0' + value % 10);
+    }
+
+    // "2024-02-25" into out (at least 40 bytes), returning its length
+    static size_t formatIsoDay(int64_t days, char* out) {
+        int64_t year;
+        unsigned month, day;
+        civilFromDays(days, year, month, day);
+        if (year < 0 || year > 9999) {
+            return static_cast<size_t>(snprintf(out, 30, "%lld-%02u-%02u", static_cast<long long>(year), month, day));
+        }
+        unsigned y = static_cast<unsigned>(year);
+        twoDigits(out, y / 100);
+        twoDigits(out + 2, y % 100);
+        out[4] = '-';
+        twoDigits(out + 5, month);
+        out[7] = '-';
+        twoDigits(out + 8, day);
+        return 10;
+    }
+};
+
+// Subject names by id, looked up in the catalog once each (the catalog
+// takes a lock per lookup, and names never move once added)
+class SubjectNameCache {
+public:
+    const std::string& operator()(uint32_t subject) {
+        while (names.size() <= subject) names.push_back(&subjects.name(static_cast<uint32_t>(names.size())));
+        return *names[subject];
+    }
+
+private:
+    std::vector<const std::string*> names;
+};
+
+// A row per marked student per session, one session copied out at a time
+void exportAttendance(ExportWriter& out) {
+    AttendanceSession session;
+    std::vector<uint32_t> slots;
+    std::vector<StrView> ids, names;
+    SubjectNameCache subjectName;
+    for (size_t s = 0;; s++) {
+        {
+            std::shared_lock<std::shared_timed_mutex> lock(attendanceLock);
+            if (s >= attendance.allSessions().size()) break;
+            session = attendance.allSessions()[s]; // Reuses the bitsets' storage
+        }
+        slots.clear();
+        for (size_t w = 0; w < session.marked.size(); w++) {
+            for (uint64_t bits = session.marked[w]; bits != 0; bits &= bits - 1) {
+                slots.push_back(static_cast<uint32_t>(w * 64 + __builtin_ctzll(bits)));
+            }
+        }
+        users.studentLabels(slots, ids, names);
+        const std::string& subject = subjectName(session.subject);
+        for (size_t i = 0; i < slots.size(); i++) {
+            out.number(static_cast<int64_t>(s + 1));
+            out.text(subject);
+            out.text(session.date);
+            out.text(ids[i]);
+            out.text(names[i]);
+            out.text(testBit(session.present, slots[i]) ? "Present" : "Absent");
+            out.endRow();
+        }
+    }
+}
+
+// A row per grade, EXPORT_BATCH_RECORDS students' grades at a time
+void exportResults(ExportWriter& out) {
+    std::vector<GradeEntry> entries;
+    std::vector<uint32_t> slots; // Whose each entry is
+    std::vector<StrView> ids, names;
+    SubjectNameCache subjectName;
+    for (size_t first = 0;; first += EXPORT_BATCH_RECORDS) {
+        entries.clear();
+        slots.clear();
+        {
+            std::lock_guard<std::mutex> lock(resultsLock);
+            if (first >= grades.slotCount()) break;
+            size_t last = std::min(grades.slotCount(), first + EXPORT_BATCH_RECORDS);
+            for (size_t slot = first; slot < last; slot++) {
+                for (const GradeEntry& entry : grades.gradesOf(static_cast<uint32_t>(slot))) {
+                    entries.push_back(entry);
+                    slots.push_back(static_cast<uint32_t>(slot));
+                }
+            }
+        }
+        users.studentLabels(slots, ids, names);
+        for (size_t i = 0; i < entries.size(); i++) {
+            const GradeEntry& entry = entries[i];
+            const GradeScaleEntry& grade = GRADE_SCALE[entry.grade < GRADE_SCALE_SIZE ? entry.grade : GRADE_SCALE_SIZE - 1];
+            out.text(ids[i]);
+            out.text(names[i]);
+            out.text(subjectName(entry.subject));
+            out.number(entry.semester);
+            out.number(entry.credits);
+            out.text(grade.letter);
+            out.number(grade.points);
+            out.endRow();
+        }
+    }
+}
+
+// A row per record of a complaint or leave list with its case status. Each
+// batch is copied out under the list's lock, then its statuses under
+// casesLock, and written with neither held. False if archived records could
+// not be read, so the export is incomplete.
+template <typename T, typename WriteRecord>
+bool exportCases(const SharedRecordList<T>& list, const CaseTracker& cases, CaseKind kind, ExportWriter& out,
+                 WriteRecord writeRecord) {
+    std::vector<T> batch(EXPORT_BATCH_RECORDS);
+    std::vector<size_t> positions(EXPORT_BATCH_RECORDS);
+    std::vector<uint8_t> status(EXPORT_BATCH_RECORDS);
+    for (size_t first = 0;; first += EXPORT_BATCH_RECORDS) {
+        size_t count = 0;
+        bool read = list.forEachIn(first, first + EXPORT_BATCH_RECORDS, [&](size_t pos, const T& record) {
+            positions[count] = pos;
+            batch[count++] = record;
+        });
+        if (!read) return false;
+        if (count == 0) return true;
+        {
+            std::shared_lock<std::shared_timed_mutex> lock(casesLock);
+            for (size_t i = 0; i < count; i++) status[i] = cases.statusOf(static_cast<uint32_t>(positions[i]));
+        }
+        for (size_t i = 0; i < count; i++) {
+            writeRecord(batch[i], caseStatusName(kind, status[i]));
+            out.endRow();
+        }
+    }
+}
+
+bool exportRecords(ExportDataset dataset, ExportFormat format, const std::string& path, ExportReport& report) {
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+    struct ColumnList {
+        const char* const* names;
+        size_t count;
+    };
+    const ColumnList columns[EXPORT_DATASET_COUNT] = {
+        {ATTENDANCE_COLUMNS, sizeof(ATTENDANCE_COLUMNS) / sizeof(ATTENDANCE_COLUMNS[0])},
+        {RESULTS_COLUMNS, sizeof(RESULTS_COLUMNS) / sizeof(RESULTS_COLUMNS[0])},
+        {COMPLAINT_COLUMNS, sizeof(COMPLAINT_COLUMNS) / sizeof(COMPLAINT_COLUMNS[0])},
+        {LEAVE_COLUMNS, sizeof(LEAVE_COLUMNS) / sizeof(LEAVE_COLUMNS[0])}
+    };
+    ExportWriter out(format, columns[dataset].names, columns[dataset].count);
+    if (!out.open(path)) return false;
+
+    auto submitted = [&](int64_t unixSeconds) {
+        if (unixSeconds == 0) out.missing();
+        else out.time(unixSeconds);
+    };
+    bool complete = true;
+    switch (dataset) {
+        case EXPORT_ATTENDANCE: exportAttendance(out); break;
+        case EXPORT_RESULTS: exportResults(out); break;
+        case EXPORT_COMPLAINTS:
+            complete = exportCases(studentComplaints, complaintCases, CASE_COMPLAINT, out, [&](const Complaint& complaint, const char* status) {
+                out.number(static_cast<int64_t>(complaint.sequence));
+                submitted(complaint.submittedAt);
+                out.text(complaint.studentEmail);
+                out.text(complaint.studentName);
+                out.text(status);
+                out.text(complaint.message);
+            });
+            break;
+        case EXPORT_LEAVE:
+            complete = exportCases(studentLeaveNotices, leaveCases, CASE_LEAVE, out, [&](const LeaveNotice& notice, const char* status) {
+                out.number(static_cast<int64_t>(notice.sequence));
+                submitted(notice.submittedAt);
+                out.text(notice.studentEmail);
+                out.text(notice.studentName);
+                out.text(notice.dates);
+                if (notice.lastDay < notice.firstDay) {
+                    out.missing();
+                    out.missing();
+                } else {
+                    out.day(notice.firstDay);
+                    out.day(notice.lastDay);
+                }
+                out.text(status);
+                out.text(notice.reason);
+            });
+            break;
+        default: break;
+    }
+    report.rows = out.rowCount();
+    report.bytes = out.byteCount();
+    bool ok = complete && out.finish(); // An incomplete export leaves no file
+    report.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return ok;
+}
+
+void handleDataExport() {
+    clearScreen();
+    size_t sessions;
+    {
+        std::shared_lock<std::shared_timed_mutex> lock(attendanceLock);
+        sessions = attendance.allSessions().size();
+    }
+    int choice;
+    sessionOut() << "--- Export Records ---\n";
+    sessionOut() << "1. Attendance (" << sessions << " sessions)\n";
+    sessionOut() << "2. Results\n";
+    sessionOut() << "3. Complaints (" << studentComplaints.size() << ")\n";
+    sessionOut() << "4. Leave Notices (" << studentLeaveNotices.size() << ")\n";
+    sessionOut() << "5. Back\n";
+    sessionOut() << "Enter your choice: ";
+    sessionIn() >> choice;
+    if (sessionIn().fail()) {
+        sessionIn().clear();
+        choice = 5;
+    }
+    ignoreLine();
+    if (choice < 1 || choice > 4) return;
+    ExportDataset dataset = static_cast<ExportDataset>(choice - 1);
+
+    int formatChoice;
+    sessionOut() << "Format (1. CSV, 2. JSON): ";
+    sessionIn() >> formatChoice;
+    if (sessionIn().fail()) {
+        sessionIn().clear();
+        formatChoice = 1;
+    }
+    ignoreLine();
+    ExportFormat format = formatChoice == 2 ? EXPORT_JSON : EXPORT_CSV;
+
+    std::string fileName = std::string(EXPORT_DATASET_NAMES[dataset]) + (format == EXPORT_JSON ? ".json" : ".csv");
+    std::string typed, path;
+    sessionOut() << "Save in the '" << EXPORT_DIR << "' folder as [" << fileName << "]: ";
+    std::getline(sessionIn(), typed);
+    const char* name = typed.data();
+    size_t length = typed.size();
+    trimSlice(name, length);
+    if (length > 0) fileName.assign(name, length);
+    if (!fileInDirectory(EXPORT_DIR, fileName, path)) {
+        sessionOut() << "Error: Give just a file name, without any folders.\n";
+        sessionOut() << "----------------------\n";
+        return;
+    }
+
+    sessionOut() << "Exporting...\n";
+    ExportReport report;
+    if (!ensureDirectory(EXPORT_DIR) || !exportRecords(dataset, format, path, report)) {
+        sessionOut() << "Error: Could not write '" << path << "'. Nothing was exported.\n";
+    } else {
+        FormatGuard restore(sessionOut());
+        sessionOut() << std::fixed << std::setprecision(2);
+        sessionOut() << "Exported " << report.rows << " rows (" << report.bytes / (1024.0 * 1024.0) << " MB) to "
+                     << path << " in " << report.seconds << " s (" << report.megabytesPerSecond() << " MB/s).\n";
+    }
+    sessionOut() << "----------------------\n";
+}
+
+// --- Batch Mode ---
+// Runs line commands instead of the menus, through the same operations. One
+// command per line, fields separated by '|'; blank lines and lines starting
+// with '#' are skipped:
+//   register|student|Name|email|phone|password|S1001   (teacher: position; staff: e.g. Librarian)
+//   login|email|password
+//   complain|email|message
+//   leave|email|dates|reason
+//   attend|subject|date|S1002 S1003   (the absent students; the rest of the roll is present)
+//   search|complaints|query           (or search|leave|query)
+//   import|roster.csv                 (a roster file, as Import User Roster reads it)
+//   scan|person|in|gate               (a gate scan now; out to leave, an empty gate for the main gate)
+//   scans|gate_scans.csv              (a scan file, as Import Scan File reads it)
+//   export|attendance|csv|file        (or results, complaints, leave; csv or json; a file name in exports/)
+//   flush                             (waits until queued complaints and leave notices are stored)
+// Failed lines are reported as they happen, and a table of throughput and
+// latency per command follows at the end.
+
+int runBatch(const std::string& path) {
+    std::ifstream file;
+    if (path != "-") {
+        file.open(path);
+        if (!file) {
+            std::cout << "Error: could not open " << path << "\n";
+            return 1;
+        }
+    }
+    std::istream& in = path == "-" ? std::cin : file;
+
+    std::vector<OperationStats> stats;
+    std::string line, error;
+    size_t lineNumber = 0, failures = 0;
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+    while (std::getline(in, line)) {
+        lineNumber++;
+        if (!runBatchCommand(line, stats, error) && ++failures <= MAX_REPORTED_PROBLEMS) {
+            std::cout << "Line " << lineNumber << ": " << error << "\n";
+        }
+    }
+    if (failures > MAX_REPORTED_PROBLEMS) std::cout << "... and " << failures - MAX_REPORTED_PROBLEMS << " more.\n";
+    submissions.flush();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    printOperationStats(stats);
+    FormatGuard format(std::cout);
+    std::cout << lineNumber << " lines in " << std::fixed << std::setprecision(2) << seconds << " s, "
+              << failures << " failed.\n";
+    return failures == 0 ? 0 : 1;
+}
+
+// Runs one line and records its latency under the command's name; false
+// (with the reason in error) when the command failed
+bool runBatchCommand(const std::string& line, std::vector<OperationStats>& stats, std::string& error) {
+    if (line.empty() || line[0] == '#' || normalizeKey(line).empty()) return true;
+    std::vector<std::string> fields;
+    size_t begin = 0;
+    while (true) {
+        size_t end = line.find('|', begin);
+        fields.push_back(line.substr(begin, end == std::string::npos ? std::string::npos : end - begin));
+        if (end == std::string::npos) break;
+        begin = end + 1;
+    }
+    if (!fields.empty() && !fields.back().empty() && fields.back().back() == '\r') fields.back().pop_back();
+    const std::string command = normalizeKey(fields[0]);
+
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+    bool ok = true;
+    error.clear();
+    auto expect = [&](size_t count) {
+        if (fields.size() == count) return true;
+        error = command + " takes " + std::to_string(count - 1) + " fields";
+        return false;
+    };
+    auto student = [&](const std::string& email) {
+        UserHandle user = users.findByEmail(email);
+        if (user == UserDirectory::npos || users.role(user) != Role::STUDENT) error = "no student " + email;
+        return error.empty() ? user : UserDirectory::npos;
+    };
+
+    if (command == "register") {
+        ok = expect(7);
+        if (ok) {
+            std::string role = normalizeKey(fields[1]);
+            User user{fields[2], fields[3], fields[5], fields[4], Role::STUDENT, fields[6]};
+            if (role == "teacher") user.role = Role::TEACHER;
+            else if (role == "staff") user.role = Role::NON_TEACHING_STAFF;
+            else if (role != "student") error = "unknown role " + fields[1];
+            RegistrationStatus status = error.empty() ? registerUser(user) : RegistrationStatus::NOT_SAVED;
+            if (status == RegistrationStatus::DUPLICATE) error = "already registered: " + fields[3];
+            else if (status == RegistrationStatus::NOT_SAVED && error.empty()) error = "could not be saved";
+            ok = status == RegistrationStatus::REGISTERED;
+        }
+    } else if (command == "login") {
+        ok = expect(3) && authenticate(fields[1], fields[2]) != UserDirectory::npos;
+        if (!ok && error.empty()) {
+            error = (loginLockout(fields[1]) > 0 ? "too many failed attempts for " : "invalid email or password for ") + fields[1];
+        }
+    } else if (command == "complain") {
+        UserHandle from = expect(3) ? student(fields[1]) : UserDirectory::npos;
+        ok = from != UserDirectory::npos;
+        if (ok) submitComplaint(from, fields[2]);
+    } else if (command == "leave") {
+        UserHandle from = expect(4) ? student(fields[1]) : UserDirectory::npos;
+        LeaveNotice notice;
+        int64_t year;
+        unsigned month, day;
+        civilFromDays(calendarNow() / 1440, year, month, day);
+        ok = from != UserDirectory::npos;
+        if (ok && !parseDayRange(fields[2], year, notice.firstDay, notice.lastDay)) {
+            error = "could not read the dates '" + fields[2] + "'";
+            ok = false;
+        }
+        if (ok) {
+            notice.dates = fields[2];
+            notice.reason = fields[3];
+            submitLeaveNotice(from, std::move(notice));
+        }
+    } else if (command == "attend") {
+        ok = expect(4);
+        std::vector<uint32_t> roll, onLeave, absent;
+        std::vector<std::string> unknown;
+        if (ok) {
+            resolveStudentIds(fields[3], absent, unknown);
+            if (!unknown.empty()) error = "unknown student " + unknown[0];
+            attendanceRoll(fields[1], fields[2], roll, onLeave);
+            if (error.empty() && roll.size() == onLeave.size()) error = "nobody to mark";
+            ok = error.empty();
+        }
+        if (ok) {
+            std::sort(absent.begin(), absent.end());
+            AttendanceSession session;
+            session.date = fields[2];
+            session.marked.assign(roll.back() / 64 + 1, 0);
+            session.present.assign(session.marked.size(), 0);
+            for (uint32_t slot : roll) {
+                if (std::binary_search(onLeave.begin(), onLeave.end(), slot)) continue;
+                setBit(session.marked, slot);
+                if (!std::binary_search(absent.begin(), absent.end(), slot)) setBit(session.present, slot);
+            }
+            ok = saveAttendance(fields[1], std::move(session));
+            if (!ok) error = "attendance could not be saved";
+        }
+    } else if (command == "import") {
+        ok = expect(2);
+        std::vector<User> parsed;
+        RosterFileReport report;
+        unsigned threads = std::thread::hardware_concurrency();
+        if (ok && !parseRosterFile(fields[1], threads == 0 ? 1 : threads, parsed, report)) {
+            error = "could not open " + fields[1];
+            ok = false;
+        }
+        size_t skipped = 0;
+        if (ok && !importUsers(parsed, skipped)) {
+            error = "the roster could not be saved";
+            ok = false;
+        }
+        if (ok && (report.rejected > 0 || skipped > 0)) {
+            error = std::to_string(report.rejected) + " row(s) rejected, " + std::to_string(skipped) +
+                    " already registered" + (report.problems.empty() ? "" : "; " + report.problems[0]);
+            ok = false;
+        }
+    } else if (command == "scan") {
+        ok = expect(4);
+        GateScan scan;
+        const char* problem = ok ? parseGateScan("," + fields[1] + "," + fields[2] + "," + fields[3], scan) : nullptr;
+        if (problem != nullptr) {
+            error = problem;
+            ok = false;
+        }
+        if (ok && !recordGateScans(std::vector<GateScan>{scan})) {
+            error = "the scan could not be saved";
+            ok = false;
+        }
+    } else if (command == "scans") {
+        ok = expect(2);
+        GateScanReport report;
+        if (ok && !importGateScans(fields[1], report)) {
+            error = "could not open " + fields[1];
+            ok = false;
+        }
+        if (ok && (report.rejected > 0 || report.unsaved > 0)) {
+            error = std::to_string(report.rejected) + " line(s) rejected, " + std::to_string(report.unsaved) +
+                    " unsaved" + (report.problems.empty() ? "" : "; " + report.problems[0]);
+            ok = false;
+        }
+    } else if (command == "export") {
+        ok = expect(4);
+        std::string dataset = ok ? normalizeKey(fields[1]) : "";
+        std::string format = ok ? normalizeKey(fields[2]) : "";
+        auto named = std::find(EXPORT_DATASET_NAMES, EXPORT_DATASET_NAMES + EXPORT_DATASET_COUNT, dataset);
+        if (ok && named == EXPORT_DATASET_NAMES + EXPORT_DATASET_COUNT) {
+            error = "export attendance, results, complaints or leave, not " + fields[1];
+            ok = false;
+        } else if (ok && format != "csv" && format != "json") {
+            error = "export as csv or json, not " + fields[2];
+            ok = false;
+        }
+        std::string path;
+        if (ok && !fileInDirectory(EXPORT_DIR, fields[3], path)) {
+            error = "export to a file name in " + std::string(EXPORT_DIR) + "/, not " + fields[3];
+            ok = false;
+        }
+        ExportReport report;
+        if (ok && (!ensureDirectory(EXPORT_DIR) ||
+                   !exportRecords(static_cast<ExportDataset>(named - EXPORT_DATASET_NAMES),
+                                  format == "json" ? EXPORT_JSON : EXPORT_CSV, path, report))) {
+            error = "could not write " + path;
+            ok = false;
+        }
+    } else if (command == "search") {
+        ok = expect(3);
+        std::string list = ok ? normalizeKey(fields[1]) : "";
+        if (ok && list != "complaints" && list != "leave") {
+            error = "search complaints or leave, not " + fields[1];
+            ok = false;
+        }
+        if (ok) {
+            std::vector<SearchHit> page;
+            size_t total;
+            OperationTimer timer(OP_SEARCH);
+            (list == "leave" ? leaveSearch : complaintSearch).search(parseSearchQuery(fields[2]), nullptr,
+                                                                    SEARCH_PAGE_SIZE, page, total);
+        }
+    } else if (command == "flush") {
+        submissions.flush();
+    } else {
+        error = "unknown command " + fields[0];
+        return false;
+    }
+    double micros = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+
+    auto entry = std::find_if(stats.begin(), stats.end(), [&](const OperationStats& s) { return s.name == command; });
+    if (entry == stats.end()) {
+        stats.emplace_back();
+        entry = stats.end() - 1;
+        entry->name = command;
+    }
+    entry->micros.push_back(micros);
+    if (!ok) entry->failed++;
+    return ok;
+}
+
+// One row per command; throughput counts only the time spent in that command
+void printOperationStats(std::vector<OperationStats>& stats) {
+    FormatGuard format(std::cout);
+    std::cout << "Operation  | Calls    | Failed | Ops/s      | p50 (us) | p99 (us)\n";
+    std::cout << "-----------|----------|--------|------------|----------|---------\n";
+    for (OperationStats& op : stats) {
+        if (op.micros.empty()) continue;
+        double total = 0;
+        for (double micros : op.micros) total += micros;
+        std::sort(op.micros.begin(), op.micros.end());
+        std::cout << std::left << std::setw(11) << op.name << "| " << std::setw(9) << op.micros.size() << "| "
+                  << std::setw(7) << op.failed << "| " << std::setw(11)
+                  << static_cast<uint64_t>(total > 0 ? op.micros.size() * 1e6 / total : 0) << "| " << std::fixed
+                  << std::setprecision(1) << std::setw(9) << op.micros[op.micros.size() / 2] << "| "
+                  << op.micros[op.micros.size() * 99 / 100] << "\n" << std::right;
+    }
+}
+
+// A reproducible script for a college of userCount users (one teacher per
+// twenty students): everyone registers, then a working day of logins,
+// complaints, leave notices, roll calls and searches follows
+void generateBatchScript(size_t userCount, std::vector<std::string>& lines) {
+    static const char* const words[] = {"wifi", "hostel", "block", "canteen", "food", "library", "fan", "broken",
+                                        "lab", "bus", "late", "water", "cold", "noise", "exam", "fees"};
+    static const char* const subjectNames[] = {"Mathematics", "Physics", "Chemistry", "Programming"};
+    uint64_t state = 88172645463325252ULL;
+    auto next = [&]() {
+        state ^= state << 13; state ^= state >> 7; state ^= state << 17; // xorshift
+        return state;
+    };
+    auto isStudent = [](size_t i) { return i % 21 != 20; };
+    auto email = [](size_t i) { return "user" + std::to_string(i) + "@college.edu"; };
+
+    lines.clear();
+    for (size_t i = 0; i < userCount; i++) {
+        std::string id = std::to_string(i);
+        lines.push_back("register|" + std::string(isStudent(i) ? "student" : "teacher") + "|User " + id + "|" + email(i) +
+                        "|9" + std::string(9 - std::min<size_t>(9, id.size()), '0') + id + "|pw" + id + "|" +
+                        (isStudent(i) ? "S" + id : "Lecturer"));
+    }
+    size_t activity = std::min<size_t>(userCount, 100000);
+    for (size_t n = 0; n < activity; n++) {
+        size_t i = next() % userCount;
+        bool typo = next() % 10 == 0;
+        lines.push_back("login|" + email(i) + "|pw" + std::to_string(i) + (typo ? "x" : ""));
+    }
+    for (size_t n = 0; n < activity / 2; n++) {
+        size_t i = next() % userCount;
+        if (!isStudent(i)) continue;
+        std::string message;
+        for (int w = 0; w < 8; w++) message += std::string(w ? " " : "") + words[next() % 16];
+        lines.push_back("complain|" + email(i) + "|" + message);
+    }
+    for (size_t n = 0; n < activity / 10; n++) {
+        size_t i = next() % userCount;
+        if (!isStudent(i)) continue;
+        unsigned first = 1 + next() % 26;
+        lines.push_back("leave|" + email(i) + "|" + std::to_string(first) + "-" + std::to_string(first + 2) +
+                        " Mar 2026|" + words[next() % 16] + " at home");
+    }
+    lines.push_back("flush");
+    for (unsigned day = 1; day <= 20; day++) {
+        std::string absent;
+        for (int k = 0; k < 10; k++) {
+            size_t i = next() % userCount;
+            if (isStudent(i)) absent += " S" + std::to_string(i);
+        }
+        lines.push_back("attend|" + std::string(subjectNames[day % 4]) + "|" + std::to_string(day) + " Mar 2026|" + absent);
+    }
+    for (size_t n = 0; n < 1000; n++) {
+        lines.push_back("search|complaints|" + std::string(words[next() % 16]) + " " + words[next() % 16]);
+    }
+}
+
+// --- Benchmark Helpers ---
+// Every benchmark draws its data from a BenchRandom with the default seed, so
+// two runs build the same college, and times its phases with a Stopwatch.
+// runBenchmarks() puts std::cout's number format back after each one.
+
+// xorshift64: cheap and reproducible, which is all picking rows needs
+class BenchRandom {
+public:
+    explicit BenchRandom(uint64_t seed = 88172645463325252ULL) : state(seed) {}
+    uint64_t next() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+
+private:
+    uint64_t state;
+};
+
+// Time since construction or the last restart(), in the unit asked for
+class Stopwatch {
+public:
+    Stopwatch() : start(std::chrono::steady_clock::now()) {}
+    void restart() { start = std::chrono::steady_clock::now(); }
+    double seconds() const { return elapsed<std::ratio<1>>(); }
+    double millis() const { return elapsed<std::milli>(); }
+    double micros() const { return elapsed<std::micro>(); }
+    double nanos() const { return elapsed<std::nano>(); }
+
+private:
+    template <typename Unit>
+    double elapsed() const {
+        return std::chrono::duration<double, Unit>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    std::chrono::steady_clock::time_point start;
+};
+
+// Runs the named benchmark, or every one when only is null; false if no
+// benchmark has that name
+bool runBenchmarks(const char* only) {
+    bool ran = false;
+    for (const NamedBenchmark& benchmark : BENCHMARKS) {
+        if (only != nullptr && strcmp(only, benchmark.name) != 0) continue;
+        FormatGuard format(std::cout);
+        benchmark.run();
+        ran = true;
+    }
+    return ran;
+}
+
+// --- Benchmark Mode ---
+
+// Builds directories of increasing size and times logins (email lookups) and
+// registrations (duplicate checks + insert). Per-operation times should stay
+// flat as the directory grows.
+void runUserDirectoryBenchmark() {
+    typedef std::chrono::steady_clock Clock;
+    const size_t sizes[] = {1000, 10000, 100000, 1000000};
+    const size_t operations = 100000;
+
+    std::cout << "Users     | Login (ns/op) | Register (ns/op)\n";
+    std::cout << "----------|---------------|-----------------\n";
+    for (size_t size : sizes) {
+        UserDirectory directory;
+        directory.reserve(size + operations);
+        for (size_t i = 0; i < size; i++) {
+            std::string id = std::to_string(i);
+            directory.add({"User " + id, "user" + id + "@test.com", "pass" + id, "0000000000",
+                           Role::STUDENT, "S" + id});
+        }
+
+        // Pre-build the inputs so string formatting isn't part of the timing
+        std::vector<std::string> loginEmails;
+        std::vector<std::string> loginPasswords;
+        std::vector<User> newUsers;
+        loginEmails.reserve(operations);
+        loginPasswords.reserve(operations);
+        newUsers.reserve(operations);
+        uint64_t state = 88172645463325252ULL;
+        for (size_t i = 0; i < operations; i++) {
+            state ^= state << 13; state ^= state >> 7; state ^= state << 17; // xorshift
+            loginEmails.push_back("User" + std::to_string(state % size) + "@Test.com");
+            loginPasswords.push_back("pass" + std::to_string(state % size));
+            std::string id = std::to_string(size + i);
+            newUsers.push_back({"New " + id, "user" + id + "@test.com", "pass", "0000000000",
+                                Role::STUDENT, "S" + id});
+        }
+
+        size_t found = 0;
+        Clock::time_point start = Clock::now();
+        for (const auto& email : loginEmails) {
+            UserHandle user = directory.findByEmail(email);
+            if (user != UserDirectory::npos && verifyPassword(directory.storedPassword(user), loginPasswords[found])) found++;
+        }
+        double loginNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / operations;
+
+        start = Clock::now();
+        for (const auto& user : newUsers) {
+            if (directory.findByEmail(user.email) == UserDirectory::npos) directory.add(user);
+        }
+        double registerNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / operations;
+
+        if (found != operations) std::cout << "Warning: only " << found << " logins matched\n";
+        std::cout << std::left << std::setw(10) << size << "| "
+                  << std::setw(14) << static_cast<long>(loginNs) << "| "
+                  << static_cast<long>(registerNs) << "\n";
+
+        // Startup cost: save and reload the largest directory through a snapshot
+        if (size == sizes[sizeof(sizes) / sizeof(sizes[0]) - 1]) {
+            const std::string path = "bench_users.snap";
+            size_t expected = directory.size();
+            users = std::move(directory); // Snapshots always cover the global stores
+            start = Clock::now();
+            bool saved = saveSnapshot(path);
+            double saveMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+            users = UserDirectory();
+            start = Clock::now();
+            bool loaded = saved && loadSnapshot(path);
+            double loadMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            remove(path.c_str());
+
+            std::cout << "\nSnapshot of " << expected << " users: save " << static_cast<long>(saveMs)
+                      << " ms, load " << static_cast<long>(loadMs) << " ms"
+                      << (loaded && users.size() == expected ? "" : " (FAILED)") << "\n";
+            users = UserDirectory();
+        }
+    }
+}
+
+// Compares 1M users held as a vector of User records with the columnar
+// directory: bytes per user, and a roll-call style scan for students.
+void runUserMemoryBenchmark() {
+    typedef std::chrono::steady_clock Clock;
+    const size_t count = 1000000;
+    const Role roleCycle[] = {Role::STUDENT, Role::STUDENT, Role::STUDENT, Role::TEACHER, Role::NON_TEACHING_STAFF};
+    const char* const staffData[] = {"Professor", "Lecturer", "Clerk", "Librarian"};
+
+    std::vector<User> records;
+    records.reserve(count);
+    UserDirectory directory;
+    directory.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        std::string id = std::to_string(i);
+        Role role = roleCycle[i % 5];
+        User user = {"User Number " + id, "user" + id + "@campus-mail.edu", "secret-pass-" + id, "03001234567",
+                     role, role == Role::STUDENT ? "S" + id : staffData[i % 4]};
+        records.push_back(user);
+        directory.addTrusted(user);
+    }
+
+    // Heap bytes of the record layout: the vector plus every string too long for SSO
+    size_t recordBytes = records.capacity() * sizeof(User);
+    for (const auto& user : records) {
+        const std::string* fields[] = {&user.name, &user.email, &user.password, &user.phone, &user.roleSpecificData};
+        for (const std::string* field : fields) {
+            if (field->capacity() > 15) recordBytes += field->capacity() + 1;
+        }
+    }
+    size_t directoryBytes = directory.memoryUsage();
+
+    Clock::time_point start = Clock::now();
+    size_t recordStudents = 0;
+    size_t idChars = 0;
+    for (const auto& user : records) {
+        if (user.role == Role::STUDENT) {
+            recordStudents++;
+            idChars += user.roleSpecificData.size();
+        }
+    }
+    double recordMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    start = Clock::now();
+    size_t students = 0;
+    size_t directoryIdChars = 0;
+    directory.forEachStudent([&](uint32_t, UserHandle, StrView studentId) {
+        students++;
+        directoryIdChars += studentId.size;
+    });
+    double directoryMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    std::cout << "\nUser storage (" << count << " users)\n";
+    std::cout << "Layout    | Bytes/user | Student scan (ms)\n";
+    std::cout << "----------|------------|------------------\n";
+    std::cout << std::left << std::setw(10) << "Records" << "| " << std::setw(11) << recordBytes / count << "| "
+              << std::fixed << std::setprecision(1) << recordMs << "\n";
+    std::cout << std::setw(10) << "Columns" << "| " << std::setw(11) << directoryBytes / count << "| "
+              << directoryMs << "\n";
+    std::cout.unsetf(std::ios::fixed);
+    if (recordStudents != students || idChars != directoryIdChars) std::cout << "Warning: scans disagree\n";
+}
+
+// Several writers commit complaints at once; wider commit windows should
+// need far fewer fsyncs than there are commits.
+void runWalBenchmark() {
+    typedef std::chrono::steady_clock Clock;
+    const long windows[] = {0, 500, 2000};
+    const int writers = 8;
+    const int commitsPerWriter = 200;
+    const std::string path = "bench_commits.wal";
+
+    std::cout << "\nWAL group commit (" << writers << " writers x " << commitsPerWriter << " commits)\n";
+    std::cout << "Window (us) | Commits/s | fsyncs\n";
+    std::cout << "------------|-----------|-------\n";
+    for (long window : windows) {
+        remove(path.c_str());
+        WriteAheadLog log;
+        log.configure(std::chrono::microseconds(window), 1 << 20);
+        if (!log.open(path, 0)) {
+            std::cout << "Could not open " << path << "\n";
+            return;
+        }
+
+        Clock::time_point start = Clock::now();
+        std::vector<std::thread> threads;
+        for (int w = 0; w < writers; w++) {
+            threads.emplace_back([&log, w, commitsPerWriter]() {
+                for (int i = 0; i < commitsPerWriter; i++) {
+                    Complaint complaint;
+                    complaint.studentEmail = "bench@test.com";
+                    complaint.studentName = "Bench";
+                    complaint.message = "Complaint " + std::to_string(w) + "-" + std::to_string(i);
+                    BinaryWriter record;
+                    encodeComplaint(record, complaint);
+                    log.commit(WAL_ADD_COMPLAINT, record);
+                }
+            });
+        }
+        for (auto& thread : threads) thread.join();
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        std::cout << std::left << std::setw(12) << window << "| "
+                  << std::setw(10) << static_cast<long>(writers * commitsPerWriter / seconds) << "| "
+                  << log.batchesWritten() << "\n";
+        log.close();
+    }
+    remove(path.c_str());
+}
+
+// Students submitting leave notices at once: how long each student waits
+// when the submission goes through the queue versus committing it to the
+// log directly, and how long the consumer needs to store the whole burst
+void runSubmissionBenchmark() {
+    typedef std::chrono::steady_clock Clock;
+    const int writers = 8;
+    const int submissionsPerWriter = 2000;
+    const std::string path = "bench_submissions.wal";
+
+    std::cout << "\nLeave notice submission (" << writers << " students x " << submissionsPerWriter << ")\n";
+    std::cout << "Path         | p50 (us) | p99 (us) | Stored/s\n";
+    std::cout << "-------------|----------|----------|---------\n";
+    for (int queued = 0; queued < 2; queued++) {
+        remove(path.c_str());
+        wal.configure(std::chrono::microseconds(1000), 1 << 20);
+        if (!wal.open(path, 0)) {
+            std::cout << "Could not open " << path << "\n";
+            return;
+        }
+        if (queued) submissions.start(storeSubmissions, 256);
+
+        std::vector<std::vector<double>> latencies(writers);
+        Clock::time_point start = Clock::now();
+        std::vector<std::thread> threads;
+        for (int w = 0; w < writers; w++) {
+            threads.emplace_back([&, w]() {
+                for (int i = 0; i < submissionsPerWriter; i++) {
+                    LeaveNotice notice;
+                    notice.studentEmail = "bench@test.com";
+                    notice.studentName = "Bench";
+                    notice.dates = "25-27 Feb 2024";
+                    notice.reason = "Notice " + std::to_string(w) + "-" + std::to_string(i);
+                    Clock::time_point submitted = Clock::now();
+                    if (queued) {
+                        Submission submission;
+                        submission.kind = Submission::LEAVE_NOTICE;
+                        submission.notice = std::move(notice);
+                        submissions.submit(std::move(submission));
+                    } else {
+                        BinaryWriter record;
+                        encodeLeaveNotice(record, notice);
+                        if (logMutation(WAL_ADD_LEAVE_NOTICE, record)) studentLeaveNotices.append(std::move(notice));
+                    }
+                    latencies[w].push_back(std::chrono::duration<double, std::micro>(Clock::now() - submitted).count());
+                }
+            });
+        }
+        for (auto& thread : threads) thread.join();
+        submissions.stop();
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        std::vector<double> all;
+        for (const auto& perWriter : latencies) all.insert(all.end(), perWriter.begin(), perWriter.end());
+        std::sort(all.begin(), all.end());
+        bool complete = studentLeaveNotices.size() == static_cast<size_t>(writers * submissionsPerWriter);
+        std::cout << std::left << std::setw(13) << (queued ? "Queued" : "Direct commit") << "| " << std::setw(9)
+                  << std::fixed << std::setprecision(1) << all[all.size() / 2] << "| " << std::setw(9)
+                  << all[all.size() * 99 / 100] << "| " << static_cast<long>(all.size() / seconds)
+                  << (complete ? "" : " (FAILED)") << "\n" << std::right;
+        std::cout.unsetf(std::ios::floatfield);
+
+        wal.close();
+        studentLeaveNotices.assign({});
+        lastSubmissionSequence = 0;
+    }
+    remove(path.c_str());
+}
+
+// Four years of sessions for a mid-sized college: one student's attendance
+// screen, college-wide percentages and the full shortage report
+void runAttendanceBenchmark() {
+    typedef std::chrono::steady_clock Clock;
+    const size_t students = 10000;
+    const uint32_t subjectCount = 6;
+    const int sessionsPerSubject = 600;
+
+    AttendanceStore store;
+    uint64_t state = 88172645463325252ULL;
+    for (int n = 0; n < sessionsPerSubject; n++) {
+        for (uint32_t s = 0; s < subjectCount; s++) {
+            AttendanceSession session;
+            session.subject = s;
+            session.date = "Day " + std::to_string(n);
+            session.marked.assign((students + 63) / 64, ~0ULL);
+            session.present.resize(session.marked.size());
+            for (auto& word : session.present) {
+                state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+                word = state | (state >> 3); // Roughly 75% of students present
+            }
+            store.addSession(std::move(session));
+        }
+    }
+
+    const int lookups = 1000;
+    Clock::time_point start = Clock::now();
+    uint64_t checksum = 0;
+    for (int i = 0; i < lookups; i++) {
+        uint32_t slot = static_cast<uint32_t>((i * 7919) % students);
+        for (uint32_t s = 0; s < subjectCount; s++) checksum += store.studentTally(slot, s).attended;
+    }
+    double studentUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / lookups;
+
+    start = Clock::now();
+    for (uint32_t s = 0; s < subjectCount; s++) checksum += store.collegeTally(s).attended;
+    double collegeMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    std::vector<uint32_t> attended, held;
+    start = Clock::now();
+    store.tallyAllStudents(students, attended, held);
+    double reportMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    std::cout << "\nAttendance (" << students << " students, " << store.allSessions().size() << " sessions)\n";
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "One student, all subjects: " << studentUs << " us\n";
+    std::cout << "College-wide per subject:  " << collegeMs << " ms\n";
+    std::cout << "Shortage report (all):     " << reportMs << " ms\n";
+    std::cout.unsetf(std::ios::floatfield);
+    if (checksum == 0 || held[0] != static_cast<uint32_t>(subjectCount * sessionsPerSubject)) std::cout << "(unexpected totals)\n";
+}
+
+// Parses a results file with a row for every student in several subjects'
+// worth of rows, single threaded and with one thread per core
+void runResultsBenchmark() {
+    typedef std::chrono::steady_clock Clock;
+    const size_t students = 100000;
+    const size_t rows = 3000000;
+    const std::string path = "bench_results.csv";
+
+    UserDirectory directory;
+    directory.reserve(students);
+    for (size_t i = 0; i < students; i++) {
+        std::string id = std::to_string(i);
+        directory.add({"Student " + id, "student" + id + "@test.com", "pass", "0000000000", Role::STUDENT, "S" + id});
+    }
+    users = std::move(directory); // The parser resolves IDs against the global directory
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        users = UserDirectory();
+        std::cout << "Could not create " << path << "\n";
+        return;
+    }
+    fputs("Student ID,Grade\n", file);
+    for (size_t r = 0; r < rows; r++) {
+        fprintf(file, "S%zu,%s\n", (r * 7919) % students, GRADE_SCALE[r % (GRADE_SCALE_SIZE - 1)].letter);
+    }
+    fclose(file);
+
+    unsigned cores = std::thread::hardware_concurrency();
+    if (cores == 0) cores = 1;
+    std::cout << "\nResults CSV (" << rows << " rows, " << students << " students)\n";
+    std::cout << "Threads | MB/s    | Rows accepted\n";
+    std::cout << "--------|---------|--------------\n";
+    const unsigned threadCounts[] = {1, cores};
+    for (unsigned threads : threadCounts) {
+        std::vector<ParsedGrade> parsed;
+        ResultsFileReport report;
+        Clock::time_point start = Clock::now();
+        parseResultsFile(path, threads, parsed, report);
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        std::cout << std::left << std::setw(8) << threads << "| " << std::setw(8)
+                  << static_cast<long>(report.bytes / (1024.0 * 1024.0) / seconds) << "| " << report.rows << "\n";
+        if (threads == cores) break;
+    }
+    std::cout << std::right;
+    remove(path.c_str());
+    users = UserDirectory();
+}
+
+// Full SGPA/CGPA + merit list build for a large college, then the
+// incremental refresh after one subject's upload for a tenth of the students
+void runAnalyticsBenchmark() {
+    typedef std::chrono::steady_clock Clock;
+    const uint32_t students = 100000;
+    const uint32_t subjectsPerStudent = 40;
+    const uint32_t uploadSize = students / 10;
+
+    GradeStore store;
+    GradeAnalytics analytics;
+    uint64_t state = 88172645463325252ULL;
+    for (uint32_t slot = 0; slot < students; slot++) {
+        for (uint32_t subject = 0; subject < subjectsPerStudent; subject++) {
+            state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+            uint8_t semester = static_cast<uint8_t>(1 + subject / 5);
+            store.set(slot, GradeEntry{subject, semester, 4, static_cast<uint8_t>(state % 8)});
+        }
+    }
+
+    Clock::time_point start = Clock::now();
+    analytics.rebuild(store);
+    double fullMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    const uint32_t newSubject = subjectsPerStudent;
+    for (uint32_t i = 0; i < uploadSize; i++) {
+        uint32_t slot = (i * 7919) % students;
+        uint8_t grade = static_cast<uint8_t>(i % 8);
+        uint8_t previous = store.set(slot, GradeEntry{newSubject, 9, 4, grade});
+        analytics.gradeChanged(slot, newSubject, previous, grade);
+    }
+    start = Clock::now();
+    analytics.refresh(store);
+    double incrementalMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    std::cout << "\nGrade analytics (" << students << " students x " << subjectsPerStudent << " subjects)\n";
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Full rebuild:                      " << fullMs << " ms\n";
+    std::cout << "Refresh after one upload (" << uploadSize << "): " << incrementalMs << " ms\n";
+    std::cout.unsetf(std::ios::floatfield);
+    if (analytics.meritList().size() != students) std::cout << "(merit list has wrong size)\n";
+}
+
+// Five years of hourly bookings across many venues; conflict checks and
+// "next 30 days" lookups should cost about the same as with a week of history.
+void runCalendarBenchmark() {
+    typedef std::chrono::steady_clock Clock;
+    const int venues = 40;
+    const int64_t firstDay = daysFromCivil(2020, 1, 1);
+    const int64_t historyDays = 5 * 365;
+    const size_t probes = 100000;
+
+    Calendar bookings;
+    std::vector<std::string> venueNames;
+    for (int v = 0; v < venues; v++) venueNames.push_back("Room " + std::to_string(v));
+    uint64_t state = 88172645463325252ULL;
+    Clock::time_point start = Clock::now();
+    for (int64_t day = 0; day < historyDays; day++) {
+        for (int hour = 9; hour < 17; hour++) {
+            for (int v = 0; v < venues; v++) {
+                state ^= state << 13; state ^= state >> 7; state ^= state << 17; // xorshift
+                if (state % 4 != 0) continue; // About a quarter of the slots are booked
+                int64_t begin = (firstDay + day) * 1440 + hour * 60;
+                uint8_t audience = static_cast<uint8_t>(1 << (state >> 8) % 3);
+                bookings.add({begin, begin + 50, audience, (state >> 16) % 2 == 0, "Booking", venueNames[v], "Bench"});
+            }
+        }
+    }
+    double buildMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    std::vector<int64_t> probeStarts(probes);
+    for (auto& probe : probeStarts) {
+        state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+        probe = (firstDay + static_cast<int64_t>(state % historyDays)) * 1440 + 8 * 60 + static_cast<int64_t>((state >> 20) % 600);
+    }
+
+    size_t clashes = 0;
+    start = Clock::now();
+    for (size_t i = 0; i < probes; i++) {
+        if (bookings.venueConflict(venueNames[i % venues], probeStarts[i], probeStarts[i] + 60) != Calendar::npos) clashes++;
+    }
+    double conflictNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / probes;
+
+    const size_t windows = 1000;
+    size_t listed = 0;
+    std::vector<uint32_t> ids;
+    start = Clock::now();
+    for (size_t i = 0; i < windows; i++) {
+        bookings.upcoming(AUDIENCE_STUDENTS, probeStarts[i], probeStarts[i] + 30 * 1440, ids);
+        listed += ids.size();
+    }
+    double upcomingUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / windows;
+
+    std::cout << "\nCalendar (" << bookings.size() << " bookings over 5 years, " << venues << " venues)\n";
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Build: " << buildMs << " ms\n";
+    std::cout << "Venue conflict check: " << conflictNs << " ns/op (" << clashes << " of " << probes << " clashed)\n";
+    std::cout << "Next 30 days for students: " << upcomingUs << " us/query (" << listed / windows << " entries each)\n";
+    std::cout.unsetf(std::ios::floatfield);
+
+    // Spot-check the tree searches against a plain scan
+    for (size_t i = 0; i < 100; i++) {
+        size_t expected = 0;
+        bool venueTaken = false;
+        for (uint32_t id = 0; id < bookings.size(); id++) {
+            const CalendarEntry& entry = bookings.entry(id);
+            bool overlaps = entry.start < probeStarts[i] + 30 * 1440 && probeStarts[i] < entry.end;
+            if (overlaps && (entry.audience & AUDIENCE_STUDENTS)) expected++;
+            if (entry.venue == venueNames[i % venues] && entry.start < probeStarts[i] + 60 && probeStarts[i] < entry.end) {
+                venueTaken = true;
+            }
+        }
+        bookings.upcoming(AUDIENCE_STUDENTS, probeStarts[i], probeStarts[i] + 30 * 1440, ids);
+        bool found = bookings.venueConflict(venueNames[i % venues], probeStarts[i], probeStarts[i] + 60) != Calendar::npos;
+        if (ids.size() != expected || found != venueTaken) {
+            std::cout << "Warning: calendar search disagrees with a scan\n";
+            break;
+        }
+    }
+}
+
+// College-wide announcements to every student: the time to reach all the
+// inboxes, and the cost of the unread badge each dashboard shows.
+void runAlertBenchmark() {
+    typedef std::chrono::steady_clock Clock;
+    const size_t sizes[] = {50000, 1000000};
+    const size_t announcements = 5;
+
+    std::cout << "\nAlert fan-out (" << announcements << " announcements to all students)\n";
+    std::cout << "Students  | Per alert (ms) | Per inbox (ns) | Unread badge (ns)\n";
+    std::cout << "----------|----------------|----------------|------------------\n";
+    for (size_t size : sizes) {
+        UserDirectory directory;
+        directory.reserve(size + size / 20);
+        for (size_t i = 0; i < size + size / 20; i++) {
+            std::string id = std::to_string(i);
+            bool student = i % 21 != 20; // One teacher per twenty students
+            directory.addTrusted({"User " + id, "user" + id + "@test.com", "pass", "0000000000",
+                                  student ? Role::STUDENT : Role::TEACHER, student ? "S" + id : "Lecturer"});
+        }
+        users = std::move(directory);
+        alerts = AlertCenter();
+
+        size_t reached = 0;
+        Clock::time_point start = Clock::now();
+        for (size_t n = 0; n < announcements; n++) {
+            AlertTarget target;
+            target.roles = AUDIENCE_STUDENTS;
+            reached += publishAlert("Principal", "Announcement " + std::to_string(n), std::move(target));
+        }
+        double alertMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / announcements;
+
+        const size_t probes = 1000000;
+        uint64_t unread = 0;
+        uint64_t state = 88172645463325252ULL;
+        UserHandle userCount = static_cast<UserHandle>(users.size());
+        start = Clock::now();
+        for (size_t i = 0; i < probes; i++) {
+            state ^= state << 13; state ^= state >> 7; state ^= state << 17; // xorshift
+            unread += alerts.unreadCount(static_cast<UserHandle>(state % userCount));
+        }
+        double badgeNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / probes;
+
+        std::cout << std::left << std::setw(10) << reached / announcements << "| " << std::fixed << std::setprecision(2)
+                  << std::setw(15) << alertMs << "| " << std::setw(15) << alertMs * 1e6 / (reached / announcements)
+                  << "| " << badgeNs << "\n";
+        std::cout.unsetf(std::ios::floatfield);
+        if (unread == 0) std::cout << "Warning: no unread alerts were counted\n";
+    }
+    users = UserDirectory();
+    alerts = AlertCenter();
+}
+
+void runSearchBenchmark() {
+    typedef std::chrono::steady_clock Clock;
+    const size_t sizes[] = {100000, 1000000};
+    const char* common[] = {"the", "wifi", "in", "hostel", "block", "is", "not", "working", "since", "monday",
+                            "lab", "fan", "broken", "canteen", "food", "library", "closed", "early", "bus", "late"};
+    const size_t vocabulary = 20000;
+    const char* queries[] = {"wifi hostel", "\"hostel block\"", "library closed early", "t42 t7", "from:user77@test.com"};
+
+    std::cout << "\nComplaint search (12 words each, " << vocabulary << " rare words, first page of 10)\n";
+    std::cout << "Complaints | Index (docs/s) | Query                  | Matches  | First page (ms)\n";
+    std::cout << "-----------|----------------|------------------------|----------|----------------\n";
+    for (size_t size : sizes) {
+        std::vector<std::string> messages(size);
+        uint64_t state = 88172645463325252ULL;
+        for (std::string& message : messages) {
+            for (int w = 0; w < 12; w++) {
+                state ^= state << 13; state ^= state >> 7; state ^= state << 17; // xorshift
+                if (w > 0) message += ' ';
+                // Half the words come from a short common list, the rest are skewed rare words
+                if (state & 1) message += common[(state >> 1) % 20];
+                else message += "t" + std::to_string(((state >> 8) % vocabulary) * ((state >> 32) % vocabulary) / vocabulary);
+            }
+        }
+
+        TextIndex index;
+        Clock::time_point start = Clock::now();
+        for (size_t n = 0; n < size; n++) {
+            index.add(static_cast<uint32_t>(n), messages[n], "user" + std::to_string(n % 1000) + "@test.com");
+        }
+        double buildSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        bool first = true;
+        for (const char* text : queries) {
+            SearchQuery query = parseSearchQuery(text);
+            std::vector<SearchHit> page;
+            size_t total = 0;
+            const int repeats = 5;
+            start = Clock::now();
+            for (int r = 0; r < repeats; r++) index.search(query, nullptr, 10, page, total);
+            double queryMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / repeats;
+
+            std::cout << std::left << std::setw(11) << (first ? std::to_string(size) : "") << "| " << std::setw(15)
+                      << (first ? std::to_string(static_cast<uint64_t>(size / buildSeconds)) : "") << "| "
+                      << std::setw(23) << text << "| " << std::setw(9) << total << "| " << std::fixed
+                      << std::setprecision(3) << queryMs << "\n";
+            std::cout.unsetf(std::ios::floatfield);
+            first = false;
+
+            // The first size also checks the match count against a plain scan
+            if (size == sizes[0] && query.ownerEmail.empty()) {
+                size_t scanned = 0;
+                for (const std::string& message : messages) {
+                    std::string padded = " " + message + " ";
+                    bool all = true;
+                    for (const auto& word : query.words) all = all && padded.find(" " + word + " ") != std::string::npos;
+                    for (const auto& phrase : query.phrases) {
+                        std::string joined;
+                        for (const auto& word : phrase) joined += " " + word;
+                        all = all && padded.find(joined + " ") != std::string::npos;
+                    }
+                    if (all) scanned++;
+                }
+                if (scanned != total) std::cout << "Warning: index found " << total << ", scan found " << scanned << "\n";
+            }
+        }
+    }
+}
+
+// Scripts from generateBatchScript run through the batch commands, so every
+// number includes parsing, lookups, locking and the submission queue (the
+// log is closed, so no fsync). Complaint and leave latency is the time to
+// queue; flush shows how long storing them took.
+void runEndToEndBenchmark() {
+    typedef std::chrono::steady_clock Clock;
+    const size_t sizes[] = {1000, 100000, 1000000};
+    for (size_t size : sizes) {
+        users = UserDirectory();
+        users.reserve(size);
+        studentComplaints.assign({});
+        studentLeaveNotices.assign({});
+        leaveIndex = LeaveIndex();
+        complaintSearch = TextIndex();
+        leaveSearch = TextIndex();
+        complaintCases = CaseTracker();
+        leaveCases = CaseTracker();
+        attendance = AttendanceStore();
+        lastSubmissionSequence = 0;
+
+        std::vector<std::string> lines;
+        generateBatchScript(size, lines);
+        submissions.start(storeSubmissions, 256);
+        std::vector<OperationStats> stats;
+        std::string error;
+        size_t failures = 0;
+        Clock::time_point start = Clock::now();
+        for (const std::string& line : lines) {
+            if (!runBatchCommand(line, stats, error)) failures++;
+        }
+        submissions.stop();
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        std::cout << "\nEnd to end, " << size << " users (" << lines.size() << " commands in " << std::fixed
+                  << std::setprecision(2) << seconds << " s)\n";
+        std::cout.unsetf(std::ios::floatfield);
+        printOperationStats(stats);
+        size_t expectedFailures = 0;
+        for (const OperationStats& op : stats) expectedFailures += op.name == "login" ? op.failed : 0;
+        if (failures != expectedFailures) std::cout << "Warning: " << failures - expectedFailures << " commands failed\n";
+    }
+    users = UserDirectory();
+    studentComplaints.assign({});
+    studentLeaveNotices.assign({});
+    leaveIndex = LeaveIndex();
+    complaintSearch = TextIndex();
+    leaveSearch = TextIndex();
+    complaintCases = CaseTracker();
+    leaveCases = CaseTracker();
+    attendance = AttendanceStore();
+    lastSubmissionSequence = 0;
+}
+
+// What instrumentation costs: one recording on its own, many threads
+// recording at once (each into its own shard), and the slowdown of the
+// cheapest instrumented path, a login, with metrics on versus off
+void runMetricsBenchmark() {
+    const size_t records = 10000000;
+    Stopwatch timer;
+    for (size_t i = 0; i < records; i++) metrics.record(OP_SEARCH, i & 0xFFFFF);
+    double recordNs = timer.nanos() / records;
+
+    timer.restart();
+    for (size_t i = 0; i < records; i++) OperationTimer timer(OP_SEARCH);
+    double timerNs = timer.nanos() / records;
+
+    const int threads = 8;
+    std::vector<std::thread> workers;
+    timer.restart();
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&]() {
+            for (size_t i = 0; i < records / threads; i++) metrics.record(OP_SEARCH, i & 0xFFFFF);
+        });
+    }
+    for (auto& worker : workers) worker.join();
+    double parallelNs = timer.nanos() / records;
+
+    MetricsSnapshot snapshot;
+    timer.restart();
+    metrics.snapshot(snapshot);
+    double mergeUs = timer.micros();
+
+    const size_t userCount = 100000;
+    users = UserDirectory();
+    users.reserve(userCount);
+    for (size_t i = 0; i < userCount; i++) {
+        std::string id = std::to_string(i);
+        users.addTrusted({"User " + id, "user" + id + "@test.com", "pw" + id, "0000000000", Role::STUDENT, "S" + id});
+    }
+    const size_t logins = 1000000;
+    double loginNs[2];
+    for (int enabled = 0; enabled < 2; enabled++) {
+        metrics.setEnabled(enabled == 1);
+        size_t found = 0;
+        BenchRandom random;
+        timer.restart();
+        for (size_t i = 0; i < logins; i++) {
+            size_t n = random.next() % userCount;
+            std::string id = std::to_string(n);
+            found += authenticate("user" + id + "@test.com", "pw" + id) != UserDirectory::npos;
+        }
+        loginNs[enabled] = timer.nanos() / logins;
+        if (found != logins) std::cout << "Warning: " << logins - found << " logins failed\n";
+    }
+    metrics.setEnabled(true);
+    users = UserDirectory();
+
+    std::cout << "\nMetrics overhead\n" << std::fixed << std::setprecision(1);
+    std::cout << "Record one sample:          " << recordNs << " ns\n";
+    std::cout << "Timed scope (2 clock reads): " << timerNs << " ns\n";
+    std::cout << "Record, " << threads << " threads at once:   " << parallelNs << " ns per sample overall\n";
+    std::cout << "Merge all shards:           " << mergeUs << " us\n";
+    std::cout << "Login, metrics off/on:      " << loginNs[0] << " / " << loginNs[1] << " ns ("
+              << std::showpos << (loginNs[1] / loginNs[0] - 1) * 100 << std::noshowpos << "%)\n";
+}
+
+// What drawing a menu costs: the whole screen, and the usual redraw after a
+// choice printed a line or two, where only the prompt (and perhaps a count)
+// changes. Running a clear command, as the menus used to, is timed alongside.
+void runRenderBenchmark() {
+    class CountingBuffer : public std::streambuf {
+    public:
+        size_t bytes = 0;
+        size_t writes = 0;
+    protected:
+        int_type overflow(int_type c) override {
+            bytes++;
+            return traits_type::not_eof(c);
+        }
+        std::streamsize xsputn(const char*, std::streamsize count) override {
+            bytes += static_cast<size_t>(count);
+            writes++;
+            return count;
+        }
+    };
+    auto menu = [](size_t unread) {
+        std::ostringstream screen;
+        screen << "=====================================\n";
+        screen << "        Teacher Dashboard - Welcome Dr. Smith\n";
+        screen << "        Position: Professor\n";
+        screen << "=====================================\n";
+        const char* options[] = {"View/Announce Meetings", "Upload Student Results", "Take/Upload Attendance",
+                                 "View Student Complaints (2 new, 5 open, 1 yours)", "View Student Leave Notices (0 new, 3 pending)",
+                                 "Attendance Shortage Report", "Results Analytics & Merit List", "Manage Course Enrollment"};
+        for (size_t i = 0; i < 8; i++) screen << i + 1 << ". " << options[i] << "\n";
+        screen << "9. View Alerts (" << unread << " unread)\n10. Send Announcement\n11. Logout\n";
+        screen << "=====================================\nEnter your choice: ";
+        return screen.str();
+    };
+
+    const size_t frames = 200000;
+    const char* names[] = {"Full draw", "Redraw, nothing changed", "Redraw, one count changed"};
+    std::string screens[] = {menu(3), menu(3), menu(4)};
+    std::cout << "\nMenu rendering (" << frames << " frames each)\n" << std::fixed << std::setprecision(2);
+    for (int mode = 0; mode < 3; mode++) {
+        CountingBuffer sink;
+        TerminalScreen screen(&sink, DEFAULT_TERMINAL_ROWS);
+        std::ostream out(&screen);
+        Stopwatch timer;
+        for (size_t i = 0; i < frames; i++) {
+            if (mode == 0) screen.clear();
+            screen.present(screens[mode == 2 ? 1 + (i & 1) : mode]);
+            out << "Invalid choice. Please try again.\n\nPress Enter to return to the Teacher Dashboard...";
+            out.flush();
+        }
+        double us = timer.micros() / frames;
+        std::cout << std::left << std::setw(27) << names[mode] << std::right << std::setw(6) << us << " us, "
+                  << std::setw(4) << sink.bytes / frames << " bytes, " << sink.writes / frames << " write(s) per frame\n";
+    }
+#ifndef _WIN32
+    const int spawns = 200;
+    Stopwatch timer;
+    for (int i = 0; i < spawns; i++) {
+        if (system("clear > /dev/null 2>&1") == -1) break;
+    }
+    double us = timer.micros() / spawns;
+    std::cout << std::left << std::setw(27) << "system(\"clear\") alone" << std::right << std::setw(6) << us << " us\n";
+#endif
+}
+
+// Semester-start onboarding: a roster of new students (with some repeated
+// and malformed rows) imported into a college that already has users, on
+// one thread and on all cores, against registering the same rows one by one
+void runRosterBenchmark() {
+    const size_t existing = 100000;
+    const size_t rows = 100000;
+    const std::string path = "bench_roster.csv";
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        std::cout << "Could not create " << path << "\n";
+        return;
+    }
+    fputs("Name,Email,Phone,Password,Role,Details\n", file);
+    for (size_t r = 0; r < rows; r++) {
+        size_t n = r % 100 == 99 ? r - 50 : existing + r; // Every hundredth row repeats an earlier one
+        if (r % 1000 == 500) fprintf(file, "Student %zu,not-an-email,9000000000,pw,student,S%zu\n", n, n);
+        else fprintf(file, "Student %zu,student%zu@test.com,9000000000,pw%zu,student,S%zu\n", n, n, n, n);
+    }
+    fclose(file);
+
+    auto resetUsers = [&]() {
+        UserDirectory directory;
+        directory.reserve(existing + rows);
+        for (size_t i = 0; i < existing; i++) {
+            std::string id = std::to_string(i);
+            directory.addTrusted({"Student " + id, "student" + id + "@test.com", "pw" + id, "0000000000", Role::STUDENT, "S" + id});
+        }
+        users = std::move(directory);
+    };
+
+    unsigned cores = std::thread::hardware_concurrency();
+    if (cores == 0) cores = 1;
+    std::cout << "\nRoster import (" << rows << " rows into " << existing << " users)\n" << std::fixed << std::setprecision(1);
+    std::cout << "Threads | Parse+check (ms) | Commit (ms) | Imported | Rejected\n";
+    std::cout << "--------|------------------|-------------|----------|---------\n";
+    const unsigned threadCounts[] = {1, cores};
+    for (unsigned threads : threadCounts) {
+        resetUsers();
+        std::vector<User> parsed;
+        RosterFileReport report;
+        Stopwatch timer;
+        parseRosterFile(path, threads, parsed, report);
+        double parseMs = timer.millis();
+        size_t skipped = 0;
+        timer.restart();
+        importUsers(parsed, skipped);
+        double commitMs = timer.millis();
+        std::cout << std::left << std::setw(8) << threads << "| " << std::setw(17) << parseMs << "| " << std::setw(12)
+                  << commitMs << "| " << std::setw(9) << parsed.size() << "| " << report.rejected + skipped << "\n";
+        if (users.size() != existing + parsed.size()) std::cout << "Warning: the directory has " << users.size() << " users\n";
+        if (threads == cores) break;
+    }
+
+    resetUsers();
+    std::vector<User> parsed;
+    RosterFileReport report;
+    parseRosterFile(path, 1, parsed, report);
+    Stopwatch timer;
+    for (const User& user : parsed) registerUser(user);
+    double oneByOneMs = timer.millis();
+    std::cout << std::right << "The same rows through registerUser one at a time: " << oneByOneMs << " ms\n";
+
+    // The runs above hash at 1 iteration; this is what the real hashes add
+    const int sampled = 200;
+    timer.restart();
+    for (int i = 0; i < sampled; i++) hashPassword("pw" + std::to_string(i), IMPORT_PASSWORD_ITERATIONS);
+    double hashMs = timer.millis() / sampled;
+    std::cout << "Hashing at the import cost (" << IMPORT_PASSWORD_ITERATIONS << " iterations): " << hashMs
+              << " ms per row, " << hashMs * rows / 1000 << " CPU-s for this roster ("
+              << hashMs * rows / 1000 * DEFAULT_PASSWORD_ITERATIONS / IMPORT_PASSWORD_ITERATIONS
+              << " CPU-s at the login cost)\n";
+    remove(path.c_str());
+    users = UserDirectory();
+}
+
+// A large catalog: ISBN lookups, type-ahead on short prefixes (checked
+// against a scan), and two months of lending with each day's overdue list
+// taken from the timing wheel and, for comparison, by scanning every loan
+void runLibraryBenchmark() {
+    const uint32_t books = 100000;
+    const uint32_t loansPerDay = 3000;
+    const int days = 60;
+    const char* syllables[] = {"al", "go", "ri", "thm", "da", "ta", "ba", "se", "net", "work", "com", "pu",
+                               "ter", "sys", "tem", "lo", "gic", "math", "phy", "sics", "che", "mi", "stry", "bio"};
+    const size_t syllableCount = sizeof(syllables) / sizeof(syllables[0]);
+    BenchRandom random;
+    auto word = [&]() {
+        std::string text;
+        for (int s = 0, count = 2 + static_cast<int>(random.next() % 3); s < count; s++) text += syllables[random.next() % syllableCount];
+        return text;
+    };
+
+    Library catalog;
+    std::vector<std::string> isbns;
+    Stopwatch timer;
+    for (uint32_t b = 0; b < books; b++) {
+        char isbn[16];
+        snprintf(isbn, sizeof(isbn), "978%010u", b);
+        isbns.push_back(isbn);
+        std::string title = word() + " " + word() + " " + word();
+        catalog.addBook(isbn, title, word() + " " + word(), 1 + static_cast<uint32_t>(random.next() % 3));
+    }
+    double buildMs = timer.millis();
+
+    size_t found = 0;
+    timer.restart();
+    for (uint32_t i = 0; i < 1000000; i++) found += catalog.findIsbn(isbns[random.next() % books]) != Library::npos;
+    double isbnNs = timer.nanos() / 1000000;
+    if (found != 1000000) std::cout << "Warning: " << 1000000 - found << " ISBN lookups failed\n";
+
+    const size_t queries = 10000;
+    std::vector<std::string> prefixes;
+    for (size_t q = 0; q < queries; q++) {
+        std::string text = word();
+        text.resize(2 + random.next() % 3);
+        if (q % 4 == 0) text += " " + std::string(syllables[random.next() % syllableCount]).substr(0, 1); // Two words
+        prefixes.push_back(text);
+    }
+    std::vector<uint32_t> page;
+    size_t hits = 0;
+    timer.restart();
+    for (const std::string& prefix : prefixes) {
+        catalog.searchPrefix(prefix, LIBRARY_PAGE_SIZE, page);
+        hits += page.size();
+    }
+    double searchUs = timer.micros() / queries;
+
+    auto matches = [&](uint32_t book, const std::string& query) {
+        std::vector<std::string> words, wanted;
+        forEachWord(catalog.title(book).str() + " " + catalog.author(book).str(), [&](const std::string& w) { words.push_back(w); });
+        forEachWord(query, [&](const std::string& w) { wanted.push_back(w); });
+        for (const std::string& prefix : wanted) {
+            if (std::none_of(words.begin(), words.end(), [&](const std::string& w) { return w.compare(0, prefix.size(), prefix) == 0; })) return false;
+        }
+        return true;
+    };
+    size_t scanned = 0;
+    double scanUs = 0;
+    for (size_t q = 0; q < 20; q++) {
+        catalog.searchPrefix(prefixes[q], LIBRARY_PAGE_SIZE, page);
+        timer.restart();
+        size_t total = 0;
+        for (uint32_t book = 0; book < books; book++) total += matches(book, prefixes[q]);
+        scanUs += timer.micros();
+        scanned++;
+        bool agree = page.size() == std::min<size_t>(total, LIBRARY_PAGE_SIZE) &&
+                     std::all_of(page.begin(), page.end(), [&](uint32_t book) { return matches(book, prefixes[q]); });
+        if (!agree) std::cout << "Warning: type-ahead disagrees with a scan for '" << prefixes[q] << "'\n";
+    }
+
+    // Each day LOANS_PER_DAY books go out for two weeks; all but about 3%
+    // come back by their due day, the rest are kept
+    const int64_t firstDay = daysFromCivil(2026, 1, 1);
+    std::vector<std::vector<uint32_t>> returnsOn(days);
+    double wheelUs = 0, fullScanUs = 0;
+    size_t listed = 0;
+    for (int day = 0; day < days; day++) {
+        int64_t today = firstDay + day;
+        for (uint32_t id : returnsOn[day]) catalog.returnLoan(id, today);
+        for (uint32_t l = 0; l < loansPerDay; l++) {
+            uint32_t book = static_cast<uint32_t>(random.next() % books);
+            if (catalog.available(book) == 0) continue;
+            uint32_t id = catalog.addLoan(Loan{book, static_cast<UserHandle>(random.next() % 50000), today, today + 14,
+                                               Library::NOT_RETURNED});
+            int back = day + 1 + static_cast<int>(random.next() % 14);
+            if (random.next() % 100 >= 3 && back < days) returnsOn[back].push_back(id);
+        }
+        timer.restart();
+        size_t overdue = catalog.overdue(today).size();
+        wheelUs += timer.micros();
+        timer.restart();
+        size_t expected = 0;
+        for (uint32_t id = 0; id < catalog.loanCount(); id++) {
+            const Loan& loan = catalog.loan(id);
+            expected += loan.returnedDay == Library::NOT_RETURNED && loan.dueDay < today;
+        }
+        fullScanUs += timer.micros();
+        if (overdue != expected) std::cout << "Warning: day " << day << " lists " << overdue << " overdue, a scan finds " << expected << "\n";
+        listed += overdue;
+    }
+
+    std::cout << "\nLibrary (" << books << " titles, " << catalog.loanCount() << " loans)\n" << std::fixed << std::setprecision(2);
+    std::cout << "Build catalog:                 " << buildMs << " ms\n";
+    std::cout << "ISBN lookup:                   " << isbnNs << " ns\n";
+    std::cout << "Type-ahead, first " << LIBRARY_PAGE_SIZE << " matches: " << searchUs << " us (" << static_cast<double>(hits) / queries
+              << " results per query)\n";
+    std::cout << "Full scan for the same:        " << scanUs / scanned << " us\n";
+    std::cout << "Overdue list per day, wheel:   " << wheelUs / days << " us (" << listed / days << " loans overdue on average)\n";
+    std::cout << "Overdue list per day, scan:    " << fullScanUs / days << " us\n";
+}
+
+// Years of complaints with most of them archived: heap per record in each
+// tier, segment size against the raw encoding, and what at() costs for a
+// record in memory, a random archived one, and archived ones read newest
+// first the way the complaint list pages through them
+void runArchiveBenchmark() {
+    const size_t count = 200000;
+    const size_t archived = count - count / 10;
+    const std::string path = "bench_archive.cold";
+    const char* common[] = {"the", "wifi", "in", "hostel", "block", "is", "not", "working", "since", "monday",
+                            "lab", "fan", "broken", "canteen", "food", "library", "closed", "early", "bus", "late"};
+    BenchRandom random;
+
+    std::vector<Complaint> originals(count);
+    for (size_t n = 0; n < count; n++) {
+        Complaint& complaint = originals[n];
+        size_t student = random.next() % 5000;
+        complaint.sequence = n + 1;
+        complaint.submittedAt = 1700000000 + static_cast<int64_t>(n) * 600;
+        complaint.studentEmail = "student" + std::to_string(student) + "@campus-mail.edu";
+        complaint.studentName = "Student Number " + std::to_string(student);
+        for (int w = 0; w < 12; w++) {
+            if (w > 0) complaint.message += ' ';
+            uint64_t r = random.next();
+            if (r & 1) complaint.message += common[(r >> 1) % 20];
+            else complaint.message += "t" + std::to_string((r >> 8) % 20000);
+        }
+    }
+    // Heap bytes of one record: the struct plus every string too long for SSO
+    auto heapBytes = [](const Complaint& complaint) {
+        size_t bytes = sizeof(Complaint);
+        for (const std::string* field : {&complaint.studentEmail, &complaint.studentName, &complaint.message}) {
+            if (field->capacity() > 15) bytes += field->capacity() + 1;
+        }
+        return bytes;
+    };
+    size_t hotBytes = 0;
+    for (const Complaint& complaint : originals) hotBytes += heapBytes(complaint);
+
+    SharedRecordList<Complaint> list;
+    list.assign(originals);
+    BinaryWriter raw;
+    for (size_t n = 0; n < archived; n++) encodeRecord(raw, originals[n]);
+    Stopwatch timer;
+    if (!list.archive(archived, path)) {
+        std::cout << "Could not write " << path << "\n";
+        return;
+    }
+    double archiveMs = timer.millis();
+    std::unique_ptr<ColdSegment> segment(new ColdSegment);
+    segment->open(path);
+    size_t remainingBytes = segment->blockCount() * sizeof(ColdSegment::Block);
+    for (size_t n = archived; n < count; n++) remainingBytes += heapBytes(originals[n]);
+
+    const int lookups = 20000;
+    size_t mismatches = 0;
+    auto timeLookups = [&](std::function<size_t(int)> position) {
+        Stopwatch lookupTimer;
+        for (int i = 0; i < lookups; i++) {
+            size_t pos = position(i);
+            Complaint complaint = list.at(pos);
+            if (complaint.sequence != originals[pos].sequence || complaint.message != originals[pos].message) mismatches++;
+        }
+        return lookupTimer.nanos() / lookups;
+    };
+    double hotNs = timeLookups([&](int) { return archived + random.next() % (count - archived); });
+    double coldRandomNs = timeLookups([&](int) { return random.next() % archived; });
+    double coldPagedNs = timeLookups([&](int i) { return archived - 1 - static_cast<size_t>(i); });
+
+    // Every record, as a snapshot load reads them to rebuild the indexes
+    timer.restart();
+    size_t visited = 0;
+    list.forEachFrom(0, [&](size_t, const Complaint&) { visited++; });
+    double scanMs = timer.millis();
+
+    std::cout << "\nComplaint archive (" << count << " complaints, " << archived << " archived in "
+              << segment->blockCount() << " blocks)\n" << std::fixed << std::setprecision(1);
+    std::cout << "Record heap, all in memory: " << hotBytes / (1024.0 * 1024.0) << " MB\n";
+    std::cout << "Record heap, archived:      " << remainingBytes / (1024.0 * 1024.0) << " MB\n";
+    std::cout << "Segment file:               " << segment->fileSize() / (1024.0 * 1024.0) << " MB ("
+              << static_cast<double>(raw.size()) / segment->fileSize() << "x smaller than the raw records)\n";
+    std::cout << "Write segment:              " << archiveMs << " ms\n";
+    std::cout << "at(), in memory:            " << hotNs << " ns\n";
+    std::cout << "at(), archived at random:   " << coldRandomNs << " ns\n";
+    std::cout << "at(), archived in order:    " << coldPagedNs << " ns\n";
+    std::cout << "Read back all records:      " << scanMs << " ms\n";
+    if (mismatches != 0 || visited != count) std::cout << "Warning: archived records read back wrong\n";
+    segment.reset();
+    list.assign({});
+    remove(path.c_str());
+}
+
+// A month of scans at four gates: how fast they are added and how small
+// they are kept, a scan file through the import path, "who entered" over
+// one-hour windows (checked against a scan of every event), last seen, and
+// a week of one person's history
+void runGateBenchmark() {
+    const uint32_t people = 5000;
+    const int days = 30;
+    const uint32_t scansPerDay = 40000;
+    const int64_t firstDay = daysFromCivil(2026, 1, 1);
+    BenchRandom random;
+
+    // Scans cluster between 7:00 and 19:00 and arrive a few seconds out of order
+    std::vector<GateEvent> events;
+    events.reserve(static_cast<size_t>(days) * scansPerDay);
+    for (int day = 0; day < days; day++) {
+        int64_t time = (firstDay + day) * 86400 + 7 * 3600;
+        for (uint32_t s = 0; s < scansPerDay; s++) {
+            time += static_cast<int64_t>(random.next() % 2);
+            int64_t jitter = static_cast<int64_t>(random.next() % 8) - 4;
+            events.push_back(GateEvent{time + jitter, static_cast<uint32_t>(random.next() % people),
+                                       static_cast<uint32_t>(random.next() % 4), (random.next() & 1) != 0});
+        }
+    }
+
+    GateLog log;
+    for (uint32_t p = 0; p < people; p++) log.internPerson("student" + std::to_string(p) + "@campus-mail.edu");
+    for (const char* gate : {"Main Gate", "North Gate", "Hostel Gate", "Staff Gate"}) log.internGate(gate);
+    Stopwatch timer;
+    for (const GateEvent& event : events) log.add(event);
+    double addSeconds = timer.seconds();
+    size_t bytes = 0;
+    for (size_t id = 0; id < log.segmentCount(); id++) bytes += log.segmentBytes(id).size();
+
+    // The import path: parse, resolve, log in batches and add
+    const std::string path = "bench_gate_scans.csv";
+    const size_t fileScans = 200000;
+    {
+        std::ofstream file(path);
+        for (size_t s = 0; s < fileScans; s++) {
+            const GateEvent& event = events[s];
+            file << event.time << ",S" << 1000 + event.person << "," << (event.entering ? "in" : "out") << ","
+                 << log.gateName(event.gate) << "\n";
+        }
+    }
+    GateScanReport report;
+    timer.restart();
+    importGateScans(path, report);
+    double importSeconds = timer.seconds();
+    if (report.logged != fileScans) std::cout << "Warning: " << fileScans - report.logged << " file scans were not imported\n";
+
+    const int windows = 200;
+    std::vector<GateEvent> found;
+    size_t entries = 0, mismatches = 0;
+    double queryUs = 0, scanUs = 0;
+    for (int w = 0; w < windows; w++) {
+        int64_t from = (firstDay + static_cast<int64_t>(random.next() % days)) * 86400 + 7 * 3600 + static_cast<int64_t>(random.next() % (11 * 3600));
+        int64_t to = from + 3600;
+        timer.restart();
+        log.between(from, to, true, found);
+        queryUs += timer.micros();
+        entries += found.size();
+        if (w < 20) {
+            timer.restart();
+            size_t expected = 0;
+            for (const GateEvent& event : events) expected += event.entering && event.time >= from && event.time <= to;
+            scanUs += timer.micros();
+            if (expected != found.size()) mismatches++;
+        }
+    }
+
+    const int lookups = 100000;
+    GateEvent last;
+    size_t seen = 0;
+    timer.restart();
+    for (int i = 0; i < lookups; i++) seen += log.lastSeen(static_cast<uint32_t>(random.next() % people), last);
+    double lastSeenNs = timer.nanos() / lookups;
+
+    const int histories = 1000;
+    size_t historyEvents = 0;
+    int64_t weekEnd = (firstDay + days) * 86400 - 1;
+    timer.restart();
+    for (int i = 0; i < histories; i++) {
+        log.history(static_cast<uint32_t>(random.next() % people), weekEnd - 7 * 86400 + 1, weekEnd, found);
+        historyEvents += found.size();
+    }
+    double historyUs = timer.micros() / histories;
+    for (uint32_t person = 0; person < 10; person++) {
+        log.history(person, weekEnd - 7 * 86400 + 1, weekEnd, found);
+        size_t expected = 0;
+        for (const GateEvent& event : events) expected += event.person == person && event.time > weekEnd - 7 * 86400 && event.time <= weekEnd;
+        if (expected != found.size()) mismatches++;
+    }
+
+    std::cout << "\nGate log (" << log.eventCount() << " scans over " << days << " days, " << people << " people)\n"
+              << std::fixed << std::setprecision(2);
+    std::cout << "Add scans:                  " << log.eventCount() / addSeconds / 1e6 << " M scans/s\n";
+    std::cout << "Encoded size:               " << static_cast<double>(bytes) / log.eventCount() << " bytes/scan ("
+              << sizeof(GateEvent) << " as a struct), " << log.memoryUsage() / (1024.0 * 1024.0) << " MB in all\n";
+    std::cout << "Import scan file:           " << fileScans / importSeconds / 1000 << " K scans/s\n";
+    std::cout << "Who entered, 1-hour window: " << queryUs / windows << " us (" << entries / windows << " entries)\n";
+    std::cout << "Scan of every event:        " << scanUs / 20 << " us\n";
+    std::cout << "Last seen:                  " << lastSeenNs << " ns\n";
+    std::cout << "Week of one person:         " << historyUs << " us (" << static_cast<double>(historyEvents) / histories
+              << " scans)\n";
+    if (mismatches != 0 || seen != static_cast<size_t>(lookups)) std::cout << "Warning: gate queries disagree with a scan\n";
+    remove(path.c_str());
+    gateLog = GateLog();
+}
+
+// Password hashing: the cost of one hash at the default work factor (and a
+// known PBKDF2 answer as a check), login throughput through authenticate
+// as password workers are added, and the failed-login table under threads
+void runPasswordBenchmark() {
+    uint8_t expected[32] = {0xc5, 0xe4, 0x78, 0xd5, 0x92, 0x88, 0xc8, 0x41, 0xaa, 0x53, 0x0d, 0xb6, 0x84, 0x5c, 0x4c, 0x8d,
+                            0x96, 0x28, 0x93, 0xa0, 0x01, 0xce, 0x4e, 0x11, 0xa4, 0x96, 0x38, 0x73, 0xaa, 0x98, 0x13, 0x4a};
+    uint8_t derived[32];
+    pbkdf2Sha256("password", 8, reinterpret_cast<const uint8_t*>("salt"), 4, 4096, derived);
+    if (memcmp(derived, expected, sizeof(expected)) != 0) std::cout << "Warning: PBKDF2-HMAC-SHA256 gives a wrong answer\n";
+
+    const int hashes = 20;
+    Stopwatch timer;
+    for (int i = 0; i < hashes; i++) hashPassword("correct horse", DEFAULT_PASSWORD_ITERATIONS);
+    double hashMs = timer.millis() / hashes;
+
+    // Logins from many session threads at once, at a lighter cost so the run stays short
+    const uint32_t iterations = 2000;
+    const size_t userCount = 256;
+    const int sessionThreads = 32;
+    const size_t logins = 4000;
+    uint32_t savedIterations = passwordIterations;
+    passwordIterations = iterations;
+    users = UserDirectory();
+    for (size_t i = 0; i < userCount; i++) {
+        std::string id = std::to_string(i);
+        users.add({"User " + id, "user" + id + "@test.com", hashPassword("pw" + id, iterations), "0000000000",
+                   Role::STUDENT, "S" + id});
+    }
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    std::cout << "\nPasswords (PBKDF2-HMAC-SHA256)\n" << std::fixed << std::setprecision(2);
+    std::cout << "One hash, " << DEFAULT_PASSWORD_ITERATIONS << " iterations: " << hashMs << " ms\n";
+    std::cout << "Logins at " << iterations << " iterations, " << sessionThreads << " session threads:\n";
+    std::cout << "Workers | Logins/s   | Speedup\n";
+    std::cout << "--------|------------|--------\n";
+    double single = 0;
+    for (unsigned workers = 1;; workers = std::min(cores, workers * 2)) {
+        passwordWorkers.start(workers);
+        std::atomic<size_t> next(0), failed(0);
+        std::vector<std::thread> sessions;
+        timer.restart();
+        for (int t = 0; t < sessionThreads; t++) {
+            sessions.emplace_back([&]() {
+                for (size_t n; (n = next.fetch_add(1)) < logins;) {
+                    std::string id = std::to_string(n % userCount);
+                    if (authenticate("user" + id + "@test.com", "pw" + id) == UserDirectory::npos) failed++;
+                }
+            });
+        }
+        for (auto& session : sessions) session.join();
+        double rate = logins / timer.seconds();
+        passwordWorkers.stop();
+        if (workers == 1) single = rate;
+        std::cout << std::left << std::setw(8) << workers << "| " << std::setw(11) << rate << "| " << rate / single
+                  << "x\n" << std::right;
+        if (failed != 0) std::cout << "Warning: " << failed << " logins failed\n";
+        if (workers == cores) break;
+    }
+    users = UserDirectory();
+    passwordIterations = savedIterations;
+
+    // Every thread fails logins for its own 256 emails and checks them
+    LoginThrottle throttle;
+    const int throttleThreads = 4;
+    const size_t operations = 1000000;
+    std::atomic<size_t> wrong(0);
+    std::vector<std::thread> threads;
+    timer.restart();
+    for (int t = 0; t < throttleThreads; t++) {
+        threads.emplace_back([&, t]() {
+            for (size_t i = 0; i < operations / throttleThreads; i++) {
+                uint64_t hash = hashString("user" + std::to_string(t * 256 + i % 256) + "@test.com");
+                throttle.recordFailure(hash, 1000);
+                if (throttle.lockedFor(hash, 1000) == 0 && i >= 256 * LoginThrottle::MAX_FAILURES) wrong++;
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    double throttleNs = timer.nanos() / operations;
+    uint64_t hash = hashString("user0@test.com");
+    throttle.recordSuccess(hash);
+    if (throttle.lockedFor(hash, 1000) != 0 || throttle.lockedFor(hashString("user1@test.com"), 1000 + LoginThrottle::LOCKOUT_SECONDS) != 0) wrong++;
+    std::cout << "Failed-login table, " << throttleThreads << " threads: " << throttleNs << " ns per failure and check\n";
+    if (wrong != 0) std::cout << "Warning: the failed-login table let " << wrong << " locked out attempts through\n";
+}
+
+// Every dataset to CSV and JSON from a college of 200k students: twenty
+// roll calls, ten grades each, 300k complaints (most of them archived) and
+// 100k leave notices.
+// Memory is the growth of peak RSS during each export (Linux only), which
+// should stay near the size of one buffer and one batch however many rows
+// are written.
+void runExportBenchmark() {
+    const uint32_t students = 200000;
+    const uint32_t sessions = 20;
+    const uint32_t gradesPerStudent = 10;
+    const size_t complaintCount = 300000;
+    const size_t archivedCount = 250000;
+    const size_t leaveCount = 100000;
+    const std::string coldPath = "bench_export.cold";
+    BenchRandom random;
+
+    users = UserDirectory();
+    users.reserve(students);
+    for (uint32_t i = 0; i < students; i++) {
+        std::string id = std::to_string(i);
+        users.add({"Student " + id, "student" + id + "@test.com", "pass", "0000000000", Role::STUDENT, "S" + id});
+    }
+    subjects = SubjectCatalog();
+    for (uint32_t s = 0; s < gradesPerStudent; s++) subjects.add("Subject " + std::to_string(s));
+    attendance = AttendanceStore();
+    uint64_t expectedAttendance = 0;
+    for (uint32_t s = 0; s < sessions; s++) {
+        AttendanceSession session;
+        session.subject = s % gradesPerStudent;
+        session.date = std::to_string(1 + s) + " Mar 2026";
+        session.marked.assign((students + 63) / 64, 0);
+        session.present.assign(session.marked.size(), 0);
+        for (uint32_t slot = 0; slot < students; slot++) {
+            if (random.next() % 20 == 0) continue; // Excused
+            setBit(session.marked, slot);
+            if (random.next() % 8 != 0) setBit(session.present, slot);
+            expectedAttendance++;
+        }
+        attendance.addSession(std::move(session));
+    }
+    grades = GradeStore();
+    for (uint32_t slot = 0; slot < students; slot++) {
+        for (uint32_t s = 0; s < gradesPerStudent; s++) {
+            grades.set(slot, GradeEntry{s, static_cast<uint8_t>(1 + s % 8), 4,
+                                        static_cast<uint8_t>(random.next() % GRADE_SCALE_SIZE)});
+        }
+    }
+    {
+        std::vector<Complaint> loaded(complaintCount);
+        for (size_t n = 0; n < complaintCount; n++) {
+            uint32_t student = static_cast<uint32_t>(random.next() % students);
+            loaded[n].sequence = n + 1;
+            loaded[n].submittedAt = 1700000000 + static_cast<int64_t>(n) * 60;
+            loaded[n].studentEmail = "student" + std::to_string(student) + "@test.com";
+            loaded[n].studentName = "Student " + std::to_string(student);
+            loaded[n].message = n % 16 == 0 ? "Fan broken, \"again\"\nsince Monday" : "The hostel wifi is not working since Monday";
+        }
+        studentComplaints.assign(std::move(loaded));
+    }
+    complaintCases = CaseTracker();
+    complaintCases.opened(complaintCount);
+    {
+        std::vector<LeaveNotice> loaded(leaveCount);
+        for (size_t n = 0; n < leaveCount; n++) {
+            uint32_t student = static_cast<uint32_t>(random.next() % students);
+            unsigned first = 1 + static_cast<unsigned>(n % 26);
+            loaded[n].sequence = complaintCount + n + 1;
+            loaded[n].submittedAt = 1700000000 + static_cast<int64_t>(n) * 300;
+            loaded[n].studentEmail = "student" + std::to_string(student) + "@test.com";
+            loaded[n].studentName = "Student " + std::to_string(student);
+            loaded[n].dates = std::to_string(first) + "-" + std::to_string(first + 2) + " Mar 2026";
+            loaded[n].reason = "Fever, at home";
+            loaded[n].firstDay = daysFromCivil(2026, 3, first);
+            loaded[n].lastDay = loaded[n].firstDay + 2;
+        }
+        studentLeaveNotices.assign(std::move(loaded));
+    }
+    leaveCases = CaseTracker();
+    leaveCases.opened(leaveCount);
+    if (!studentComplaints.archive(archivedCount, coldPath)) std::cout << "Could not write " << coldPath << "\n";
+
+    auto statusField = [](const char* field) {
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line)) {
+            if (line.compare(0, strlen(field), field) == 0) return strtoull(line.c_str() + strlen(field), nullptr, 10);
+        }
+        return 0ULL;
+    };
+    auto countLines = [](const std::string& path) {
+        FILE* file = fopen(path.c_str(), "rb");
+        uint64_t lines = 0;
+        char chunk[65536];
+        for (size_t n; file != nullptr && (n = fread(chunk, 1, sizeof(chunk), file)) > 0;) {
+            lines += static_cast<uint64_t>(std::count(chunk, chunk + n, '\n'));
+        }
+        if (file != nullptr) fclose(file);
+        return lines;
+    };
+
+    const uint64_t expectedRows[EXPORT_DATASET_COUNT] = {expectedAttendance,
+                                                         static_cast<uint64_t>(students) * gradesPerStudent,
+                                                         complaintCount, leaveCount};
+    std::cout << "\nExport (" << students << " students, " << complaintCount << " complaints with " << archivedCount
+              << " archived, " << leaveCount << " leave notices)\n" << std::fixed << std::setprecision(1);
+    std::cout << "Dataset    | Format | Rows     | MB      | MB/s    | Peak RSS growth (MB)\n";
+    std::cout << "-----------|--------|----------|---------|---------|---------------------\n";
+    size_t mismatches = 0;
+    for (int d = 0; d < EXPORT_DATASET_COUNT; d++) {
+        for (ExportFormat format : {EXPORT_CSV, EXPORT_JSON}) {
+            std::string path = format == EXPORT_CSV ? "bench_export.csv" : "bench_export.json";
+            {
+                std::ofstream reset("/proc/self/clear_refs"); // "5" restarts the peak RSS count
+                reset << "5";
+            }
+            unsigned long long before = statusField("VmRSS:");
+            ExportReport report;
+            if (!exportRecords(static_cast<ExportDataset>(d), format, path, report)) {
+                std::cout << "Could not write " << path << "\n";
+                mismatches++;
+                continue;
+            }
+            unsigned long long peak = statusField("VmHWM:");
+            // CSV adds a header line; JSON the brackets. Complaint messages
+            // with a line break put one more line in the CSV.
+            uint64_t lines = countLines(path);
+            uint64_t expected = report.rows + (format == EXPORT_CSV ? 1 : 2);
+            if (d == EXPORT_COMPLAINTS && format == EXPORT_CSV) expected += (complaintCount + 15) / 16;
+            if (report.rows != expectedRows[d] || lines != expected) mismatches++;
+            std::cout << std::left << std::setw(11) << EXPORT_DATASET_NAMES[d] << "| " << std::setw(7)
+                      << (format == EXPORT_CSV ? "csv" : "json") << "| " << std::setw(9) << report.rows << "| "
+                      << std::setw(8) << report.bytes / (1024.0 * 1024.0) << "| " << std::setw(8)
+                      << report.megabytesPerSecond() << "| ";
+            if (peak == 0) std::cout << "-\n";
+            else std::cout << (peak > before ? peak - before : 0) / 1024.0 << "\n";
+            std::cout << std::right;
+            remove(path.c_str());
+        }
+    }
+    if (mismatches != 0) std::cout << "Warning: " << mismatches << " exports wrote the wrong rows\n";
+
+    users = UserDirectory();
+    subjects = SubjectCatalog();
+    attendance = AttendanceStore();
+    grades = GradeStore();
+    studentComplaints.assign({});
+    complaintCases = CaseTracker();
+    studentLeaveNotices.assign({});
+    leaveCases = CaseTracker();
+    remove(coldPath.c_str());
+}
+
+// --- Check Mode ---
+// Each check builds a small case around one feature's edge cases, prints
+// what it expected and got when they differ, and leaves the global stores
+// empty again. runChecks() reports one line per check.
+
+// Counts a failure (and says what it was) when condition is false
+bool expect(bool condition, const std::string& what) {
+    if (!condition) std::cout << "  expected " << what << "\n";
+    return condition;
+}
+
+bool writeCheckFile(const std::string& path, const std::string& text) {
+    std::ofstream file(path, std::ios::binary);
+    file << text;
+    return static_cast<bool>(file);
+}
+
+bool runChecks(const char* only, bool& ran) {
+    bool passed = true;
+    ran = false;
+    for (const NamedCheck& check : CHECKS) {
+        if (only != nullptr && strcmp(only, check.name) != 0) continue;
+        bool ok = check.run();
+        std::cout << check.name << ": " << (ok ? "ok" : "FAILED") << "\n";
+        passed = passed && ok;
+        ran = true;
+    }
+    return passed;
+}
+
+// A roster with a header, a repeated email in another case, an ID that only
+// a refused row used (so a later row may take it), a repeated ID and a bad
+// row; then the same on many threads, and a batch against registered users
+bool checkRosterRepeats() {
+    const std::string path = "check_roster.csv";
+    bool ok = writeCheckFile(path, "Name,Email,Phone,Password,Role,Details\n"
+                                   "Asha,asha@x.edu,1,pw,student,S1\n"
+                                   "Asha Again,ASHA@x.edu ,1,pw,student,S2\n"
+                                   "Bala,bala@x.edu,1,pw,student,s2\n"
+                                   "Chitra,chitra@x.edu,1,pw,student,S1\n"
+                                   "Dev,not-an-email,1,pw,student,S3\n"
+                                   "Esha,esha@x.edu,1,pw,teacher,\n");
+    std::vector<User> parsed;
+    RosterFileReport report;
+    ok = expect(ok && parseRosterFile(path, 1, parsed, report), "the roster file to be read") && ok;
+    remove(path.c_str());
+    std::vector<std::string> emails;
+    for (const User& user : parsed) emails.push_back(user.email);
+    ok = expect(emails == std::vector<std::string>{"asha@x.edu", "bala@x.edu", "esha@x.edu"},
+                "asha, bala and esha to be accepted") && ok;
+    ok = expect(report.rejected == 3, "3 rejected rows, got " + std::to_string(report.rejected)) && ok;
+    ok = expect(!parsed.empty() && parsed.size() > 1 && parsed[1].roleSpecificData == "S2",
+                "bala to keep S2, which only a refused row had used") && ok;
+    for (const std::string& problem : report.problems) {
+        ok = expect(problem.find("pw") == std::string::npos, "no row text in '" + problem + "'") && ok;
+    }
+
+    // Big enough to be split across threads: every 7th row repeats an
+    // earlier email with a new ID, every 11th an earlier ID with a new email
+    std::vector<RosterRow> rows(40000);
+    for (size_t r = 0; r < rows.size(); r++) {
+        size_t emailKey = r % 7 == 6 ? r - 3 : r;
+        size_t idKey = r % 11 == 10 ? r - 5 : r + (r % 7 == 6 ? 1000000 : 0);
+        rows[r].user = User{"S", "s" + std::to_string(emailKey) + "@x.edu", "pw", "1", Role::STUDENT,
+                            "S" + std::to_string(idKey)};
+        rows[r].emailHash = hashString(rows[r].user.email);
+        rows[r].idHash = hashString(rows[r].user.roleSpecificData);
+    }
+    std::vector<uint8_t> oneEmail, oneId, manyEmail, manyId;
+    markRepeatedRows(rows, 1, oneEmail, oneId);
+    markRepeatedRows(rows, 8, manyEmail, manyId);
+    ok = expect(oneEmail == manyEmail && oneId == manyId, "the same repeats on 1 and 8 threads") && ok;
+    std::vector<std::string> acceptedEmails, acceptedIds;
+    for (size_t r = 0; r < rows.size(); r++) {
+        if (oneEmail[r] || oneId[r]) continue;
+        acceptedEmails.push_back(rows[r].user.email);
+        acceptedIds.push_back(rows[r].user.roleSpecificData);
+    }
+    auto distinct = [](std::vector<std::string>& keys) {
+        std::sort(keys.begin(), keys.end());
+        return std::adjacent_find(keys.begin(), keys.end()) == keys.end();
+    };
+    ok = expect(distinct(acceptedEmails) && distinct(acceptedIds), "no email or ID twice among the accepted rows") && ok;
+
+    users = UserDirectory();
+    users.add({"Asha", "asha@x.edu", "pw", "1", Role::STUDENT, "S1"});
+    size_t skipped = 0;
+    ok = expect(importUsers(parsed, skipped), "the import to succeed") && ok;
+    ok = expect(skipped == 1 && users.size() == 3, "asha to be skipped as registered and 2 users added") && ok;
+    ok = expect(users.findByStudentId("S2") != UserDirectory::npos, "S2 to be registered") && ok;
+    users = UserDirectory();
+    return ok;
+}
+
+// Complaints archived into two segments ahead of some still in memory:
+// empty fields, binary text and records longer than a block come back from
+// at(), from a walk across both segment boundaries and from the files
+// reopened the way a snapshot load opens them. A damaged segment must not
+// open, and leave notices keep their day range.
+bool checkColdRoundTrip() {
+    const std::string paths[] = {"check_cold_1.cold", "check_cold_2.cold", "check_cold_bad.cold"};
+    const char binary[] = "nul\0byte, \"quote\"\nline";
+    std::vector<Complaint> originals(300);
+    for (size_t n = 0; n < originals.size(); n++) {
+        Complaint& complaint = originals[n];
+        complaint.sequence = n + 1;
+        complaint.submittedAt = n == 0 ? 0 : 1700000000 + static_cast<int64_t>(n) * 60;
+        complaint.studentEmail = "s" + std::to_string(n % 13) + "@x.edu";
+        complaint.studentName = n % 5 == 0 ? "" : "Student " + std::to_string(n);
+        if (n % 50 == 7) complaint.message = std::string(2 * COLD_BLOCK_BYTES + n, static_cast<char>('a' + n % 26));
+        else if (n % 3 == 0) complaint.message = std::string(binary, sizeof(binary) - 1);
+        else complaint.message = "message " + std::to_string(n);
+    }
+    auto same = [](const Complaint& a, const Complaint& b) {
+        return a.sequence == b.sequence && a.submittedAt == b.submittedAt && a.studentEmail == b.studentEmail &&
+               a.studentName == b.studentName && a.message == b.message;
+    };
+    auto matches = [&](const SharedRecordList<Complaint>& list, const std::string& how) {
+        bool ok = expect(list.size() == originals.size() && list.coldCount() == 250, how + ": 250 of 300 archived");
+        for (size_t pos = 0; ok && pos < originals.size(); pos++) {
+            ok = expect(same(list.at(pos), originals[pos]), how + ": record " + std::to_string(pos) + " from at()");
+        }
+        size_t next = 95;
+        bool inOrder = true;
+        bool walked = list.forEachIn(95, 260, [&](size_t pos, const Complaint& complaint) {
+            inOrder = inOrder && pos == next++ && same(complaint, originals[pos]);
+        });
+        return expect(walked && inOrder && next == 260, how + ": records 95-259 in order from a walk") && ok;
+    };
+
+    SharedRecordList<Complaint> list;
+    list.assign(originals);
+    bool ok = expect(list.archive(100, paths[0]) && list.archive(150, paths[1]), "both segments to be written");
+    ok = expect(list.archive(0, paths[2]) && list.coldCount() == 250, "archiving nothing to change nothing") && ok;
+    ok = matches(list, "archived") && ok;
+
+    std::vector<std::unique_ptr<ColdSegment>> segments;
+    for (int s = 0; s < 2; s++) {
+        segments.emplace_back(new ColdSegment);
+        ok = expect(segments.back()->open(paths[s]), paths[s] + " to reopen") && ok;
+    }
+    SharedRecordList<Complaint> reopened;
+    reopened.restore(std::move(segments), std::vector<Complaint>(originals.begin() + 250, originals.end()));
+    ok = matches(reopened, "reopened") && ok;
+
+    std::ifstream in(paths[1], std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (!bytes.empty()) bytes[bytes.size() / 2] ^= 0x20;
+    ColdSegment damaged;
+    ok = expect(writeCheckFile(paths[2], bytes) && !damaged.open(paths[2]), "a damaged segment to be refused") && ok;
+
+    std::vector<LeaveNotice> notices(3);
+    for (size_t n = 0; n < notices.size(); n++) {
+        notices[n].sequence = 301 + n;
+        notices[n].studentEmail = "s1@x.edu";
+        notices[n].dates = n == 1 ? "sometime soon" : "25-27 Feb 2024";
+        notices[n].reason = n == 2 ? "" : "Fever, \"at home\"";
+        notices[n].firstDay = daysFromCivil(2024, 2, 25);
+        notices[n].lastDay = n == 1 ? notices[n].firstDay - 1 : notices[n].firstDay + 2;
+    }
+    SharedRecordList<LeaveNotice> leave;
+    leave.assign(notices);
+    ok = expect(leave.archive(2, paths[2]), "leave notices to be archived") && ok;
+    for (size_t n = 0; n < notices.size(); n++) {
+        LeaveNotice notice = leave.at(n);
+        ok = expect(notice.sequence == notices[n].sequence && notice.dates == notices[n].dates &&
+                    notice.reason == notices[n].reason && notice.firstDay == notices[n].firstDay &&
+                    notice.lastDay == notices[n].lastDay, "leave notice " + std::to_string(n) + " unchanged") && ok;
+    }
+
+    list.assign({});
+    reopened.assign({});
+    leave.assign({});
+    for (const std::string& path : paths) remove(path.c_str());
+    return ok;
+}
+
+// Typed times are already on the wall clock; scanner (Unix) times are moved
+// onto it in the local zone, including a half-hour zone and both sides of a
+// daylight saving change; malformed times are refused
+bool checkGateTimes() {
+    const int64_t morning = daysFromCivil(2024, 3, 20) * 86400 + 9 * 3600 + 30 * 60;
+    int64_t seconds = 0;
+    bool ok = expect(parseGateTime("2024-03-20 09:30:15", seconds) && seconds == morning + 15, "2024-03-20 09:30:15");
+    ok = expect(parseGateTime(" 2024-03-20 09:30", seconds) && seconds == morning, "2024-03-20 09:30") && ok;
+    ok = expect(formatGateTime(morning + 15) == "20 Mar 2024, 09:30:15", "it to print as 20 Mar 2024, 09:30:15") && ok;
+    for (const char* bad : {"", "12abc", "-5", "2024-02-30 10:00:00", "2024-03-20 24:00:00", "2024-03-20 09:60",
+                            "2024-03-20 09:30:15 x", "20 Mar 2024"}) {
+        ok = expect(!parseGateTime(bad, seconds), "'" + std::string(bad) + "' to be refused") && ok;
+    }
+#ifndef _WIN32
+    // Zones given as POSIX rules need no zone database. Each zone is tried on
+    // a new thread, since parseGateTime keeps the last offset per thread.
+    std::string savedZone = getenv("TZ") != nullptr ? getenv("TZ") : "";
+    bool hadZone = getenv("TZ") != nullptr;
+    struct ZoneCase {
+        const char* zone;
+        const char* scan;
+        int64_t expected;
+    };
+    const ZoneCase cases[] = {
+        {"UTC0", " 1700000000 ", 1700000000},
+        {"IST-5:30", "1700000000", 1700000000 + 5 * 3600 + 30 * 60},
+        {"EST5EDT,M3.2.0,M11.1.0", "1710053999", 1710053999 - 5 * 3600}, // 01:59:59 EST on 10 Mar 2024
+        {"EST5EDT,M3.2.0,M11.1.0", "1710054000", 1710054000 - 4 * 3600}  // A second later: 03:00:00 EDT
+    };
+    for (const ZoneCase& zone : cases) {
+        setenv("TZ", zone.zone, 1);
+        tzset();
+        std::thread([&]() {
+            bool parsed = parseGateTime(zone.scan, seconds);
+            ok = expect(parsed && seconds == zone.expected,
+                        std::string(zone.scan) + " in " + zone.zone + " at " + std::to_string(zone.expected) + ", got " +
+                            std::to_string(seconds)) && ok;
+        }).join();
+    }
+    std::thread([&]() {
+        bool parsed = parseGateTime("1710053999", seconds) && parseGateTime("1710054000", seconds);
+        ok = expect(parsed && seconds == 1710054000 - 4 * 3600, "consecutive scans across the change to use the new offset") && ok;
+    }).join();
+    if (hadZone) setenv("TZ", savedZone.c_str(), 1);
+    else unsetenv("TZ");
+    tzset();
+#endif
+    return ok;
+}
+
+// Three complaints, the first archived, through both formats byte for byte:
+// CSV quotes only fields with a comma, quote or line break and doubles the
+// quotes; JSON escapes quotes, backslashes and control characters and
+// passes UTF-8 through. The status of each row is that record's own. Export
+// names must be bare file names.
+bool checkExportEscaping() {
+    std::vector<Complaint> complaints(3);
+    const char* const emails[] = {"a@x.edu", "b@x.edu", "c@x.edu"};
+    const char* const names[] = {"A, \"B\"", "Bala", ""};
+    const char* const messages[] = {"say \"hi\",\r\nback\\slash\ttab\x01 \xc3\xa9", "plain", ""};
+    for (size_t n = 0; n < complaints.size(); n++) {
+        complaints[n].sequence = n + 1;
+        complaints[n].submittedAt = n == 0 ? 0 : 1700000000 + 60 * static_cast<int64_t>(n - 1);
+        complaints[n].studentEmail = emails[n];
+        complaints[n].studentName = names[n];
+        complaints[n].message = messages[n];
+    }
+    const std::string coldPath = "check_export.cold";
+    studentComplaints.assign(complaints);
+    complaintCases = CaseTracker();
+    complaintCases.opened(complaints.size());
+    complaintCases.update(1, CASE_RESOLVED, UserDirectory::npos);
+    bool ok = expect(studentComplaints.archive(1, coldPath), "the first complaint to be archived");
+
+    const std::string expected[] = {
+        "number,submitted_at,student_email,student_name,status,message\n"
+        "1,,a@x.edu,\"A, \"\"B\"\"\",Open,\"say \"\"hi\"\",\r\nback\\slash\ttab\x01 \xc3\xa9\"\n"
+        "2,2023-11-14T22:13:20Z,b@x.edu,Bala,Resolved,plain\n"
+        "3,2023-11-14T22:14:20Z,c@x.edu,,Open,\n",
+        "[\n"
+        "{\"number\":1,\"submitted_at\":null,\"student_email\":\"a@x.edu\",\"student_name\":\"A, \\\"B\\\"\","
+        "\"status\":\"Open\",\"message\":\"say \\\"hi\\\",\\r\\nback\\\\slash\\ttab\\u0001 \xc3\xa9\"},\n"
+        "{\"number\":2,\"submitted_at\":\"2023-11-14T22:13:20Z\",\"student_email\":\"b@x.edu\",\"student_name\":\"Bala\","
+        "\"status\":\"Resolved\",\"message\":\"plain\"},\n"
+        "{\"number\":3,\"submitted_at\":\"2023-11-14T22:14:20Z\",\"student_email\":\"c@x.edu\",\"student_name\":\"\","
+        "\"status\":\"Open\",\"message\":\"\"}\n"
+        "]\n"};
+    const ExportFormat formats[] = {EXPORT_CSV, EXPORT_JSON};
+    for (int f = 0; f < 2; f++) {
+        const std::string path = f == 0 ? "check_export.csv" : "check_export.json";
+        ExportReport report;
+        bool exported = exportRecords(EXPORT_COMPLAINTS, formats[f], path, report);
+        std::ifstream in(path, std::ios::binary);
+        std::string written((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        in.close();
+        ok = expect(exported && report.rows == 3, path + " to be written with 3 rows") && ok;
+        ok = expect(written == expected[f], path + " to read\n" + expected[f] + "  but it reads\n" + written) && ok;
+        remove(path.c_str());
+    }
+
+    std::string path;
+    for (const char* bad : {"", ".", "..", "../x.csv", "a/b.csv", "a\\b.csv", "C:x.csv"}) {
+        ok = expect(!fileInDirectory(EXPORT_DIR, bad, path), "'" + std::string(bad) + "' to be refused as a name") && ok;
+    }
+    ok = expect(fileInDirectory(EXPORT_DIR, "c.json", path) && path == std::string(EXPORT_DIR) + "/c.json",
+                "c.json to go in " + std::string(EXPORT_DIR)) && ok;
+
+    studentComplaints.assign({});
+    complaintCases = CaseTracker();
+    remove(coldPath.c_str());
+    return ok;
+}